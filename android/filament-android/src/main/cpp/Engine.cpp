@@ -54,6 +54,20 @@ Java_com_google_android_filament_Engine_nGetBackend(JNIEnv*, jclass, jlong nativ
     return (jlong) engine->getBackend();
 }
 
+extern "C" JNIEXPORT void JNICALL
+Java_com_google_android_filament_Engine_nSetAutomaticInstancingEnabled(JNIEnv*, jclass,
+        jlong nativeEngine, jboolean enable) {
+    Engine* engine = (Engine*) nativeEngine;
+    engine->setAutomaticInstancingEnabled(enable);
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_google_android_filament_Engine_nIsAutomaticInstancingEnabled(JNIEnv*, jclass,
+        jlong nativeEngine) {
+    Engine* engine = (Engine*) nativeEngine;
+    return (jboolean) engine->isAutomaticInstancingEnabled();
+}
+
 extern "C" JNIEXPORT jlong JNICALL
 Java_com_google_android_filament_Engine_nCreateSwapChain(JNIEnv* env,
         jclass klass, jlong nativeEngine, jobject surface, jlong flags) {
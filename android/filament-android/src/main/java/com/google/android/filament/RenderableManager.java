@@ -337,6 +337,22 @@ public class RenderableManager {
             return this;
         }
 
+        /**
+         * Hints that this renderable's shadow doesn't change from frame to frame (false by
+         * default). The depth of static shadow casters is kept across frames and only rendered
+         * again when the light, the shadow map's frustum or the set of static casters changes.
+         * Moving a static shadow caster is allowed, but is more expensive than moving a dynamic
+         * one. Changing the geometry, material, bones or morph weights of a static shadow caster
+         * with this RenderableManager is detected, but changing the content of its buffers,
+         * textures or material parameters is not: call {@link #setStaticShadowCaster} again
+         * after such changes. This has no effect with {@link View.ShadowType#VSM}.
+         */
+        @NonNull
+        public Builder staticShadowCaster(boolean enabled) {
+            nBuilderStaticShadowCaster(mNativeBuilder, enabled);
+            return this;
+        }
+
         /**
          * Allows bones to be swapped out and shared using SkinningBuffer.
          *
@@ -702,6 +718,17 @@ public class RenderableManager {
         nSetScreenSpaceContactShadows(mNativeObject, i, enabled);
     }
 
+    /**
+     * Changes whether or not the renderable is a static shadow caster. When the renderable is,
+     * or was, a static shadow caster, this also causes the static shadow casters to be rendered
+     * again in the next frame.
+     *
+     * @see Builder#staticShadowCaster
+     */
+    public void setStaticShadowCaster(@EntityInstance int i, boolean enabled) {
+        nSetStaticShadowCaster(mNativeObject, i, enabled);
+    }
+
     /**
      * Checks if the renderable can cast shadows.
      *
@@ -720,6 +747,15 @@ public class RenderableManager {
         return nIsShadowReceiver(mNativeObject, i);
     }
 
+    /**
+     * Checks if the renderable is a static shadow caster.
+     *
+     * @see Builder#staticShadowCaster
+     */
+    public boolean isStaticShadowCaster(@EntityInstance int i) {
+        return nIsStaticShadowCaster(mNativeObject, i);
+    }
+
     /**
      * Gets the bounding box used for frustum culling.
      *
@@ -860,6 +896,7 @@ public class RenderableManager {
     private static native void nBuilderCastShadows(long nativeBuilder, boolean enabled);
     private static native void nBuilderReceiveShadows(long nativeBuilder, boolean enabled);
     private static native void nBuilderScreenSpaceContactShadows(long nativeBuilder, boolean enabled);
+    private static native void nBuilderStaticShadowCaster(long nativeBuilder, boolean enabled);
     private static native void nBuilderSkinning(long nativeBuilder, int boneCount);
     private static native int nBuilderSkinningBones(long nativeBuilder, int boneCount, Buffer bones, int remaining);
     private static native void nBuilderSkinningBuffer(long nativeBuilder, long nativeSkinningBuffer, int boneCount, int offset);
@@ -884,8 +921,10 @@ public class RenderableManager {
     private static native void nSetCastShadows(long nativeRenderableManager, int i, boolean enabled);
     private static native void nSetReceiveShadows(long nativeRenderableManager, int i, boolean enabled);
     private static native void nSetScreenSpaceContactShadows(long nativeRenderableManager, int i, boolean enabled);
+    private static native void nSetStaticShadowCaster(long nativeRenderableManager, int i, boolean enabled);
     private static native boolean nIsShadowCaster(long nativeRenderableManager, int i);
     private static native boolean nIsShadowReceiver(long nativeRenderableManager, int i);
+    private static native boolean nIsStaticShadowCaster(long nativeRenderableManager, int i);
     private static native void nGetAxisAlignedBoundingBox(long nativeRenderableManager, int i, float[] center, float[] halfExtent);
     private static native int nGetPrimitiveCount(long nativeRenderableManager, int i);
     private static native void nSetMaterialInstanceAt(long nativeRenderableManager, int i, int primitiveIndex, long nativeMaterialInstance);
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "DataReshaper.h"
+
+#include <utils/JobSystem.h>
+
+#include <benchmark/benchmark.h>
+
+#include <type_traits>
+#include <vector>
+
+using namespace filament::backend;
+
+// Every benchmark converts a 2048x2048 image, like a large texture upload or a full-screen
+// readPixels(). The "jobs" argument selects between the driver thread only and a JobSystem.
+static constexpr size_t WIDTH = 2048;
+static constexpr size_t HEIGHT = 2048;
+
+template<typename componentType>
+static componentType makeComponent(size_t i) noexcept {
+    if constexpr (std::is_same_v<componentType, float>) {
+        return float(i % 256) / 255.0f;
+    } else {
+        return componentType(i % 256);
+    }
+}
+
+// 3-component to 4-component expansion done before texture uploads, see reshape() in
+// BackendUtils.cpp
+template<typename componentType>
+static void BM_reshape(benchmark::State& state) {
+    utils::JobSystem js;
+    js.adopt();
+    utils::JobSystem* jobSystem = state.range(0) ? &js : nullptr;
+
+    std::vector<componentType> src(WIDTH * HEIGHT * 3);
+    for (size_t i = 0; i < src.size(); i++) {
+        src[i] = makeComponent<componentType>(i);
+    }
+    std::vector<componentType> dst(WIDTH * HEIGHT * 4);
+
+    for (auto _ : state) {
+        DataReshaper::reshape<componentType, 3, 4>(dst.data(), src.data(),
+                src.size() * sizeof(componentType), jobSystem);
+        benchmark::DoNotOptimize(dst.data());
+    }
+    js.emancipate();
+
+    state.SetItemsProcessed(state.iterations() * WIDTH * HEIGHT);
+    state.SetBytesProcessed(state.iterations() * src.size() * sizeof(componentType));
+}
+
+// RGBA readback conversion to the client's PixelBufferDescriptor, see VulkanDriver::readPixels()
+template<typename dstComponentType, typename srcComponentType>
+static void BM_reshapeImage(benchmark::State& state) {
+    utils::JobSystem js;
+    js.adopt();
+    utils::JobSystem* jobSystem = state.range(0) ? &js : nullptr;
+    const size_t dstChannelCount = size_t(state.range(1));
+    const bool swizzle = state.range(2);
+
+    std::vector<srcComponentType> src(WIDTH * HEIGHT * 4);
+    for (size_t i = 0; i < src.size(); i++) {
+        src[i] = makeComponent<srcComponentType>(i);
+    }
+    const size_t srcBytesPerRow = WIDTH * 4 * sizeof(srcComponentType);
+    const size_t dstBytesPerRow = WIDTH * dstChannelCount * sizeof(dstComponentType);
+    std::vector<uint8_t> dst(dstBytesPerRow * HEIGHT);
+
+    for (auto _ : state) {
+        DataReshaper::reshapeImage<dstComponentType, srcComponentType>(dst.data(),
+                (const uint8_t*) src.data(), srcBytesPerRow, dstBytesPerRow, dstChannelCount,
+                HEIGHT, swizzle, false, jobSystem);
+        benchmark::DoNotOptimize(dst.data());
+    }
+    js.emancipate();
+
+    state.SetItemsProcessed(state.iterations() * WIDTH * HEIGHT);
+    state.SetBytesProcessed(state.iterations() * srcBytesPerRow * HEIGHT);
+}
+
+#define RESHAPE_ARGS \
+        ArgNames({"jobs"})->Arg(0)->Arg(1)->UseRealTime()->Unit(benchmark::kMicrosecond)
+
+BENCHMARK_TEMPLATE(BM_reshape, uint8_t)->RESHAPE_ARGS;
+BENCHMARK_TEMPLATE(BM_reshape, uint16_t)->RESHAPE_ARGS;
+BENCHMARK_TEMPLATE(BM_reshape, uint32_t)->RESHAPE_ARGS;
+BENCHMARK_TEMPLATE(BM_reshape, float)->RESHAPE_ARGS;
+
+static void reshapeImageArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"jobs", "channels", "swizzle"});
+    for (int64_t jobs : {0, 1}) {
+        for (int64_t channels : {3, 4}) {
+            for (int64_t swizzle : {0, 1}) {
+                b->Args({jobs, channels, swizzle});
+            }
+        }
+    }
+}
+
+#define RESHAPE_IMAGE_ARGS \
+        Apply(reshapeImageArgs)->UseRealTime()->Unit(benchmark::kMicrosecond)
+
+BENCHMARK_TEMPLATE(BM_reshapeImage, uint8_t, uint8_t)->RESHAPE_IMAGE_ARGS;
+BENCHMARK_TEMPLATE(BM_reshapeImage, uint8_t, float)->RESHAPE_IMAGE_ARGS;
+BENCHMARK_TEMPLATE(BM_reshapeImage, uint8_t, int32_t)->RESHAPE_IMAGE_ARGS;
+BENCHMARK_TEMPLATE(BM_reshapeImage, uint8_t, uint32_t)->RESHAPE_IMAGE_ARGS;
+BENCHMARK_TEMPLATE(BM_reshapeImage, float, uint8_t)->RESHAPE_IMAGE_ARGS;
+BENCHMARK_TEMPLATE(BM_reshapeImage, float, float)->RESHAPE_IMAGE_ARGS;
+BENCHMARK_TEMPLATE(BM_reshapeImage, float, int32_t)->RESHAPE_IMAGE_ARGS;
+BENCHMARK_TEMPLATE(BM_reshapeImage, float, uint32_t)->RESHAPE_IMAGE_ARGS;
+BENCHMARK_TEMPLATE(BM_reshapeImage, int32_t, uint8_t)->RESHAPE_IMAGE_ARGS;
+BENCHMARK_TEMPLATE(BM_reshapeImage, int32_t, float)->RESHAPE_IMAGE_ARGS;
+BENCHMARK_TEMPLATE(BM_reshapeImage, int32_t, int32_t)->RESHAPE_IMAGE_ARGS;
+BENCHMARK_TEMPLATE(BM_reshapeImage, int32_t, uint32_t)->RESHAPE_IMAGE_ARGS;
+BENCHMARK_TEMPLATE(BM_reshapeImage, uint32_t, uint8_t)->RESHAPE_IMAGE_ARGS;
+BENCHMARK_TEMPLATE(BM_reshapeImage, uint32_t, float)->RESHAPE_IMAGE_ARGS;
+BENCHMARK_TEMPLATE(BM_reshapeImage, uint32_t, int32_t)->RESHAPE_IMAGE_ARGS;
+BENCHMARK_TEMPLATE(BM_reshapeImage, uint32_t, uint32_t)->RESHAPE_IMAGE_ARGS;
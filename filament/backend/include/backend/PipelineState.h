@@ -38,6 +38,15 @@ struct PipelineState {
     };
 };
 
+/**
+ * One element of a multiDraw() call. All the records of a multiDraw() call share the same
+ * PipelineState and the same resource bindings, only the primitive and instance count change.
+ */
+struct DrawRecord {
+    Handle<HwRenderPrimitive> primitive;
+    uint32_t instanceCount = 1;
+};
+
 } // namespace filament::backend
 
 #if !defined(NDEBUG)
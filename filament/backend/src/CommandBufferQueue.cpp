@@ -74,6 +74,7 @@ void CommandBufferQueue::flush() noexcept {
 
     // size of this slice
     uint32_t used = uint32_t(intptr_t(head) - intptr_t(tail));
+    mFlushedSize += used;
 
     circularBuffer.circularize();
 
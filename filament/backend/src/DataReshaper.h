@@ -24,7 +24,13 @@
 
 #include <math/scalar.h>
 
+#include <utils/compiler.h>
 #include <utils/debug.h>
+#include <utils/JobSystem.h>
+
+#include <algorithm>
+#include <functional>
+#include <type_traits>
 
 namespace filament {
 namespace backend {
@@ -33,79 +39,75 @@ namespace backend {
 // Also used as a normalization scale when converting between numeric types.
 template<typename componentType> inline componentType getMaxValue();
 
+// The reshapers below are written so that the compiler can turn their inner loops into SIMD
+// shuffles: channel counts and swizzling are template parameters, and source and destination
+// never alias. They can optionally split large images across the jobs of a JobSystem, which
+// must have been adopted by the calling thread.
 class DataReshaper {
 public:
 
+    // Images smaller than this (in pixels for reshape(), in rows for reshapeImage()) are
+    // not split across jobs
+    static constexpr size_t PARALLEL_PIXEL_COUNT = 64 * 1024;
+    static constexpr size_t PARALLEL_ROW_COUNT = 64;
+
     // Adds padding to multi-channel interleaved data by inserting dummy values, or discards
     // trailing channels. This is useful for platforms that only accept 4-component data, since
     // users often wish to submit (or receive) 3-component data.
+    // No caller passes a JobSystem yet: the drivers call this from the driver thread, which
+    // isn't adopted by any JobSystem.
     template<typename componentType, size_t srcChannelCount, size_t dstChannelCount>
-    static void reshape(void* dest, const void* src, size_t numSrcBytes) {
-        const componentType maxValue = getMaxValue<componentType>();
-        const componentType* in = (const componentType*) src;
-        componentType* out = (componentType*) dest;
+    static void reshape(void* dest, const void* src, size_t numSrcBytes,
+            utils::JobSystem* js = nullptr) {
         const size_t width = (numSrcBytes / sizeof(componentType)) / srcChannelCount;
-        const int minChannelCount = filament::math::min(srcChannelCount, dstChannelCount);
-        for (size_t column = 0; column < width; ++column) {
-            for (size_t channel = 0; channel < minChannelCount; ++channel) {
-                out[channel] = in[channel];
-            }
-            for (size_t channel = srcChannelCount; channel < dstChannelCount; ++channel) {
-                out[channel] = maxValue;
-            }
-            in += srcChannelCount;
-            out += dstChannelCount;
-        }
+        auto kernel = [dest, src](size_t start, size_t count) {
+            reshapePixels<componentType, srcChannelCount, dstChannelCount>(
+                    (componentType*) dest + start * dstChannelCount,
+                    (const componentType*) src + start * srcChannelCount, count);
+        };
+        parallelFor<PARALLEL_PIXEL_COUNT>(js, width, kernel);
     }
 
     // Converts a 4-channel image of UBYTE, INT, UINT, or FLOAT to a different type.
+    // No caller passes a JobSystem yet, see reshape().
     template<typename dstComponentType, typename srcComponentType>
     static void reshapeImage(uint8_t* dest, const uint8_t* src,  size_t srcBytesPerRow,
-            size_t dstBytesPerRow, size_t dstChannelCount, size_t height, bool swizzle, bool flip) {
-        const size_t srcChannelCount = 4;
-        const dstComponentType dstMaxValue = getMaxValue<dstComponentType>();
-        const srcComponentType srcMaxValue = getMaxValue<srcComponentType>();
-        const size_t width = (srcBytesPerRow / sizeof(srcComponentType)) / srcChannelCount;
-        const size_t minChannelCount = filament::math::min(srcChannelCount, dstChannelCount);
-        assert_invariant(minChannelCount <= 4);
-        const int inds[4] = {swizzle ? 2 : 0, 1, swizzle ? 0 : 2, 3};
-
-        int srcStride;
-        if (flip) {
-            src += srcBytesPerRow * (height - 1);
-            srcStride = -srcBytesPerRow;
-        } else {
-            srcStride = srcBytesPerRow;
-        }
-
-        for (size_t row = 0; row < height; ++row) {
-            const srcComponentType* in = (const srcComponentType*) src;
-            dstComponentType* out = (dstComponentType*) dest;
-            for (size_t column = 0; column < width; ++column) {
-                for (size_t channel = 0; channel < minChannelCount; ++channel) {
-                    if constexpr (std::is_same_v<dstComponentType, srcComponentType>) {
-                        out[channel] = in[inds[channel]];
-                    } else {
-                        // TODO: beware of overflows in the multiply
-                        // TODO: probably not correct for _INTEGER src/dst
-                        out[channel] = in[inds[channel]] * dstMaxValue / srcMaxValue;
-                    }
-                }
-                for (size_t channel = srcChannelCount; channel < dstChannelCount; ++channel) {
-                    out[channel] = dstMaxValue;
+            size_t dstBytesPerRow, size_t dstChannelCount, size_t height, bool swizzle, bool flip,
+            utils::JobSystem* js = nullptr) {
+        assert_invariant(dstChannelCount >= 1 && dstChannelCount <= 4);
+        using RowReshaper = void(*)(dstComponentType*, const srcComponentType*, size_t);
+        constexpr RowReshaper reshapers[2][4] = {
+                {
+                        reshapeRow<dstComponentType, srcComponentType, 1, false>,
+                        reshapeRow<dstComponentType, srcComponentType, 2, false>,
+                        reshapeRow<dstComponentType, srcComponentType, 3, false>,
+                        reshapeRow<dstComponentType, srcComponentType, 4, false>,
+                },
+                {
+                        reshapeRow<dstComponentType, srcComponentType, 1, true>,
+                        reshapeRow<dstComponentType, srcComponentType, 2, true>,
+                        reshapeRow<dstComponentType, srcComponentType, 3, true>,
+                        reshapeRow<dstComponentType, srcComponentType, 4, true>,
                 }
-                in += srcChannelCount;
-                out += dstChannelCount;
+        };
+        const RowReshaper reshaper = reshapers[swizzle][dstChannelCount - 1];
+        const size_t width = (srcBytesPerRow / sizeof(srcComponentType)) / 4;
+
+        auto kernel = [=](size_t start, size_t count) {
+            for (size_t row = start; row < start + count; ++row) {
+                const size_t srcRow = flip ? height - 1 - row : row;
+                reshaper((dstComponentType*) (dest + row * dstBytesPerRow),
+                        (const srcComponentType*) (src + srcRow * srcBytesPerRow), width);
             }
-            src += srcStride;
-            dest += dstBytesPerRow;
-        }
+        };
+        parallelFor<PARALLEL_ROW_COUNT>(js, height, kernel);
     }
 
     // Converts a 4-channel image of UBYTE, INT, UINT, or FLOAT to a different type.
+    // No caller passes a JobSystem yet, see reshape().
     static bool reshapeImage(PixelBufferDescriptor* dst, PixelDataType srcType,
             const uint8_t* srcBytes, int srcBytesPerRow, int width, int height, bool swizzle,
-            bool flip) {
+            bool flip, utils::JobSystem* js = nullptr) {
         size_t dstChannelCount;
         switch (dst->format) {
             case PixelDataFormat::R_INTEGER: dstChannelCount = 1; break;
@@ -118,8 +120,8 @@ public:
             case PixelDataFormat::RGBA: dstChannelCount = 4; break;
             default: return false;
         }
-        void (*reshaper)(uint8_t*, const uint8_t*, size_t, size_t, size_t, size_t, bool, bool)
-                = nullptr;
+        void (*reshaper)(uint8_t*, const uint8_t*, size_t, size_t, size_t, size_t, bool, bool,
+                utils::JobSystem*) = nullptr;
         constexpr auto UBYTE = PixelDataType::UBYTE, FLOAT = PixelDataType::FLOAT,
                 UINT = PixelDataType::UINT, INT = PixelDataType::INT;
         switch (dst->type) {
@@ -166,12 +168,65 @@ public:
         const int dstBytesPerRow = PixelBufferDescriptor::computeDataSize(dst->format, dst->type,
                 dst->stride ? dst->stride : width, 1, dst->alignment);
         reshaper(dstBytes, srcBytes, srcBytesPerRow, dstBytesPerRow, dstChannelCount, height,
-                swizzle, flip);
+                swizzle, flip, js);
         return true;
     }
 
+private:
+
+    template<typename componentType, size_t srcChannelCount, size_t dstChannelCount>
+    static void reshapePixels(componentType* UTILS_RESTRICT out,
+            const componentType* UTILS_RESTRICT in, size_t count) noexcept {
+        const componentType maxValue = getMaxValue<componentType>();
+        constexpr size_t minChannelCount = std::min(srcChannelCount, dstChannelCount);
+        // one 128-bit register worth of components per iteration
+        #pragma clang loop vectorize_width(16 / sizeof(componentType))
+        for (size_t i = 0; i < count; ++i) {
+            for (size_t channel = 0; channel < minChannelCount; ++channel) {
+                out[i * dstChannelCount + channel] = in[i * srcChannelCount + channel];
+            }
+            for (size_t channel = srcChannelCount; channel < dstChannelCount; ++channel) {
+                out[i * dstChannelCount + channel] = maxValue;
+            }
+        }
+    }
+
+    template<typename dstComponentType, typename srcComponentType,
+            size_t dstChannelCount, bool swizzle>
+    static void reshapeRow(dstComponentType* UTILS_RESTRICT out,
+            const srcComponentType* UTILS_RESTRICT in, size_t width) noexcept {
+        constexpr size_t srcChannelCount = 4;
+        constexpr size_t inds[4] = {swizzle ? 2u : 0u, 1, swizzle ? 0u : 2u, 3};
+        const dstComponentType dstMaxValue = getMaxValue<dstComponentType>();
+        const srcComponentType srcMaxValue = getMaxValue<srcComponentType>();
+        for (size_t column = 0; column < width; ++column) {
+            for (size_t channel = 0; channel < dstChannelCount; ++channel) {
+                const srcComponentType value = in[column * srcChannelCount + inds[channel]];
+                if constexpr (std::is_same_v<dstComponentType, srcComponentType>) {
+                    out[column * dstChannelCount + channel] = value;
+                } else {
+                    // TODO: beware of overflows in the multiply
+                    // TODO: probably not correct for _INTEGER src/dst
+                    out[column * dstChannelCount + channel] = value * dstMaxValue / srcMaxValue;
+                }
+            }
+        }
+    }
+
+    // Calls kernel(start, count) over [0, count), split across jobs when count is large enough
+    template<size_t MIN_COUNT, typename Kernel>
+    static void parallelFor(utils::JobSystem* js, size_t count, Kernel& kernel) {
+        if (!js || count < MIN_COUNT * 2) {
+            kernel(0, count);
+            return;
+        }
+        auto* job = utils::jobs::parallel_for(*js, nullptr, 0, uint32_t(count),
+                std::ref(kernel), utils::jobs::CountSplitter<MIN_COUNT>());
+        js->runAndWait(job);
+    }
 };
 
+
 template<> inline float getMaxValue() { return 1.0f; }
 template<> inline int32_t getMaxValue() { return 0x7fffffff; }
 template<> inline uint32_t getMaxValue() { return 0xffffffff; }
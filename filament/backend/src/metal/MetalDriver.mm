@@ -1411,6 +1411,13 @@ void MetalDriver::draw(PipelineState ps, Handle<HwRenderPrimitive> rph, uint32_t
                                                 instanceCount:instanceCount];
 }
 
+void MetalDriver::multiDraw(PipelineState ps, DrawRecord const* records, uint32_t count) {
+    // For now this is a loop of draw calls. The encoder skips the state that didn't change.
+    for (uint32_t i = 0; i < count; i++) {
+        draw(ps, records[i].primitive, records[i].instanceCount);
+    }
+}
+
 void MetalDriver::beginTimerQuery(Handle<HwTimerQuery> tqh) {
     ASSERT_PRECONDITION(!isInRenderPass(mContext),
             "beginTimerQuery must be called outside of a render pass.");
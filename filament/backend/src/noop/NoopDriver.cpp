@@ -17,6 +17,11 @@
 #include "noop/NoopDriver.h"
 #include "CommandStreamDispatcher.h"
 
+#include <utils/Log.h>
+#include <utils/Systrace.h>
+
+using namespace utils;
+
 namespace filament::backend {
 
 Driver* NoopDriver::create() {
@@ -44,8 +49,17 @@ template class ConcreteDispatcher<NoopDriver>;
 
 
 void NoopDriver::terminate() {
+    Statistics const& stats = mTotalStatistics;
+    if (stats.drawCount) {
+        slog.d << "NoopDriver: "
+               << stats.bindCount << " binds (" << stats.redundantBindCount << " redundant), "
+               << stats.drawCount << " draws (" << stats.redundantPipelineCount
+               << " with redundant pipeline state, "
+               << stats.multiDrawCount << " multi-draws)" << io::endl;
+    }
 }
 
+
 void NoopDriver::tick(int) {
 }
 
@@ -66,6 +80,19 @@ void NoopDriver::setPresentationTime(int64_t monotonic_clock_ns) {
 }
 
 void NoopDriver::endFrame(uint32_t frameId) {
+    SYSTRACE_CONTEXT();
+    Statistics const& stats = mFrameStatistics;
+    SYSTRACE_VALUE32("noop.bindCount", stats.bindCount);
+    SYSTRACE_VALUE32("noop.redundantBindCount", stats.redundantBindCount);
+    SYSTRACE_VALUE32("noop.drawCount", stats.drawCount);
+    SYSTRACE_VALUE32("noop.multiDrawCount", stats.multiDrawCount);
+    SYSTRACE_VALUE32("noop.redundantPipelineCount", stats.redundantPipelineCount);
+    mTotalStatistics.bindCount += stats.bindCount;
+    mTotalStatistics.redundantBindCount += stats.redundantBindCount;
+    mTotalStatistics.drawCount += stats.drawCount;
+    mTotalStatistics.multiDrawCount += stats.multiDrawCount;
+    mTotalStatistics.redundantPipelineCount += stats.redundantPipelineCount;
+    mFrameStatistics = {};
 }
 
 void NoopDriver::flush(int) {
@@ -254,6 +281,8 @@ void NoopDriver::updateSamplerGroup(Handle<HwSamplerGroup> sbh,
 }
 
 void NoopDriver::beginRenderPass(Handle<HwRenderTarget> rth, const RenderPassParams& params) {
+    // the pipeline state doesn't carry over render passes
+    mCurrentPipeline = {};
 }
 
 void NoopDriver::endRenderPass(int) {
@@ -278,13 +307,28 @@ void NoopDriver::commit(Handle<HwSwapChain> sch) {
 }
 
 void NoopDriver::bindUniformBuffer(uint32_t index, Handle<HwBufferObject> ubh) {
+    // a full-buffer binding is recorded with a size of zero
+    bindUniformBufferRange(index, ubh, 0, 0);
 }
 
 void NoopDriver::bindUniformBufferRange(uint32_t index, Handle<HwBufferObject> ubh,
         uint32_t offset, uint32_t size) {
+    assert_invariant(index < CONFIG_BINDING_COUNT);
+    UniformBinding& binding = mUniformBindings[index];
+    mFrameStatistics.bindCount++;
+    if (binding.ubh == ubh && binding.offset == offset && binding.size == size) {
+        mFrameStatistics.redundantBindCount++;
+    }
+    binding = { ubh, offset, size };
 }
 
 void NoopDriver::bindSamplers(uint32_t index, Handle<HwSamplerGroup> sbh) {
+    assert_invariant(index < CONFIG_BINDING_COUNT);
+    mFrameStatistics.bindCount++;
+    if (mSamplerBindings[index] == sbh) {
+        mFrameStatistics.redundantBindCount++;
+    }
+    mSamplerBindings[index] = sbh;
 }
 
 void NoopDriver::insertEventMarker(char const* string, uint32_t len) {
@@ -316,6 +360,27 @@ void NoopDriver::blit(TargetBufferFlags buffers,
 
 void NoopDriver::draw(PipelineState pipelineState, Handle<HwRenderPrimitive> rph,
         uint32_t instanceCount) {
+    PipelineState const& current = mCurrentPipeline;
+    mFrameStatistics.drawCount++;
+    if (current.program == pipelineState.program &&
+            current.rasterState == pipelineState.rasterState &&
+            current.polygonOffset.slope == pipelineState.polygonOffset.slope &&
+            current.polygonOffset.constant == pipelineState.polygonOffset.constant &&
+            current.scissor.left == pipelineState.scissor.left &&
+            current.scissor.bottom == pipelineState.scissor.bottom &&
+            current.scissor.width == pipelineState.scissor.width &&
+            current.scissor.height == pipelineState.scissor.height) {
+        mFrameStatistics.redundantPipelineCount++;
+    }
+    mCurrentPipeline = pipelineState;
+}
+
+void NoopDriver::multiDraw(PipelineState pipelineState, DrawRecord const* records,
+        uint32_t count) {
+    mFrameStatistics.multiDrawCount++;
+    for (uint32_t i = 0; i < count; i++) {
+        draw(pipelineState, records[i].primitive, records[i].instanceCount);
+    }
 }
 
 void NoopDriver::beginTimerQuery(Handle<HwTimerQuery> tqh) {
@@ -54,6 +54,32 @@ private:
     UTILS_ALWAYS_INLINE inline void methodName##R(RetType, paramsDecl) { }
 
 #include "private/backend/DriverAPI.inc"
+
+    /*
+     * Since this driver doesn't do any actual work, it's a convenient place to measure how
+     * much redundant state is sent by the engine. A command is counted as redundant when it
+     * doesn't change the state already set by the previous commands, i.e. when it could have
+     * been elided by the caller.
+     */
+    struct Statistics {
+        uint32_t bindCount = 0;
+        uint32_t redundantBindCount = 0;
+        uint32_t drawCount = 0;
+        uint32_t multiDrawCount = 0;
+        uint32_t redundantPipelineCount = 0;
+    };
+
+    struct UniformBinding {
+        Handle<HwBufferObject> ubh;
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    Statistics mFrameStatistics;
+    Statistics mTotalStatistics;
+    UniformBinding mUniformBindings[CONFIG_BINDING_COUNT] = {};
+    Handle<HwSamplerGroup> mSamplerBindings[CONFIG_BINDING_COUNT];
+    PipelineState mCurrentPipeline;
 };
 
 } // namespace filament
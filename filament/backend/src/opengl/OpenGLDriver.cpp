@@ -30,6 +30,8 @@
 #include <utils/Panic.h>
 #include <utils/Systrace.h>
 
+#include <algorithm>
+
 #if defined(__EMSCRIPTEN__)
 #include <emscripten.h>
 #endif
@@ -208,6 +210,12 @@ void OpenGLDriver::terminate() {
 
     // because we called glFinish(), all callbacks should have been executed
     assert_invariant(mGpuCommandCompleteOps.empty());
+    assert_invariant(!mReadPixelsInFlightCount);
+
+    for (ReadPixelsBuffer const& buffer : mReadPixelsBuffers) {
+        glDeleteBuffers(1, &buffer.pbo);
+    }
+    mReadPixelsBuffers.clear();
 
     for (auto& item : mSamplerMap) {
         mContext.unbindSampler(item.second);
@@ -2622,10 +2630,8 @@ void OpenGLDriver::readPixels(Handle<HwRenderTarget> src,
     GLRenderTarget const* s = handle_cast<GLRenderTarget const*>(src);
     gl.bindFramebuffer(GL_READ_FRAMEBUFFER, s->gl.fbo);
 
-    GLuint pbo;
-    glGenBuffers(1, &pbo);
-    gl.bindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
-    glBufferData(GL_PIXEL_PACK_BUFFER, p.size, nullptr, GL_STATIC_DRAW);
+    ReadPixelsBuffer const buffer = acquireReadPixelsBuffer(GLsizeiptr(p.size));
+    gl.bindBuffer(GL_PIXEL_PACK_BUFFER, buffer.pbo);
     glReadPixels(GLint(x), GLint(y), GLint(width), GLint(height), glFormat, glType, nullptr);
     gl.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
     CHECK_GL_ERROR(utils::slog.e)
@@ -2633,10 +2639,10 @@ void OpenGLDriver::readPixels(Handle<HwRenderTarget> src,
     // we're forced to make a copy on the heap because otherwise it deletes std::function<> copy
     // constructor.
     auto* pUserBuffer = new PixelBufferDescriptor(std::move(p));
-    whenGpuCommandsComplete([this, width, height, pbo, pUserBuffer]() mutable {
+    whenGpuCommandsComplete([this, width, height, buffer, pUserBuffer]() mutable {
         PixelBufferDescriptor& p = *pUserBuffer;
         auto& gl = mContext;
-        gl.bindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+        gl.bindBuffer(GL_PIXEL_PACK_BUFFER, buffer.pbo);
         void* vaddr = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,  p.size, GL_MAP_READ_BIT);
         if (vaddr) {
             // now we need to flip the buffer vertically to match our API
@@ -2655,13 +2661,60 @@ void OpenGLDriver::readPixels(Handle<HwRenderTarget> src,
             glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
         }
         gl.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
-        glDeleteBuffers(1, &pbo);
+        releaseReadPixelsBuffer(buffer);
         scheduleDestroy(std::move(p));
         delete pUserBuffer;
         CHECK_GL_ERROR(utils::slog.e)
     });
 }
 
+OpenGLDriver::ReadPixelsBuffer OpenGLDriver::acquireReadPixelsBuffer(GLsizeiptr size) noexcept {
+    // When the ring is full, wait for the oldest read-backs to complete. Fences signal in
+    // order, so it's enough to wait on the oldest pending ones.
+    auto& ops = mGpuCommandCompleteOps;
+    while (mReadPixelsInFlightCount >= READ_PIXELS_RING_SIZE && !ops.empty()) {
+        GLenum const status = glClientWaitSync(ops.front().first,
+                GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000'000);
+        if (UTILS_UNLIKELY(status == GL_WAIT_FAILED)) {
+            break;
+        }
+        executeGpuCommandsCompleteOps();
+    }
+    mReadPixelsInFlightCount++;
+
+    // reuse a buffer large enough if we have one, otherwise grow one of the others
+    auto& buffers = mReadPixelsBuffers;
+    auto pos = std::find_if(buffers.begin(), buffers.end(),
+            [size](ReadPixelsBuffer const& buffer) { return buffer.size >= size; });
+    if (pos == buffers.end() && !buffers.empty()) {
+        pos = buffers.end() - 1;
+    }
+
+    ReadPixelsBuffer buffer{};
+    if (pos != buffers.end()) {
+        buffer = *pos;
+        buffers.erase(pos);
+    } else {
+        glGenBuffers(1, &buffer.pbo);
+    }
+    if (buffer.size < size) {
+        buffer.size = size;
+        mContext.bindBuffer(GL_PIXEL_PACK_BUFFER, buffer.pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+    }
+    return buffer;
+}
+
+void OpenGLDriver::releaseReadPixelsBuffer(ReadPixelsBuffer buffer) noexcept {
+    assert_invariant(mReadPixelsInFlightCount > 0);
+    mReadPixelsInFlightCount--;
+    if (mReadPixelsBuffers.size() < READ_PIXELS_RING_SIZE) {
+        mReadPixelsBuffers.push_back(buffer);
+    } else {
+        glDeleteBuffers(1, &buffer.pbo);
+    }
+}
+
 void OpenGLDriver::whenGpuCommandsComplete(std::function<void()> fn) noexcept {
     GLsync sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
     mGpuCommandCompleteOps.emplace_back(sync, std::move(fn));
@@ -2953,21 +3006,9 @@ void OpenGLDriver::updateTextureLodRange(GLTexture* texture, int8_t targetLevel)
     }
 }
 
-void OpenGLDriver::draw(PipelineState state, Handle<HwRenderPrimitive> rph, uint32_t instanceCount) {
-    DEBUG_MARKER()
+void OpenGLDriver::drawPrimitive(Handle<HwRenderPrimitive> rph, uint32_t instanceCount) noexcept {
     auto& gl = mContext;
 
-    OpenGLProgram* p = handle_cast<OpenGLProgram*>(state.program);
-
-    // If the material debugger is enabled, avoid fatal (or cascading) errors and that can occur
-    // during the draw call when the program is invalid. The shader compile error has already been
-    // dumped to the console at this point, so it's fine to simply return early.
-    if (FILAMENT_ENABLE_MATDBG && UTILS_UNLIKELY(!p->isValid())) {
-        return;
-    }
-
-    useProgram(p);
-
     GLRenderPrimitive* rp = handle_cast<GLRenderPrimitive *>(rph);
 
     // Gracefully do nothing if the render primitive has not been set up.
@@ -2984,12 +3025,6 @@ void OpenGLDriver::draw(PipelineState state, Handle<HwRenderPrimitive> rph, uint
         updateVertexArrayObject(rp, glvb);
     }
 
-    setRasterState(state.rasterState);
-
-    gl.polygonOffset(state.polygonOffset.slope, state.polygonOffset.constant);
-
-    setViewportScissor(state.scissor);
-
     if (UTILS_LIKELY(instanceCount <= 1)) {
         glDrawRangeElements(GLenum(rp->type), rp->minIndex, rp->maxIndex, rp->count,
                 rp->gl.getIndicesType(), reinterpret_cast<const void*>(rp->offset));
@@ -2998,6 +3033,41 @@ void OpenGLDriver::draw(PipelineState state, Handle<HwRenderPrimitive> rph, uint
                 rp->gl.getIndicesType(), reinterpret_cast<const void*>(rp->offset),
                 instanceCount);
     }
+}
+
+void OpenGLDriver::draw(PipelineState state, Handle<HwRenderPrimitive> rph, uint32_t instanceCount) {
+    DrawRecord const record{ rph, instanceCount };
+    multiDraw(state, &record, 1);
+}
+
+void OpenGLDriver::multiDraw(PipelineState state, DrawRecord const* records, uint32_t count) {
+    DEBUG_MARKER()
+    auto& gl = mContext;
+
+    OpenGLProgram* p = handle_cast<OpenGLProgram*>(state.program);
+
+    // If the material debugger is enabled, avoid fatal (or cascading) errors and that can occur
+    // during the draw call when the program is invalid. The shader compile error has already been
+    // dumped to the console at this point, so it's fine to simply return early.
+    if (FILAMENT_ENABLE_MATDBG && UTILS_UNLIKELY(!p->isValid())) {
+        return;
+    }
+
+    // The pipeline state is the same for all records, so we only need to set it once; this
+    // saves the state-cache lookups that would otherwise be done for each primitive.
+    useProgram(p);
+
+    setRasterState(state.rasterState);
+
+    gl.polygonOffset(state.polygonOffset.slope, state.polygonOffset.constant);
+
+    setViewportScissor(state.scissor);
+
+    // GLES 3.0 doesn't have multi-draw-indirect and our primitives each have their own VAO,
+    // so for now this is a loop of draw calls, only the VAO binding changes between records.
+    for (uint32_t i = 0; i < count; i++) {
+        drawPrimitive(records[i].primitive, records[i].instanceCount);
+    }
 
 #ifdef FILAMENT_ENABLE_MATDBG
     CHECK_GL_ERROR_NON_FATAL(utils::slog.e)
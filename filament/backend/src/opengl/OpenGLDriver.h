@@ -269,6 +269,9 @@ private:
 
     void updateVertexArrayObject(GLRenderPrimitive* rp, GLVertexBuffer const* vb);
 
+    // binds the primitive's VAO and issues the draw call, the pipeline state must be set already
+    void drawPrimitive(Handle<HwRenderPrimitive> rph, uint32_t instanceCount) noexcept;
+
     void framebufferTexture(TargetBufferInfo const& binfo,
             GLRenderTarget const* rt, GLenum attachment) noexcept;
 
@@ -368,6 +371,18 @@ private:
     void executeGpuCommandsCompleteOps() noexcept;
     std::vector<std::pair<GLsync, std::function<void()>>> mGpuCommandCompleteOps;
 
+    // pixel-pack buffers recycled across readPixels() calls. At most READ_PIXELS_RING_SIZE
+    // read-backs are in flight, so rendering the next frames overlaps the oldest read-backs.
+    struct ReadPixelsBuffer {
+        GLuint pbo;
+        GLsizeiptr size;
+    };
+    static constexpr size_t READ_PIXELS_RING_SIZE = 3;
+    ReadPixelsBuffer acquireReadPixelsBuffer(GLsizeiptr size) noexcept;
+    void releaseReadPixelsBuffer(ReadPixelsBuffer buffer) noexcept;
+    std::vector<ReadPixelsBuffer> mReadPixelsBuffers;
+    size_t mReadPixelsInFlightCount = 0;
+
     // tasks regularly executed on the main thread at until they return true
     void runEveryNowAndThen(std::function<bool()> fn) noexcept;
     void executeEveryNowAndThenOps() noexcept;
@@ -1868,6 +1868,15 @@ void VulkanDriver::draw(PipelineState pipelineState, Handle<HwRenderPrimitive> r
     vkCmdDrawIndexed(cmdbuffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstId);
 }
 
+void VulkanDriver::multiDraw(PipelineState pipelineState, DrawRecord const* records,
+        uint32_t count) {
+    // Each primitive binds its own vertex and index buffers, so vkCmdDrawIndexedIndirect can't
+    // be used here. The pipeline and descriptor caches make the repeated state setup cheap.
+    for (uint32_t i = 0; i < count; i++) {
+        draw(pipelineState, records[i].primitive, records[i].instanceCount);
+    }
+}
+
 void VulkanDriver::beginTimerQuery(Handle<HwTimerQuery> tqh) {
     VulkanCommandBuffer const* commands = &mContext.commands->get();
     VulkanTimerQuery* vtq = handle_cast<VulkanTimerQuery*>(tqh);
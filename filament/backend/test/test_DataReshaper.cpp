@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "DataReshaper.h"
+
+#include <utils/JobSystem.h>
+
+#include <array>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include <string.h>
+
+using namespace filament::backend;
+
+namespace {
+
+// The straightforward per-pixel loops the reshapers must match, byte for byte
+
+template<typename componentType, size_t srcChannelCount, size_t dstChannelCount>
+void referenceReshape(componentType* out, const componentType* in, size_t width) {
+    const componentType maxValue = getMaxValue<componentType>();
+    for (size_t column = 0; column < width; ++column) {
+        for (size_t channel = 0; channel < std::min(srcChannelCount, dstChannelCount); ++channel) {
+            out[channel] = in[channel];
+        }
+        for (size_t channel = srcChannelCount; channel < dstChannelCount; ++channel) {
+            out[channel] = maxValue;
+        }
+        in += srcChannelCount;
+        out += dstChannelCount;
+    }
+}
+
+template<typename dstComponentType, typename srcComponentType>
+void referenceReshapeImage(uint8_t* dest, const uint8_t* src, size_t srcBytesPerRow,
+        size_t dstBytesPerRow, size_t dstChannelCount, size_t height, bool swizzle, bool flip) {
+    const dstComponentType dstMaxValue = getMaxValue<dstComponentType>();
+    const srcComponentType srcMaxValue = getMaxValue<srcComponentType>();
+    const size_t width = srcBytesPerRow / sizeof(srcComponentType) / 4;
+    const size_t inds[4] = { swizzle ? 2u : 0u, 1, swizzle ? 0u : 2u, 3 };
+    for (size_t row = 0; row < height; ++row) {
+        const size_t srcRow = flip ? height - 1 - row : row;
+        auto const* in = (const srcComponentType*) (src + srcRow * srcBytesPerRow);
+        auto* out = (dstComponentType*) (dest + row * dstBytesPerRow);
+        for (size_t column = 0; column < width; ++column) {
+            for (size_t channel = 0; channel < dstChannelCount; ++channel) {
+                const srcComponentType value = in[column * 4 + inds[channel]];
+                if constexpr (std::is_same_v<dstComponentType, srcComponentType>) {
+                    out[column * dstChannelCount + channel] = value;
+                } else {
+                    out[column * dstChannelCount + channel] = value * dstMaxValue / srcMaxValue;
+                }
+            }
+        }
+    }
+}
+
+// Integers are in [0, limit). Floats are in [0, 1): the conversions scale 1.0 to exactly 2^31 or
+// 2^32, which doesn't fit in the integer destinations.
+template<typename T>
+std::vector<T> randomComponents(size_t count, uint32_t seed, uint32_t limit = 256) {
+    std::mt19937 generator(seed);
+    std::vector<T> components(count);
+    for (T& component : components) {
+        if constexpr (std::is_floating_point_v<T>) {
+            component = T(generator() % 1000) / T(1000);
+        } else {
+            component = T(generator() % limit);
+        }
+    }
+    return components;
+}
+
+class DataReshaperTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        js.adopt();
+    }
+
+    void TearDown() override {
+        js.emancipate();
+    }
+
+    // without a JobSystem, then with one
+    std::array<utils::JobSystem*, 2> jobSystems() {
+        return { nullptr, &js };
+    }
+
+    template<typename componentType, size_t srcChannelCount, size_t dstChannelCount>
+    void testReshape() {
+        // large enough to be split across jobs, with a remainder
+        const size_t width = DataReshaper::PARALLEL_PIXEL_COUNT * 2 + 17;
+        auto src = randomComponents<componentType>(width * srcChannelCount, 1);
+        std::vector<componentType> expected(width * dstChannelCount);
+        referenceReshape<componentType, srcChannelCount, dstChannelCount>(
+                expected.data(), src.data(), width);
+        for (utils::JobSystem* jobSystem : jobSystems()) {
+            std::vector<componentType> actual(width * dstChannelCount);
+            DataReshaper::reshape<componentType, srcChannelCount, dstChannelCount>(
+                    actual.data(), src.data(), src.size() * sizeof(componentType), jobSystem);
+            EXPECT_EQ(memcmp(actual.data(), expected.data(),
+                    expected.size() * sizeof(componentType)), 0)
+                    << "sizeof(componentType)=" << sizeof(componentType)
+                    << " srcChannelCount=" << srcChannelCount
+                    << " dstChannelCount=" << dstChannelCount
+                    << " jobs=" << (jobSystem != nullptr);
+        }
+    }
+
+    template<typename componentType>
+    void testReshapeChannels() {
+        testReshape<componentType, 3, 3>();
+        testReshape<componentType, 3, 4>();
+        testReshape<componentType, 4, 3>();
+        testReshape<componentType, 4, 4>();
+        testReshape<componentType, 4, 2>();
+    }
+
+    template<typename dstComponentType, typename srcComponentType>
+    void testReshapeImage() {
+        // tall enough to be split across jobs, with a remainder
+        const size_t width = 37;
+        const size_t height = DataReshaper::PARALLEL_ROW_COUNT * 2 + 5;
+        const size_t srcBytesPerRow = width * 4 * sizeof(srcComponentType);
+        // The conversions multiply before dividing (see the TODO in DataReshaper.h). uint8_t
+        // values are promoted to int, and multiplying them by the maximum int32_t value
+        // overflows for any value above 1, so that pair is only tested with 0 and 1.
+        constexpr uint32_t limit = std::is_same_v<dstComponentType, int32_t> &&
+                std::is_same_v<srcComponentType, uint8_t> ? 2 : 256;
+        auto src = randomComponents<srcComponentType>(width * 4 * height, 2, limit);
+        for (size_t dstChannelCount = 1; dstChannelCount <= 4; dstChannelCount++) {
+            // padded rows, which must be left untouched
+            const size_t dstBytesPerRow = width * dstChannelCount * sizeof(dstComponentType) + 4;
+            for (bool swizzle : { false, true }) {
+                for (bool flip : { false, true }) {
+                    std::vector<uint8_t> expected(dstBytesPerRow * height, 0xcd);
+                    referenceReshapeImage<dstComponentType, srcComponentType>(expected.data(),
+                            (const uint8_t*) src.data(), srcBytesPerRow, dstBytesPerRow,
+                            dstChannelCount, height, swizzle, flip);
+                    for (utils::JobSystem* jobSystem : jobSystems()) {
+                        std::vector<uint8_t> actual(dstBytesPerRow * height, 0xcd);
+                        DataReshaper::reshapeImage<dstComponentType, srcComponentType>(
+                                actual.data(), (const uint8_t*) src.data(), srcBytesPerRow,
+                                dstBytesPerRow, dstChannelCount, height, swizzle, flip,
+                                jobSystem);
+                        EXPECT_EQ(actual, expected)
+                                << "sizeof(dstComponentType)=" << sizeof(dstComponentType)
+                                << " sizeof(srcComponentType)=" << sizeof(srcComponentType)
+                                << " dstChannelCount=" << dstChannelCount
+                                << " swizzle=" << swizzle << " flip=" << flip
+                                << " jobs=" << (jobSystem != nullptr);
+                    }
+                }
+            }
+        }
+    }
+
+    template<typename dstComponentType>
+    void testReshapeImageSources() {
+        testReshapeImage<dstComponentType, uint8_t>();
+        testReshapeImage<dstComponentType, float>();
+        testReshapeImage<dstComponentType, int32_t>();
+        testReshapeImage<dstComponentType, uint32_t>();
+    }
+
+    utils::JobSystem js;
+};
+
+} // anonymous namespace
+
+TEST_F(DataReshaperTest, Reshape) {
+    testReshapeChannels<uint8_t>();
+    testReshapeChannels<uint16_t>();
+    testReshapeChannels<uint32_t>();
+    testReshapeChannels<int32_t>();
+    testReshapeChannels<float>();
+}
+
+TEST_F(DataReshaperTest, ReshapeImageToUbyte) {
+    testReshapeImageSources<uint8_t>();
+}
+
+TEST_F(DataReshaperTest, ReshapeImageToFloat) {
+    testReshapeImageSources<float>();
+}
+
+TEST_F(DataReshaperTest, ReshapeImageToInt) {
+    testReshapeImageSources<int32_t>();
+}
+
+TEST_F(DataReshaperTest, ReshapeImageToUint) {
+    testReshapeImageSources<uint32_t>();
+}
+
+TEST_F(DataReshaperTest, ReshapeImageDescriptor) {
+    const int width = 5, height = 3;
+    auto src = randomComponents<float>(width * height * 4, 3);
+    std::vector<uint8_t> expected(width * height * 3);
+    referenceReshapeImage<uint8_t, float>(expected.data(), (const uint8_t*) src.data(),
+            width * 4 * sizeof(float), width * 3, 3, height, true, true);
+
+    std::vector<uint8_t> actual(width * height * 3);
+    PixelBufferDescriptor dst(actual.data(), actual.size(),
+            PixelDataFormat::RGB, PixelDataType::UBYTE, 1);
+    EXPECT_TRUE(DataReshaper::reshapeImage(&dst, PixelDataType::FLOAT,
+            (const uint8_t*) src.data(), width * 4 * sizeof(float), width, height, true, true));
+    EXPECT_EQ(actual, expected);
+
+    // unsupported formats and types
+    PixelBufferDescriptor half(actual.data(), actual.size(),
+            PixelDataFormat::RGB, PixelDataType::HALF, 1);
+    EXPECT_FALSE(DataReshaper::reshapeImage(&half, PixelDataType::FLOAT,
+            (const uint8_t*) src.data(), width * 4 * sizeof(float), width, height, false, false));
+    EXPECT_FALSE(DataReshaper::reshapeImage(&dst, PixelDataType::HALF,
+            (const uint8_t*) src.data(), width * 4 * sizeof(float), width, height, false, false));
+}
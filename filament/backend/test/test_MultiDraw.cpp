@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "BackendTest.h"
+
+#include "ShaderGenerator.h"
+#include "TrianglePrimitive.h"
+
+#include <array>
+#include <vector>
+
+#include <stdlib.h>
+#include <string.h>
+
+using namespace filament;
+using namespace filament::backend;
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Shaders
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string vertex (R"(#version 450 core
+
+layout(location = 0) in vec4 mesh_position;
+
+void main() {
+    gl_Position = vec4(mesh_position.xy, 0.0, 1.0);
+#if defined(TARGET_VULKAN_ENVIRONMENT)
+    // In Vulkan, clip space is Y-down. In OpenGL and Metal, clip space is Y-up.
+    gl_Position.y = -gl_Position.y;
+#endif
+}
+)");
+
+std::string fragment (R"(#version 450 core
+
+layout(location = 0) out vec4 fragColor;
+
+void main() {
+    fragColor = vec4(1.0, 0.0, 0.0, 1.0);
+}
+
+)");
+
+constexpr size_t kSize = 512;
+
+}
+
+namespace test {
+
+// Draws the same triangles with a single multiDraw() call and with one draw() call per triangle
+// in two render targets, the results must be identical.
+TEST_F(BackendTest, MultiDraw) {
+    auto& api = getDriverApi();
+
+    std::array<std::vector<uint8_t>, 2> results;
+
+    // The test is executed within this block scope to force destructors to run before
+    // executeCommands().
+    {
+        // Create a platform-specific SwapChain and make it current.
+        auto swapChain = createSwapChain();
+        api.makeCurrent(swapChain, swapChain);
+
+        // Create a program.
+        ShaderGenerator shaderGen(vertex, fragment, sBackend, sIsMobilePlatform);
+        Program p = shaderGen.getProgram();
+        ProgramHandle program = api.createProgram(std::move(p));
+
+        // Four small triangles, one in each quadrant, the last one is drawn twice (instanced).
+        std::array<TrianglePrimitive, 4> triangles{
+                TrianglePrimitive(api), TrianglePrimitive(api),
+                TrianglePrimitive(api), TrianglePrimitive(api) };
+        const math::float2 offsets[4] = { { -1, -1 }, { 0, -1 }, { -1, 0 }, { 0, 0 } };
+        for (size_t i = 0; i < triangles.size(); i++) {
+            const math::float2 o = offsets[i];
+            const math::float2 vertices[3] = {
+                    o + math::float2{ 0.1, 0.1 }, o + math::float2{ 0.9, 0.1 },
+                    o + math::float2{ 0.1, 0.9 } };
+            triangles[i].updateVertices(vertices);
+        }
+        const uint32_t instanceCounts[4] = { 1, 1, 1, 2 };
+
+        std::array<Handle<HwTexture>, 2> colorTextures;
+        std::array<Handle<HwRenderTarget>, 2> renderTargets;
+        for (size_t i = 0; i < renderTargets.size(); i++) {
+            colorTextures[i] = api.createTexture(SamplerType::SAMPLER_2D, 1,
+                    TextureFormat::RGBA8, 1, kSize, kSize, 1, TextureUsage::COLOR_ATTACHMENT);
+            renderTargets[i] = api.createRenderTarget(TargetBufferFlags::COLOR0,
+                    kSize, kSize, 1, {{ colorTextures[i] }}, {}, {});
+        }
+
+        RenderPassParams params = {};
+        params.flags.clear = TargetBufferFlags::COLOR0;
+        params.viewport = { 0, 0, kSize, kSize };
+        params.clearColor = math::float4(0.0f, 0.0f, 1.0f, 1.0f);
+        params.flags.discardStart = TargetBufferFlags::ALL;
+        params.flags.discardEnd = TargetBufferFlags::NONE;
+
+        PipelineState ps = {};
+        ps.program = program;
+        ps.rasterState.colorWrite = true;
+        ps.rasterState.depthWrite = false;
+        ps.rasterState.depthFunc = RasterState::DepthFunc::A;
+        ps.rasterState.culling = CullingMode::NONE;
+
+        api.makeCurrent(swapChain, swapChain);
+        api.beginFrame(0, 0);
+
+        // all the triangles with a single call
+        api.beginRenderPass(renderTargets[0], params);
+        DrawRecord* const records = api.allocatePod<DrawRecord>(triangles.size());
+        for (size_t i = 0; i < triangles.size(); i++) {
+            records[i] = { triangles[i].getRenderPrimitive(), instanceCounts[i] };
+        }
+        api.multiDraw(ps, records, uint32_t(triangles.size()));
+        api.endRenderPass();
+
+        // and one call per triangle
+        api.beginRenderPass(renderTargets[1], params);
+        for (size_t i = 0; i < triangles.size(); i++) {
+            api.draw(ps, triangles[i].getRenderPrimitive(), instanceCounts[i]);
+        }
+        api.endRenderPass();
+
+        for (size_t i = 0; i < renderTargets.size(); i++) {
+            void* buffer = calloc(1, kSize * kSize * 4);
+            PixelBufferDescriptor pbd(buffer, kSize * kSize * 4, PixelDataFormat::RGBA,
+                    PixelDataType::UBYTE, 1, 0, 0, kSize,
+                    [](void* buffer, size_t size, void* user) {
+                        auto* result = (std::vector<uint8_t>*)user;
+                        result->assign((uint8_t*)buffer, (uint8_t*)buffer + size);
+                        free(buffer);
+                    }, &results[i]);
+            api.readPixels(renderTargets[i], 0, 0, kSize, kSize, std::move(pbd));
+        }
+
+        api.commit(swapChain);
+        api.endFrame(0);
+
+        api.destroyProgram(program);
+        api.destroySwapChain(swapChain);
+        for (size_t i = 0; i < renderTargets.size(); i++) {
+            api.destroyTexture(colorTextures[i]);
+            api.destroyRenderTarget(renderTargets[i]);
+        }
+    }
+
+    flushAndWait();
+    getDriver().purge();
+
+    ASSERT_EQ(results[0].size(), kSize * kSize * 4);
+    ASSERT_EQ(results[1].size(), kSize * kSize * 4);
+    EXPECT_EQ(memcmp(results[0].data(), results[1].data(), results[0].size()), 0);
+
+    // a point inside each triangle must have been drawn (red), the center of the target not;
+    // these points are inside the triangles whether or not the image is flipped vertically.
+    for (math::float2 point : { math::float2{ 0.1, 0.25 }, math::float2{ 0.6, 0.25 },
+            math::float2{ 0.1, 0.75 }, math::float2{ 0.6, 0.75 } }) {
+        const size_t x = size_t(point.x * kSize);
+        const size_t y = size_t(point.y * kSize);
+        EXPECT_EQ(results[0][(y * kSize + x) * 4 + 0], 0xFF);
+        EXPECT_EQ(results[0][(y * kSize + x) * 4 + 2], 0x00);
+    }
+    EXPECT_EQ(results[0][(kSize / 2 * kSize + kSize / 2) * 4 + 2], 0xFF);
+}
+
+} // namespace test
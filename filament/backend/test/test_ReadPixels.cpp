@@ -21,6 +21,8 @@
 
 #include <utils/Hash.h>
 
+#include <array>
+#include <chrono>
 #include <fstream>
 
 using namespace filament;
@@ -79,6 +81,7 @@ namespace test {
 class ReadPixelsTest : public BackendTest {
 public:
     bool readPixelsFinished = false;
+    size_t readPixelsCompletedCount = 0;
 };
 
 TEST_F(ReadPixelsTest, ReadPixels) {
@@ -471,4 +474,105 @@ TEST_F(ReadPixelsTest, ReadPixelsPerformance) {
     executeCommands();
 }
 
+TEST_F(ReadPixelsTest, ReadPixelsThroughput) {
+    // Renders 1080p frames headless and reads each one back without waiting, the way an
+    // offscreen render service would. Read-backs of previous frames overlap the rendering of
+    // the next ones.
+    const size_t width = 1920;
+    const size_t height = 1080;
+    const size_t frameCount = 120;
+    const size_t bufferSize = width * height * 4;
+
+    auto swapChain = getDriverApi().createSwapChainHeadless(width, height, 0);
+    getDriverApi().makeCurrent(swapChain, swapChain);
+
+    ShaderGenerator shaderGen(vertex, fragmentFloat, sBackend, sIsMobilePlatform);
+    Program p = shaderGen.getProgram();
+    auto program = getDriverApi().createProgram(std::move(p));
+
+    auto usage = TextureUsage::COLOR_ATTACHMENT | TextureUsage::SAMPLEABLE;
+    Handle<HwTexture> texture = getDriverApi().createTexture(
+            SamplerType::SAMPLER_2D, 1, TextureFormat::RGBA8, 1, width, height, 1, usage);
+
+    Handle<HwRenderTarget> renderTarget = getDriverApi().createRenderTarget(
+            TargetBufferFlags::COLOR, width, height, 1, {{ texture }}, {}, {});
+
+    TrianglePrimitive triangle(getDriverApi());
+
+    RenderPassParams params = {};
+    params.flags.clear = TargetBufferFlags::COLOR;
+    params.clearColor = {0.f, 0.f, 1.f, 1.f};
+    params.flags.discardStart = TargetBufferFlags::ALL;
+    params.flags.discardEnd = TargetBufferFlags::NONE;
+    params.viewport = { 0, 0, uint32_t(width), uint32_t(height) };
+
+    PipelineState state;
+    state.program = program;
+    state.rasterState.colorWrite = true;
+    state.rasterState.depthWrite = false;
+    state.rasterState.depthFunc = RasterState::DepthFunc::A;
+    state.rasterState.culling = CullingMode::NONE;
+
+    // one client buffer per read-back in flight
+    std::array<void*, 3> buffers{};
+    for (void*& buffer : buffers) {
+        buffer = calloc(1, bufferSize);
+    }
+
+    readPixelsCompletedCount = 0;
+    const auto start = std::chrono::steady_clock::now();
+
+    for (size_t frame = 0; frame < frameCount; ++frame) {
+        // don't overwrite a client buffer whose read-back hasn't been delivered yet
+        while (frame >= readPixelsCompletedCount + buffers.size()) {
+            getDriverApi().tick();
+            executeCommands();
+            getDriver().purge();
+        }
+
+        getDriverApi().makeCurrent(swapChain, swapChain);
+        getDriverApi().beginFrame(0, 0);
+        getDriverApi().tick();
+
+        getDriverApi().beginRenderPass(renderTarget, params);
+        getDriverApi().draw(state, triangle.getRenderPrimitive(), 1);
+        getDriverApi().endRenderPass();
+
+        PixelBufferDescriptor descriptor(buffers[frame % buffers.size()], bufferSize,
+                PixelDataFormat::RGBA, PixelDataType::UBYTE, 1, 0, 0, width,
+                [](void*, size_t, void* user) {
+                    ReadPixelsTest* test = (ReadPixelsTest*) user;
+                    test->readPixelsCompletedCount++;
+                }, this);
+
+        getDriverApi().readPixels(renderTarget, 0, 0, width, height, std::move(descriptor));
+        getDriverApi().commit(swapChain);
+        getDriverApi().endFrame(0);
+        getDriverApi().flush();
+
+        executeCommands();
+        getDriver().purge();
+    }
+
+    flushAndWait();
+    getDriver().purge();
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    printf("ReadPixelsThroughput: %zu frames at %zux%zu in %.3f s, %.1f fps\n",
+            frameCount, width, height, elapsed.count(), double(frameCount) / elapsed.count());
+
+    EXPECT_EQ(readPixelsCompletedCount, frameCount);
+
+    for (void* buffer : buffers) {
+        free(buffer);
+    }
+
+    getDriverApi().destroyProgram(program);
+    getDriverApi().destroySwapChain(swapChain);
+    getDriverApi().destroyRenderTarget(renderTarget);
+    getDriverApi().destroyTexture(texture);
+    getDriverApi().finish();
+    executeCommands();
+}
+
 } // namespace test
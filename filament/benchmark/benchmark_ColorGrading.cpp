@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <filament/ColorGrading.h>
+#include <filament/Engine.h>
+#include <filament/ToneMapper.h>
+
+#include <math/vec3.h>
+
+#include <benchmark/benchmark.h>
+
+using namespace filament;
+using namespace filament::math;
+
+enum class Rebuild {
+    NO_ADJUSTMENTS, // only the tone mapping and output stages run
+    ALL_STAGES,     // an early parameter changes between builds, nothing can be reused
+    LATE_STAGES,    // only a late parameter changes between builds, early stages are cached
+};
+
+// Builds a LUT of the given dimension, changing one parameter between each build.
+static void BM_colorGradingLut(benchmark::State& state, Rebuild rebuild) {
+    Engine* engine = Engine::create(Engine::Backend::NOOP);
+    const ACESToneMapper toneMapper;
+    const uint8_t dim = uint8_t(state.range(0));
+
+    size_t i = 0;
+    for (auto _ : state) {
+        const float change = float(i++ & 1u) * 0.1f;
+        ColorGrading::Builder builder;
+        builder.dimensions(dim).format(ColorGrading::LutFormat::FLOAT).toneMapper(&toneMapper);
+        if (rebuild == Rebuild::ALL_STAGES) {
+            builder.exposure(0.5f + change).contrast(1.2f).saturation(1.1f);
+        } else if (rebuild == Rebuild::LATE_STAGES) {
+            builder.exposure(0.5f).contrast(1.2f).saturation(1.1f + change);
+        }
+        ColorGrading* colorGrading = builder.build(*engine);
+
+        state.PauseTiming();
+        engine->destroy(colorGrading);
+        engine->flushAndWait();
+        state.ResumeTiming();
+    }
+    Engine::destroy(&engine);
+
+    state.SetItemsProcessed(state.iterations() * dim * dim * dim);
+}
+
+BENCHMARK_CAPTURE(BM_colorGradingLut, no_adjustments, Rebuild::NO_ADJUSTMENTS)
+        ->ArgName("dim")->Arg(16)->Arg(32)->Arg(64)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_colorGradingLut, all_stages, Rebuild::ALL_STAGES)
+        ->ArgName("dim")->Arg(16)->Arg(32)->Arg(64)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_colorGradingLut, late_stages, Rebuild::LATE_STAGES)
+        ->ArgName("dim")->Arg(16)->Arg(32)->Arg(64)->UseRealTime()->Unit(benchmark::kMillisecond);
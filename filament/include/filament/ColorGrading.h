@@ -450,6 +450,11 @@ public:
         /**
          * Creates the ColorGrading object and returns a pointer to it.
          *
+         * The engine keeps the intermediate stages of the last color grading LUT built with
+         * adjustments. Building a new ColorGrading that only differs by later stages (for
+         * instance vibrance, saturation, curves or the tone mapper) is therefore faster than
+         * building one that changes early stages such as the exposure or white balance.
+         *
          * @param engine Reference to the filament::Engine to associate this ColorGrading with.
          *
          * @return pointer to the newly created object or nullptr if exceptions are disabled and
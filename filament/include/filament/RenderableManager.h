@@ -251,6 +251,18 @@ public:
          */
         Builder& screenSpaceContactShadows(bool enable) noexcept;
 
+        /**
+         * Hints that this renderable's shadow doesn't change from frame to frame (false by
+         * default). The depth of static shadow casters is kept across frames and only rendered
+         * again when the light, the shadow map's frustum or the set of static casters changes.
+         * Moving a static shadow caster is allowed, but is more expensive than moving a dynamic
+         * one. Changing the geometry, material, bones or morph weights of a static shadow caster
+         * with this RenderableManager is detected, but changing the content of its buffers,
+         * textures or material parameters is not: call setStaticShadowCaster() again after
+         * such changes. This has no effect with ShadowType::VSM.
+         */
+        Builder& staticShadowCaster(bool enable) noexcept;
+
         /**
          * Allows bones to be swapped out and shared using SkinningBuffer.
          *
@@ -475,6 +487,15 @@ public:
      */
     void setScreenSpaceContactShadows(Instance instance, bool enable) noexcept;
 
+    /**
+     * Changes whether or not the renderable is a static shadow caster. When the renderable is,
+     * or was, a static shadow caster, this also causes the static shadow casters to be rendered
+     * again in the next frame.
+     *
+     * \see Builder::staticShadowCaster()
+     */
+    void setStaticShadowCaster(Instance instance, bool enable) noexcept;
+
     /**
      * Checks if the renderable can cast shadows.
      *
@@ -489,6 +510,13 @@ public:
      */
     bool isShadowReceiver(Instance instance) const noexcept;
 
+    /**
+     * Checks if the renderable is a static shadow caster.
+     *
+     * \see Builder::staticShadowCaster().
+     */
+    bool isStaticShadowCaster(Instance instance) const noexcept;
+
     /**
      * Updates the bone transforms in the range [offset, offset + boneCount).
      * The bones must be pre-allocated using Builder::skinning().
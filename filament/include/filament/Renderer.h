@@ -132,6 +132,33 @@ public:
         bool discard = true;
     };
 
+    /**
+     * CPU statistics of a frame, see getFrameStatistics().
+     *
+     * All durations are wall-clock times in nanoseconds. Per-view values are accumulated over
+     * all the views rendered during the frame. Views rendered with renderStandaloneView() or
+     * renderStandaloneViews() are not part of any frame and are not accounted for, except in
+     * driverExecutionTime, which is measured on the driver thread.
+     */
+    struct FrameStatistics {
+        uint32_t frameId = 0;                   //!< id of the frame, 0 if not available
+        uint64_t frameTime = 0;                 //!< from beginFrame() to the end of endFrame()
+        uint64_t scenePrepareTime = 0;          //!< gathering the Scene's renderables and lights
+        uint64_t cullingTime = 0;               //!< renderables and lights culling
+        uint64_t shadowSetupTime = 0;           //!< shadow cameras set-up and casters culling
+        uint64_t froxelizationTime = 0;         //!< lights froxelization (on a worker thread)
+        uint64_t commandGenerationTime = 0;     //!< generation of the color pass commands
+        uint64_t commandSortTime = 0;           //!< sorting of the color pass commands
+        uint64_t frameGraphCompileTime = 0;     //!< compilation of the FrameGraph
+        uint64_t commandEncodingTime = 0;       //!< execution of the FrameGraph passes
+        uint64_t driverExecutionTime = 0;       //!< driver thread busy time since the last frame
+        uint32_t renderableCount = 0;           //!< renderables in the scenes
+        uint32_t visibleRenderableCount = 0;    //!< renderables visible from the cameras
+        uint32_t commandCount = 0;              //!< commands in the color passes
+        uint32_t drawCount = 0;                 //!< draw calls of renderables, post-processing excluded
+        uint32_t commandStreamSize = 0;         //!< bytes of driver commands flushed
+    };
+
     /**
      * Information about the display this Renderer is associated to. This information is needed
      * to accurately compute dynamic-resolution scaling and for frame-pacing.
@@ -149,6 +176,16 @@ public:
      */
     void setClearOptions(const ClearOptions& options);
 
+    /**
+     * Retrieves the CPU statistics of the most recently completed frames, i.e. frames for which
+     * endFrame() has returned. The statistics of the last 16 frames are kept.
+     *
+     * @param out   Array of at least `count` FrameStatistics, filled most recent frame first.
+     * @param count Maximum number of FrameStatistics to retrieve.
+     * @return      The number of FrameStatistics written to `out`.
+     */
+    size_t getFrameStatistics(FrameStatistics* out, size_t count) const noexcept;
+
     /**
      * Get the Engine that created this Renderer.
      *
@@ -492,6 +529,29 @@ public:
      */
     void renderStandaloneView(View const* view);
 
+    /**
+     * Render several standalone Views into their associated RenderTarget
+     *
+     * This call is equivalent to calling renderStandaloneView() for each View, but the
+     * per-frame work is only done once for all of them. Moreover, consecutive Views sharing
+     * the same Scene and world origin gather the Scene's renderables and lights only once,
+     * which makes this well suited for capturing a Scene from many cameras, e.g. for the
+     * six faces of a cubemap.
+     *
+     * @param views An array of `count` pointers to the views to render. Each View must have
+     *              a RenderTarget associated to it.
+     * @param count Number of views in the `views` array.
+     *
+     * @attention
+     * renderStandaloneViews() must be called outside of beginFrame() / endFrame().
+     *
+     * @note
+     * renderStandaloneViews() must be called from the Engine's main thread
+     * (or external synchronization must be provided). In particular, calls to
+     * renderStandaloneViews() on different Renderer instances **must** be synchronized.
+     */
+    void renderStandaloneViews(View const* const* views, size_t count);
+
 
     /**
      * Returns the time in second of the last call to beginFrame(). This value is constant for all
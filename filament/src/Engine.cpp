@@ -83,6 +83,14 @@ Backend Engine::getBackend() const noexcept {
     return upcast(this)->getBackend();
 }
 
+void Engine::setAutomaticInstancingEnabled(bool enable) noexcept {
+    upcast(this)->setAutomaticInstancingEnabled(enable);
+}
+
+bool Engine::isAutomaticInstancingEnabled() const noexcept {
+    return upcast(this)->isAutomaticInstancingEnabled();
+}
+
 Platform* Engine::getPlatform() const noexcept {
     return upcast(this)->getPlatform();
 }
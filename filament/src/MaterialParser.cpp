@@ -99,6 +99,15 @@ ChunkContainer const& MaterialParser::getChunkContainer() const noexcept {
 MaterialParser::ParseResult MaterialParser::parse() noexcept {
     ChunkContainer& cc = getChunkContainer();
     if (cc.parse()) {
+        // Compressed shaders are decompressed on demand and don't use a dictionary.
+        const ChunkType compressedTag = MaterialChunk::getCompressedType(mImpl.mMaterialTag);
+        if (cc.hasChunk(compressedTag)) {
+            mImpl.mMaterialTag = compressedTag;
+            if (!mImpl.mMaterialChunk.readIndex(mImpl.mMaterialTag)) {
+                return ParseResult::ERROR_OTHER;
+            }
+            return ParseResult::SUCCESS;
+        }
         if (!cc.hasChunk(mImpl.mMaterialTag) || !cc.hasChunk(mImpl.mDictionaryTag)) {
             return ParseResult::ERROR_MISSING_BACKEND;
         }
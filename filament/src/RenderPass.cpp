@@ -30,6 +30,7 @@
 #include <utils/JobSystem.h>
 #include <utils/Systrace.h>
 
+#include <memory>
 #include <utility>
 
 using namespace utils;
@@ -68,10 +69,12 @@ void RenderPass::resize(size_t count) noexcept {
 }
 
 void RenderPass::setGeometry(FScene::RenderableSoa const& soa, Range<uint32_t> vr,
-        backend::Handle<backend::HwBufferObject> uboHandle) noexcept {
+        backend::Handle<backend::HwBufferObject> uboHandle,
+        PerRenderableData const* uboData) noexcept {
     mRenderableSoa = &soa;
     mVisibleRenderables = vr;
     mUboHandle = uboHandle;
+    mUboData = uboData;
 }
 
 void RenderPass::setCamera(const CameraInfo& camera) noexcept {
@@ -178,6 +181,115 @@ void RenderPass::sortCommands() noexcept {
             });
 
     resize(uint32_t(last - mCommandBegin));
+
+    if (mUboData && mEngine.isAutomaticInstancingEnabled()) {
+        instancify();
+    }
+}
+
+void RenderPass::instancify() noexcept {
+    SYSTRACE_NAME("instancify");
+
+    auto const* const UTILS_RESTRICT soaSkinning = mRenderableSoa->data<FScene::SKINNING_BUFFER>();
+
+    // Commands that can be drawn with a single instanced draw call must be identical except for
+    // the renderable they belong to. Skinned, morphed and user-instanced renderables don't
+    // qualify because they bind additional per-renderable state.
+    auto canBeInstanced = [soaSkinning](Command const& cmd) {
+        return (cmd.key & CUSTOM_MASK) == uint64_t(CustomCommand::PASS) &&
+                cmd.primitive.instanceCount == 1 &&
+                !cmd.primitive.morphWeightBuffer &&
+                !soaSkinning[cmd.primitive.index].handle;
+    };
+
+    auto isSameDraw = [](Command const& lhs, Command const& rhs) {
+        return (lhs.key & PASS_MASK) == (rhs.key & PASS_MASK) &&
+                lhs.primitive.mi == rhs.primitive.mi &&
+                lhs.primitive.primitiveHandle == rhs.primitive.primitiveHandle &&
+                lhs.primitive.morphTargetBuffer == rhs.primitive.morphTargetBuffer &&
+                lhs.primitive.materialVariant == rhs.primitive.materialVariant &&
+                lhs.primitive.rasterState == rhs.primitive.rasterState;
+    };
+
+    // returns the end of the run of commands that can be drawn together with the first one
+    Command* const end = mCommandEnd;
+    auto findRunEnd = [end, &canBeInstanced, &isSameDraw](Command* first) -> Command* {
+        if (!canBeInstanced(*first)) {
+            return first + 1;
+        }
+        Command* const last = first + std::min(size_t(end - first), CONFIG_MAX_INSTANCES);
+        return std::find_if_not(first + 1, last, [first, &canBeInstanced, &isSameDraw](auto const& c) {
+            return canBeInstanced(c) && isSameDraw(*first, c);
+        });
+    };
+
+    // first, find how many renderables will be instanced, so we can size our UBO
+    uint32_t instancedCount = 0;
+    for (Command* curr = mCommandBegin; curr != end;) {
+        Command* const e = findRunEnd(curr);
+        const uint32_t instanceCount = uint32_t(e - curr);
+        // instanced commands index the UBO with 16 bits
+        if (instanceCount > 1 &&
+                instancedCount + instanceCount <= std::numeric_limits<uint16_t>::max()) {
+            instancedCount += instanceCount;
+        }
+        curr = e;
+    }
+
+    if (!instancedCount) {
+        return;
+    }
+
+    // the instanced UBO is shared by all the passes of the frame, we get our own range of it
+    auto [instancedUboHandle, first] = mEngine.allocateInstancedUbo(instancedCount);
+    if (!instancedUboHandle) {
+        return;
+    }
+    mInstancedUboHandle = instancedUboHandle;
+
+    // then, copy the per-renderable data of each run of identical commands into consecutive
+    // elements of our range, the first command of the run becomes an instanced draw and the
+    // others are turned into sentinels.
+    const size_t size = instancedCount * sizeof(PerRenderableData);
+    auto* const UTILS_RESTRICT stagingBuffer = (PerRenderableData*)malloc(size);
+    PerRenderableData const* const UTILS_RESTRICT uboData = mUboData;
+    uint32_t stagingBufferCount = 0;
+    for (Command* curr = mCommandBegin; curr != end;) {
+        Command* const e = findRunEnd(curr);
+        const uint32_t instanceCount = uint32_t(e - curr);
+        if (instanceCount > 1 && stagingBufferCount + instanceCount <= instancedCount) {
+            for (uint32_t i = 0; i < instanceCount; i++) {
+                memcpy(stagingBuffer + stagingBufferCount + i,
+                        uboData + curr[i].primitive.index, sizeof(PerRenderableData));
+            }
+            for (uint32_t i = 1; i < instanceCount; i++) {
+                curr[i].key = uint64_t(Pass::SENTINEL);
+            }
+            curr->primitive.index = uint16_t(first + stagingBufferCount);
+            curr->primitive.instanceCount = uint16_t(instanceCount);
+            curr->primitive.instanced = true;
+            stagingBufferCount += instanceCount;
+        }
+        curr = e;
+    }
+    assert_invariant(stagingBufferCount == instancedCount);
+
+    mEngine.getDriverApi().updateBufferObject(mInstancedUboHandle, {
+            stagingBuffer, size,
+            +[](void* buffer, size_t, void*) { free(buffer); }
+    }, first * sizeof(PerRenderableData));
+
+    // finally, remove the sentinels, preserving the order of the remaining commands
+    Command* const last = std::remove_if(mCommandBegin, end, [](Command const& c) {
+        return c.key == uint64_t(Pass::SENTINEL);
+    });
+    resize(uint32_t(last - mCommandBegin));
+}
+
+void RenderPass::Test::instancify(RenderPass& pass,
+        Command const* commands, size_t count) noexcept {
+    std::uninitialized_copy_n(commands, count, pass.append(count));
+    pass.instancify();
 }
 
 /* static */
@@ -307,6 +419,8 @@ void RenderPass::generateCommandsImpl(uint32_t extraFlags,
 
     const bool hasShadowing = renderFlags & HAS_SHADOWING;
     const bool viewInverseFrontFaces = renderFlags & HAS_INVERSE_FRONT_FACES;
+    const bool skipStaticShadowCasters = renderFlags & SKIP_STATIC_SHADOW_CASTERS;
+    const bool skipDynamicShadowCasters = renderFlags & SKIP_DYNAMIC_SHADOW_CASTERS;
 
     Command cmdColor;
 
@@ -321,9 +435,11 @@ void RenderPass::generateCommandsImpl(uint32_t extraFlags,
     }
 
     for (uint32_t i = range.first; i < range.last; ++i) {
-        // Check if this renderable passes the visibilityMask. If it doesn't, encode SENTINEL
-        // commands (no-op).
-        if (UTILS_UNLIKELY(!(soaVisibilityMask[i] & visibilityMask))) {
+        // Check if this renderable passes the visibilityMask and isn't filtered out as a
+        // static or dynamic shadow caster. If it doesn't, encode SENTINEL commands (no-op).
+        const bool skipped = soaVisibility[i].staticShadowCaster ?
+                skipStaticShadowCasters : skipDynamicShadowCasters;
+        if (UTILS_UNLIKELY(!(soaVisibilityMask[i] & visibilityMask) || skipped)) {
             // We need to encode a SENTINEL for each command that would have been generated
             // otherwise. Color passes get 2 commands per primitive; depth passes get 1.
             const Slice<FRenderPrimitive>& primitives = soaPrimitives[i];
@@ -574,10 +690,40 @@ void RenderPass::Executor::recordDriverCommands(FEngine& engine,
                 mPolygonOffsetOverride ? &dummyPolyOffset : &pipeline.polygonOffset;
 
         Handle<HwBufferObject> uboHandle = mUboHandle;
+        Handle<HwBufferObject> instancedUboHandle = mInstancedUboHandle;
         FMaterialInstance const* UTILS_RESTRICT mi = nullptr;
         FMaterial const* UTILS_RESTRICT ma = nullptr;
         auto customCommands = mCustomCommands.data();
 
+        // Commands are sorted by material, so consecutive commands often share most of their
+        // state; in particular all primitives of a renderable use the same per-renderable
+        // uniforms. We keep track of what's currently bound and skip the redundant bindings.
+        constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+        uint32_t currentIndex = INVALID_INDEX;
+        Variant currentVariant;
+        Handle<HwBufferObject> currentSkinningHandle;
+        uint32_t currentSkinningOffset = 0;
+        Handle<HwBufferObject> currentMorphWeightBuffer;
+        Handle<HwSamplerGroup> currentMorphTargetBuffer;
+        uint32_t elidedCommandCount = 0;
+        uint32_t multiDrawCount = 0;
+        uint32_t drawCount = 0;
+
+        // Returns whether a command can be drawn with the same pipeline state and bindings as
+        // the one described by `info`, this is typically the case of the primitives of a
+        // renderable that use the same material instance.
+        auto canShareDraw = [](PrimitiveInfo const& info, Command const& command) noexcept {
+            PrimitiveInfo const& other = command.primitive;
+            return (command.key & CUSTOM_MASK) == uint64_t(CustomCommand::PASS) &&
+                    other.mi == info.mi &&
+                    other.materialVariant == info.materialVariant &&
+                    other.rasterState == info.rasterState &&
+                    other.index == info.index &&
+                    other.instanced == info.instanced &&
+                    other.morphWeightBuffer == info.morphWeightBuffer &&
+                    other.morphTargetBuffer == info.morphTargetBuffer;
+        };
+
         first--;
         while (++first != last) {
             /*
@@ -588,6 +734,12 @@ void RenderPass::Executor::recordDriverCommands(FEngine& engine,
                 uint32_t index = (first->key & CUSTOM_INDEX_MASK) >> CUSTOM_INDEX_SHIFT;
                 assert_invariant(index < mCustomCommands.size());
                 customCommands[index]();
+                // a custom command can change any state, forget everything we know
+                mi = nullptr;
+                currentIndex = INVALID_INDEX;
+                currentSkinningHandle.clear();
+                currentMorphWeightBuffer.clear();
+                currentMorphTargetBuffer.clear();
                 continue;
             }
 
@@ -607,36 +759,94 @@ void RenderPass::Executor::recordDriverCommands(FEngine& engine,
                 pipeline.scissor = mi->getScissor();
                 *pPipelinePolygonOffset = mi->getPolygonOffset();
                 mi->use(driver);
+                pipeline.program = ma->getProgram(info.materialVariant);
+                currentVariant = info.materialVariant;
+            } else if (UTILS_UNLIKELY(currentVariant != info.materialVariant)) {
+                pipeline.program = ma->getProgram(info.materialVariant);
+                currentVariant = info.materialVariant;
             }
 
-            pipeline.program = ma->getProgram(info.materialVariant);
-            size_t offset = info.index * sizeof(PerRenderableUib);
-            driver.bindUniformBufferRange(BindingPoints::PER_RENDERABLE,
-                    uboHandle, offset, sizeof(PerRenderableUib));
+            // instanced commands index the instanced UBO, they're never skinned or morphed
+            const uint32_t index = info.index | (uint32_t(info.instanced) << 16u);
+            if (UTILS_UNLIKELY(currentIndex != index)) {
+                currentIndex = index;
+                size_t offset = info.index * sizeof(PerRenderableData);
+                driver.bindUniformBufferRange(BindingPoints::PER_RENDERABLE,
+                        info.instanced ? instancedUboHandle : uboHandle,
+                        offset, sizeof(PerRenderableUib));
+            } else {
+                elidedCommandCount++;
+            }
 
-            auto skinning = soaSkinning[info.index];
+            auto skinning = info.instanced ? FRenderableManager::SkinningBindingInfo{} :
+                    soaSkinning[info.index];
             if (UTILS_UNLIKELY(skinning.handle)) {
-                // note: we can't bind less than CONFIG_MAX_BONE_COUNT due to glsl limitations
-                driver.bindUniformBufferRange(BindingPoints::PER_RENDERABLE_BONES,
-                        skinning.handle,
-                        skinning.offset * sizeof(PerRenderableUibBone),
-                        CONFIG_MAX_BONE_COUNT * sizeof(PerRenderableUibBone));
+                if (skinning.handle != currentSkinningHandle ||
+                        skinning.offset != currentSkinningOffset) {
+                    currentSkinningHandle = skinning.handle;
+                    currentSkinningOffset = skinning.offset;
+                    // note: we can't bind less than CONFIG_MAX_BONE_COUNT due to glsl limitations
+                    driver.bindUniformBufferRange(BindingPoints::PER_RENDERABLE_BONES,
+                            skinning.handle,
+                            skinning.offset * sizeof(PerRenderableUibBone),
+                            CONFIG_MAX_BONE_COUNT * sizeof(PerRenderableUibBone));
+                } else {
+                    elidedCommandCount++;
+                }
                 // note: even if skinning is only enabled, binding morphTargetBuffer is needed.
-                driver.bindSamplers(BindingPoints::PER_RENDERABLE_MORPHING,
-                        info.morphTargetBuffer);
+                if (info.morphTargetBuffer != currentMorphTargetBuffer) {
+                    currentMorphTargetBuffer = info.morphTargetBuffer;
+                    driver.bindSamplers(BindingPoints::PER_RENDERABLE_MORPHING,
+                            info.morphTargetBuffer);
+                } else {
+                    elidedCommandCount++;
+                }
             }
 
             if (UTILS_UNLIKELY(info.morphWeightBuffer)) {
                 // Instead of using a UBO per primitive, we could also have a single UBO for all
                 // primitives and use bindUniformBufferRange which might be more efficient.
-                driver.bindUniformBuffer(BindingPoints::PER_RENDERABLE_MORPHING,
-                        info.morphWeightBuffer);
-                driver.bindSamplers(BindingPoints::PER_RENDERABLE_MORPHING,
-                        info.morphTargetBuffer);
+                if (info.morphWeightBuffer != currentMorphWeightBuffer) {
+                    currentMorphWeightBuffer = info.morphWeightBuffer;
+                    driver.bindUniformBuffer(BindingPoints::PER_RENDERABLE_MORPHING,
+                            info.morphWeightBuffer);
+                } else {
+                    elidedCommandCount++;
+                }
+                if (info.morphTargetBuffer != currentMorphTargetBuffer) {
+                    currentMorphTargetBuffer = info.morphTargetBuffer;
+                    driver.bindSamplers(BindingPoints::PER_RENDERABLE_MORPHING,
+                            info.morphTargetBuffer);
+                } else {
+                    elidedCommandCount++;
+                }
             }
 
-            driver.draw(pipeline, info.primitiveHandle, info.instanceCount);
+            Command const* runEnd = first + 1;
+            while (runEnd != last && canShareDraw(info, *runEnd)) {
+                runEnd++;
+            }
+
+            const size_t count = runEnd - first;
+            drawCount++;
+            if (UTILS_LIKELY(count == 1)) {
+                driver.draw(pipeline, info.primitiveHandle, info.instanceCount);
+            } else {
+                // all the bindings are already set, submit the whole run at once
+                DrawRecord* const UTILS_RESTRICT records = driver.allocatePod<DrawRecord>(count);
+                for (size_t i = 0; i < count; i++) {
+                    records[i].primitive = first[i].primitive.primitiveHandle;
+                    records[i].instanceCount = first[i].primitive.instanceCount;
+                }
+                driver.multiDraw(pipeline, records, uint32_t(count));
+                multiDrawCount++;
+                first = runEnd - 1;
+            }
         }
+
+        SYSTRACE_VALUE32("elidedCommandCount", elidedCommandCount);
+        SYSTRACE_VALUE32("multiDrawCount", multiDrawCount);
+        engine.addRenderPassDrawCount(drawCount);
     }
 }
 
@@ -645,6 +855,7 @@ void RenderPass::Executor::recordDriverCommands(FEngine& engine,
 RenderPass::Executor::Executor(RenderPass const* pass, Command const* b, Command const* e) noexcept
         : mEngine(pass->mEngine), mBegin(b), mEnd(e), mRenderableSoa(*pass->mRenderableSoa),
           mCustomCommands(pass->mCustomCommands), mUboHandle(pass->mUboHandle),
+          mInstancedUboHandle(pass->mInstancedUboHandle),
           mPolygonOffset(pass->mPolygonOffset),
           mPolygonOffsetOverride(pass->mPolygonOffsetOverride) {
     assert_invariant(b >= pass->begin());
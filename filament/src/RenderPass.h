@@ -42,6 +42,7 @@
 namespace filament {
 
 class FMaterialInstance;
+struct PerRenderableData;
 
 class RenderPass {
 public:
@@ -225,7 +226,8 @@ public:
         uint16_t instanceCount;                                         // 2 bytes
         backend::RasterState rasterState;                               // 8 bytes
         Variant materialVariant;                                        // 1 byte
-        uint8_t reserved1[7] = {};                                      // 7 bytes
+        bool instanced = false;                                         // 1 byte
+        uint8_t reserved1[6] = {};                                      // 6 bytes
     };
     static_assert(sizeof(PrimitiveInfo) == 40);
 
@@ -246,6 +248,9 @@ public:
     using RenderFlags = uint8_t;
     static constexpr RenderFlags HAS_SHADOWING           = 0x01;
     static constexpr RenderFlags HAS_INVERSE_FRONT_FACES = 0x02;
+    // these select a subset of the renderables, see RenderableManager::Builder::staticShadowCaster()
+    static constexpr RenderFlags SKIP_STATIC_SHADOW_CASTERS  = 0x04;
+    static constexpr RenderFlags SKIP_DYNAMIC_SHADOW_CASTERS = 0x08;
 
     // Arena used for commands
     using Arena = utils::Arena<
@@ -271,8 +276,10 @@ public:
     void overridePolygonOffset(backend::PolygonOffset* polygonOffset) noexcept;
 
     // specifies the geometry to generate commands for
+    // uboData is the CPU copy of the UBO's content, it's only needed for automatic instancing.
     void setGeometry(FScene::RenderableSoa const& soa, utils::Range<uint32_t> vr,
-            backend::Handle<backend::HwBufferObject> uboHandle) noexcept;
+            backend::Handle<backend::HwBufferObject> uboHandle,
+            PerRenderableData const* uboData = nullptr) noexcept;
 
     // specifies camera information (e.g. used for sorting commands)
     void setCamera(const CameraInfo& camera) noexcept;
@@ -298,6 +305,8 @@ public:
     void appendCommands(CommandTypeFlags commandTypeFlags) noexcept;
 
     // sorts commands, then trims sentinels
+    // With automatic instancing, runs of identical draw commands are then merged into
+    // instanced draw commands.
     void sortCommands() noexcept;
 
     // Helper to execute all the commands generated by this RenderPass
@@ -322,6 +331,7 @@ public:
         FScene::RenderableSoa const& mRenderableSoa;
         const CustomCommandVector mCustomCommands;
         const backend::Handle<backend::HwBufferObject> mUboHandle;
+        const backend::Handle<backend::HwBufferObject> mInstancedUboHandle;
         const backend::PolygonOffset mPolygonOffset;
         const bool mPolygonOffsetOverride;
 
@@ -353,12 +363,19 @@ public:
     void appendCustomCommand(Pass pass, CustomCommand custom, uint32_t order,
             Executor::CustomCommandFn command);
 
+    struct UTILS_PUBLIC Test {
+        // Appends the given (sorted) commands to the pass and merges them with automatic
+        // instancing, as sortCommands() does. setGeometry() must have been called.
+        static void instancify(RenderPass& pass, Command const* commands, size_t count) noexcept;
+    };
+
 
 private:
     friend class FRenderer;
 
     Command* append(size_t count) noexcept;
     void resize(size_t count) noexcept;
+    void instancify() noexcept;
 
     // on 64-bits systems, we process batches of 256 (64 bytes) cache-lines, or 512 (32 bytes) commands
     // on 32-bits systems, we process batches of 512 (32 bytes) cache-lines, or 512 (32 bytes) commands
@@ -408,6 +425,12 @@ private:
     // the UBO containing the data for the renderables
     backend::Handle<backend::HwBufferObject> mUboHandle;
 
+    // CPU copy of the data above, only set when automatic instancing is enabled
+    PerRenderableData const* mUboData = nullptr;
+
+    // the UBO containing the data of instanced renderables, owned by the engine
+    backend::Handle<backend::HwBufferObject> mInstancedUboHandle;
+
     // info about the camera
     math::float3 mCameraPosition{};
     math::float3 mCameraForwardVector{};
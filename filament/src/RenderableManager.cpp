@@ -68,6 +68,10 @@ void RenderableManager::setScreenSpaceContactShadows(Instance instance, bool ena
     upcast(this)->setScreenSpaceContactShadows(instance, enable);
 }
 
+void RenderableManager::setStaticShadowCaster(Instance instance, bool enable) noexcept {
+    upcast(this)->setStaticShadowCaster(instance, enable);
+}
+
 bool RenderableManager::isShadowCaster(Instance instance) const noexcept {
     return upcast(this)->isShadowCaster(instance);
 }
@@ -76,6 +80,10 @@ bool RenderableManager::isShadowReceiver(Instance instance) const noexcept {
     return upcast(this)->isShadowReceiver(instance);
 }
 
+bool RenderableManager::isStaticShadowCaster(Instance instance) const noexcept {
+    return upcast(this)->isStaticShadowCaster(instance);
+}
+
 const Box& RenderableManager::getAxisAlignedBoundingBox(Instance instance) const noexcept {
     return upcast(this)->getAxisAlignedBoundingBox(instance);
 }
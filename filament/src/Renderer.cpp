@@ -81,8 +81,16 @@ void Renderer::setClearOptions(const ClearOptions& options) {
     upcast(this)->setClearOptions(options);
 }
 
+size_t Renderer::getFrameStatistics(FrameStatistics* out, size_t count) const noexcept {
+    return upcast(this)->getFrameStatistics(out, count);
+}
+
 void Renderer::renderStandaloneView(View const* view) {
     upcast(this)->renderStandaloneView(upcast(view));
 }
 
+void Renderer::renderStandaloneViews(View const* const* views, size_t count) {
+    upcast(this)->renderStandaloneViews(views, count);
+}
+
 } // namespace filament
@@ -26,8 +26,12 @@
 #include <backend/DriverEnums.h>
 
 #include <utils/debug.h>
+#include <utils/FixedCapacityVector.h>
+#include <utils/JobSystem.h>
 #include <utils/Systrace.h>
 
+#include <algorithm>
+#include <functional>
 #include <limits>
 
 using namespace utils;
@@ -75,7 +79,8 @@ ShadowMap::~ShadowMap() {
 void ShadowMap::render(FScene const& scene, utils::Range<uint32_t> range,
         FScene::VisibleMaskType visibilityMask, RenderPass* const pass) noexcept {
     pass->setVisibilityMask(visibilityMask);
-    pass->setGeometry(scene.getRenderableData(), range, scene.getRenderableUBO());
+    pass->setGeometry(scene.getRenderableData(), range, scene.getRenderableUBO(),
+            scene.getRenderableUBOData());
     pass->overridePolygonOffset(&mShadowMapInfo.polygonOffset);
     pass->appendCommands(RenderPass::SHADOW);
     pass->sortCommands();
@@ -131,8 +136,8 @@ void ShadowMap::updateDirectional(const FScene::LightSoa& lightData, size_t inde
     // This will be adjusted later because of how we compute the depth metric for VSM.
     const mat4f MvAtOrigin = getDirectionalLightViewMatrix(direction);
 
-    // Compute scene-dependent values shared across all cascades
-    ShadowMap::updateSceneInfo(MvAtOrigin, scene, sceneInfo);
+    // Scene-dependent values shared across all cascades, including sceneInfo.lsNearFar which
+    // was computed for MvAtOrigin, were set by initSceneInfo().
 
     const Aabb wsShadowCastersVolume = sceneInfo.wsShadowCastersVolume;
     const Aabb wsShadowReceiversVolume = sceneInfo.wsShadowReceiversVolume;
@@ -406,8 +411,7 @@ void ShadowMap::updateSpot(const FScene::LightSoa& lightData, size_t index,
     // Choose a reasonable value for the near plane.
     const mat4f Mv = getDirectionalLightViewMatrix(direction, position);
 
-    // find decent near/far
-    ShadowMap::updateSceneInfo(Mv, scene, sceneInfo, mShadowMapInfo.spotIndex);
+    // find decent near/far, sceneInfo.lsNearFar was computed by cullShadowCasters()
     // FIXME: we need a configuration for minimum near plane (for now hardcoded to 1cm)
     float nearPlane = std::max(0.01f, -sceneInfo.lsNearFar.x);
     float farPlane  = std::min(radius, -sceneInfo.lsNearFar.y);
@@ -566,12 +570,14 @@ mat4 ShadowMap::getTextureCoordsMapping() const noexcept {
             0.0f, 0.0f, 0.0f, 1.0f
     });
 
-    // apply the 1-texel border viewport transform
-    const float o = 1.0f / mShadowMapInfo.atlasDimension;
-    const float s = 1.0f - 2.0f * (1.0f / mShadowMapInfo.textureDimension);
+    // apply the border viewport transform, and move the shadow map to its place in the atlas
+    const float border = float(mShadowMapInfo.border);
+    const float2 o = (float2(mShadowMapInfo.atlasOffset) + border) /
+            float(mShadowMapInfo.atlasDimension);
+    const float s = 1.0f - 2.0f * (border / mShadowMapInfo.textureDimension);
     const mat4f Mb(mat4f::row_major_init{
-             s,    0.0f, 0.0f, o,
-             0.0f, s,    0.0f, o,
+             s,    0.0f, 0.0f, o.x,
+             0.0f, s,    0.0f, o.y,
              0.0f, 0.0f, 1.0f, 0.0f,
              0.0f, 0.0f, 0.0f, 1.0f
     });
@@ -1022,91 +1028,173 @@ float ShadowMap::texelSizeWorldSpace(const mat4f& Wp, const mat4f& MbMtF) const
     return s;
 }
 
-template<typename Casters, typename Receivers>
-void ShadowMap::visitScene(const FScene& scene, uint32_t visibleLayers,
-        Casters casters, Receivers receivers) noexcept {
+template<typename ProcessChunk>
+void ShadowMap::forEachChunk(JobSystem& js, size_t count, size_t cost,
+        ProcessChunk const& processChunk) noexcept {
+    // below this, the overhead of the JobSystem is larger than the work
+    constexpr size_t PARALLEL_THRESHOLD = 8192;
+
+    const uint32_t chunkCount = uint32_t(getSceneChunkCount(count));
+    auto work = [&processChunk, count](uint32_t start, uint32_t c) {
+        for (uint32_t chunk = start; chunk < start + c; chunk++) {
+            const uint32_t first = chunk * SCENE_CHUNK_SIZE;
+            processChunk(chunk, first, std::min(SCENE_CHUNK_SIZE, uint32_t(count) - first));
+        }
+    };
+
+    if (chunkCount > 1 && count * cost >= PARALLEL_THRESHOLD) {
+        auto* job = jobs::parallel_for(js, nullptr, 0, chunkCount,
+                std::cref(work), jobs::CountSplitter<1, 8>());
+        js.runAndWait(job);
+    } else {
+        work(0, chunkCount);
+    }
+}
+
+void ShadowMap::initSceneInfo(JobSystem& js, FScene const& scene, mat4f const& viewMatrix,
+        mat4f const* directionalLightViewMatrix, ShadowMap::SceneInfo& sceneInfo) {
     SYSTRACE_CALL();
 
+    // We assume the light is at the origin to compute the SceneInfo. This is consumed later by
+    // computeShadowCameraDirectional() which takes this into account.
+
+    // Compute scene bounds in world space, as well as the light-space and view-space near/far
+    // planes. Each chunk of the scene is reduced separately, then the chunks are merged.
+    auto extend = [](Aabb& aabb, Aabb const& other) {
+        aabb.min = min(aabb.min, other.min);
+        aabb.max = max(aabb.max, other.max);
+    };
+
+    struct Bounds {
+        Aabb wsShadowCastersVolume;
+        Aabb wsShadowReceiversVolume;
+        float2 vsNearFar = {
+                std::numeric_limits<float>::lowest(), std::numeric_limits<float>::max() };
+        float2 lsNearFar = {
+                std::numeric_limits<float>::lowest(), std::numeric_limits<float>::max() };
+    };
+
     using State = FRenderableManager::Visibility;
     FScene::RenderableSoa const& UTILS_RESTRICT soa = scene.getRenderableData();
     float3 const* const UTILS_RESTRICT worldAABBCenter = soa.data<FScene::WORLD_AABB_CENTER>();
     float3 const* const UTILS_RESTRICT worldAABBExtent = soa.data<FScene::WORLD_AABB_EXTENT>();
     uint8_t const* const UTILS_RESTRICT layers = soa.data<FScene::LAYERS>();
     State const* const UTILS_RESTRICT visibility = soa.data<FScene::VISIBILITY_STATE>();
-    auto const* const UTILS_RESTRICT visibleMasks = soa.data<FScene::VISIBLE_MASK>();
-    size_t c = soa.size();
-    for (size_t i = 0; i < c; i++) {
-        if (layers[i] & visibleLayers) {
+    const uint8_t visibleLayers = sceneInfo.visibleLayers;
+
+    const size_t count = soa.size();
+    auto chunkBounds = FixedCapacityVector<Bounds>::with_capacity(getSceneChunkCount(count));
+    chunkBounds.resize(chunkBounds.capacity());
+
+    forEachChunk(js, count, 1, [&](uint32_t chunk, uint32_t first, uint32_t c) {
+        Bounds bounds;
+        for (size_t i = first; i < first + c; i++) {
+            if (!(layers[i] & visibleLayers)) {
+                continue;
+            }
             const Aabb aabb{ worldAABBCenter[i] - worldAABBExtent[i],
                              worldAABBCenter[i] + worldAABBExtent[i] };
             if (visibility[i].castShadows) {
-                casters(aabb, visibleMasks[i]);
+                extend(bounds.wsShadowCastersVolume, aabb);
+                if (directionalLightViewMatrix) {
+                    const float2 nf = computeNearFar(*directionalLightViewMatrix, aabb);
+                    bounds.lsNearFar.x = std::max(bounds.lsNearFar.x, nf.x);  // near
+                    bounds.lsNearFar.y = std::min(bounds.lsNearFar.y, nf.y);  // far
+                }
             }
             if (visibility[i].receiveShadows) {
-                receivers(aabb, visibleMasks[i]);
+                extend(bounds.wsShadowReceiversVolume, aabb);
+                const float2 nf = computeNearFar(viewMatrix, aabb);
+                bounds.vsNearFar.x = std::max(bounds.vsNearFar.x, nf.x);
+                bounds.vsNearFar.y = std::min(bounds.vsNearFar.y, nf.y);
             }
         }
+        chunkBounds[chunk] = bounds;
+    });
+
+    Bounds bounds;
+    for (Bounds const& b : chunkBounds) {
+        extend(bounds.wsShadowCastersVolume, b.wsShadowCastersVolume);
+        extend(bounds.wsShadowReceiversVolume, b.wsShadowReceiversVolume);
+        bounds.vsNearFar.x = std::max(bounds.vsNearFar.x, b.vsNearFar.x);
+        bounds.vsNearFar.y = std::min(bounds.vsNearFar.y, b.vsNearFar.y);
+        bounds.lsNearFar.x = std::max(bounds.lsNearFar.x, b.lsNearFar.x);
+        bounds.lsNearFar.y = std::min(bounds.lsNearFar.y, b.lsNearFar.y);
     }
-}
 
-void ShadowMap::initSceneInfo(FScene const& scene, mat4f const& viewMatrix,
-        ShadowMap::SceneInfo& sceneInfo) {
-    sceneInfo.vsNearFar = { std::numeric_limits<float>::lowest(), std::numeric_limits<float>::max() };
+    sceneInfo.wsShadowCastersVolume = bounds.wsShadowCastersVolume;
+    sceneInfo.wsShadowReceiversVolume = bounds.wsShadowReceiversVolume;
+    sceneInfo.vsNearFar = bounds.vsNearFar;
+    sceneInfo.lsNearFar = bounds.lsNearFar;
+}
 
-    // We assume the light is at the origin to compute the SceneInfo. This is consumed later by
-    // computeShadowCameraDirectional() which takes this into account.
+void ShadowMap::cullShadowCasters(JobSystem& js, FScene::RenderableSoa& soa,
+        uint8_t visibleLayers, Frustum const* directionalFrustum,
+        Slice<SpotCullingInfo> spots) noexcept {
+    SYSTRACE_CALL();
 
-    // Compute scene bounds in world space, as well as the light-space and view-space near/far planes
-    sceneInfo.wsShadowCastersVolume = {};
-    sceneInfo.wsShadowReceiversVolume = {};
-    visitScene(scene, sceneInfo.visibleLayers,
-            [&](Aabb caster, Culler::result_type) {
-                sceneInfo.wsShadowCastersVolume.min =
-                        min(sceneInfo.wsShadowCastersVolume.min, caster.min);
-                sceneInfo.wsShadowCastersVolume.max =
-                        max(sceneInfo.wsShadowCastersVolume.max, caster.max);
-            },
-            [&](Aabb receiver, Culler::result_type) {
-                sceneInfo.wsShadowReceiversVolume.min =
-                        min(sceneInfo.wsShadowReceiversVolume.min, receiver.min);
-                sceneInfo.wsShadowReceiversVolume.max =
-                        max(sceneInfo.wsShadowReceiversVolume.max, receiver.max);
-                float2 nf = ShadowMap::computeNearFar(viewMatrix, receiver);
-                sceneInfo.vsNearFar.x = std::max(sceneInfo.vsNearFar.x, nf.x);
-                sceneInfo.vsNearFar.y = std::min(sceneInfo.vsNearFar.y, nf.y);
-            }
-    );
-}
+    using State = FRenderableManager::Visibility;
+    float3 const* const UTILS_RESTRICT worldAABBCenter = soa.data<FScene::WORLD_AABB_CENTER>();
+    float3 const* const UTILS_RESTRICT worldAABBExtent = soa.data<FScene::WORLD_AABB_EXTENT>();
+    uint8_t const* const UTILS_RESTRICT layers = soa.data<FScene::LAYERS>();
+    State const* const UTILS_RESTRICT visibility = soa.data<FScene::VISIBILITY_STATE>();
+    Culler::result_type* const UTILS_RESTRICT visibleMasks = soa.data<FScene::VISIBLE_MASK>();
+
+    const size_t count = soa.size();
+    const size_t spotCount = spots.size();
+
+    // near/far of each spot light's shadow casters, for each chunk
+    auto chunkNearFar = FixedCapacityVector<float2>::with_capacity(
+            getSceneChunkCount(count) * spotCount);
+    chunkNearFar.resize(chunkNearFar.capacity());
+
+    forEachChunk(js, count, spotCount + 1, [&](uint32_t chunk, uint32_t first, uint32_t c) {
+        Culler::result_type* const UTILS_RESTRICT masks = visibleMasks + first;
+        if (directionalFrustum) {
+            Culler::intersects(masks, *directionalFrustum,
+                    worldAABBCenter + first, worldAABBExtent + first, c,
+                    VISIBLE_DIR_SHADOW_RENDERABLE_BIT);
+        }
 
-void ShadowMap::updateSceneInfo(const mat4f& Mv, FScene const& scene,
-        ShadowMap::SceneInfo& sceneInfo) {
-    sceneInfo.lsNearFar = { std::numeric_limits<float>::lowest(), std::numeric_limits<float>::max() };
-    visitScene(scene, sceneInfo.visibleLayers,
-            [&](Aabb caster, Culler::result_type) {
-                float2 nf = ShadowMap::computeNearFar(Mv, caster);
-                sceneInfo.lsNearFar.x = std::max(sceneInfo.lsNearFar.x, nf.x);  // near
-                sceneInfo.lsNearFar.y = std::min(sceneInfo.lsNearFar.y, nf.y);  // far
-            },
-            [&](Aabb receiver, Culler::result_type) {
+        // Each spot light is culled into its own mask, which lets us compute its near/far from
+        // its own shadow casters even when it shares its visibility bit with other spot lights.
+        Culler::result_type spotMasks[SCENE_CHUNK_SIZE];
+        for (size_t s = 0; s < spotCount; s++) {
+            std::fill_n(spotMasks, Culler::round(c), 0);
+            Culler::intersects(spotMasks, spots[s].frustum,
+                    worldAABBCenter + first, worldAABBExtent + first, c, 0);
+
+            const size_t bit = VISIBLE_SPOT_SHADOW_RENDERABLE_N_BIT(s);
+            for (size_t i = 0; i < c; i++) {
+                masks[i] |= Culler::result_type(spotMasks[i] << bit);
             }
-    );
-}
 
-void ShadowMap::updateSceneInfo(const mat4f& Mv, FScene const& scene,
-        ShadowMap::SceneInfo& sceneInfo, uint16_t index) {
-    sceneInfo.lsNearFar = { std::numeric_limits<float>::lowest(), std::numeric_limits<float>::max() };
-    sceneInfo.vsNearFar = { std::numeric_limits<float>::lowest(), std::numeric_limits<float>::max() };
-    visitScene(scene, sceneInfo.visibleLayers,
-            [&](Aabb caster, Culler::result_type mask) {
-                if (mask & VISIBLE_SPOT_SHADOW_RENDERABLE_N(index)) {
-                    float2 nf = ShadowMap::computeNearFar(Mv, caster);
-                    sceneInfo.lsNearFar.x = std::max(sceneInfo.lsNearFar.x, nf.x);  // near
-                    sceneInfo.lsNearFar.y = std::min(sceneInfo.lsNearFar.y, nf.y);  // far
+            float2 nearFar = {
+                    std::numeric_limits<float>::lowest(), std::numeric_limits<float>::max() };
+            for (size_t i = 0; i < c; i++) {
+                const size_t j = first + i;
+                if (spotMasks[i] && (layers[j] & visibleLayers) && visibility[j].castShadows) {
+                    const Aabb aabb{ worldAABBCenter[j] - worldAABBExtent[j],
+                                     worldAABBCenter[j] + worldAABBExtent[j] };
+                    const float2 nf = computeNearFar(spots[s].Mv, aabb);
+                    nearFar.x = std::max(nearFar.x, nf.x);  // near
+                    nearFar.y = std::min(nearFar.y, nf.y);  // far
                 }
-            },
-            [&](Aabb receiver, Culler::result_type) {
             }
-    );
+            chunkNearFar[chunk * spotCount + s] = nearFar;
+        }
+    });
+
+    const size_t chunkCount = spotCount ? chunkNearFar.size() / spotCount : 0;
+    for (size_t s = 0; s < spotCount; s++) {
+        float2 nearFar = { std::numeric_limits<float>::lowest(), std::numeric_limits<float>::max() };
+        for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+            const float2 nf = chunkNearFar[chunk * spotCount + s];
+            nearFar.x = std::max(nearFar.x, nf.x);
+            nearFar.y = std::min(nearFar.y, nf.y);
+        }
+        spots[s].lsNearFar = nearFar;
+    }
 }
 
 } // namespace filament
@@ -25,7 +25,11 @@
 #include "private/backend/DriverApiForward.h"
 #include "private/backend/SamplerGroup.h"
 
+#include <utils/JobSystem.h>
+#include <utils/Slice.h>
+
 #include <math/mat4.h>
+#include <math/vec2.h>
 #include <math/vec4.h>
 
 namespace filament {
@@ -51,7 +55,17 @@ class RenderPass;
 static constexpr size_t VISIBLE_RENDERABLE_BIT              = 0u;
 static constexpr size_t VISIBLE_DIR_SHADOW_RENDERABLE_BIT   = 1u;
 
-static constexpr size_t VISIBLE_SPOT_SHADOW_RENDERABLE_N_BIT(size_t n) { return n + 2; }
+// Because we're using a uint16_t for the visibility mask, only 14 bits are available for spot
+// light shadows (2 of the bits are used for visible renderables + directional light shadow
+// casters). When there are more shadow-casting spot lights than that, spot light N shares its
+// bit with spot lights N +/- 14, and its shadow pass renders the shadow casters of all of them.
+// This is always correct (the extra casters are clipped), it's just more work.
+static constexpr size_t VISIBLE_SPOT_SHADOW_RENDERABLE_BIT_COUNT =
+        sizeof(Culler::result_type) * 8u - 2u;
+
+static constexpr size_t VISIBLE_SPOT_SHADOW_RENDERABLE_N_BIT(size_t n) {
+    return n % VISIBLE_SPOT_SHADOW_RENDERABLE_BIT_COUNT + 2u;
+}
 
 static constexpr Culler::result_type VISIBLE_DIR_SHADOW_RENDERABLE = 1u << VISIBLE_DIR_SHADOW_RENDERABLE_BIT;
 static constexpr Culler::result_type VISIBLE_SPOT_SHADOW_RENDERABLE_N(size_t n) {
@@ -60,12 +74,7 @@ static constexpr Culler::result_type VISIBLE_SPOT_SHADOW_RENDERABLE_N(size_t n)
 
 // ORing of all the VISIBLE_SPOT_SHADOW_RENDERABLE bits
 static constexpr Culler::result_type VISIBLE_SPOT_SHADOW_RENDERABLE =
-        (0xFFu >> (sizeof(Culler::result_type) * 8u - CONFIG_MAX_SHADOW_CASTING_SPOTS)) << 2u;
-
-// Because we're using a uint16_t for the visibility mask, we're limited to 14 spot light shadows.
-// (2 of the bits are used for visible renderables + directional light shadow casters).
-static_assert(CONFIG_MAX_SHADOW_CASTING_SPOTS <= sizeof(Culler::result_type) * 8 - 2,
-        "CONFIG_MAX_SHADOW_CASTING_SPOTS cannot be higher than 14.");
+        Culler::result_type(~0u << 2u);
 
 class ShadowMap {
 public:
@@ -87,12 +96,15 @@ public:
         // e.g., for at atlas size of 1024 split into 4 quadrants, textureDimension would be 512
         uint16_t textureDimension = 0;
 
-        // the dimension of the actual shadow map, taking into account the 1 texel border
-        // e.g., for a texture dimension of 512, shadowDimension would be 510
+        // the dimension of the actual shadow map, taking into account the border
+        // e.g., for a texture dimension of 512 and a 1 texel border, shadowDimension would be 510
         uint16_t shadowDimension = 0;
 
-        // This spot shadowmap index.
-        uint16_t spotIndex = 0;
+        // the offset of the shadow map texture within the atlas, in texels
+        math::ushort2 atlasOffset{};
+
+        // the border around the shadow map, in texels, within the shadow map texture
+        uint8_t border = 1;
 
         // whether we're using vsm
         bool vsm = false;
@@ -107,10 +119,11 @@ public:
         // The near and far planes, in clip space, to use for this shadow map
         math::float2 csNearFar = { -1.0f, 1.0f };
 
-        // The following fields are set by computeSceneCascadeParams.
+        // The following fields are set by initSceneInfo().
 
         // light's near/far expressed in light-space, calculated from the scene's content
-        // assuming the light is at the origin.
+        // assuming the light is at the origin. For spot lights, it is set from
+        // SpotCullingInfo::lsNearFar before calling updateSpot().
         math::float2 lsNearFar{};
 
         // Viewing camera's near/far expressed in view-space, calculated from the scene's content
@@ -162,17 +175,39 @@ public:
 
     backend::PolygonOffset getPolygonOffset() const noexcept { return mShadowMapInfo.polygonOffset; }
 
+    // For unit tests
+    struct Test {
+        static void setLightSpaceMatrix(ShadowMap& shadowMap, math::mat4f const& lightSpace,
+                backend::PolygonOffset polygonOffset) noexcept {
+            shadowMap.mLightSpace = lightSpace;
+            shadowMap.mShadowMapInfo.polygonOffset = polygonOffset;
+        }
+    };
+
     // Call once per frame to populate the SceneInfo struct, then pass to update().
-    // This computes values constant across all shadow maps.
-    static void initSceneInfo(FScene const& scene, math::mat4f const& viewMatrix,
+    // This computes values constant across all shadow maps, as well as the light-space near/far
+    // of the directional light if its view matrix is given (see getDirectionalLightViewMatrix()).
+    // The scene is processed in parallel on the JobSystem.
+    static void initSceneInfo(utils::JobSystem& js, FScene const& scene,
+            math::mat4f const& viewMatrix, math::mat4f const* directionalLightViewMatrix,
             ShadowMap::SceneInfo& sceneInfo);
 
-    // Update SceneInfo struct for a given light
-    static void updateSceneInfo(const math::mat4f& Mv, FScene const& scene,
-            ShadowMap::SceneInfo& sceneInfo);
+    struct SpotCullingInfo {
+        // the light's view matrix, at the light position
+        math::mat4f Mv;
+        // the light's culling frustum
+        Frustum frustum;
+        // set by cullShadowCasters(), near/far of the light's shadow casters in light-space
+        math::float2 lsNearFar;
+    };
 
-    static void updateSceneInfo(const math::mat4f& Mv, FScene const& scene,
-            ShadowMap::SceneInfo& sceneInfo, uint16_t index);
+    // Culls the shadow casters of the directional light (if a frustum is given) and of all the
+    // spot lights, and computes the light-space near/far of each spot light, in a single pass
+    // over the scene, processed in parallel on the JobSystem.
+    // This sets the VISIBLE_DIR_SHADOW_RENDERABLE and VISIBLE_SPOT_SHADOW_RENDERABLE_N bits.
+    static void cullShadowCasters(utils::JobSystem& js, FScene::RenderableSoa& soa,
+            uint8_t visibleLayers, Frustum const* directionalFrustum,
+            utils::Slice<SpotCullingInfo> spots) noexcept;
 
 private:
     struct Segment {
@@ -207,9 +242,20 @@ private:
     static inline math::float4 computeBoundingSphere(
             math::float3 const* vertices, size_t count) noexcept;
 
-    template<typename Casters, typename Receivers>
-    static void visitScene(FScene const& scene, uint32_t visibleLayers,
-            Casters casters, Receivers receivers) noexcept;
+    // Scene traversals are split in chunks of this many renderables, must be a multiple of
+    // Culler::MODULO.
+    static constexpr uint32_t SCENE_CHUNK_SIZE = 256;
+    static_assert(SCENE_CHUNK_SIZE % Culler::MODULO == 0);
+
+    static constexpr size_t getSceneChunkCount(size_t count) noexcept {
+        return (count + SCENE_CHUNK_SIZE - 1) / SCENE_CHUNK_SIZE;
+    }
+
+    // Calls processChunk(chunk, first, count) for consecutive chunks of the scene's renderables,
+    // in parallel if the work is large enough. cost is the relative cost of each renderable.
+    template<typename ProcessChunk>
+    static void forEachChunk(utils::JobSystem& js, size_t count, size_t cost,
+            ProcessChunk const& processChunk) noexcept;
 
     static inline Aabb compute2DBounds(const math::mat4f& lightView,
             math::float3 const* wsVertices, size_t count) noexcept;
@@ -19,6 +19,9 @@
 #include "RenderPass.h"
 #include "ShadowMap.h"
 
+#include "components/RenderableManager.h"
+#include "components/TransformManager.h"
+
 #include "details/Texture.h"
 #include "details/View.h"
 
@@ -26,6 +29,13 @@
 
 #include <utils/debug.h>
 #include <utils/FixedCapacityVector.h>
+#include <utils/Hash.h>
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+
+#include <string.h>
 
 namespace filament {
 
@@ -47,6 +57,8 @@ ShadowMapManager::ShadowMapManager(FEngine& engine) { // NOLINT(cppcoreguideline
             &engine.debug.shadowmap.visualize_cascades);
     debugRegistry.registerProperty("d.shadowmap.tightly_bound_scene",
             &engine.debug.shadowmap.tightly_bound_scene);
+    debugRegistry.registerProperty("d.shadowmap.static_cache",
+            &engine.debug.shadowmap.static_cache);
 }
 
 void ShadowMapManager::terminate(FEngine& engine) {
@@ -56,6 +68,11 @@ void ShadowMapManager::terminate(FEngine& engine) {
     for (auto& entry : mShadowMapCache) {
         std::launder(reinterpret_cast<ShadowMap*>(&entry))->terminate(engine);
     }
+    for (auto& cache : mStaticShadowCaches) {
+        if (cache.texture) {
+            driver.destroyTexture(cache.texture);
+        }
+    }
 }
 
 ShadowMapManager::~ShadowMapManager() {
@@ -71,18 +88,30 @@ ShadowMapManager::ShadowTechnique ShadowMapManager::update(FEngine& engine, FVie
         FScene::RenderableSoa& renderableData, FScene::LightSoa& lightData) noexcept {
     ShadowTechnique shadowTechnique = {};
 
+    mWorldOrigin = cameraInfo.worldOrigin;
+
     calculateTextureRequirements(engine, view, lightData);
 
     ShadowMap::SceneInfo sceneInfo(view.getVisibleLayers());
 
     // Compute scene-dependent values shared across all shadow maps
-    ShadowMap::initSceneInfo(*view.getScene(), cameraInfo.view, sceneInfo);
+    mat4f directionalLightViewMatrix;
+    if (!mCascadeShadowMaps.empty()) {
+        directionalLightViewMatrix = ShadowMap::getDirectionalLightViewMatrix(
+                lightData.elementAt<FScene::DIRECTION>(0));
+    }
+    ShadowMap::initSceneInfo(engine.getJobSystem(), *view.getScene(), cameraInfo.view,
+            mCascadeShadowMaps.empty() ? nullptr : &directionalLightViewMatrix, sceneInfo);
 
+    // The shadow casters of the directional light are culled along with the spot lights'
+    Frustum directionalShadowCastersFrustum;
     shadowTechnique |= updateCascadeShadowMaps(
-            engine, view, cameraInfo, renderableData, lightData, sceneInfo);
+            engine, view, cameraInfo, renderableData, lightData, sceneInfo,
+            directionalShadowCastersFrustum);
 
     shadowTechnique |= updateSpotShadowMaps(
-            engine, view, cameraInfo, renderableData, lightData, sceneInfo);
+            engine, view, cameraInfo, renderableData, lightData, sceneInfo,
+            mCascadeShadowMaps.empty() ? nullptr : &directionalShadowCastersFrustum);
 
     if (mShadowUb.isDirty()) {
         DriverApi& driver = engine.getDriverApi();
@@ -103,16 +132,31 @@ void ShadowMapManager::setShadowCascades(size_t lightIndex,
     assert_invariant(options->shadowCascades <= CONFIG_MAX_SHADOW_CASCADES);
     for (size_t c = 0; c < options->shadowCascades; c++) {
         auto* shadowMap = getCascadeShadowMap(c);
-        mCascadeShadowMaps.emplace_back(shadowMap, lightIndex, options);
+        mCascadeShadowMaps.emplace_back(shadowMap, &mStaticShadowCaches[c], lightIndex, options);
     }
 }
 
 void ShadowMapManager::addSpotShadowMap(size_t lightIndex,
-        LightManager::ShadowOptions const* options) noexcept {
+        LightManager::ShadowOptions const* options, float importance) noexcept {
     const size_t c = mSpotShadowMaps.size();
-    assert_invariant(c < CONFIG_MAX_SHADOW_CASTING_SPOTS);
-    auto* shadowMap = getSpotShadowMap(c);
-    mSpotShadowMaps.emplace_back(shadowMap, lightIndex, options);
+    if (UTILS_LIKELY(c < CONFIG_MAX_SHADOW_CASTING_SPOTS)) {
+        auto* shadowMap = getSpotShadowMap(c);
+        mSpotShadowMaps.emplace_back(shadowMap,
+                &mStaticShadowCaches[CONFIG_MAX_SHADOW_CASCADES + c], lightIndex, options,
+                importance);
+        return;
+    }
+
+    // We ran out of spot light shadow maps, this one replaces the least important one if
+    // it matters more.
+    auto leastImportant = std::min_element(mSpotShadowMaps.begin(), mSpotShadowMaps.end(),
+            [](ShadowMapEntry const& lhs, ShadowMapEntry const& rhs) {
+                return lhs.getImportance() < rhs.getImportance();
+            });
+    if (leastImportant->getImportance() < importance) {
+        *leastImportant = { &leastImportant->getShadowMap(), &leastImportant->getStaticCache(),
+                lightIndex, options, importance };
+    }
 }
 
 FrameGraphId<FrameGraphTexture> ShadowMapManager::render(FrameGraph& fg, FEngine& engine,
@@ -131,6 +175,8 @@ FrameGraphId<FrameGraphTexture> ShadowMapManager::render(FrameGraph& fg, FEngine
         ShadowMapEntry const* shadowMapEntry;
         utils::Range<uint32_t> range;
         FScene::VisibleMaskType visibilityMask;
+        StaticShadowCacheState staticCache = StaticShadowCacheState::NONE;
+        bool hasDynamicCasters = true;
     };
 
     auto passList = utils::FixedCapacityVector<ShadowPass>::with_capacity(MAX_SHADOW_LAYERS);
@@ -164,7 +210,17 @@ FrameGraphId<FrameGraphTexture> ShadowMapManager::render(FrameGraph& fg, FEngine
         }
     }
 
-    assert_invariant(passList.size() <= textureRequirements.layers);
+    // spot light shadow maps can share a layer, so there can be more passes than layers
+    assert_invariant(passList.size() <= mCascadeShadowMaps.size() + mSpotShadowMaps.size());
+    assert_invariant(std::all_of(passList.begin(), passList.end(), [&](ShadowPass const& entry) {
+        return entry.shadowMapEntry->getLayer() < textureRequirements.layers;
+    }));
+
+    for (auto& entry : passList) {
+        entry.staticCache = updateStaticShadowCache(engine, view, *entry.shadowMapEntry,
+                scene->getRenderableData(), entry.range, entry.visibilityMask,
+                entry.hasDynamicCasters);
+    }
 
     // -------------------------------------------------------------------------------------------
 
@@ -193,6 +249,19 @@ FrameGraphId<FrameGraphTexture> ShadowMapManager::render(FrameGraph& fg, FEngine
     const float vsmMoment1 = std::sqrt(vsmMoment2);
     const float4 vsmClearColor{ vsmMoment1, vsmMoment2, 0.0f, 0.0f };
 
+    struct ShadowLayerClearPassData {
+        FrameGraphId<FrameGraphTexture> output;
+    };
+
+    struct StaticShadowPassData {
+        FrameGraphId<FrameGraphTexture> cache;
+    };
+
+    struct StaticShadowCopyPassData {
+        FrameGraphId<FrameGraphTexture> cache;
+        FrameGraphId<FrameGraphTexture> output;
+    };
+
     struct ShadowPassData {
         FrameGraphId<FrameGraphTexture> tempBlurSrc{};  // temporary shadowmap when blurring
         FrameGraphId<FrameGraphTexture> output;
@@ -200,11 +269,158 @@ FrameGraphId<FrameGraphTexture> ShadowMapManager::render(FrameGraph& fg, FEngine
         uint32_t shadowRt{};
     };
 
+    // renders the shadow casters of a shadow map into the given render target,
+    // at the given offset
+    auto renderShadowCasters = [&engine, &view, scene](DriverApi& driver, RenderPass const& pass,
+            ShadowPass const& entry, RenderPass::RenderFlags flags,
+            FrameGraphResources::RenderPassInfo rt, ushort2 offset) {
+        ShadowMap& shadowMap = entry.shadowMapEntry->getShadowMap();
+        const CameraInfo cameraInfo(shadowMap.getCamera());
+
+        // updatePrimitivesLod must be run before RenderPass::appendCommands.
+        view.updatePrimitivesLod(engine, cameraInfo, scene->getRenderableData(), entry.range);
+
+        // generate and sort the commands for rendering the shadow map
+        RenderPass entryPass(pass);
+        entryPass.setRenderFlags(entryPass.getRenderFlags() | flags);
+        shadowMap.render(*scene, entry.range, entry.visibilityMask, &entryPass);
+
+        const auto& executor = entryPass.getExecutor();
+
+        view.prepareCamera(cameraInfo);
+
+        // We set a viewport with a border (1 texel, or more for spot light shadow maps sharing
+        // a layer) for when we index outside the texture.
+        // DON'T CHANGE this unless ShadowMap::getTextureCoordsMapping() is updated too.
+        // see: ShadowMap::getTextureCoordsMapping()
+        //
+        // For floating-point depth textures, the 1-texel border could be set to
+        // FLOAT_MAX to avoid clamping in the shadow shader (see sampleDepth inside
+        // shadowing.fs). Unfortunately, the APIs don't seem let us clear depth
+        // attachments to anything greater than 1.0, so we'd need a way to do this other
+        // than clearing.
+        const uint32_t dim = entry.shadowMapEntry->getDimension();
+        const uint32_t border = entry.shadowMapEntry->getBorder();
+        filament::Viewport viewport{
+                int32_t(offset.x + border), int32_t(offset.y + border),
+                dim - 2u * border, dim - 2u * border };
+        view.prepareViewport(viewport, 0, 0);
+
+        view.commitUniforms(driver);
+
+        rt.params.viewport = viewport;
+
+        executor.execute("Shadow Pass", rt.target, rt.params);
+    };
+
     auto& ppm = engine.getPostProcessManager();
 
+    // Spot light shadow maps can share a layer, in which case each shadow pass writes on top of
+    // the previous version of the layer, and only the first one clears it.
+    std::array<uint8_t, MAX_SHADOW_LAYERS> layerShadowMapCount{};
+    for (auto const& entry : passList) {
+        layerShadowMapCount[entry.shadowMapEntry->getLayer()]++;
+    }
+    std::array<FrameGraphId<FrameGraphTexture>, MAX_SHADOW_LAYERS> layerOutputs{};
+
     for (auto const& entry : passList) {
         const auto layer = entry.shadowMapEntry->getLayer();
         const auto* options = entry.shadowMapEntry->getShadowOptions();
+        FrameGraphId<FrameGraphTexture>& layerOutput = layerOutputs[layer];
+
+        // The static shadow casters are kept in their own texture, which is copied into the
+        // shadow map before the dynamic shadow casters are rendered on top of it.
+        FrameGraphId<FrameGraphTexture> staticShadows;
+        if (entry.staticCache != StaticShadowCacheState::NONE) {
+            StaticShadowCache const& cache = entry.shadowMapEntry->getStaticCache();
+            staticShadows = fg.import("Static Shadowmap", {
+                    .width = cache.dimension, .height = cache.dimension,
+                    .format = mTextureFormat
+            }, FrameGraphTexture::Usage::DEPTH_ATTACHMENT,
+                    FrameGraphTexture{ .handle = cache.texture });
+        }
+
+        if (entry.staticCache == StaticShadowCacheState::MISS) {
+            auto& staticShadowPass = fg.addPass<StaticShadowPassData>("Static Shadow Pass",
+                    [&](FrameGraph::Builder& builder, auto& data) {
+                        data.cache = builder.write(staticShadows,
+                                FrameGraphTexture::Usage::DEPTH_ATTACHMENT);
+                        builder.declareRenderPass("Static Shadow RT", {
+                                .attachments = { .depth = data.cache },
+                                .clearFlags = TargetBufferFlags::DEPTH });
+                    },
+                    [=](FrameGraphResources const& resources,
+                            auto const& data, DriverApi& driver) {
+                        renderShadowCasters(driver, pass, entry,
+                                RenderPass::SKIP_DYNAMIC_SHADOW_CASTERS,
+                                resources.getRenderPassInfo(), {});
+                    });
+            staticShadows = staticShadowPass->cache;
+        }
+
+        if (staticShadows) {
+            if (!layerOutput && layerShadowMapCount[layer] > 1) {
+                // the copy below only covers this shadow map, the rest of the layer must be
+                // cleared for the other ones.
+                auto& clearPass = fg.addPass<ShadowLayerClearPassData>("Shadow Layer Clear",
+                        [&](FrameGraph::Builder& builder, auto& data) {
+                            data.output = builder.createSubresource(prepareShadowPass->shadows,
+                                    "Shadowmap Layer", { .layer = layer });
+                            data.output = builder.write(data.output,
+                                    FrameGraphTexture::Usage::DEPTH_ATTACHMENT);
+                            builder.declareRenderPass("Shadow Layer Clear RT", {
+                                    .attachments = { .depth = data.output },
+                                    .clearFlags = TargetBufferFlags::DEPTH });
+                        },
+                        [](FrameGraphResources const& resources,
+                                auto const& data, DriverApi& driver) {
+                            auto out = resources.getRenderPassInfo();
+                            driver.beginRenderPass(out.target, out.params);
+                            driver.endRenderPass();
+                        });
+                layerOutput = clearPass->output;
+            }
+
+            auto& copyPass = fg.addPass<StaticShadowCopyPassData>("Static Shadow Copy",
+                    [&](FrameGraph::Builder& builder, auto& data) {
+                        data.cache = builder.read(staticShadows,
+                                FrameGraphTexture::Usage::DEPTH_ATTACHMENT);
+                        if (layerOutput) {
+                            // we need to preserve the other shadow maps of this layer
+                            data.output = builder.read(layerOutput,
+                                    FrameGraphTexture::Usage::DEPTH_ATTACHMENT);
+                        } else {
+                            data.output = builder.createSubresource(prepareShadowPass->shadows,
+                                    "Shadowmap Layer", { .layer = layer });
+                        }
+                        data.output = builder.write(data.output,
+                                FrameGraphTexture::Usage::DEPTH_ATTACHMENT);
+                        builder.declareRenderPass("Static Shadow Copy RT",
+                                {{ .depth = data.output }});
+                    },
+                    [dim = entry.shadowMapEntry->getDimension(),
+                            offset = entry.shadowMapEntry->getOffset()](
+                            FrameGraphResources const& resources,
+                            auto const& data, DriverApi& driver) {
+                        auto out = resources.getRenderPassInfo();
+                        // create a temporary render target for the cache, needed for the blit.
+                        auto inTarget = driver.createRenderTarget(TargetBufferFlags::DEPTH,
+                                dim, dim, 1, {}, { resources.getTexture(data.cache) }, {});
+                        // this includes the 1-texel border
+                        const filament::Viewport srcViewport{ 0, 0, dim, dim };
+                        const filament::Viewport dstViewport{ offset.x, offset.y, dim, dim };
+                        driver.blit(TargetBufferFlags::DEPTH,
+                                out.target, dstViewport, inTarget, srcViewport,
+                                SamplerMagFilter::NEAREST);
+                        driver.destroyRenderTarget(inTarget);
+                    });
+            layerOutput = copyPass->output;
+
+            if (!entry.hasDynamicCasters) {
+                // the copy is all we need
+                continue;
+            }
+        }
 
         auto& shadowPass = fg.addPass<ShadowPassData>("Shadow Pass",
                 [&](FrameGraph::Builder& builder, auto& data) {
@@ -212,8 +428,15 @@ FrameGraphId<FrameGraphTexture> ShadowMapManager::render(FrameGraph& fg, FEngine
 
                     FrameGraphRenderPass::Descriptor renderTargetDesc{};
 
-                    data.output = builder.createSubresource(prepareShadowPass->shadows,
-                            "Shadowmap Layer", { .layer = layer });
+                    if (layerOutput) {
+                        // we need to preserve the static shadow casters, or the other shadow
+                        // maps of this layer
+                        data.output = builder.read(layerOutput,
+                                FrameGraphTexture::Usage::DEPTH_ATTACHMENT);
+                    } else {
+                        data.output = builder.createSubresource(prepareShadowPass->shadows,
+                                "Shadowmap Layer", { .layer = layer });
+                    }
 
                     if (view.hasVSM()) {
                         // Each shadow pass has its own sample count, but textures are created with
@@ -267,54 +490,33 @@ FrameGraphId<FrameGraphTexture> ShadowMapManager::render(FrameGraph& fg, FEngine
                         data.output = builder.write(data.output,
                                 FrameGraphTexture::Usage::DEPTH_ATTACHMENT);
                         renderTargetDesc.attachments.depth = data.output;
-                        renderTargetDesc.clearFlags = TargetBufferFlags::DEPTH;
+                        renderTargetDesc.clearFlags = layerOutput ?
+                                TargetBufferFlags::NONE : TargetBufferFlags::DEPTH;
                     }
 
                     // finally, create the shadowmap render target -- one per layer.
                     data.shadowRt = builder.declareRenderPass("Shadow RT", renderTargetDesc);
                 },
-                [=, &engine, &view](FrameGraphResources const& resources,
+                [=, &view](FrameGraphResources const& resources,
                         auto const& data, DriverApi& driver) {
-
-                    ShadowMap& shadowMap = entry.shadowMapEntry->getShadowMap();
-                    const CameraInfo cameraInfo(shadowMap.getCamera());
-
-                    // updatePrimitivesLod must be run before RenderPass::appendCommands.
-                    view.updatePrimitivesLod(engine, cameraInfo, scene->getRenderableData(), entry.range);
-
-                    // generate and sort the commands for rendering the shadow map
-                    RenderPass entryPass(pass);
-                    shadowMap.render(*scene, entry.range, entry.visibilityMask, &entryPass);
-
-                    const auto& executor = entryPass.getExecutor();
                     const bool blur = view.hasVSM() && options->vsm.blurWidth > 0.0f;
 
-                    view.prepareCamera(cameraInfo);
-
-                    // We set a viewport with a 1-texel border for when we index outside the
-                    // texture.
-                    // DON'T CHANGE this unless ShadowMap::getTextureCoordsMapping() is updated too.
-                    // see: ShadowMap::getTextureCoordsMapping()
-                    //
-                    // For floating-point depth textures, the 1-texel border could be set to
-                    // FLOAT_MAX to avoid clamping in the shadow shader (see sampleDepth inside
-                    // shadowing.fs). Unfortunately, the APIs don't seem let us clear depth
-                    // attachments to anything greater than 1.0, so we'd need a way to do this other
-                    // than clearing.
-                    const uint32_t dim = options->mapSize;
-                    filament::Viewport viewport{ 1, 1, dim - 2, dim - 2 };
-                    view.prepareViewport(viewport, 0, 0);
-
-                    view.commitUniforms(driver);
+                    // the static shadow casters have already been rendered
+                    const RenderPass::RenderFlags flags =
+                            entry.staticCache != StaticShadowCacheState::NONE ?
+                            RenderPass::SKIP_STATIC_SHADOW_CASTERS : 0;
 
                     // render either directly into the shadowmap, or to the temporary texture for
                     // blurring.
-                    auto rt = resources.getRenderPassInfo(blur ? data.blurRt : data.shadowRt);
-                    rt.params.viewport = viewport;
-
-                    executor.execute("Shadow Pass", rt.target, rt.params);
+                    renderShadowCasters(driver, pass, entry, flags,
+                            resources.getRenderPassInfo(blur ? data.blurRt : data.shadowRt),
+                            entry.shadowMapEntry->getOffset());
                 });
 
+        if (!view.hasVSM()) {
+            layerOutput = shadowPass->output;
+        }
+
 
         // now emit the blurring passes
         if (view.hasVSM()) {
@@ -348,7 +550,8 @@ FrameGraphId<FrameGraphTexture> ShadowMapManager::render(FrameGraph& fg, FEngine
 
 ShadowMapManager::ShadowTechnique ShadowMapManager::updateCascadeShadowMaps(FEngine& engine,
         FView& view, CameraInfo const& cameraInfo, FScene::RenderableSoa& renderableData,
-        FScene::LightSoa& lightData, ShadowMap::SceneInfo& sceneInfo) noexcept {
+        FScene::LightSoa& lightData, ShadowMap::SceneInfo& sceneInfo,
+        Frustum& shadowCastersFrustum) noexcept {
     FScene* scene = view.getScene();
     auto& lcm = engine.getLightManager();
 
@@ -375,9 +578,7 @@ ShadowMapManager::ShadowTechnique ShadowMapManager::updateCascadeShadowMaps(FEng
 
         shadowMap.updateDirectional(lightData, 0, cameraInfo, shadowMapInfo, *scene, sceneInfo);
 
-        Frustum const& frustum = shadowMap.getCamera().getCullingFrustum();
-        FView::cullRenderables(engine.getJobSystem(), renderableData, frustum,
-                VISIBLE_DIR_SHADOW_RENDERABLE_BIT);
+        shadowCastersFrustum = shadowMap.getCamera().getCullingFrustum();
 
         // Set shadowBias, using the first directional cascade.
         // when computing the required bias we need a half-texel size, so we multiply by 0.5 here.
@@ -488,10 +689,35 @@ ShadowMapManager::ShadowTechnique ShadowMapManager::updateCascadeShadowMaps(FEng
 
 ShadowMapManager::ShadowTechnique ShadowMapManager::updateSpotShadowMaps(FEngine& engine,
         FView& view, CameraInfo const& cameraInfo, FScene::RenderableSoa& renderableData,
-        FScene::LightSoa& lightData, ShadowMap::SceneInfo& sceneInfo) noexcept {
+        FScene::LightSoa& lightData, ShadowMap::SceneInfo& sceneInfo,
+        Frustum const* directionalShadowCastersFrustum) noexcept {
 
     auto& lcm = engine.getLightManager();
 
+    // For spotlights, we cull shadow casters first because we already know the frustum, this
+    // will help us find better near/far plane later. All the lights are culled in a single
+    // pass over the scene.
+    auto spots = utils::FixedCapacityVector<ShadowMap::SpotCullingInfo>::with_capacity(
+            mSpotShadowMaps.size());
+    for (auto const& entry : mSpotShadowMaps) {
+        const size_t lightIndex = entry.getLightIndex();
+        const FLightManager::Instance li = lightData.elementAt<FScene::LIGHT_INSTANCE>(lightIndex);
+        const auto position  = lightData.elementAt<FScene::POSITION_RADIUS>(lightIndex).xyz;
+        const auto direction = lightData.elementAt<FScene::DIRECTION>(lightIndex);
+        const auto radius    = lightData.elementAt<FScene::POSITION_RADIUS>(lightIndex).w;
+        const auto outerConeAngle = lcm.getSpotLightOuterCone(li);
+
+        const mat4f Mv = ShadowMap::getDirectionalLightViewMatrix(direction, position);
+        const mat4f Mp = mat4f::perspective(outerConeAngle * f::RAD_TO_DEG * 2.0f,
+                1.0f, 0.01f, radius);
+        const mat4f MpMv(math::highPrecisionMultiply(Mp, Mv));
+        spots.push_back({ Mv, Frustum(MpMv), {} });
+    }
+
+    // Cull shadow casters
+    ShadowMap::cullShadowCasters(engine.getJobSystem(), renderableData, sceneInfo.visibleLayers,
+            directionalShadowCastersFrustum, { spots.data(), spots.size() });
+
     // shadow-map shadows for point/spotlights
     ShadowTechnique shadowTechnique{};
     FScene::ShadowInfo* const shadowInfo = lightData.data<FScene::SHADOW_INFO>();
@@ -507,9 +733,10 @@ ShadowMapManager::ShadowTechnique ShadowMapManager::updateSpotShadowMaps(FEngine
         FLightManager::ShadowOptions const* const options = entry.getShadowOptions();
         const ShadowMap::ShadowMapInfo shadowMapInfo{
                 .atlasDimension = mTextureAtlasRequirements.size,
-                .textureDimension = uint16_t(options->mapSize),
-                .shadowDimension = uint16_t(options->mapSize - 2u),
-                .spotIndex = uint16_t(i),
+                .textureDimension = entry.getDimension(),
+                .shadowDimension = uint16_t(entry.getDimension() - 2u * entry.getBorder()),
+                .atlasOffset = entry.getOffset(),
+                .border = entry.getBorder(),
                 .vsm = view.hasVSM(),
                 .polygonOffset = { // handle reversed Z
                         .slope    = view.hasVSM() ? 0.0f : -params.options.polygonOffsetSlope,
@@ -517,24 +744,9 @@ ShadowMapManager::ShadowTechnique ShadowMapManager::updateSpotShadowMaps(FEngine
                 }
         };
 
-        // for spotlights, we cull shadow casters first because we already know the frustum,
-        // this will help us find better near/far plane later
-
-        const auto position  = lightData.elementAt<FScene::POSITION_RADIUS>(lightIndex).xyz;
         const auto direction = lightData.elementAt<FScene::DIRECTION>(lightIndex);
-        const auto radius    = lightData.elementAt<FScene::POSITION_RADIUS>(lightIndex).w;
-        const auto outerConeAngle = lcm.getSpotLightOuterCone(li);
-
-        const mat4f Mv = ShadowMap::getDirectionalLightViewMatrix(direction, position);
-        const mat4f Mp = mat4f::perspective(outerConeAngle * f::RAD_TO_DEG * 2.0f,
-                1.0f, 0.01f, radius);
-        const mat4f MpMv(math::highPrecisionMultiply(Mp, Mv));
-        const Frustum frustum(MpMv);
-
-        // Cull shadow casters
-        FView::cullRenderables(engine.getJobSystem(), renderableData, frustum,
-                VISIBLE_SPOT_SHADOW_RENDERABLE_N_BIT(i));
 
+        sceneInfo.lsNearFar = spots[i].lsNearFar;
         shadowMap.updateSpot(lightData, lightIndex,
                 cameraInfo, shadowMapInfo,
                 *view.getScene(), sceneInfo);
@@ -579,27 +791,138 @@ ShadowMapManager::ShadowTechnique ShadowMapManager::updateSpotShadowMaps(FEngine
     return shadowTechnique;
 }
 
+ShadowMapManager::StaticShadowCacheState ShadowMapManager::updateStaticShadowCache(
+        FEngine& engine, FView const& view, ShadowMapEntry const& entry,
+        FScene::RenderableSoa const& soa, utils::Range<uint32_t> range,
+        FScene::VisibleMaskType visibilityMask, bool& hasDynamicCasters) noexcept {
+
+    StaticShadowCache& cache = entry.getStaticCache();
+
+    hasDynamicCasters = true;
+    if (!engine.debug.shadowmap.static_cache || view.hasVSM()) {
+        cache.valid = false;
+        return StaticShadowCacheState::NONE;
+    }
+
+    FRenderableManager const& rcm = engine.getRenderableManager();
+    FTransformManager const& tcm = engine.getTransformManager();
+
+    auto const* const UTILS_RESTRICT soaInstance        = soa.data<FScene::RENDERABLE_INSTANCE>();
+    auto const* const UTILS_RESTRICT soaVisibility      = soa.data<FScene::VISIBILITY_STATE>();
+    auto const* const UTILS_RESTRICT soaVisibilityMask  = soa.data<FScene::VISIBLE_MASK>();
+    auto const* const UTILS_RESTRICT soaPrimitives      = soa.data<FScene::PRIMITIVES>();
+
+    // Hash the static shadow casters of this shadow map. The hashes are summed so that the
+    // result doesn't depend on the order of the renderables, which changes from frame to frame.
+    // We use the transforms from the TransformManager because the ones in the scene are relative
+    // to the world origin, which moves with the camera.
+    // Changes to their geometry or material are tracked by the RenderableManager instead.
+    uint32_t castersHash = 0;
+    size_t staticCasterCount = 0;
+    size_t dynamicCasterCount = 0;
+    for (uint32_t i = range.first; i < range.last; i++) {
+        if (!(soaVisibilityMask[i] & visibilityMask) || !soaVisibility[i].castShadows) {
+            continue;
+        }
+        if (!soaVisibility[i].staticShadowCaster) {
+            dynamicCasterCount++;
+            continue;
+        }
+        const auto ti = tcm.getInstance(rcm.getEntity(soaInstance[i]));
+        const mat4 worldTransform = tcm.getWorldTransformAccurate(ti);
+        const uint64_t primitives = uint64_t(uintptr_t(soaPrimitives[i].data()));
+        uint32_t key[4 + sizeof(mat4) / sizeof(uint32_t)];
+        key[0] = soaInstance[i].asValue();
+        key[1] = uint32_t(primitives);
+        key[2] = uint32_t(primitives >> 32u);
+        key[3] = soaPrimitives[i].size();
+        memcpy(key + 4, &worldTransform, sizeof(mat4));
+        castersHash += utils::hash::murmur3(key, sizeof(key) / sizeof(uint32_t), 0);
+        staticCasterCount++;
+    }
+
+    hasDynamicCasters = dynamicCasterCount > 0;
+    if (!staticCasterCount) {
+        cache.valid = false;
+        return StaticShadowCacheState::NONE;
+    }
+
+    // The light space matrix is relative to the world origin too, so we compare it in world
+    // space, with a tolerance for the rounding errors.
+    ShadowMap const& shadowMap = entry.getShadowMap();
+    const mat4 lightFromWorld = mat4(shadowMap.getLightSpaceMatrix()) * mWorldOrigin;
+    const PolygonOffset polygonOffset = shadowMap.getPolygonOffset();
+    const uint16_t dim = entry.getDimension();
+    const uint32_t castersGeneration = rcm.getStaticShadowCasterGeneration();
+
+    auto isNearlyEqual = [](mat4 const& lhs, mat4 const& rhs) {
+        for (size_t c = 0; c < 4; c++) {
+            for (size_t r = 0; r < 4; r++) {
+                const double a = lhs[c][r];
+                const double b = rhs[c][r];
+                if (std::abs(a - b) > 1e-5 * std::max(std::abs(a), std::abs(b)) + 1e-9) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+
+    if (cache.valid &&
+            cache.dimension == dim &&
+            cache.castersHash == castersHash &&
+            cache.castersGeneration == castersGeneration &&
+            cache.polygonOffset.slope == polygonOffset.slope &&
+            cache.polygonOffset.constant == polygonOffset.constant &&
+            isNearlyEqual(cache.lightFromWorld, lightFromWorld)) {
+        mStaticShadowCacheHitCount++;
+        return StaticShadowCacheState::HIT;
+    }
+
+    if (cache.dimension != dim) {
+        DriverApi& driver = engine.getDriverApi();
+        if (cache.texture) {
+            driver.destroyTexture(cache.texture);
+        }
+        cache.texture = driver.createTexture(SamplerType::SAMPLER_2D, 1, mTextureFormat, 1,
+                dim, dim, 1, TextureUsage::DEPTH_ATTACHMENT | TextureUsage::SAMPLEABLE);
+        cache.dimension = dim;
+    }
+    cache.lightFromWorld = lightFromWorld;
+    cache.polygonOffset = polygonOffset;
+    cache.castersHash = castersHash;
+    cache.castersGeneration = castersGeneration;
+    cache.valid = true;
+    mStaticShadowCacheMissCount++;
+    return StaticShadowCacheState::MISS;
+}
+
 void ShadowMapManager::calculateTextureRequirements(FEngine& engine, FView& view,
         FScene::LightSoa& lightData) noexcept {
 
     // Lay out the shadow maps. For now, we take the largest requested dimension and allocate a
-    // texture of that size. Each cascade / shadow map gets its own layer in the array texture.
-    // The directional shadow cascades start on layer 0, followed by spotlights.
-    uint8_t layer = 0;
+    // texture of that size. Each cascade gets its own layer in the array texture, starting at
+    // layer 0, spot light shadow maps are packed in the following layers.
     uint32_t maxDimension = 0;
     for (auto& entry : mCascadeShadowMaps) {
         // Shadow map size should be the same for all cascades.
         auto const& options = entry.getShadowOptions();
         maxDimension = std::max(maxDimension, options->mapSize);
-        entry.setLayer(layer++);
     }
     for (auto& entry : mSpotShadowMaps) {
         auto const& options = entry.getShadowOptions();
         maxDimension = std::max(maxDimension, options->mapSize);
-        entry.setLayer(layer++);
     }
 
-    const uint8_t layersNeeded = layer;
+    uint8_t layer = 0;
+    for (auto& entry : mCascadeShadowMaps) {
+        entry.setAtlasRegion(layer++, {}, uint16_t(entry.getShadowOptions()->mapSize));
+    }
+
+    // VSM shadow maps are cleared, blurred and mipmapped a whole layer at a time, and the DPCF
+    // and PCSS kernels grow with the penumbra, so they would sample the neighbouring tiles.
+    const bool shareLayers = view.getShadowType() == ShadowType::PCF;
+    const uint8_t layersNeeded = layoutSpotShadowMaps(uint16_t(maxDimension), layer, shareLayers);
 
     // Generate mipmaps for VSM when anisotropy is enabled or when requested
     auto const& vsmShadowOptions = view.getVsmShadowOptions();
@@ -623,6 +946,144 @@ void ShadowMapManager::calculateTextureRequirements(FEngine& engine, FView& view
     };
 }
 
+uint8_t ShadowMapManager::layoutSpotShadowMaps(uint16_t atlasDimension, uint8_t firstLayer,
+        bool shareLayers) noexcept {
+
+    // The most important spot lights come first, they get the lowest indices, which means they
+    // don't share their visibility bit (see VISIBLE_SPOT_SHADOW_RENDERABLE_N_BIT).
+    std::stable_sort(mSpotShadowMaps.begin(), mSpotShadowMaps.end(),
+            [](ShadowMapEntry const& lhs, ShadowMapEntry const& rhs) {
+                return lhs.getImportance() > rhs.getImportance();
+            });
+
+    if (!shareLayers) {
+        // Each shadow map gets its own layer, and the least important spot lights don't cast
+        // shadows past our budget.
+        while (mSpotShadowMaps.size() > MAX_SPOT_SHADOW_LAYERS) {
+            mSpotShadowMaps.pop_back();
+        }
+        uint8_t layer = firstLayer;
+        for (auto& entry : mSpotShadowMaps) {
+            entry.setAtlasRegion(layer++, {}, uint16_t(entry.getShadowOptions()->mapSize));
+        }
+        return layer;
+    }
+
+    // Otherwise, each shadow map gets a square tile of a layer, whose size is a power-of-two
+    // fraction of the layer; the "level" of a tile is the number of times the layer is halved.
+    uint8_t maxLevel = 0;
+    while ((atlasDimension >> (maxLevel + 1u)) >= MIN_SPOT_SHADOW_DIMENSION) {
+        maxLevel++;
+    }
+    const uint32_t minTileDimension = atlasDimension >> maxLevel;
+    auto tileDimension = [=](uint8_t level) -> uint32_t {
+        return level ? minTileDimension << (maxLevel - level) : atlasDimension;
+    };
+
+    // start with the smallest tiles that fit the requested dimensions
+    const size_t count = mSpotShadowMaps.size();
+    std::array<uint8_t, CONFIG_MAX_SHADOW_CASTING_SPOTS> levels; // NOLINT
+    uint64_t area = 0;
+    for (size_t i = 0; i < count; i++) {
+        const uint32_t dim = mSpotShadowMaps[i].getShadowOptions()->mapSize;
+        uint8_t level = 0;
+        while (level < maxLevel && tileDimension(level + 1u) >= dim) {
+            level++;
+        }
+        levels[i] = level;
+        area += uint64_t(tileDimension(level)) * tileDimension(level);
+    }
+
+    // Then shrink the tiles until they fit in our budget. We always halve the tile that has the
+    // most texels per unit of importance, so the resolution goes where the shadows matter the
+    // most, and the least important spot lights degrade first.
+    const uint64_t budget = uint64_t(MAX_SPOT_SHADOW_LAYERS) * atlasDimension * atlasDimension;
+    while (area > budget) {
+        size_t candidate = count;
+        float maxDensity = 0.0f;
+        for (size_t i = 0; i < count; i++) {
+            if (levels[i] < maxLevel) {
+                const float dim = float(tileDimension(levels[i]));
+                const float density = dim * dim / mSpotShadowMaps[i].getImportance();
+                // on ties, pick the least important spot light
+                if (density >= maxDensity) {
+                    maxDensity = density;
+                    candidate = i;
+                }
+            }
+        }
+        if (candidate == count) {
+            // all the tiles are as small as they can be, we'll use more layers
+            break;
+        }
+        const uint64_t dim = tileDimension(levels[candidate]);
+        const uint64_t halfDim = tileDimension(levels[candidate] + 1u);
+        area -= dim * dim - halfDim * halfDim;
+        levels[candidate]++;
+    }
+
+    // Finally, allocate the tiles from the largest to the smallest, in Z-order within each layer,
+    // which keeps all the tiles aligned to their size. The cursor is in units of the smallest
+    // tile.
+    std::array<uint8_t, CONFIG_MAX_SHADOW_CASTING_SPOTS> order; // NOLINT
+    std::iota(order.begin(), order.begin() + count, 0);
+    std::stable_sort(order.begin(), order.begin() + count,
+            [&levels](uint8_t lhs, uint8_t rhs) { return levels[lhs] < levels[rhs]; });
+
+    const uint32_t tilesPerLayer = 1u << (2u * maxLevel);
+    uint8_t layer = firstLayer;
+    uint32_t cursor = 0;
+    for (size_t j = 0; j < count; j++) {
+        ShadowMapEntry& entry = mSpotShadowMaps[order[j]];
+        const uint8_t level = levels[order[j]];
+        const uint32_t tileSize = 1u << (2u * (maxLevel - level));
+        if (cursor + tileSize > tilesPerLayer) {
+            layer++;
+            cursor = 0;
+        }
+        // the position of the tile is given by the deinterleaved bits of the cursor
+        uint32_t x = 0;
+        uint32_t y = 0;
+        for (uint32_t b = 0; b < maxLevel; b++) {
+            x |= ((cursor >> (2u * b)) & 1u) << b;
+            y |= ((cursor >> (2u * b + 1u)) & 1u) << b;
+        }
+        const uint32_t dim = std::min(entry.getShadowOptions()->mapSize, tileDimension(level));
+        entry.setAtlasRegion(layer,
+                { uint16_t(x * minTileDimension), uint16_t(y * minTileDimension) }, uint16_t(dim),
+                SHARED_LAYER_SHADOW_BORDER);
+        cursor += tileSize;
+    }
+    return cursor ? layer + 1u : layer;
+}
+
+uint8_t ShadowMapManager::Test::layoutSpotShadowMaps(ShadowMapManager& shadowMapManager,
+        uint16_t atlasDimension, uint8_t firstLayer, bool shareLayers) noexcept {
+    return shadowMapManager.layoutSpotShadowMaps(atlasDimension, firstLayer, shareLayers);
+}
+
+utils::FixedCapacityVector<ShadowMapManager::Test::AtlasRegion>
+ShadowMapManager::Test::getSpotShadowMapRegions(ShadowMapManager const& shadowMapManager) {
+    auto regions = utils::FixedCapacityVector<AtlasRegion>::with_capacity(
+            shadowMapManager.mSpotShadowMaps.size());
+    for (auto const& entry : shadowMapManager.mSpotShadowMaps) {
+        regions.push_back({ entry.getLightIndex(), entry.getLayer(), entry.getOffset(),
+                entry.getDimension(), entry.getBorder() });
+    }
+    return regions;
+}
+
+ShadowMapManager::StaticShadowCacheState ShadowMapManager::Test::updateSpotStaticShadowCache(
+        ShadowMapManager& shadowMapManager, FEngine& engine, FView const& view,
+        size_t spot, mat4f const& lightSpace, PolygonOffset polygonOffset,
+        FScene::RenderableSoa const& soa, FScene::VisibleMaskType visibilityMask,
+        bool& hasDynamicCasters) noexcept {
+    ShadowMapEntry const& entry = shadowMapManager.mSpotShadowMaps[spot];
+    ShadowMap::Test::setLightSpaceMatrix(entry.getShadowMap(), lightSpace, polygonOffset);
+    return shadowMapManager.updateStaticShadowCache(engine, view, entry, soa,
+            { 0, uint32_t(soa.size()) }, visibilityMask, hasDynamicCasters);
+}
+
 ShadowMapManager::CascadeSplits::CascadeSplits(Params const& params) noexcept
         : mSplitCount(params.cascadeCount + 1) {
     for (size_t s = 0; s < mSplitCount; s++) {
@@ -35,6 +35,7 @@
 
 #include <utils/FixedCapacityVector.h>
 
+#include <math/vec2.h>
 #include <math/vec3.h>
 
 #include <array>
@@ -77,7 +78,12 @@ public:
     void reset() noexcept;
 
     void setShadowCascades(size_t lightIndex, LightManager::ShadowOptions const* options) noexcept;
-    void addSpotShadowMap(size_t lightIndex, LightManager::ShadowOptions const* options) noexcept;
+
+    // Adds a spot light shadow map. importance is used to share the shadow atlas between spot
+    // lights, and to pick which ones cast shadows when there are more than
+    // CONFIG_MAX_SHADOW_CASTING_SPOTS of them.
+    void addSpotShadowMap(size_t lightIndex, LightManager::ShadowOptions const* options,
+            float importance) noexcept;
 
     // Updates all of the shadow maps and performs culling.
     // Returns true if any of the shadow maps have visible shadows.
@@ -117,43 +123,140 @@ public:
 
     auto& getShadowUniformsHandle() const { return mShadowUbh; }
 
+    // Number of times the depth of the static shadow casters of a shadow map was reused (hits)
+    // or had to be rendered again (misses). Shadow maps without static casters aren't counted.
+    uint32_t getStaticShadowCacheHitCount() const noexcept { return mStaticShadowCacheHitCount; }
+    uint32_t getStaticShadowCacheMissCount() const noexcept { return mStaticShadowCacheMissCount; }
+
+    enum class StaticShadowCacheState : uint8_t {
+        NONE,   // no static shadow casters, or VSM, render everything
+        HIT,    // the cached depth is up-to-date, only render the dynamic shadow casters
+        MISS,   // render the static shadow casters in the cache first
+    };
+
+    // For unit tests
+    struct UTILS_PUBLIC Test {
+        struct AtlasRegion {
+            size_t lightIndex;
+            uint8_t layer;
+            math::ushort2 offset;
+            uint16_t dimension;
+            uint8_t border;
+        };
+
+        static uint8_t layoutSpotShadowMaps(ShadowMapManager& shadowMapManager,
+                uint16_t atlasDimension, uint8_t firstLayer, bool shareLayers) noexcept;
+
+        // in the order of the spot light shadow maps, i.e. by decreasing importance
+        static utils::FixedCapacityVector<AtlasRegion> getSpotShadowMapRegions(
+                ShadowMapManager const& shadowMapManager);
+
+        // Sets the light space matrix and polygon offset of the given spot light shadow map as
+        // ShadowMap::update() would, then updates its static shadow cache.
+        static StaticShadowCacheState updateSpotStaticShadowCache(
+                ShadowMapManager& shadowMapManager, FEngine& engine, FView const& view,
+                size_t spot, math::mat4f const& lightSpace, backend::PolygonOffset polygonOffset,
+                FScene::RenderableSoa const& soa, FScene::VisibleMaskType visibilityMask,
+                bool& hasDynamicCasters) noexcept;
+    };
+
 private:
+    // shadowCastersFrustum is set to the frustum to cull the directional shadow casters with.
     ShadowMapManager::ShadowTechnique updateCascadeShadowMaps(FEngine& engine,
             FView& view, CameraInfo const& cameraInfo, FScene::RenderableSoa& renderableData,
-            FScene::LightSoa& lightData, ShadowMap::SceneInfo& sceneInfo) noexcept;
+            FScene::LightSoa& lightData, ShadowMap::SceneInfo& sceneInfo,
+            Frustum& shadowCastersFrustum) noexcept;
 
+    // Also culls the directional shadow casters, if directionalShadowCastersFrustum is given.
     ShadowMapManager::ShadowTechnique updateSpotShadowMaps(FEngine& engine,
             FView& view, CameraInfo const& cameraInfo, FScene::RenderableSoa& renderableData,
-            FScene::LightSoa& lightData, ShadowMap::SceneInfo& sceneInfo) noexcept;
+            FScene::LightSoa& lightData, ShadowMap::SceneInfo& sceneInfo,
+            Frustum const* directionalShadowCastersFrustum) noexcept;
 
     void calculateTextureRequirements(FEngine& engine, FView& view, FScene::LightSoa& lightData) noexcept;
 
+    // Sorts the spot light shadow maps by importance and places them in the atlas, starting at
+    // firstLayer. When shareLayers is set, they're packed as tiles in the layers, otherwise each
+    // gets its own layer. Returns the index past the last layer used.
+    uint8_t layoutSpotShadowMaps(uint16_t atlasDimension, uint8_t firstLayer,
+            bool shareLayers) noexcept;
+
+    // Maximum number of layers of the shadow atlas used by spot lights. Past that, the shadow
+    // maps of the least important spot lights get smaller.
+    static constexpr size_t MAX_SPOT_SHADOW_LAYERS = 14;
+
+    // Spot light shadow maps are never smaller than this, unless requested.
+    static constexpr uint16_t MIN_SPOT_SHADOW_DIMENSION = 64;
+
+    // Border of the shadow maps sharing a layer. The PCF kernel (see ShadowSample_PCF_Low in
+    // shadowing.fs) reads up to 2 texels away from the sample, which must stay in the tile.
+    static constexpr uint8_t SHARED_LAYER_SHADOW_BORDER = 2;
+
+    // The depth of the static shadow casters of a shadow map, kept across frames.
+    struct StaticShadowCache {
+        backend::Handle<backend::HwTexture> texture;
+        // the cache is valid as long as all of these are unchanged
+        math::mat4 lightFromWorld;
+        backend::PolygonOffset polygonOffset;
+        uint32_t castersHash = 0;
+        uint32_t castersGeneration = 0;
+        uint16_t dimension = 0;
+        bool valid = false;
+    };
+
     class ShadowMapEntry {
     public:
         ShadowMapEntry() = default;
-        ShadowMapEntry(ShadowMap* shadowMap, size_t light,
-                LightManager::ShadowOptions const* options) :
-                mShadowMap(shadowMap), mOptions(options), mLightIndex(light) {
+        ShadowMapEntry(ShadowMap* shadowMap, StaticShadowCache* staticCache, size_t light,
+                LightManager::ShadowOptions const* options, float importance = 1.0f) :
+                mShadowMap(shadowMap), mStaticCache(staticCache), mOptions(options),
+                mImportance(importance), mLightIndex(light) {
         }
 
         explicit operator bool() const { return mShadowMap != nullptr; }
 
-        void setLayer(uint8_t layer) noexcept { mLayer = layer; }
+        // where this shadow map lives in the atlas
+        void setAtlasRegion(uint8_t layer, math::ushort2 offset, uint16_t dimension,
+                uint8_t border = 1) noexcept {
+            mLayer = layer;
+            mOffset = offset;
+            mDimension = dimension;
+            mBorder = border;
+        }
         uint8_t getLayer() const noexcept { return mLayer; }
+        math::ushort2 getOffset() const noexcept { return mOffset; }
+        // dimension of the shadow map in the atlas, including the border
+        uint16_t getDimension() const noexcept { return mDimension; }
+        // border around the shadow map, in texels
+        uint8_t getBorder() const noexcept { return mBorder; }
+
+        float getImportance() const noexcept { return mImportance; }
 
         LightManager::ShadowOptions const* getShadowOptions() const noexcept { return mOptions; }
         ShadowMap& getShadowMap() const { return *mShadowMap; }
+        StaticShadowCache& getStaticCache() const { return *mStaticCache; }
         size_t getLightIndex() const { return mLightIndex; }
 
         bool hasVisibleShadows() const { return mShadowMap->hasVisibleShadows(); }
 
     private:
         ShadowMap* mShadowMap = nullptr;
+        StaticShadowCache* mStaticCache = nullptr;
         LightManager::ShadowOptions const* mOptions = nullptr;
+        float mImportance = 1.0f;
         uint32_t mLightIndex = 0;
+        math::ushort2 mOffset{};
+        uint16_t mDimension = 0;
         uint8_t mLayer = 0;
+        uint8_t mBorder = 1;
     };
 
+    // Finds out whether the cached static shadow casters of this shadow map can be used.
+    StaticShadowCacheState updateStaticShadowCache(FEngine& engine, FView const& view,
+            ShadowMapEntry const& entry, FScene::RenderableSoa const& soa,
+            utils::Range<uint32_t> range, FScene::VisibleMaskType visibilityMask,
+            bool& hasDynamicCasters) noexcept;
+
     class CascadeSplits {
     public:
         constexpr static size_t SPLIT_COUNT = CONFIG_MAX_SHADOW_CASCADES + 1;
@@ -228,6 +331,16 @@ private:
     using ShadowMapStorage = std::aligned_storage<sizeof(ShadowMap), alignof(ShadowMap)>::type;
     std::array<ShadowMapStorage,
             CONFIG_MAX_SHADOW_CASCADES + CONFIG_MAX_SHADOW_CASTING_SPOTS> mShadowMapCache;
+
+    // indexed like mShadowMapCache
+    std::array<StaticShadowCache,
+            CONFIG_MAX_SHADOW_CASCADES + CONFIG_MAX_SHADOW_CASTING_SPOTS> mStaticShadowCaches;
+
+    // world origin of the current frame, see CameraInfo::worldOrigin
+    math::mat4 mWorldOrigin;
+
+    uint32_t mStaticShadowCacheHitCount = 0;
+    uint32_t mStaticShadowCacheMissCount = 0;
 };
 
 } // namespace filament
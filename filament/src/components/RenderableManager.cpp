@@ -54,6 +54,7 @@ struct RenderableManager::BuilderDetails {
     bool mCastShadows : 1;
     bool mReceiveShadows : 1;
     bool mScreenSpaceContactShadows : 1;
+    bool mStaticShadowCaster : 1;
     bool mSkinningBufferMode : 1;
     size_t mSkinningBoneCount = 0;
     size_t mMorphTargetCount = 0;
@@ -64,7 +65,8 @@ struct RenderableManager::BuilderDetails {
 
     explicit BuilderDetails(size_t count)
             : mEntries(count), mCulling(true), mCastShadows(false), mReceiveShadows(true),
-              mScreenSpaceContactShadows(false), mSkinningBufferMode(false) {
+              mScreenSpaceContactShadows(false), mStaticShadowCaster(false),
+              mSkinningBufferMode(false) {
     }
     // this is only needed for the explicit instantiation below
     BuilderDetails() = default;
@@ -161,6 +163,11 @@ RenderableManager::Builder& RenderableManager::Builder::screenSpaceContactShadow
     return *this;
 }
 
+RenderableManager::Builder& RenderableManager::Builder::staticShadowCaster(bool enable) noexcept {
+    mImpl->mStaticShadowCaster = enable;
+    return *this;
+}
+
 RenderableManager::Builder& RenderableManager::Builder::skinning(size_t boneCount) noexcept {
     mImpl->mSkinningBoneCount = boneCount;
     return *this;
@@ -334,6 +341,9 @@ void FRenderableManager::create(
         setCastShadows(ci, builder->mCastShadows);
         setReceiveShadows(ci, builder->mReceiveShadows);
         setScreenSpaceContactShadows(ci, builder->mScreenSpaceContactShadows);
+        if (builder->mStaticShadowCaster) {
+            setStaticShadowCaster(ci, true);
+        }
         setCulling(ci, builder->mCulling);
         setSkinning(ci, false);
         setMorphing(ci, builder->mMorphTargetCount);
@@ -501,6 +511,7 @@ void FRenderableManager::setMaterialInstanceAt(Instance instance, uint8_t level,
         Slice<FRenderPrimitive>& primitives = getRenderPrimitives(instance, level);
         if (primitiveIndex < primitives.size()) {
             primitives[primitiveIndex].setMaterialInstance(upcast(mi));
+            invalidateStaticShadowCaster(instance);
             AttributeBitset required = mi->getMaterial()->getRequiredAttributes();
             AttributeBitset declared = primitives[primitiveIndex].getEnabledAttributes();
             if (UTILS_UNLIKELY((declared & required) != required)) {
@@ -554,6 +565,7 @@ void FRenderableManager::setGeometryAt(Instance instance, uint8_t level, size_t
         if (primitiveIndex < primitives.size()) {
             primitives[primitiveIndex].set(mEngine, type, vertices, indices, offset,
                     0, vertices->getVertexCount() - 1, count);
+            invalidateStaticShadowCaster(instance);
         }
     }
 }
@@ -564,6 +576,7 @@ void FRenderableManager::setGeometryAt(Instance instance, uint8_t level, size_t
         Slice<FRenderPrimitive>& primitives = getRenderPrimitives(instance, level);
         if (primitiveIndex < primitives.size()) {
             primitives[primitiveIndex].set(mEngine, type, offset, 0, 0, count);
+            invalidateStaticShadowCaster(instance);
         }
     }
 }
@@ -580,6 +593,7 @@ void FRenderableManager::setBones(Instance ci,
         if (bones.handle) {
             boneCount = std::min(boneCount, bones.count - offset);
             FSkinningBuffer::setBones(mEngine, bones.handle, transforms, boneCount, offset);
+            invalidateStaticShadowCaster(ci);
         }
     }
 }
@@ -596,6 +610,7 @@ void FRenderableManager::setBones(Instance ci,
         if (bones.handle) {
             boneCount = std::min(boneCount, bones.count - offset);
             FSkinningBuffer::setBones(mEngine, bones.handle, transforms, boneCount, offset);
+            invalidateStaticShadowCaster(ci);
         }
     }
 }
@@ -629,6 +644,7 @@ void FRenderableManager::setSkinningBuffer(FRenderableManager::Instance ci,
     bones.handle = skinningBuffer->getHwHandle();
     bones.count = uint16_t(count);
     bones.offset = uint16_t(offset);
+    invalidateStaticShadowCaster(ci);
 }
 
 static void updateMorphWeights(FEngine& engine, backend::Handle<backend::HwBufferObject> handle,
@@ -651,6 +667,7 @@ void FRenderableManager::setMorphWeights(Instance instance, float const* weights
         MorphWeights& morphWeights = mManager[instance].morphWeights;
         if (morphWeights.handle) {
             updateMorphWeights(mEngine, morphWeights.handle, weights, count, offset);
+            invalidateStaticShadowCaster(instance);
         }
     }
 }
@@ -671,6 +688,7 @@ void FRenderableManager::setMorphTargetBufferAt(Instance instance, uint8_t level
         if (primitiveIndex < morphTargets.size()) {
             morphTargets[primitiveIndex] = { morphTargetBuffer, (uint32_t)offset,
                                              (uint32_t)count };
+            invalidateStaticShadowCaster(instance);
         }
     }
 }
@@ -60,6 +60,7 @@ public:
         bool morphing                   : 1;
         bool screenSpaceContactShadows  : 1;
         bool reversedWindingOrder       : 1;
+        bool staticShadowCaster         : 1;
     };
 
     static_assert(sizeof(Visibility) == sizeof(uint16_t), "Visibility should be 16 bits");
@@ -106,6 +107,7 @@ public:
     inline void setLayerMask(Instance instance, uint8_t layerMask) noexcept;
     inline void setReceiveShadows(Instance instance, bool enable) noexcept;
     inline void setScreenSpaceContactShadows(Instance instance, bool enable) noexcept;
+    inline void setStaticShadowCaster(Instance instance, bool enable) noexcept;
     inline void setCulling(Instance instance, bool enable) noexcept;
 
     inline void setPrimitives(Instance instance, utils::Slice<FRenderPrimitive> const& primitives) noexcept;
@@ -127,8 +129,16 @@ public:
 
     inline bool isShadowCaster(Instance instance) const noexcept;
     inline bool isShadowReceiver(Instance instance) const noexcept;
+    inline bool isStaticShadowCaster(Instance instance) const noexcept;
     inline bool isCullingEnabled(Instance instance) const noexcept;
 
+    // Incremented when the geometry, material or skinning of a static shadow caster changes,
+    // or when a renderable becomes or stays a static shadow caster through
+    // setStaticShadowCaster(). Static shadow caches are invalid when it changes.
+    uint32_t getStaticShadowCasterGeneration() const noexcept {
+        return mStaticShadowCasterGeneration;
+    }
+
 
     inline Box const& getAABB(Instance instance) const noexcept;
     inline Box const& getAxisAlignedBoundingBox(Instance instance) const noexcept { return getAABB(instance); }
@@ -175,6 +185,7 @@ public:
     inline utils::Slice<MorphTargets>& getMorphTargets(Instance instance, uint8_t level) noexcept;
 
 private:
+    inline void invalidateStaticShadowCaster(Instance instance) noexcept;
     void destroyComponent(Instance ci) noexcept;
     static void destroyComponentPrimitives(FEngine& engine,
             utils::Slice<FRenderPrimitive>& primitives) noexcept;
@@ -253,6 +264,7 @@ private:
 
     Sim mManager;
     FEngine& mEngine;
+    uint32_t mStaticShadowCasterGeneration = 0;
 };
 
 FILAMENT_UPCAST(RenderableManager)
@@ -305,6 +317,16 @@ void FRenderableManager::setScreenSpaceContactShadows(Instance instance, bool en
     }
 }
 
+void FRenderableManager::setStaticShadowCaster(Instance instance, bool enable) noexcept {
+    if (instance) {
+        Visibility& visibility = mManager[instance].visibility;
+        if (visibility.staticShadowCaster != enable || enable) {
+            mStaticShadowCasterGeneration++;
+        }
+        visibility.staticShadowCaster = enable;
+    }
+}
+
 void FRenderableManager::setCulling(Instance instance, bool enable) noexcept {
     if (instance) {
         Visibility& visibility = mManager[instance].visibility;
@@ -346,10 +368,20 @@ bool FRenderableManager::isShadowReceiver(Instance instance) const noexcept {
     return getVisibility(instance).receiveShadows;
 }
 
+bool FRenderableManager::isStaticShadowCaster(Instance instance) const noexcept {
+    return getVisibility(instance).staticShadowCaster;
+}
+
 bool FRenderableManager::isCullingEnabled(Instance instance) const noexcept {
     return getVisibility(instance).culling;
 }
 
+void FRenderableManager::invalidateStaticShadowCaster(Instance instance) noexcept {
+    if (isStaticShadowCaster(instance)) {
+        mStaticShadowCasterGeneration++;
+    }
+}
+
 uint8_t FRenderableManager::getLayerMask(Instance instance) const noexcept {
     return mManager[instance].layers;
 }
@@ -467,7 +467,7 @@ void FTransformManager::validateNode(Instance i) noexcept {
 
 void FTransformManager::gc(utils::EntityManager& em) noexcept {
     auto& manager = mManager;
-    manager.gc(em, 4, [this](Entity e) {
+    manager.gc(em, Base::DEFAULT_GC_BUDGET, [this](Entity e) {
                 destroy(e);
             });
 }
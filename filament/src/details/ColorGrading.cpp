@@ -31,6 +31,9 @@
 #include <utils/SpinLock.h>
 #include <utils/Systrace.h>
 
+#include <memory>
+#include <vector>
+
 #include <math.h>
 #include <stdlib.h>
 
@@ -509,10 +512,16 @@ inline float3 vibrance(float3 v, float3 luminance, float vibrance) {
 }
 
 UTILS_ALWAYS_INLINE
-inline float3 curves(float3 v, float3 shadowGamma, float3 midPoint, float3 highlightScale) {
+inline float3 curvesShadowScale(float3 shadowGamma, float3 midPoint) {
+    return 1.0f / (pow(midPoint, shadowGamma - 1.0f));
+}
+
+UTILS_ALWAYS_INLINE
+inline float3 curves(float3 v, float3 shadowGamma, float3 midPoint, float3 highlightScale,
+        float3 shadowScale) {
     // "Practical HDR and Wide Color Techniques in Gran Turismo SPORT", Uchimura 2018
-    float3 d = 1.0f / (pow(midPoint, shadowGamma - 1.0f));
-    float3 dark = pow(v, shadowGamma) * d;
+    // shadowScale is curvesShadowScale(shadowGamma, midPoint), computed once per LUT
+    float3 dark = pow(v, shadowGamma) * shadowScale;
     float3 light = highlightScale * (v - midPoint) + midPoint;
     return float3{
         v.r <= midPoint.r ? dark.r : light.r,
@@ -615,33 +624,38 @@ struct Config {
     mat3f  colorGradingIn;
     mat3f  colorGradingOut;
     float3 colorGradingLuminance;
+    float3 curvesShadowScale;
+    // LogC decoding and exposure, which are separable, for each of the lutDimension coordinates
+    const float* linear;
+    // Intermediate stages, see FColorGrading::LutCache, only used when there are adjustments
+    float3* inputStage;
+    float3* gradingStage;
+    bool updateInputStage;
+    bool updateGradingStage;
 };
 
-// Inside the FColorGrading constructor, TSAN sporadically detects a data race on the config struct;
-// the Filament thread writes and the Job thread reads. In practice there should be no data race, so
-// we force TSAN off to silence the warning.
-UTILS_NO_SANITIZE_THREAD
+// Flattens the parameters a cached LUT stage depends on, to detect when it must be regenerated
+template<typename ... T>
+static std::vector<float> makeLutCacheKey(T const& ... values) noexcept {
+    std::vector<float> key;
+    key.reserve((sizeof(T) + ...) / sizeof(float));
+    auto append = [&key](auto const& value) {
+        static_assert(sizeof(value) % sizeof(float) == 0, "keys can only contain floats");
+        float const* p = reinterpret_cast<float const*>(&value);
+        key.insert(key.end(), p, p + sizeof(value) / sizeof(float));
+    };
+    (append(values), ...);
+    return key;
+}
+
 FColorGrading::FColorGrading(FEngine& engine, const Builder& builder) {
     SYSTRACE_CALL();
 
     DriverApi& driver = engine.getDriverApi();
 
-    Config c;
-    // This lock protects the data inside Config, which is written to by the Filament thread,
-    // and read from multiple Job threads.
-    utils::SpinLock configLock;
-    {
-        std::lock_guard<utils::SpinLock> lock(configLock);
-        c.lutDimension          = builder->dimension;
-        c.adaptationTransform   = adaptationTransform(builder->whiteBalance);
-        c.colorGradingIn        = selectColorGradingTransformIn(builder->toneMapping);
-        c.colorGradingOut       = selectColorGradingTransformOut(builder->toneMapping);
-        c.colorGradingLuminance = selectColorGradingLuminance(builder->toneMapping);
-    }
-
-    mDimension = c.lutDimension;
+    mDimension = builder->dimension;
+    const size_t lutElementCount = mDimension * mDimension * mDimension;
 
-    size_t lutElementCount = c.lutDimension * c.lutDimension * c.lutDimension;
     size_t elementSize = sizeof(half4);
     void* data = malloc(lutElementCount * elementSize);
 
@@ -657,10 +671,119 @@ FColorGrading::FColorGrading(FEngine& engine, const Builder& builder) {
         converted = malloc(lutElementCount * sizeof(uint32_t));
     }
 
+    generateLut(engine, builder, (half4*) data, (uint32_t*) converted);
+
+    mLutHandle = driver.createTexture(
+            SamplerType::SAMPLER_3D,
+            1,
+            textureFormat,
+            1,
+            mDimension,
+            mDimension,
+            mDimension,
+            TextureUsage::DEFAULT
+    );
+
+    if (converted) {
+        free(data);
+        data = converted;
+        elementSize = sizeof(uint32_t);
+    }
+
+    driver.update3DImage(mLutHandle, 0,
+            0, 0, 0,
+            mDimension, mDimension, mDimension,
+            PixelBufferDescriptor{
+                    data, lutElementCount * elementSize,format, type,
+                    [](void* buffer, size_t, void*) { free(buffer); }
+            }
+    );
+}
+
+// Inside generateLut(), TSAN sporadically detects a data race on the config struct;
+// the Filament thread writes and the Job thread reads. In practice there should be no data race, so
+// we force TSAN off to silence the warning.
+UTILS_NO_SANITIZE_THREAD
+FColorGrading::LutStages FColorGrading::generateLut(FEngine& engine, Builder const& builder,
+        half4* data, uint32_t* converted) {
+    const size_t lutDimension = builder->dimension;
+    const size_t lutElementCount = lutDimension * lutDimension * lutDimension;
+
+    // The first stages of the LUT (LogC decoding and exposure) are applied to each channel
+    // independently, so we only evaluate them once per coordinate
+    std::vector<float> linear(lutDimension);
+    for (size_t i = 0; i < lutDimension; i++) {
+        float3 v{float(i) * (1.0f / float(lutDimension - 1u))};
+
+        // LogC encoding
+        v = LogC_to_linear(v);
+
+        // Kill negative values near 0.0f due to imprecision in the log conversion
+        v = max(v, 0.0f);
+
+        if (builder->hasAdjustments) {
+            // Exposure
+            v = adjustExposure(v, builder->exposure);
+        }
+
+        linear[i] = v.x;
+    }
+
+    Config c;
+    // This lock protects the data inside Config, which is written to by the Filament thread,
+    // and read from multiple Job threads.
+    utils::SpinLock configLock;
+    {
+        std::lock_guard<utils::SpinLock> lock(configLock);
+        c.lutDimension          = lutDimension;
+        c.adaptationTransform   = adaptationTransform(builder->whiteBalance);
+        c.colorGradingIn        = selectColorGradingTransformIn(builder->toneMapping);
+        c.colorGradingOut       = selectColorGradingTransformOut(builder->toneMapping);
+        c.colorGradingLuminance = selectColorGradingLuminance(builder->toneMapping);
+        c.curvesShadowScale     = curvesShadowScale(builder->shadowGamma, builder->midPoint);
+        c.linear                = linear.data();
+        c.inputStage            = nullptr;
+        c.gradingStage          = nullptr;
+        c.updateInputStage      = false;
+        c.updateGradingStage    = false;
+
+        if (builder->hasAdjustments) {
+            // Only regenerate the stages whose parameters (or whose preceding stages) changed
+            // since the last ColorGrading built by this engine
+            LutCache& cache = engine.getColorGradingCache();
+
+            auto inputKey = makeLutCacheKey(float(lutDimension),
+                    builder->exposure, builder->nightAdaptation,
+                    c.colorGradingIn, c.colorGradingLuminance, builder->whiteBalance,
+                    builder->outRed, builder->outGreen, builder->outBlue,
+                    builder->shadows, builder->midtones, builder->highlights,
+                    builder->tonalRanges);
+            auto gradingKey = makeLutCacheKey(
+                    builder->slope, builder->offset, builder->power, builder->contrast);
+
+            c.updateInputStage = cache.input.key != inputKey;
+            c.updateGradingStage = c.updateInputStage || cache.grading.key != gradingKey;
+
+            if (c.updateInputStage) {
+                cache.input.key = std::move(inputKey);
+                cache.input.texels.resize(lutElementCount);
+            }
+            if (c.updateGradingStage) {
+                cache.grading.key = std::move(gradingKey);
+                cache.grading.texels.resize(lutElementCount);
+            }
+
+            c.inputStage = cache.input.texels.data();
+            c.gradingStage = cache.grading.texels.data();
+        }
+    }
+
     //auto now = std::chrono::steady_clock::now();
 
-    // Multithreadedly generate the tone mapping 3D look-up table using 32 jobs
-    // Slices are 8 KiB (128 cache lines) apart.
+    // Multithreadedly generate the tone mapping 3D look-up table using one job per slice.
+    // Each job runs the pipeline one group of stages at a time over the whole slice, so that
+    // the groups whose parameters didn't change since the last build can be skipped (see
+    // LutCache). The stages themselves still process one texel at a time.
     // This takes about 3-6ms on Android in Release
     JobSystem& js = engine.getJobSystem();
     auto *slices = js.createJob();
@@ -672,109 +795,133 @@ FColorGrading::FColorGrading(FEngine& engine, const Builder& builder) {
                 std::lock_guard<utils::SpinLock> lock(configLock);
                 config = c;
             }
-            half4* UTILS_RESTRICT p = (half4*) data + b * config.lutDimension * config.lutDimension;
-            for (size_t g = 0; g < config.lutDimension; g++) {
-                for (size_t r = 0; r < config.lutDimension; r++) {
-                    float3 v = float3{r, g, b} * (1.0f / float(config.lutDimension - 1u));
-
-                    // LogC encoding
-                    v = LogC_to_linear(v);
-
-                    // Kill negative values near 0.0f due to imprecision in the log conversion
-                    v = max(v, 0.0f);
-
-                    if (builder->hasAdjustments) {
-                        // Exposure
-                        v = adjustExposure(v, builder->exposure);
 
-                        // Purkinje shift ("low-light" vision)
-                        v = scotopicAdaptation(v, builder->nightAdaptation);
+            const size_t dimension = config.lutDimension;
+            const size_t count = dimension * dimension;
+            const size_t offset = b * count;
+            const float* const UTILS_RESTRICT linear = config.linear;
+
+            // Holds the stages that are not cached, i.e. everything when there are no adjustments
+            std::unique_ptr<float3[]> scratch(new float3[count]);
+
+            if (!builder->hasAdjustments) {
+                float3* const UTILS_RESTRICT v = scratch.get();
+                for (size_t g = 0; g < dimension; g++) {
+                    float3* const UTILS_RESTRICT row = v + g * dimension;
+                    for (size_t r = 0; r < dimension; r++) {
+                        // Move to color grading color space
+                        row[r] = config.colorGradingIn * float3{linear[r], linear[g], linear[b]};
                     }
+                }
+            } else {
+                if (config.updateInputStage) {
+                    float3* const UTILS_RESTRICT v = config.inputStage + offset;
+                    for (size_t g = 0; g < dimension; g++) {
+                        float3* const UTILS_RESTRICT row = v + g * dimension;
+                        for (size_t r = 0; r < dimension; r++) {
+                            // Purkinje shift ("low-light" vision)
+                            float3 t = scotopicAdaptation(float3{linear[r], linear[g], linear[b]},
+                                    builder->nightAdaptation);
+
+                            // Move to color grading color space
+                            t = config.colorGradingIn * t;
+
+                            // White balance
+                            t = chromaticAdaptation(t, config.adaptationTransform);
+
+                            // Kill negative values before the next transforms
+                            t = max(t, 0.0f);
+
+                            // Channel mixer
+                            t = channelMixer(t,
+                                    builder->outRed, builder->outGreen, builder->outBlue);
+
+                            // Shadows/mid-tones/highlights
+                            row[r] = tonalRanges(t, config.colorGradingLuminance,
+                                    builder->shadows, builder->midtones, builder->highlights,
+                                    builder->tonalRanges);
+                        }
+                    }
+                }
 
-                    // Move to color grading color space
-                    v = c.colorGradingIn * v;
-
-                    if (builder->hasAdjustments) {
-                        // White balance
-                        v = chromaticAdaptation(v, config.adaptationTransform);
-
-                        // Kill negative values before the next transforms
-                        v = max(v, 0.0f);
-
-                        // Channel mixer
-                        v = channelMixer(v, builder->outRed, builder->outGreen, builder->outBlue);
-
-                        // Shadows/mid-tones/highlights
-                        v = tonalRanges(v, c.colorGradingLuminance,
-                                builder->shadows, builder->midtones, builder->highlights,
-                                builder->tonalRanges);
-
+                if (config.updateGradingStage) {
+                    const float3* const UTILS_RESTRICT src = config.inputStage + offset;
+                    float3* const UTILS_RESTRICT dst = config.gradingStage + offset;
+                    for (size_t i = 0; i < count; i++) {
                         // The adjustments below behave better in log space
-                        v = linear_to_LogC(v);
+                        float3 t = linear_to_LogC(src[i]);
 
                         // ASC CDL
-                        v = colorDecisionList(v, builder->slope, builder->offset, builder->power);
+                        t = colorDecisionList(t, builder->slope, builder->offset, builder->power);
 
                         // Contrast in log space
-                        v = contrast(v, builder->contrast);
+                        t = contrast(t, builder->contrast);
 
                         // Back to linear space
-                        v = LogC_to_linear(v);
+                        dst[i] = LogC_to_linear(t);
+                    }
+                }
 
-                        // Vibrance in linear space
-                        v = vibrance(v, c.colorGradingLuminance, builder->vibrance);
+                const float3* const UTILS_RESTRICT src = config.gradingStage + offset;
+                float3* const UTILS_RESTRICT dst = scratch.get();
+                for (size_t i = 0; i < count; i++) {
+                    // Vibrance in linear space
+                    float3 t = vibrance(src[i], config.colorGradingLuminance, builder->vibrance);
 
-                        // Saturation in linear space
-                        v = saturation(v, c.colorGradingLuminance, builder->saturation);
+                    // Saturation in linear space
+                    t = saturation(t, config.colorGradingLuminance, builder->saturation);
 
-                        // Kill negative values before curves
-                        v = max(v, 0.0f);
+                    // Kill negative values before curves
+                    t = max(t, 0.0f);
 
-                        // RGB curves
-                        v = curves(v,
-                                builder->shadowGamma, builder->midPoint, builder->highlightScale);
-                    }
+                    // RGB curves
+                    dst[i] = curves(t, builder->shadowGamma, builder->midPoint,
+                            builder->highlightScale, config.curvesShadowScale);
+                }
+            }
 
-                    // Tone mapping
-                    if (builder->luminanceScaling) {
-                        v = luminanceScaling(v, *builder->toneMapper, c.colorGradingLuminance);
-                    } else {
-                        v = (*builder->toneMapper)(v);
-                    }
+            half4* UTILS_RESTRICT p = (half4*) data + offset;
+            const float3* const UTILS_RESTRICT src = scratch.get();
+            for (size_t i = 0; i < count; i++) {
+                float3 v = src[i];
 
-                    // Go back to display color space
-                    v = c.colorGradingOut * v;
+                // Tone mapping
+                if (builder->luminanceScaling) {
+                    v = luminanceScaling(v, *builder->toneMapper, config.colorGradingLuminance);
+                } else {
+                    v = (*builder->toneMapper)(v);
+                }
 
-                    // Apply gamut mapping
-                    if (builder->gamutMapping) {
-                        // TODO: This should depend on the output color space
-                        v = gamutMapping_sRGB(v);
-                    }
+                // Go back to display color space
+                v = config.colorGradingOut * v;
 
-                    // TODO: We should convert to the output color space if we use a working
-                    //       color space that's not sRGB
-                    // TODO: Allow the user to customize the output color space
+                // Apply gamut mapping
+                if (builder->gamutMapping) {
+                    // TODO: This should depend on the output color space
+                    v = gamutMapping_sRGB(v);
+                }
 
-                    // We need to clamp for the output transfer function
-                    v = saturate(v);
+                // TODO: We should convert to the output color space if we use a working
+                //       color space that's not sRGB
+                // TODO: Allow the user to customize the output color space
 
-                    // Apply OETF
-                    v = OETF_sRGB(v);
+                // We need to clamp for the output transfer function
+                v = saturate(v);
 
-                    *p++ = half4{v, 0.0f};
-                }
+                // Apply OETF
+                v = OETF_sRGB(v);
+
+                p[i] = half4{v, 0.0f};
             }
 
             if (converted) {
-                uint32_t* const UTILS_RESTRICT dst = (uint32_t*) converted +
-                        b * config.lutDimension * config.lutDimension;
-                half4* UTILS_RESTRICT src = (half4*) data +
-                        b * config.lutDimension * config.lutDimension;
+                uint32_t* const UTILS_RESTRICT dst = (uint32_t*) converted + offset;
+                half4* UTILS_RESTRICT src = (half4*) data + offset;
                 // we use a vectorize width of 8 because, on ARMv8 it allows the compiler to write eight
                 // 32-bits results in one go.
-                const size_t count = (config.lutDimension * config.lutDimension) & ~0x7u; // tell the compiler that we're a multiple of 8
+                const size_t count8 = count & ~0x7u; // tell the compiler that we're a multiple of 8
                 #pragma clang loop vectorize_width(8)
-                for (size_t i = 0; i < count; ++i) {
+                for (size_t i = 0; i < count8; ++i) {
                     float4 v{src[i]};
                     uint32_t pr = uint32_t(std::floor(v.x * 1023.0f + 0.5f));
                     uint32_t pg = uint32_t(std::floor(v.y * 1023.0f + 0.5f));
@@ -794,31 +941,7 @@ FColorGrading::FColorGrading(FEngine& engine, const Builder& builder) {
     //std::chrono::duration<float, std::milli> duration = std::chrono::steady_clock::now() - now;
     //slog.d << "LUT generation time: " << duration.count() << " ms" << io::endl;
 
-    mLutHandle = driver.createTexture(
-            SamplerType::SAMPLER_3D,
-            1,
-            textureFormat,
-            1,
-            c.lutDimension,
-            c.lutDimension,
-            c.lutDimension,
-            TextureUsage::DEFAULT
-    );
-
-    if (converted) {
-        free(data);
-        data = converted;
-        elementSize = sizeof(uint32_t);
-    }
-
-    driver.update3DImage(mLutHandle, 0,
-            0, 0, 0,
-            c.lutDimension, c.lutDimension, c.lutDimension,
-            PixelBufferDescriptor{
-                    data, lutElementCount * elementSize,format, type,
-                    [](void* buffer, size_t, void*) { free(buffer); }
-            }
-    );
+    return { c.updateInputStage, c.updateGradingStage };
 }
 
 FColorGrading::~FColorGrading() noexcept = default;
@@ -828,4 +951,20 @@ void FColorGrading::terminate(FEngine& engine) {
     driver.destroyTexture(mLutHandle);
 }
 
+FColorGrading::Test::Lut FColorGrading::Test::generateLut(FEngine& engine,
+        Builder const& builder) {
+    // finalize a copy of the builder, as Builder::build() does
+    Builder finalized(builder);
+    const Builder defaults;
+    finalized->hasAdjustments = *defaults.operator->() != *finalized.operator->();
+    assert_invariant(finalized->toneMapper);
+
+    const size_t dimension = finalized->dimension;
+    Lut lut{ std::vector<half4>(dimension * dimension * dimension, half4{ 0.0f }), false, false };
+    LutStages stages = FColorGrading::generateLut(engine, finalized, lut.texels.data(), nullptr);
+    lut.inputStageUpdated = stages.input;
+    lut.gradingStageUpdated = stages.grading;
+    return lut;
+}
+
 } //namespace filament
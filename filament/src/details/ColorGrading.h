@@ -24,7 +24,11 @@
 
 #include <filament/ColorGrading.h>
 
-#include <math/mathfwd.h>
+#include <math/half.h>
+#include <math/vec3.h>
+#include <math/vec4.h>
+
+#include <vector>
 
 namespace filament {
 
@@ -32,6 +36,18 @@ class FEngine;
 
 class FColorGrading : public ColorGrading {
 public:
+    // Intermediate stages of the last LUT generated with adjustments. FEngine keeps one around
+    // so that rebuilding a ColorGrading after changing only late-stage parameters (vibrance,
+    // saturation, curves, tone mapping...) skips the earlier stages. At most 6 MiB (64^3 LUT).
+    struct LutCache {
+        struct Stage {
+            std::vector<float> key;             // parameters this stage depends on
+            std::vector<math::float3> texels;   // output of this stage, for each texel of the LUT
+        };
+        Stage input;    // exposure to shadows/mid-tones/highlights
+        Stage grading;  // ASC CDL and contrast, in log space
+    };
+
     FColorGrading(FEngine& engine, const Builder& builder);
     FColorGrading(const FColorGrading& rhs) = delete;
     FColorGrading& operator=(const FColorGrading& rhs) = delete;
@@ -45,7 +61,30 @@ public:
 
     uint32_t getDimension() const noexcept { return mDimension; }
 
+    // For unit tests
+    struct UTILS_PUBLIC Test {
+        struct Lut {
+            std::vector<math::half4> texels;    // always RGBA16F
+            bool inputStageUpdated;             // the cached stages had to be regenerated
+            bool gradingStageUpdated;
+        };
+
+        // Generates the LUT a ColorGrading built from builder with this engine would use,
+        // updating the engine's LutCache. The builder must set a ToneMapper.
+        static Lut generateLut(FEngine& engine, Builder const& builder);
+    };
+
 private:
+    struct LutStages {
+        bool input;
+        bool grading;
+    };
+
+    // Generates the LUT of a builder finalized by Builder::build() in data, and in converted as
+    // UINT_2_10_10_10_REV if not null. Returns the cached stages that were regenerated.
+    static LutStages generateLut(FEngine& engine, Builder const& builder,
+            math::half4* data, uint32_t* converted);
+
     backend::TextureHandle mLutHandle;
     uint32_t mDimension;
 };
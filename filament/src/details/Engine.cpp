@@ -37,6 +37,7 @@
 #include "details/View.h"
 
 #include <private/filament/SibGenerator.h>
+#include <private/filament/UibStructs.h>
 
 #include <filament/MaterialEnums.h>
 
@@ -49,6 +50,7 @@
 #include <utils/Systrace.h>
 #include <utils/ThreadUtils.h>
 
+#include <limits>
 #include <memory>
 
 #include "generated/resources/materials.h"
@@ -377,6 +379,13 @@ void FEngine::shutdown() {
     mCameraManager.terminate();             // free-up all cameras
 
     driver.destroyRenderPrimitive(mFullScreenTriangleRph);
+    for (auto handle : mRetiredInstancedUbhs) {
+        driver.destroyBufferObject(handle);
+    }
+    mRetiredInstancedUbhs.clear();
+    if (mInstancedUbh) {
+        driver.destroyBufferObject(mInstancedUbh);
+    }
     destroy(mFullScreenTriangleIb);
     destroy(mFullScreenTriangleVb);
     destroy(mDummyMorphTargetBuffer);
@@ -466,6 +475,14 @@ void FEngine::prepare() {
     // skipped is the UBO hasn't changed. Still we could have a lot of these.
     FEngine::DriverApi& driver = getDriverApi();
 
+    // The instanced UBO is refilled every frame. The commands of the previous frame were all
+    // executed by now, so the buffers it outgrew can go.
+    for (auto handle : mRetiredInstancedUbhs) {
+        driver.destroyBufferObject(handle);
+    }
+    mRetiredInstancedUbhs.clear();
+    mInstancedUboCount = 0;
+
     for (auto& materialInstanceList: mMaterialInstances) {
         materialInstanceList.second.forEach([&driver](FMaterialInstance* item) {
             item->commit(driver);
@@ -481,6 +498,33 @@ void FEngine::prepare() {
     });
 }
 
+std::pair<Handle<HwBufferObject>, uint32_t> FEngine::allocateInstancedUbo(
+        uint32_t count) noexcept {
+    // instanced commands index the UBO with 16 bits
+    const uint32_t first = mInstancedUboCount;
+    if (first + count > std::numeric_limits<uint16_t>::max()) {
+        return {};
+    }
+
+    // The whole PerRenderableUib is bound at the offset of each instanced command,
+    // so we need room for CONFIG_MAX_INSTANCES - 1 elements past the last one.
+    const uint32_t needed = first + count + CONFIG_MAX_INSTANCES - 1;
+    if (mInstancedUboCapacity < needed) {
+        // The commands of the passes that were instanced earlier this frame still use the
+        // current buffer, we keep it alive until the next frame.
+        if (mInstancedUbh) {
+            mRetiredInstancedUbhs.push_back(mInstancedUbh);
+        }
+        // allocate 1/3 extra, with a minimum of 64 objects
+        mInstancedUboCapacity = std::max(64u, (4u * needed + 2u) / 3u);
+        mInstancedUbh = getDriverApi().createBufferObject(
+                mInstancedUboCapacity * sizeof(PerRenderableData),
+                BufferObjectBinding::UNIFORM, BufferUsage::DYNAMIC);
+    }
+    mInstancedUboCount = first + count;
+    return { mInstancedUbh, first };
+}
+
 void FEngine::gc() {
     // Note: this runs in a Job
     auto& em = mEntityManager;
@@ -1002,12 +1046,16 @@ bool FEngine::execute() {
     }
 
     // execute all command buffers
+    using namespace std::chrono;
+    const steady_clock::time_point start = steady_clock::now();
     for (auto& item : buffers) {
         if (UTILS_LIKELY(item.begin)) {
             getDriverApi().execute(item.begin);
             mCommandBufferQueue.releaseBuffer(item);
         }
     }
+    mDriverExecutionTime.fetch_add(uint64_t(duration_cast<nanoseconds>(
+            steady_clock::now() - start).count()), std::memory_order_relaxed);
 
     return true;
 }
@@ -75,11 +75,14 @@ using MaterialKey = uint32_t;
 #include <utils/JobSystem.h>
 #include <utils/CountDownLatch.h>
 
+#include <atomic>
 #include <chrono>
 #include <memory>
 #include <new>
 #include <random>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace filament {
 
@@ -168,6 +171,7 @@ public:
     const FIndirectLight* getDefaultIndirectLight() const noexcept { return mDefaultIbl; }
     const FTexture* getDummyCubemap() const noexcept { return mDefaultIblTexture; }
     const FColorGrading* getDefaultColorGrading() const noexcept { return mDefaultColorGrading; }
+    FColorGrading::LutCache& getColorGradingCache() noexcept { return mColorGradingCache; }
     FMorphTargetBuffer* getDummyMorphTargetBuffer() const { return mDummyMorphTargetBuffer; }
 
     backend::Handle<backend::HwRenderPrimitive> getFullScreenRenderPrimitive() const noexcept {
@@ -226,6 +230,21 @@ public:
         return mPlatform;
     }
 
+    void setAutomaticInstancingEnabled(bool enable) noexcept {
+        mAutomaticInstancingEnabled = enable;
+    }
+
+    bool isAutomaticInstancingEnabled() const noexcept {
+        return mAutomaticInstancingEnabled;
+    }
+
+    // Reserves room for count PerRenderableData in the UBO of automatically instanced draw
+    // calls, which is shared by all the render passes of a frame (see RenderPass::instancify()).
+    // Returns the UBO and the index of the first reserved element, or a null handle if the
+    // frame ran out of instanced elements.
+    std::pair<backend::Handle<backend::HwBufferObject>, uint32_t> allocateInstancedUbo(
+            uint32_t count) noexcept;
+
     ResourceAllocator& getResourceAllocator() noexcept {
         assert_invariant(mResourceAllocator);
         return *mResourceAllocator;
@@ -338,6 +357,25 @@ public:
 
     bool execute();
 
+    // time in nanoseconds spent by the driver thread executing commands since the last call
+    uint64_t getAndResetDriverExecutionTime() noexcept {
+        return mDriverExecutionTime.exchange(0, std::memory_order_relaxed);
+    }
+
+    // total size in bytes of the command buffers flushed so far
+    uint64_t getCommandStreamFlushedSize() const noexcept {
+        return mCommandBufferQueue.getFlushedSize();
+    }
+
+    // total number of draw and multi-draw calls issued by render passes so far
+    uint64_t getRenderPassDrawCount() const noexcept {
+        return mRenderPassDrawCount;
+    }
+
+    void addRenderPassDrawCount(uint32_t count) noexcept {
+        mRenderPassDrawCount += count;
+    }
+
     utils::JobSystem& getJobSystem() noexcept {
         return mJobSystem;
     }
@@ -382,6 +420,12 @@ private:
     Backend mBackend;
     Platform* mPlatform = nullptr;
     bool mOwnPlatform = false;
+    bool mAutomaticInstancingEnabled = false;
+    // grow-only UBO of automatically instanced draw calls, and the buffers it outgrew this frame
+    backend::Handle<backend::HwBufferObject> mInstancedUbh;
+    uint32_t mInstancedUboCapacity = 0;     // in PerRenderableData
+    uint32_t mInstancedUboCount = 0;        // in PerRenderableData, reset every frame
+    std::vector<backend::Handle<backend::HwBufferObject>> mRetiredInstancedUbhs;
     void* mSharedGLContext = nullptr;
     backend::Handle<backend::HwRenderPrimitive> mFullScreenTriangleRph;
     FVertexBuffer* mFullScreenTriangleVb = nullptr;
@@ -431,6 +475,8 @@ private:
     static_assert( sizeof(mDriverApiStorage) >= sizeof(DriverApi) );
 
     uint32_t mFlushCounter = 0;
+    std::atomic<uint64_t> mDriverExecutionTime{ 0 };
+    uint64_t mRenderPassDrawCount = 0;
 
     LinearAllocatorArena mPerRenderPassAllocator;
     HeapAllocatorArena mHeapAllocator;
@@ -449,6 +495,7 @@ private:
     mutable FIndirectLight* mDefaultIbl = nullptr;
 
     mutable FColorGrading* mDefaultColorGrading = nullptr;
+    FColorGrading::LutCache mColorGradingCache;
     FMorphTargetBuffer* mDummyMorphTargetBuffer = nullptr;
 
     mutable utils::CountDownLatch mDriverBarrier;
@@ -474,6 +521,7 @@ public:
             bool lispsm = true;
             bool visualize_cascades = false;
             bool tightly_bound_scene = true;
+            bool static_cache = true;
             float dzn = -1.0f;
             float dzf =  1.0f;
         } shadowmap;
@@ -193,6 +193,9 @@ bool FRenderer::beginFrame(FSwapChain* swapChain, uint64_t vsyncSteadyClockTimeN
 
     mFrameId++;
 
+    mFrameStatistics = { .frameId = mFrameId };
+    mFrameStatisticsBeginTime = now;
+
     { // scope for frame id trace
         char buf[64];
         snprintf(buf, 64, "frame %u", mFrameId);
@@ -314,6 +317,24 @@ void FRenderer::endFrame() {
 
     // make sure we're done with the gcs
     js.waitAndRelease(job);
+
+    // record this frame's statistics
+    FrameStatistics& stats = mFrameStatistics;
+    stats.frameTime = elapsedSince(mFrameStatisticsBeginTime);
+    stats.driverExecutionTime = engine.getAndResetDriverExecutionTime();
+    const uint64_t flushedSize = engine.getCommandStreamFlushedSize();
+    stats.commandStreamSize = uint32_t(flushedSize - mFrameStatisticsFlushedSize);
+    mFrameStatisticsFlushedSize = flushedSize;
+    mFrameStatisticsHistory[mFrameStatisticsCount % FRAME_STATISTICS_HISTORY] = stats;
+    mFrameStatisticsCount++;
+}
+
+size_t FRenderer::getFrameStatistics(FrameStatistics* out, size_t count) const noexcept {
+    count = std::min({ count, size_t(mFrameStatisticsCount), FRAME_STATISTICS_HISTORY });
+    for (size_t i = 0; i < count; i++) {
+        out[i] = mFrameStatisticsHistory[(mFrameStatisticsCount - 1 - i) % FRAME_STATISTICS_HISTORY];
+    }
+    return count;
 }
 
 void FRenderer::readPixels(uint32_t xoffset, uint32_t yoffset, uint32_t width, uint32_t height,
@@ -401,12 +422,55 @@ void FRenderer::renderStandaloneView(FView const* view) {
         FEngine::DriverApi& driver = engine.getDriverApi();
         driver.beginFrame(steady_clock::now().time_since_epoch().count(), mFrameId);
 
-        renderInternal(view);
+        // standalone views are not part of the frame statistics
+        const uint64_t flushedSize = engine.getCommandStreamFlushedSize();
+        FrameStatistics statistics{};
+        renderInternal(view, statistics);
 
         driver.endFrame(mFrameId);
+        mFrameStatisticsFlushedSize += engine.getCommandStreamFlushedSize() - flushedSize;
     }
 }
 
+void FRenderer::renderStandaloneViews(View const* const* views, size_t count) {
+    SYSTRACE_CALL();
+
+    using namespace std::chrono;
+
+    for (size_t i = 0; i < count; i++) {
+        FView const* const view = upcast(views[i]);
+        ASSERT_PRECONDITION(view->getRenderTarget(),
+                "View \"%s\" must have a RenderTarget associated", view->getName());
+    }
+
+    mPreviousRenderTargets.clear();
+    mFrameId++;
+
+    // ask the engine to do what it needs to (e.g. updates light buffer, materials...), once
+    // for all the views
+    FEngine& engine = mEngine;
+    engine.prepare();
+
+    FEngine::DriverApi& driver = engine.getDriverApi();
+    driver.beginFrame(steady_clock::now().time_since_epoch().count(), mFrameId);
+
+    // standalone views are not part of the frame statistics
+    const uint64_t flushedSize = engine.getCommandStreamFlushedSize();
+    FrameStatistics statistics{};
+
+    mPreparedScene = PreparedScene{};
+    for (size_t i = 0; i < count; i++) {
+        FView const* const view = upcast(views[i]);
+        if (UTILS_LIKELY(view->getScene())) {
+            renderInternal(view, statistics);
+        }
+    }
+    mPreparedScene.reset();
+
+    driver.endFrame(mFrameId);
+    mFrameStatisticsFlushedSize += engine.getCommandStreamFlushedSize() - flushedSize;
+}
+
 void FRenderer::render(FView const* view) {
     SYSTRACE_CALL();
 
@@ -422,11 +486,11 @@ void FRenderer::render(FView const* view) {
     if (UTILS_LIKELY(view && view->getScene())) {
         // NOTE: in the past we tried to kick the GPU here with a flush (b2cdf9f), but this
         // was problematic on certain devices. b/232224942
-        renderInternal(view);
+        renderInternal(view, mFrameStatistics);
     }
 }
 
-void FRenderer::renderInternal(FView const* view) {
+void FRenderer::renderInternal(FView const* view, FrameStatistics& statistics) {
     // per-renderpass data
     ArenaScope rootArena(mPerRenderPassArena);
 
@@ -437,7 +501,7 @@ void FRenderer::renderInternal(FView const* view) {
     auto *rootJob = js.setRootJob(js.createJob());
 
     // execute the render pass
-    renderJob(rootArena, const_cast<FView&>(*view));
+    renderJob(rootArena, const_cast<FView&>(*view), statistics);
 
     // make sure to flush the command buffer
     engine.flush();
@@ -446,7 +510,7 @@ void FRenderer::renderInternal(FView const* view) {
     js.runAndWait(rootJob);
 }
 
-void FRenderer::renderJob(ArenaScope& arena, FView& view) {
+void FRenderer::renderJob(ArenaScope& arena, FView& view, FrameStatistics& statistics) {
     FEngine& engine = mEngine;
     JobSystem& js = engine.getJobSystem();
     FEngine::DriverApi& driver = engine.getDriverApi();
@@ -594,16 +658,40 @@ void FRenderer::renderJob(ArenaScope& arena, FView& view) {
         xvp.bottom = int32_t(guardBand);
     }
 
-    view.prepare(engine, driver, arena, svp, cameraInfo, getShaderUserTime(), needsAlphaChannel);
+    // Within a renderStandaloneViews() batch, nothing can change between two views, so a view
+    // can reuse the scene gathered by the previous one if it used the same world origin.
+    bool sceneAlreadyPrepared = false;
+    if (mPreparedScene) {
+        PreparedScene& prepared = *mPreparedScene;
+        FScene const* const scene = view.getScene();
+        const bool shadowReceiversAreCasters = view.hasVSM();
+        mat4 const& worldOrigin = cameraInfo.worldOrigin;
+        sceneAlreadyPrepared = prepared.scene == scene &&
+                prepared.shadowReceiversAreCasters == shadowReceiversAreCasters &&
+                prepared.worldOrigin[0] == worldOrigin[0] &&
+                prepared.worldOrigin[1] == worldOrigin[1] &&
+                prepared.worldOrigin[2] == worldOrigin[2] &&
+                prepared.worldOrigin[3] == worldOrigin[3];
+        prepared = { scene, worldOrigin, shadowReceiversAreCasters };
+    }
+
+    view.prepare(engine, driver, arena, svp, cameraInfo, getShaderUserTime(), needsAlphaChannel,
+            statistics, sceneAlreadyPrepared);
 
     view.prepareUpscaler(scale);
 
     // start froxelization immediately, it has no dependencies
     JobSystem::Job* jobFroxelize = nullptr;
     if (view.hasDynamicLighting()) {
+        // the froxelization time is written before the job is waited on, below
         jobFroxelize = js.runAndRetain(js.createJob(nullptr,
-                [&engine, &view, &viewMatrix = cameraInfo.view](JobSystem&, JobSystem::Job*) {
-                    view.froxelize(engine, viewMatrix); }));
+                [&engine, &view, &viewMatrix = cameraInfo.view,
+                        &froxelizationTime = statistics.froxelizationTime]
+                        (JobSystem&, JobSystem::Job*) {
+                    const clock::time_point start = clock::now();
+                    view.froxelize(engine, viewMatrix);
+                    froxelizationTime += elapsedSince(start);
+                }));
     }
 
     /*
@@ -723,7 +811,8 @@ void FRenderer::renderJob(ArenaScope& arena, FView& view) {
             scene.getRenderableData(), view.getVisibleRenderables());
 
     pass.setCamera(cameraInfo);
-    pass.setGeometry(scene.getRenderableData(), view.getVisibleRenderables(), scene.getRenderableUBO());
+    pass.setGeometry(scene.getRenderableData(), view.getVisibleRenderables(), scene.getRenderableUBO(),
+            scene.getRenderableUBOData());
 
     // view set-ups that need to happen before rendering
     fg.addTrivialSideEffectPass("Prepare View Uniforms",
@@ -837,8 +926,13 @@ void FRenderer::renderJob(ArenaScope& arena, FView& view) {
     // This one doesn't need to be a FrameGraph pass because it always happens by construction
     // (i.e. it won't be culled, unless everything is culled), so no need to complexify things.
     pass.setVariant(variant);
+    clock::time_point time = clock::now();
     pass.appendCommands(RenderPass::COLOR);
+    statistics.commandGenerationTime += elapsedSince(time);
+    time = clock::now();
     pass.sortCommands();
+    statistics.commandSortTime += elapsedSince(time);
+    statistics.commandCount += uint32_t(pass.end() - pass.begin());
 
     FrameGraphTexture::Descriptor desc = {
             .width = config.width,
@@ -1051,11 +1145,17 @@ void FRenderer::renderJob(ArenaScope& arena, FView& view) {
 
     fg.present(fgViewRenderTarget);
 
+    time = clock::now();
     fg.compile();
+    statistics.frameGraphCompileTime += elapsedSince(time);
 
     //fg.export_graphviz(slog.d, view.getName());
 
+    time = clock::now();
+    const uint64_t drawCount = engine.getRenderPassDrawCount();
     fg.execute(driver);
+    statistics.commandEncodingTime += elapsedSince(time);
+    statistics.drawCount += uint32_t(engine.getRenderPassDrawCount() - drawCount);
 
     // save the current history entry and destroy the oldest entry
     view.commitFrameHistory(engine);
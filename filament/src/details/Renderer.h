@@ -41,8 +41,14 @@
 #include <utils/compiler.h>
 #include <utils/Allocator.h>
 
+#include <math/mat4.h>
+
 #include <tsl/robin_set.h>
 
+#include <array>
+#include <chrono>
+#include <optional>
+
 namespace filament {
 
 namespace backend {
@@ -51,6 +57,7 @@ class Driver;
 
 class FEngine;
 class FRenderTarget;
+class FScene;
 class FView;
 
 /*
@@ -58,6 +65,7 @@ class FView;
  */
 class FRenderer : public Renderer {
     static constexpr unsigned MAX_FRAMETIME_HISTORY = 32u;
+    static constexpr size_t FRAME_STATISTICS_HISTORY = 16u;
 
 public:
     explicit FRenderer(FEngine& engine);
@@ -75,6 +83,9 @@ public:
     // renders a single standalone view. The view must have a a custom rendertarget.
     void renderStandaloneView(FView const* view);
 
+    // renders several standalone views back to back, sharing the scenes' preparation.
+    void renderStandaloneViews(View const* const* views, size_t count);
+
 
     void setPresentationTime(int64_t monotonic_clock_ns);
 
@@ -127,6 +138,8 @@ public:
         mClearOptions = options;
     }
 
+    size_t getFrameStatistics(FrameStatistics* out, size_t count) const noexcept;
+
 private:
     friend class Renderer;
     using Command = RenderPass::Command;
@@ -154,8 +167,14 @@ private:
         return mCommandsHighWatermark;
     }
 
-    void renderInternal(FView const* view);
-    void renderJob(ArenaScope& arena, FView& view);
+    // statistics receives the work of the view, see FrameStatistics
+    void renderInternal(FView const* view, FrameStatistics& statistics);
+    void renderJob(ArenaScope& arena, FView& view, FrameStatistics& statistics);
+
+    static uint64_t elapsedSince(clock::time_point since) noexcept {
+        return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                clock::now() - since).count());
+    }
 
     // keep a reference to our engine
     FEngine& mEngine;
@@ -179,6 +198,22 @@ private:
     tsl::robin_set<FRenderTarget*> mPreviousRenderTargets;
     std::function<void()> mBeginFrameInternal;
 
+    // the scene gathered by the previous view of a renderStandaloneViews() batch, only
+    // engaged during renderStandaloneViews()
+    struct PreparedScene {
+        FScene const* scene = nullptr;
+        math::mat4 worldOrigin;
+        bool shadowReceiversAreCasters = false;
+    };
+    std::optional<PreparedScene> mPreparedScene;
+
+    // statistics of the current frame and ring buffer of the last completed frames
+    FrameStatistics mFrameStatistics;
+    Epoch mFrameStatisticsBeginTime;
+    uint64_t mFrameStatisticsFlushedSize = 0;
+    std::array<FrameStatistics, FRAME_STATISTICS_HISTORY> mFrameStatisticsHistory;
+    uint32_t mFrameStatisticsCount = 0;
+
     // per-frame arena for this Renderer
     LinearAllocatorArena& mPerRenderPassArena;
 };
@@ -185,6 +185,21 @@ void FScene::prepare(const mat4& worldOriginTransform, bool shadowReceiversAreCa
         new(lightData.data<POSITION_RADIUS>() + i) float4{ 0, 0, 0, 1 };
     }
 
+    // keep a copy of the gathered lights, so that other views of a batch can reuse this
+    // preparation (see restoreGatheredLights())
+    auto& gatheredLightData = mGatheredLightData;
+    gatheredLightData.clear();
+    if (gatheredLightData.capacity() < lightData.size()) {
+        gatheredLightData.setCapacity(lightDataCapacity);
+    }
+    gatheredLightData.resize(lightData.size());
+    std::copy_n(lightData.data<POSITION_RADIUS>(), lightData.size(),
+            gatheredLightData.data<0>());
+    std::copy_n(lightData.data<DIRECTION>(), lightData.size(),
+            gatheredLightData.data<1>());
+    std::copy_n(lightData.data<LIGHT_INSTANCE>(), lightData.size(),
+            gatheredLightData.data<2>());
+
     // Purely for the benefit of MSAN, we can avoid uninitialized reads by zeroing out the
     // unused scene elements between the end of the array and the rounded-up count.
     if (UTILS_HAS_SANITIZE_MEMORY) {
@@ -196,14 +211,36 @@ void FScene::prepare(const mat4& worldOriginTransform, bool shadowReceiversAreCa
     }
 }
 
+void FScene::restoreGatheredLights() noexcept {
+    auto const& gatheredLightData = mGatheredLightData;
+    auto& lightData = mLightData;
+    const size_t count = gatheredLightData.size();
+    assert_invariant(count <= lightData.capacity());
+
+    // reset all the per-view fields
+    lightData.clear();
+    lightData.resize(count);
+    std::copy_n(gatheredLightData.data<0>(), count, lightData.data<POSITION_RADIUS>());
+    std::copy_n(gatheredLightData.data<1>(), count, lightData.data<DIRECTION>());
+    std::copy_n(gatheredLightData.data<2>(), count, lightData.data<LIGHT_INSTANCE>());
+}
+
 void FScene::updateUBOs(utils::Range<uint32_t> visibleRenderables, backend::Handle<backend::HwBufferObject> renderableUbh) noexcept {
     FEngine::DriverApi& driver = mEngine.getDriverApi();
     FRenderableManager& rcm = mEngine.getRenderableManager();
 
-    const size_t size = visibleRenderables.size() * sizeof(PerRenderableUib);
+    const size_t size = visibleRenderables.size() * sizeof(PerRenderableData);
 
-    // allocate space into the command stream directly
-    void* const buffer = driver.allocatePod<PerRenderableUib>(visibleRenderables.size());
+    // With automatic instancing, RenderPass needs a CPU copy of the per-renderable data,
+    // otherwise we allocate space into the command stream directly.
+    const bool keepCopy = mEngine.isAutomaticInstancingEnabled();
+    if (keepCopy && mRenderableUboData.size() < visibleRenderables.size()) {
+        mRenderableUboData.resize(visibleRenderables.size());
+    } else if (!keepCopy && !mRenderableUboData.empty()) {
+        mRenderableUboData = {};
+    }
+    void* const buffer = keepCopy ? (void*)mRenderableUboData.data() :
+            driver.allocatePod<PerRenderableData>(visibleRenderables.size());
 
     bool hasContactShadows = false;
     auto& sceneData = mRenderableData;
@@ -212,10 +249,10 @@ void FScene::updateUBOs(utils::Range<uint32_t> visibleRenderables, backend::Hand
         FRenderableManager::Visibility visibility = sceneData.elementAt<VISIBILITY_STATE>(i);
         auto ri = sceneData.elementAt<RENDERABLE_INSTANCE>(i);
 
-        const size_t offset = i * sizeof(PerRenderableUib);
+        const size_t offset = i * sizeof(PerRenderableData);
 
         UniformBuffer::setUniform(buffer,
-                offset + offsetof(PerRenderableUib, worldFromModelMatrix), model);
+                offset + offsetof(PerRenderableData, worldFromModelMatrix), model);
 
         // Using mat3f::getTransformForNormals handles non-uniform scaling, but DOESN'T guarantee that
         // the transformed normals will have unit-length, therefore they need to be normalized
@@ -239,7 +276,7 @@ void FScene::updateUBOs(utils::Range<uint32_t> visibleRenderables, backend::Hand
         }
 
         UniformBuffer::setUniform(buffer,
-                offset + offsetof(PerRenderableUib, worldFromModelNormalMatrix), m);
+                offset + offsetof(PerRenderableData, worldFromModelNormalMatrix), m);
 
         // Note that we cast bool to uint32_t. Booleans are byte-sized in C++, but we need to
         // initialize all 32 bits in the UBO field.
@@ -247,34 +284,41 @@ void FScene::updateUBOs(utils::Range<uint32_t> visibleRenderables, backend::Hand
         hasContactShadows = hasContactShadows || visibility.screenSpaceContactShadows;
 
         UniformBuffer::setUniform(buffer,
-                offset + offsetof(PerRenderableUib, flags),
-                PerRenderableUib::packFlags(
+                offset + offsetof(PerRenderableData, flags),
+                PerRenderableData::packFlags(
                         visibility.skinning,
                         visibility.morphing,
-                        visibility.screenSpaceContactShadows));
+                        visibility.screenSpaceContactShadows,
+                        sceneData.elementAt<INSTANCE_COUNT>(i) > 1));
 
         UniformBuffer::setUniform(buffer,
-                offset + offsetof(PerRenderableUib, morphTargetCount),
+                offset + offsetof(PerRenderableData, morphTargetCount),
                 sceneData.elementAt<MORPHING_BUFFER>(i).count);
 
         UniformBuffer::setUniform(buffer,
-                offset + offsetof(PerRenderableUib, channels),
+                offset + offsetof(PerRenderableData, channels),
                 (uint32_t)sceneData.elementAt<CHANNELS>(i));
 
         UniformBuffer::setUniform(buffer,
-                offset + offsetof(PerRenderableUib, objectId),
+                offset + offsetof(PerRenderableData, objectId),
                 rcm.getEntity(ri).getId()); // we could also store the entity in sceneData
 
         // TODO: We need to find a better way to provide the scale information per object
         UniformBuffer::setUniform(buffer,
-                offset + offsetof(PerRenderableUib, userData),
+                offset + offsetof(PerRenderableData, userData),
                 sceneData.elementAt<USER_DATA>(i));
     }
 
     // TODO: handle static objects separately
     mHasContactShadows = hasContactShadows;
     mRenderableViewUbh = renderableUbh;
-    driver.updateBufferObject(renderableUbh, { buffer, size }, 0);
+    if (keepCopy) {
+        void* const copy = driver.allocatePod<PerRenderableData>(visibleRenderables.size());
+        memcpy(copy, buffer, size);
+        driver.updateBufferObject(renderableUbh, { copy, size }, 0);
+    } else {
+        driver.updateBufferObject(renderableUbh, { buffer, size }, 0);
+    }
 
     if (mSkybox) {
         mSkybox->commit(driver);
@@ -29,6 +29,8 @@
 #include <filament/Box.h>
 #include <filament/Scene.h>
 
+#include <private/filament/UibStructs.h>
+
 #include <utils/compiler.h>
 #include <utils/Entity.h>
 #include <utils/Slice.h>
@@ -36,6 +38,8 @@
 #include <utils/Range.h>
 #include <utils/debug.h>
 
+#include <vector>
+
 #include <stddef.h>
 
 #include <tsl/robin_set.h>
@@ -68,6 +72,8 @@ public:
     void terminate(FEngine& engine);
 
     void prepare(const math::mat4& worldOriginTransform, bool shadowReceiversAreCasters) noexcept;
+    // restores the lights gathered by the last prepare(), views cull and sort them in place
+    void restoreGatheredLights() noexcept;
     void prepareDynamicLights(const CameraInfo& camera, ArenaScope& arena,
             backend::Handle<backend::HwBufferObject> lightUbh) noexcept;
 
@@ -75,6 +81,11 @@ public:
         return mRenderableViewUbh;
     }
 
+    // CPU copy of the per-renderable UBO, only available with automatic instancing
+    PerRenderableData const* getRenderableUBOData() const noexcept {
+        return mRenderableUboData.empty() ? nullptr : mRenderableUboData.data();
+    }
+
     /*
      * Storage for per-frame renderable data
      */
@@ -212,7 +223,10 @@ private:
      */
     RenderableSoa mRenderableData;
     LightSoa mLightData;
+    // copy of the lights gathered by prepare(), before any view culled them
+    utils::StructureOfArrays<math::float4, math::float3, FLightManager::Instance> mGatheredLightData;
     backend::Handle<backend::HwBufferObject> mRenderableViewUbh; // This is actually owned by the view.
+    std::vector<PerRenderableData> mRenderableUboData;
     bool mHasContactShadows = false;
 };
 
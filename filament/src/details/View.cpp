@@ -44,6 +44,8 @@
 #include <math/scalar.h>
 #include <math/fast.h>
 
+#include <chrono>
+#include <limits>
 #include <memory>
 
 using namespace utils;
@@ -294,10 +296,9 @@ void FView::prepareShadowing(FEngine& engine, DriverApi& driver,
     }
 
     // Find all shadow-casting spotlights.
-    size_t shadowCastingSpotCount = 0;
-
-    // We allow a max of CONFIG_MAX_SHADOW_CASTING_SPOTS spot light shadows. Any additional
-    // shadow-casting spotlights are ignored.
+    // We allow a max of CONFIG_MAX_SHADOW_CASTING_SPOTS spot light shadows, the ShadowMapManager
+    // keeps the most important ones. The importance of a spot light is roughly the size of its
+    // sphere of influence on screen.
     for (size_t l = FScene::DIRECTIONAL_LIGHTS_COUNT; l < lightData.size(); l++) {
 
         // when we get here all the lights should be visible
@@ -317,12 +318,13 @@ void FView::prepareShadowing(FEngine& engine, DriverApi& driver,
             continue; // is not a spot-li (we're not supporting point-lights yet)
         }
 
+        const float4 sphere = lightData.elementAt<FScene::POSITION_RADIUS>(l);
+        const float distance = length((cameraInfo.view * float4{ sphere.xyz, 1.0f }).xyz);
+        const float importance = sphere.w / std::max(distance, sphere.w);
+
         const auto& shadowOptions = lcm.getShadowOptions(li);
-        mShadowMapManager.addSpotShadowMap(l, &shadowOptions);
-        ++shadowCastingSpotCount;
-        if (shadowCastingSpotCount > CONFIG_MAX_SHADOW_CASTING_SPOTS - 1) {
-            break; // we ran out of spotlight shadow casting
-        }
+        mShadowMapManager.addSpotShadowMap(l, &shadowOptions,
+                std::max(importance, std::numeric_limits<float>::min()));
     }
 
     auto shadowTechnique = mShadowMapManager.update(engine, *this, cameraInfo,
@@ -428,10 +430,20 @@ CameraInfo FView::computeCameraInfo(FEngine& engine) const noexcept {
 
 void FView::prepare(FEngine& engine, DriverApi& driver, ArenaScope& arena,
         filament::Viewport const& viewport, CameraInfo const& cameraInfo,
-        float4 const& userTime, bool needsAlphaChannel) noexcept {
+        float4 const& userTime, bool needsAlphaChannel,
+        Renderer::FrameStatistics& statistics, bool sceneAlreadyPrepared) noexcept {
 
     JobSystem& js = engine.getJobSystem();
 
+    using clock = std::chrono::steady_clock;
+    auto elapsed = [](clock::time_point& since) -> uint64_t {
+        const clock::time_point now = clock::now();
+        const auto d = std::chrono::duration_cast<std::chrono::nanoseconds>(now - since);
+        since = now;
+        return uint64_t(d.count());
+    };
+    clock::time_point time = clock::now();
+
     /*
      * Prepare the scene -- this is where we gather all the objects added to the scene,
      * and in particular their world-space AABB.
@@ -460,8 +472,18 @@ void FView::prepare(FEngine& engine, DriverApi& driver, ArenaScope& arena,
     /*
      * Gather all information needed to render this scene. Apply the world origin to all
      * objects in the scene.
+     * When a previous view of the same batch already gathered the scene with the same world
+     * origin, only its lights need to be restored: the renderables are reordered, but not
+     * removed, by the steps below.
      */
-    scene->prepare(cameraInfo.worldOrigin, hasVSM());
+    if (UTILS_LIKELY(!sceneAlreadyPrepared)) {
+        scene->prepare(cameraInfo.worldOrigin, hasVSM());
+    } else {
+        scene->restoreGatheredLights();
+    }
+
+    statistics.scenePrepareTime += elapsed(time);
+    statistics.renderableCount += uint32_t(scene->getRenderableData().size());
 
     /*
      * Light culling: runs in parallel with Renderable culling (below)
@@ -501,8 +523,13 @@ void FView::prepare(FEngine& engine, DriverApi& driver, ArenaScope& arena,
         if (prepareVisibleLightsJob) {
             js.waitAndRelease(prepareVisibleLightsJob);
         }
+
+        statistics.cullingTime += elapsed(time);
+
         prepareShadowing(engine, driver, renderableData, scene->getLightData(), cameraInfo);
 
+        statistics.shadowSetupTime += elapsed(time);
+
         /*
          * Partition the SoA so that renderables are partitioned w.r.t their visibility into the
          * following groups:
@@ -547,13 +574,18 @@ void FView::prepare(FEngine& engine, DriverApi& driver, ArenaScope& arena,
         mSpotLightShadowCasters = Range{ 0, iSpotLightCastersEnd };
         merged = Range{ 0, iSpotLightCastersEnd };
 
+        statistics.visibleRenderableCount += mVisibleRenderables.size();
+
         // update those UBOs
-        const size_t size = merged.size() * sizeof(PerRenderableUib);
-        if (size) {
+        // The whole PerRenderableUib is bound at each renderable's offset, so we need room for
+        // CONFIG_MAX_INSTANCES - 1 elements past the last renderable.
+        const size_t size = (merged.size() + CONFIG_MAX_INSTANCES - 1) * sizeof(PerRenderableData);
+        if (!merged.empty()) {
             if (mRenderableUBOSize < size) {
                 // allocate 1/3 extra, with a minimum of 16 objects
                 const size_t count = std::max(size_t(16u), (4u * merged.size() + 2u) / 3u);
-                mRenderableUBOSize = uint32_t(count * sizeof(PerRenderableUib));
+                mRenderableUBOSize = uint32_t(
+                        (count + CONFIG_MAX_INSTANCES - 1) * sizeof(PerRenderableData));
                 driver.destroyBufferObject(mRenderableUbh);
                 mRenderableUbh = driver.createBufferObject(mRenderableUBOSize,
                         BufferObjectBinding::UNIFORM, BufferUsage::STREAM);
@@ -620,7 +652,7 @@ void FView::computeVisibilityMasks(
         visibleMask[i] = Culler::result_type(visRenderables) |
                 Culler::result_type(visShadowRenderable << 1u);
         // this loop gets fully unrolled
-        for (size_t j = 0; j < CONFIG_MAX_SHADOW_CASTING_SPOTS; ++j) {
+        for (size_t j = 0; j < VISIBLE_SPOT_SHADOW_RENDERABLE_BIT_COUNT; ++j) {
             const bool visSpotShadowRenderable =
                     (!v.culling || (mask & VISIBLE_SPOT_SHADOW_RENDERABLE_N(j))) &&
                         inVisibleLayer && visShadowParticipant;
@@ -88,9 +88,11 @@ public:
 
     CameraInfo computeCameraInfo(FEngine& engine) const noexcept;
 
+    // the scene preparation, culling and shadow set-up times are added to `statistics`
     void prepare(FEngine& engine, backend::DriverApi& driver, ArenaScope& arena,
             filament::Viewport const& viewport, CameraInfo const& cameraInfo,
-            math::float4 const& userTime, bool needsAlphaChannel) noexcept;
+            math::float4 const& userTime, bool needsAlphaChannel,
+            Renderer::FrameStatistics& statistics, bool sceneAlreadyPrepared = false) noexcept;
 
     void setScene(FScene* scene) { mScene = scene; }
     FScene const* getScene() const noexcept { return mScene; }
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TriangleMesh.h"
+
+#include <filament/Engine.h>
+#include <filament/IndexBuffer.h>
+#include <filament/Material.h>
+#include <filament/VertexBuffer.h>
+
+#include <math/vec3.h>
+
+using namespace filament;
+using namespace filament::math;
+
+namespace test {
+
+static const float3 gVertices[3] = { { -1, -1, 0 }, { 1, -1, 0 }, { -1, 1, 0 } };
+static const uint16_t gIndices[3] = { 0, 1, 2 };
+
+TriangleMesh::TriangleMesh(Engine& engine) : mEngine(engine) {
+    mVertexBuffer = VertexBuffer::Builder()
+            .vertexCount(3)
+            .bufferCount(1)
+            .attribute(VertexAttribute::POSITION, 0, VertexBuffer::AttributeType::FLOAT3)
+            .build(engine);
+    mVertexBuffer->setBufferAt(engine, 0, { gVertices, sizeof(gVertices) });
+    mIndexBuffer = IndexBuffer::Builder()
+            .indexCount(3)
+            .bufferType(IndexBuffer::IndexType::USHORT)
+            .build(engine);
+    mIndexBuffer->setBuffer(engine, { gIndices, sizeof(gIndices) });
+}
+
+TriangleMesh::~TriangleMesh() {
+    mEngine.destroy(mVertexBuffer);
+    mEngine.destroy(mIndexBuffer);
+}
+
+RenderableManager::Builder TriangleMesh::builder() const {
+    RenderableManager::Builder builder(1);
+    builder.material(0, mEngine.getDefaultMaterial()->getDefaultInstance())
+            .geometry(0, RenderableManager::PrimitiveType::TRIANGLES,
+                    mVertexBuffer, mIndexBuffer);
+    return builder;
+}
+
+} // namespace test
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_TEST_TRIANGLEMESH_H
+#define TNT_FILAMENT_TEST_TRIANGLEMESH_H
+
+#include <filament/RenderableManager.h>
+
+namespace filament {
+class Engine;
+class IndexBuffer;
+class VertexBuffer;
+} // namespace filament
+
+namespace test {
+
+/**
+ * A wrapper class that manages the vertex and index buffers of a single triangle in the z = 0
+ * plane, used by the test cases that need renderables.
+ *
+ * The vertices are at (-1, -1), (1, -1) and (-1, 1).
+ */
+class TriangleMesh {
+public:
+    explicit TriangleMesh(filament::Engine& engine);
+    ~TriangleMesh();
+
+    TriangleMesh(TriangleMesh const&) = delete;
+    TriangleMesh& operator=(TriangleMesh const&) = delete;
+
+    filament::VertexBuffer* getVertexBuffer() const noexcept { return mVertexBuffer; }
+    filament::IndexBuffer* getIndexBuffer() const noexcept { return mIndexBuffer; }
+
+    // Returns a builder for a renderable made of this triangle, with the default material.
+    filament::RenderableManager::Builder builder() const;
+
+private:
+    filament::Engine& mEngine;
+    filament::VertexBuffer* mVertexBuffer = nullptr;
+    filament::IndexBuffer* mIndexBuffer = nullptr;
+};
+
+} // namespace test
+
+#endif // TNT_FILAMENT_TEST_TRIANGLEMESH_H
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <filament/ColorGrading.h>
+#include <filament/Engine.h>
+#include <filament/ToneMapper.h>
+
+#include "details/ColorGrading.h"
+#include "details/Engine.h"
+
+#include <string.h>
+
+using namespace filament;
+using namespace filament::math;
+
+using Lut = FColorGrading::Test::Lut;
+
+class FilamentColorGradingTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        engine = Engine::create(Engine::Backend::NOOP);
+    }
+
+    void TearDown() override {
+        Engine::destroy(&engine);
+    }
+
+    // The LUT as generated by an engine that has no cached stages
+    static Lut generateUncachedLut(ColorGrading::Builder const& builder) {
+        Engine* fresh = Engine::create(Engine::Backend::NOOP);
+        Lut lut = FColorGrading::Test::generateLut(upcast(*fresh), builder);
+        Engine::destroy(&fresh);
+        EXPECT_TRUE(lut.inputStageUpdated);
+        EXPECT_TRUE(lut.gradingStageUpdated);
+        return lut;
+    }
+
+    static bool isEqual(Lut const& lhs, Lut const& rhs) {
+        return lhs.texels.size() == rhs.texels.size() &&
+                !memcmp(lhs.texels.data(), rhs.texels.data(), lhs.texels.size() * sizeof(half4));
+    }
+
+    ColorGrading::Builder makeBuilder() const {
+        ColorGrading::Builder builder;
+        builder.toneMapper(&toneMapper)
+                .dimensions(16)
+                .exposure(0.5f)
+                .whiteBalance(0.1f, 0.0f)
+                .slopeOffsetPower({ 1.1f }, { 0.01f }, { 0.9f })
+                .contrast(1.2f)
+                .saturation(1.1f);
+        return builder;
+    }
+
+    Engine* engine = nullptr;
+    const ACESToneMapper toneMapper;
+};
+
+TEST_F(FilamentColorGradingTest, LutCache) {
+    FEngine& cachedEngine = upcast(*engine);
+
+    // A: nothing is cached yet
+    ColorGrading::Builder builderA = makeBuilder();
+    Lut a = FColorGrading::Test::generateLut(cachedEngine, builderA);
+    EXPECT_TRUE(a.inputStageUpdated);
+    EXPECT_TRUE(a.gradingStageUpdated);
+    EXPECT_TRUE(isEqual(a, generateUncachedLut(builderA)));
+
+    // B: only late stages change, both cached stages are reused
+    ColorGrading::Builder builderB = makeBuilder();
+    builderB.vibrance(1.3f)
+            .saturation(0.8f)
+            .curves({ 1.1f }, { 0.9f }, { 1.2f });
+    Lut b = FColorGrading::Test::generateLut(cachedEngine, builderB);
+    EXPECT_FALSE(b.inputStageUpdated);
+    EXPECT_FALSE(b.gradingStageUpdated);
+    EXPECT_FALSE(isEqual(b, a));
+    EXPECT_TRUE(isEqual(b, generateUncachedLut(builderB)));
+
+    // C: an early stage changes, the cache is invalidated
+    ColorGrading::Builder builderC = makeBuilder();
+    builderC.vibrance(1.3f)
+            .saturation(0.8f)
+            .curves({ 1.1f }, { 0.9f }, { 1.2f })
+            .exposure(-0.5f);
+    Lut c = FColorGrading::Test::generateLut(cachedEngine, builderC);
+    EXPECT_TRUE(c.inputStageUpdated);
+    EXPECT_TRUE(c.gradingStageUpdated);
+    EXPECT_FALSE(isEqual(c, b));
+    EXPECT_TRUE(isEqual(c, generateUncachedLut(builderC)));
+
+    // D: only the log space grading changes, the input stage is reused
+    ColorGrading::Builder builderD = builderC;
+    builderD.contrast(0.8f);
+    Lut d = FColorGrading::Test::generateLut(cachedEngine, builderD);
+    EXPECT_FALSE(d.inputStageUpdated);
+    EXPECT_TRUE(d.gradingStageUpdated);
+    EXPECT_FALSE(isEqual(d, c));
+    EXPECT_TRUE(isEqual(d, generateUncachedLut(builderD)));
+
+    // back to A, whose stages are no longer cached
+    Lut a2 = FColorGrading::Test::generateLut(cachedEngine, builderA);
+    EXPECT_TRUE(a2.inputStageUpdated);
+    EXPECT_TRUE(isEqual(a2, a));
+}
+
+TEST_F(FilamentColorGradingTest, LutCacheDimension) {
+    // the cached stages depend on the dimension of the LUT
+    ColorGrading::Builder builder = makeBuilder();
+    Lut small = FColorGrading::Test::generateLut(upcast(*engine), builder);
+    builder.dimensions(32);
+    Lut large = FColorGrading::Test::generateLut(upcast(*engine), builder);
+    EXPECT_TRUE(large.inputStageUpdated);
+    EXPECT_EQ(large.texels.size(), 32u * 32u * 32u);
+    EXPECT_TRUE(isEqual(large, generateUncachedLut(builder)));
+    EXPECT_NE(small.texels.size(), large.texels.size());
+}
+
+TEST_F(FilamentColorGradingTest, NoAdjustments) {
+    // without adjustments the cache isn't used
+    ColorGrading::Builder builder;
+    builder.toneMapper(&toneMapper).dimensions(16);
+    Lut lut = FColorGrading::Test::generateLut(upcast(*engine), builder);
+    EXPECT_FALSE(lut.inputStageUpdated);
+    EXPECT_FALSE(lut.gradingStageUpdated);
+    EXPECT_TRUE(upcast(*engine).getColorGradingCache().input.key.empty());
+}
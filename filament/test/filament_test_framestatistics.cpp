@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <filament/Camera.h>
+#include <filament/Engine.h>
+#include <filament/RenderableManager.h>
+#include <filament/Renderer.h>
+#include <filament/RenderTarget.h>
+#include <filament/Scene.h>
+#include <filament/Texture.h>
+#include <filament/View.h>
+#include <filament/Viewport.h>
+
+#include <utils/Entity.h>
+#include <utils/EntityManager.h>
+
+#include "TriangleMesh.h"
+
+#include <array>
+#include <memory>
+
+using namespace filament;
+using namespace utils;
+
+using FrameStatistics = Renderer::FrameStatistics;
+
+class FrameStatisticsTest : public ::testing::Test {
+protected:
+    static constexpr size_t HISTORY = 16;
+
+    void SetUp() override {
+        engine = Engine::create(Engine::Backend::NOOP);
+        swapChain = engine->createSwapChain(16, 16);
+        renderer = engine->createRenderer();
+        scene = engine->createScene();
+        cameraEntity = EntityManager::get().create();
+        camera = engine->createCamera(cameraEntity);
+        camera->setProjection(Camera::Projection::ORTHO, -1, 1, -1, 1, -1, 1);
+        view = engine->createView();
+        view->setScene(scene);
+        view->setCamera(camera);
+        view->setViewport({ 0, 0, 16, 16 });
+    }
+
+    void TearDown() override {
+        if (triangle) {
+            engine->destroy(triangle);
+            EntityManager::get().destroy(triangle);
+        }
+        mesh.reset();
+        engine->destroy(view);
+        engine->destroyCameraComponent(cameraEntity);
+        EntityManager::get().destroy(cameraEntity);
+        engine->destroy(scene);
+        engine->destroy(renderer);
+        engine->destroy(swapChain);
+        Engine::destroy(&engine);
+    }
+
+    void addTriangle() {
+        mesh = std::make_unique<test::TriangleMesh>(*engine);
+        triangle = EntityManager::get().create();
+        mesh->builder()
+                .boundingBox({ { 0, 0, 0 }, { 1, 1, 1 } })
+                .culling(false)
+                .castShadows(false)
+                .receiveShadows(false)
+                .build(*engine, triangle);
+        scene->addEntity(triangle);
+    }
+
+    void renderFrames(size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            ASSERT_TRUE(renderer->beginFrame(swapChain));
+            renderer->render(view);
+            renderer->endFrame();
+        }
+    }
+
+    Engine* engine = nullptr;
+    SwapChain* swapChain = nullptr;
+    Renderer* renderer = nullptr;
+    Scene* scene = nullptr;
+    Entity cameraEntity;
+    Camera* camera = nullptr;
+    View* view = nullptr;
+    Entity triangle;
+    std::unique_ptr<test::TriangleMesh> mesh;
+};
+
+TEST_F(FrameStatisticsTest, EmptyHistory) {
+    std::array<FrameStatistics, HISTORY> stats;
+    EXPECT_EQ(renderer->getFrameStatistics(stats.data(), stats.size()), 0u);
+}
+
+TEST_F(FrameStatisticsTest, PartialHistory) {
+    renderFrames(3);
+
+    std::array<FrameStatistics, HISTORY> stats;
+    ASSERT_EQ(renderer->getFrameStatistics(stats.data(), stats.size()), 3u);
+
+    // most recent frame first, with consecutive frame ids
+    for (size_t i = 1; i < 3; i++) {
+        EXPECT_EQ(stats[i].frameId + 1, stats[i - 1].frameId);
+    }
+    for (size_t i = 0; i < 3; i++) {
+        EXPECT_GT(stats[i].frameTime, 0u);
+        EXPECT_GT(stats[i].commandStreamSize, 0u);
+        EXPECT_EQ(stats[i].drawCount, 0u);
+    }
+
+    // count smaller than the history
+    std::array<FrameStatistics, 1> last;
+    ASSERT_EQ(renderer->getFrameStatistics(last.data(), last.size()), 1u);
+    EXPECT_EQ(last[0].frameId, stats[0].frameId);
+}
+
+TEST_F(FrameStatisticsTest, RingBufferWrapsAround) {
+    renderFrames(HISTORY + 5);
+
+    std::array<FrameStatistics, HISTORY * 2> stats;
+    ASSERT_EQ(renderer->getFrameStatistics(stats.data(), stats.size()), HISTORY);
+
+    // only the last HISTORY frames are kept, most recent first
+    for (size_t i = 1; i < HISTORY; i++) {
+        EXPECT_EQ(stats[i].frameId + 1, stats[i - 1].frameId);
+    }
+
+    renderFrames(1);
+    std::array<FrameStatistics, HISTORY * 2> next;
+    ASSERT_EQ(renderer->getFrameStatistics(next.data(), next.size()), HISTORY);
+    EXPECT_EQ(next[0].frameId, stats[0].frameId + 1);
+    EXPECT_EQ(next[HISTORY - 1].frameId, stats[HISTORY - 2].frameId);
+}
+
+TEST_F(FrameStatisticsTest, DrawCount) {
+    addTriangle();
+    renderFrames(2);
+
+    std::array<FrameStatistics, HISTORY> stats;
+    ASSERT_EQ(renderer->getFrameStatistics(stats.data(), stats.size()), 2u);
+    EXPECT_EQ(stats[0].visibleRenderableCount, 1u);
+    EXPECT_EQ(stats[0].commandCount, 1u);
+    EXPECT_GE(stats[0].drawCount, 1u);
+    EXPECT_EQ(stats[0].drawCount, stats[1].drawCount);
+}
+
+TEST_F(FrameStatisticsTest, StandaloneViewsAreNotRecorded) {
+    addTriangle();
+    renderFrames(2);
+
+    std::array<FrameStatistics, HISTORY> before;
+    ASSERT_EQ(renderer->getFrameStatistics(before.data(), before.size()), 2u);
+
+    Texture* color = Texture::Builder()
+            .width(16).height(16)
+            .format(Texture::InternalFormat::RGBA8)
+            .usage(Texture::Usage::COLOR_ATTACHMENT | Texture::Usage::SAMPLEABLE)
+            .build(*engine);
+    RenderTarget* target = RenderTarget::Builder()
+            .texture(RenderTarget::AttachmentPoint::COLOR, color)
+            .build(*engine);
+    View* standalone = engine->createView();
+    standalone->setScene(scene);
+    standalone->setCamera(camera);
+    standalone->setViewport({ 0, 0, 16, 16 });
+    standalone->setRenderTarget(target);
+
+    renderer->renderStandaloneView(standalone);
+    View const* views[] = { standalone, standalone };
+    renderer->renderStandaloneViews(views, 2);
+
+    std::array<FrameStatistics, HISTORY> after;
+    ASSERT_EQ(renderer->getFrameStatistics(after.data(), after.size()), 2u);
+    EXPECT_EQ(after[0].frameId, before[0].frameId);
+    EXPECT_EQ(after[0].frameTime, before[0].frameTime);
+    EXPECT_EQ(after[0].commandEncodingTime, before[0].commandEncodingTime);
+    EXPECT_EQ(after[0].drawCount, before[0].drawCount);
+
+    // the standalone views' commands are not accounted to the next frame either
+    renderFrames(1);
+    ASSERT_EQ(renderer->getFrameStatistics(after.data(), after.size()), 3u);
+    EXPECT_EQ(after[0].drawCount, before[0].drawCount);
+    EXPECT_LE(after[0].commandStreamSize, before[0].commandStreamSize * 2);
+
+    engine->destroy(standalone);
+    engine->destroy(target);
+    engine->destroy(color);
+}
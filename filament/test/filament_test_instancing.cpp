@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <filament/Engine.h>
+#include <filament/Material.h>
+#include <filament/MaterialInstance.h>
+
+#include <private/filament/UibStructs.h>
+
+#include "RenderPass.h"
+#include "details/Engine.h"
+#include "details/MaterialInstance.h"
+
+#include <memory>
+#include <vector>
+
+using namespace filament;
+using namespace filament::backend;
+
+using Command = RenderPass::Command;
+
+class FilamentInstancingTest : public ::testing::Test {
+protected:
+    static constexpr size_t RENDERABLE_COUNT = 16;
+
+    void SetUp() override {
+        engine = Engine::create(Engine::Backend::NOOP);
+        miA = engine->getDefaultMaterial()->createInstance();
+        miB = engine->getDefaultMaterial()->createInstance();
+
+        soa.setCapacity(RENDERABLE_COUNT);
+        soa.resize(RENDERABLE_COUNT);
+        uboData.resize(RENDERABLE_COUNT);
+        for (size_t i = 0; i < RENDERABLE_COUNT; i++) {
+            uboData[i].objectId = uint32_t(i);
+        }
+
+        arenaStorage.resize(RENDERABLE_COUNT * 2 * sizeof(Command));
+        arena = std::make_unique<RenderPass::Arena>("test arena",
+                utils::AreaPolicy::StaticArea{ arenaStorage.data(),
+                        arenaStorage.data() + arenaStorage.size() });
+    }
+
+    void TearDown() override {
+        arena.reset();
+        engine->destroy(miA);
+        engine->destroy(miB);
+        Engine::destroy(&engine);
+    }
+
+    std::unique_ptr<RenderPass> createPass() {
+        auto pass = std::make_unique<RenderPass>(upcast(*engine), *arena);
+        pass->setGeometry(soa, { 0, RENDERABLE_COUNT }, {}, uboData.data());
+        return pass;
+    }
+
+    static Command makeCommand(MaterialInstance const* mi, uint16_t index,
+            Handle<HwRenderPrimitive> primitive = Handle<HwRenderPrimitive>{ 1 }) {
+        Command cmd;
+        cmd.key = uint64_t(RenderPass::Pass::COLOR) | uint64_t(RenderPass::CustomCommand::PASS);
+        cmd.primitive.mi = upcast(mi);
+        cmd.primitive.primitiveHandle = primitive;
+        cmd.primitive.index = index;
+        cmd.primitive.instanceCount = 1;
+        return cmd;
+    }
+
+    static std::vector<Command> instancify(RenderPass& pass, std::vector<Command> const& commands) {
+        RenderPass::Test::instancify(pass, commands.data(), commands.size());
+        return { pass.begin(), pass.end() };
+    }
+
+    Engine* engine = nullptr;
+    MaterialInstance* miA = nullptr;
+    MaterialInstance* miB = nullptr;
+    FScene::RenderableSoa soa;
+    std::vector<PerRenderableData> uboData;
+    std::vector<uint8_t> arenaStorage;
+    std::unique_ptr<RenderPass::Arena> arena;
+};
+
+TEST_F(FilamentInstancingTest, IdenticalCommandsAreInstanced) {
+    auto pass = createPass();
+    auto result = instancify(*pass, {
+            makeCommand(miA, 3), makeCommand(miA, 5), makeCommand(miA, 7), makeCommand(miA, 9) });
+
+    ASSERT_EQ(result.size(), 1);
+    EXPECT_TRUE(result[0].primitive.instanced);
+    EXPECT_EQ(result[0].primitive.instanceCount, 4);
+    // the first element of the instanced UBO range of this pass
+    EXPECT_EQ(result[0].primitive.index, 0);
+}
+
+TEST_F(FilamentInstancingTest, DifferentMaterialInstancesAreNotInstanced) {
+    auto pass = createPass();
+    auto result = instancify(*pass, {
+            makeCommand(miA, 0), makeCommand(miA, 1), makeCommand(miB, 2), makeCommand(miB, 3),
+            makeCommand(miA, 4), makeCommand(miB, 5) });
+
+    ASSERT_EQ(result.size(), 4);
+    EXPECT_TRUE(result[0].primitive.instanced);
+    EXPECT_EQ(result[0].primitive.mi, upcast(miA));
+    EXPECT_EQ(result[0].primitive.instanceCount, 2);
+    EXPECT_EQ(result[0].primitive.index, 0);
+    EXPECT_TRUE(result[1].primitive.instanced);
+    EXPECT_EQ(result[1].primitive.mi, upcast(miB));
+    EXPECT_EQ(result[1].primitive.instanceCount, 2);
+    EXPECT_EQ(result[1].primitive.index, 2);
+    // single commands are left alone
+    EXPECT_FALSE(result[2].primitive.instanced);
+    EXPECT_EQ(result[2].primitive.index, 4);
+    EXPECT_FALSE(result[3].primitive.instanced);
+    EXPECT_EQ(result[3].primitive.index, 5);
+}
+
+TEST_F(FilamentInstancingTest, DifferentStatesAreNotInstanced) {
+    Command culled = makeCommand(miA, 1);
+    culled.primitive.rasterState.culling = CullingMode::FRONT;
+
+    Command otherPass = makeCommand(miA, 3);
+    otherPass.key = uint64_t(RenderPass::Pass::BLENDED) | uint64_t(RenderPass::CustomCommand::PASS);
+
+    Command otherVariant = makeCommand(miA, 4);
+    otherVariant.primitive.materialVariant = Variant{ Variant::DIR };
+
+    Command userInstanced = makeCommand(miA, 5);
+    userInstanced.primitive.instanceCount = 2;
+
+    // renderable 6 is skinned
+    soa.elementAt<FScene::SKINNING_BUFFER>(6).handle = Handle<HwBufferObject>{ 1 };
+    Command skinned = makeCommand(miA, 6);
+
+    auto pass = createPass();
+    auto result = instancify(*pass, {
+            makeCommand(miA, 0), culled,
+            makeCommand(miA, 2, Handle<HwRenderPrimitive>{ 2 }), otherPass,
+            otherVariant, userInstanced, skinned });
+
+    ASSERT_EQ(result.size(), 7);
+    for (Command const& cmd : result) {
+        EXPECT_FALSE(cmd.primitive.instanced);
+    }
+}
+
+TEST_F(FilamentInstancingTest, PassesShareTheInstancedUbo) {
+    // the passes of a frame get consecutive ranges of the engine's instanced UBO
+    auto pass0 = createPass();
+    auto result0 = instancify(*pass0, { makeCommand(miA, 0), makeCommand(miA, 1) });
+    auto pass1 = createPass();
+    auto result1 = instancify(*pass1, { makeCommand(miB, 2), makeCommand(miB, 3) });
+
+    ASSERT_EQ(result0.size(), 1);
+    ASSERT_EQ(result1.size(), 1);
+    EXPECT_EQ(result0[0].primitive.index, 0);
+    EXPECT_EQ(result1[0].primitive.index, 2);
+
+    // and the UBO is refilled from the start every frame
+    upcast(engine)->prepare();
+    auto pass2 = createPass();
+    auto result2 = instancify(*pass2, { makeCommand(miA, 4), makeCommand(miA, 5) });
+    ASSERT_EQ(result2.size(), 1);
+    EXPECT_EQ(result2[0].primitive.index, 0);
+}
@@ -0,0 +1,368 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <filament/Engine.h>
+#include <filament/LightManager.h>
+#include <filament/Material.h>
+#include <filament/RenderableManager.h>
+#include <filament/TransformManager.h>
+
+#include "ShadowMapManager.h"
+#include "details/Engine.h"
+#include "details/View.h"
+
+#include "TriangleMesh.h"
+
+#include <utils/EntityManager.h>
+
+#include <array>
+#include <memory>
+
+using namespace filament;
+using namespace filament::math;
+
+using AtlasRegion = ShadowMapManager::Test::AtlasRegion;
+using StaticShadowCacheState = ShadowMapManager::StaticShadowCacheState;
+
+class FilamentShadowMapTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        engine = Engine::create(Engine::Backend::NOOP);
+        shadowMapManager = std::make_unique<ShadowMapManager>(upcast(*engine));
+    }
+
+    void TearDown() override {
+        shadowMapManager->terminate(upcast(*engine));
+        shadowMapManager.reset();
+        Engine::destroy(&engine);
+    }
+
+    static LightManager::ShadowOptions makeOptions(uint32_t mapSize) {
+        LightManager::ShadowOptions options;
+        options.mapSize = mapSize;
+        return options;
+    }
+
+    static void expectRegion(AtlasRegion const& region, size_t lightIndex, uint8_t layer,
+            ushort2 offset, uint16_t dimension, uint8_t border) {
+        EXPECT_EQ(region.lightIndex, lightIndex);
+        EXPECT_EQ(region.layer, layer);
+        EXPECT_EQ(region.offset.x, offset.x);
+        EXPECT_EQ(region.offset.y, offset.y);
+        EXPECT_EQ(region.dimension, dimension);
+        EXPECT_EQ(region.border, border);
+    }
+
+    Engine* engine = nullptr;
+    std::unique_ptr<ShadowMapManager> shadowMapManager;
+
+    const LightManager::ShadowOptions options256 = makeOptions(256);
+    const LightManager::ShadowOptions options512 = makeOptions(512);
+    const LightManager::ShadowOptions options1024 = makeOptions(1024);
+};
+
+TEST_F(FilamentShadowMapTest, SpotShadowMapsShareLayer) {
+    // one cascade at 1024 (layer 0) and two spot lights at 256: 3 shadow maps in 2 layers
+    shadowMapManager->addSpotShadowMap(1, &options256, 1.0f);
+    shadowMapManager->addSpotShadowMap(2, &options256, 2.0f);
+
+    const uint8_t layers = ShadowMapManager::Test::layoutSpotShadowMaps(
+            *shadowMapManager, 1024, 1, true);
+    EXPECT_EQ(layers, 2);
+
+    auto regions = ShadowMapManager::Test::getSpotShadowMapRegions(*shadowMapManager);
+    ASSERT_EQ(regions.size(), 2);
+    // sorted by decreasing importance, tiles allocated in Z-order
+    expectRegion(regions[0], 2, 1, { 0, 0 }, 256, 2);
+    expectRegion(regions[1], 1, 1, { 256, 0 }, 256, 2);
+}
+
+TEST_F(FilamentShadowMapTest, SpotShadowMapsMixedTileSizes) {
+    shadowMapManager->addSpotShadowMap(1, &options256, 1.0f);
+    shadowMapManager->addSpotShadowMap(2, &options512, 3.0f);
+    shadowMapManager->addSpotShadowMap(3, &options256, 2.0f);
+
+    const uint8_t layers = ShadowMapManager::Test::layoutSpotShadowMaps(
+            *shadowMapManager, 1024, 1, true);
+    EXPECT_EQ(layers, 2);
+
+    auto regions = ShadowMapManager::Test::getSpotShadowMapRegions(*shadowMapManager);
+    ASSERT_EQ(regions.size(), 3);
+    // the 512 tile takes the first quadrant, the 256 tiles follow in Z-order
+    expectRegion(regions[0], 2, 1, { 0, 0 }, 512, 2);
+    expectRegion(regions[1], 3, 1, { 512, 0 }, 256, 2);
+    expectRegion(regions[2], 1, 1, { 768, 0 }, 256, 2);
+}
+
+TEST_F(FilamentShadowMapTest, SpotShadowMapsOverflowToNewLayer) {
+    shadowMapManager->addSpotShadowMap(1, &options256, 1.0f);
+    shadowMapManager->addSpotShadowMap(2, &options512, 3.0f);
+    shadowMapManager->addSpotShadowMap(3, &options256, 2.0f);
+    shadowMapManager->addSpotShadowMap(4, &options1024, 0.5f);
+
+    const uint8_t layers = ShadowMapManager::Test::layoutSpotShadowMaps(
+            *shadowMapManager, 1024, 1, true);
+    EXPECT_EQ(layers, 3);
+
+    auto regions = ShadowMapManager::Test::getSpotShadowMapRegions(*shadowMapManager);
+    ASSERT_EQ(regions.size(), 4);
+    // the largest tiles are allocated first, the full layer leaves no room for the others
+    expectRegion(regions[0], 2, 2, { 0, 0 }, 512, 2);
+    expectRegion(regions[1], 3, 2, { 512, 0 }, 256, 2);
+    expectRegion(regions[2], 1, 2, { 768, 0 }, 256, 2);
+    expectRegion(regions[3], 4, 1, { 0, 0 }, 1024, 2);
+}
+
+TEST_F(FilamentShadowMapTest, SpotShadowMapsOwnLayers) {
+    // VSM, DPCF and PCSS don't share layers
+    shadowMapManager->addSpotShadowMap(1, &options256, 1.0f);
+    shadowMapManager->addSpotShadowMap(2, &options512, 2.0f);
+
+    const uint8_t layers = ShadowMapManager::Test::layoutSpotShadowMaps(
+            *shadowMapManager, 1024, 1, false);
+    EXPECT_EQ(layers, 3);
+
+    auto regions = ShadowMapManager::Test::getSpotShadowMapRegions(*shadowMapManager);
+    ASSERT_EQ(regions.size(), 2);
+    expectRegion(regions[0], 2, 1, { 0, 0 }, 512, 1);
+    expectRegion(regions[1], 1, 2, { 0, 0 }, 256, 1);
+}
+
+TEST_F(FilamentShadowMapTest, SpotShadowMapsOverBudget) {
+    // more full-size shadow maps than the layer budget: tiles shrink, but never overlap
+    constexpr size_t count = 40;
+    for (size_t i = 0; i < count; i++) {
+        shadowMapManager->addSpotShadowMap(i + 1, &options1024, float(i + 1));
+    }
+
+    const uint8_t layers = ShadowMapManager::Test::layoutSpotShadowMaps(
+            *shadowMapManager, 1024, 1, true);
+    // the first layer plus at most MAX_SPOT_SHADOW_LAYERS (14) layers for the spot lights
+    EXPECT_LE(layers, 1 + 14);
+
+    auto regions = ShadowMapManager::Test::getSpotShadowMapRegions(*shadowMapManager);
+    ASSERT_EQ(regions.size(), count);
+    for (size_t i = 0; i < count; i++) {
+        AtlasRegion const& a = regions[i];
+        EXPECT_GE(a.layer, 1);
+        EXPECT_LT(a.layer, layers);
+        EXPECT_LE(a.offset.x + a.dimension, 1024);
+        EXPECT_LE(a.offset.y + a.dimension, 1024);
+        for (size_t j = i + 1; j < count; j++) {
+            AtlasRegion const& b = regions[j];
+            const bool overlap = a.layer == b.layer &&
+                    a.offset.x < b.offset.x + b.dimension &&
+                    b.offset.x < a.offset.x + a.dimension &&
+                    a.offset.y < b.offset.y + b.dimension &&
+                    b.offset.y < a.offset.y + a.dimension;
+            EXPECT_FALSE(overlap) << "spot shadow maps " << i << " and " << j << " overlap";
+        }
+    }
+    // the most important spot light keeps the largest shadow map
+    EXPECT_EQ(regions[0].lightIndex, count);
+    for (size_t i = 1; i < count; i++) {
+        EXPECT_GE(regions[0].dimension, regions[i].dimension);
+    }
+}
+
+class FilamentStaticShadowCacheTest : public FilamentShadowMapTest {
+protected:
+    static constexpr size_t RENDERABLE_COUNT = 3;
+    static constexpr FScene::VisibleMaskType VISIBLE_MASK = 0x2;
+
+    void SetUp() override {
+        FilamentShadowMapTest::SetUp();
+        view = engine->createView();
+
+        mesh = std::make_unique<test::TriangleMesh>(*engine);
+
+        // the first two renderables are static shadow casters, the last one is dynamic
+        utils::EntityManager::get().create(RENDERABLE_COUNT, entities.data());
+        for (size_t i = 0; i < RENDERABLE_COUNT; i++) {
+            engine->getTransformManager().create(entities[i]);
+            mesh->builder()
+                    .boundingBox({ { 0, 0, 0 }, { 1, 1, 1 } })
+                    .castShadows(true)
+                    .staticShadowCaster(i < 2)
+                    .build(*engine, entities[i]);
+        }
+
+        shadowMapManager->addSpotShadowMap(1, &options256, 1.0f);
+        ShadowMapManager::Test::layoutSpotShadowMaps(*shadowMapManager, 1024, 0, true);
+
+        // the scene data ShadowMap::update() and the culling would have produced
+        FRenderableManager const& rcm = upcast(*engine).getRenderableManager();
+        soa.setCapacity(RENDERABLE_COUNT);
+        soa.resize(RENDERABLE_COUNT);
+        for (size_t i = 0; i < RENDERABLE_COUNT; i++) {
+            auto ri = rcm.getInstance(entities[i]);
+            soa.elementAt<FScene::RENDERABLE_INSTANCE>(i) = ri;
+            soa.elementAt<FScene::VISIBILITY_STATE>(i) = rcm.getVisibility(ri);
+            soa.elementAt<FScene::VISIBLE_MASK>(i) = VISIBLE_MASK;
+            soa.elementAt<FScene::PRIMITIVES>(i) = rcm.getRenderPrimitives(ri, 0);
+        }
+    }
+
+    void TearDown() override {
+        for (auto e : entities) {
+            engine->getRenderableManager().destroy(e);
+            engine->getTransformManager().destroy(e);
+        }
+        utils::EntityManager::get().destroy(RENDERABLE_COUNT, entities.data());
+        mesh.reset();
+        engine->destroy(view);
+        FilamentShadowMapTest::TearDown();
+    }
+
+    StaticShadowCacheState update(mat4f const& lightSpace = {},
+            backend::PolygonOffset polygonOffset = {}) {
+        bool hasDynamicCasters = false;
+        auto state = ShadowMapManager::Test::updateSpotStaticShadowCache(*shadowMapManager,
+                upcast(*engine), *upcast(view), 0, lightSpace, polygonOffset, soa, VISIBLE_MASK,
+                hasDynamicCasters);
+        EXPECT_EQ(hasDynamicCasters, soa.elementAt<FScene::VISIBLE_MASK>(2) == VISIBLE_MASK);
+        return state;
+    }
+
+    View* view = nullptr;
+    std::unique_ptr<test::TriangleMesh> mesh;
+    std::array<utils::Entity, RENDERABLE_COUNT> entities;
+    FScene::RenderableSoa soa;
+};
+
+TEST_F(FilamentStaticShadowCacheTest, HitAndMiss) {
+    EXPECT_EQ(update(), StaticShadowCacheState::MISS);
+    EXPECT_EQ(update(), StaticShadowCacheState::HIT);
+    EXPECT_EQ(update(), StaticShadowCacheState::HIT);
+    EXPECT_EQ(shadowMapManager->getStaticShadowCacheMissCount(), 1);
+    EXPECT_EQ(shadowMapManager->getStaticShadowCacheHitCount(), 2);
+
+    // the dynamic shadow casters don't matter
+    soa.elementAt<FScene::VISIBLE_MASK>(2) = 0;
+    EXPECT_EQ(update(), StaticShadowCacheState::HIT);
+}
+
+TEST_F(FilamentStaticShadowCacheTest, NoStaticCasters) {
+    soa.elementAt<FScene::VISIBLE_MASK>(0) = 0;
+    soa.elementAt<FScene::VISIBLE_MASK>(1) = 0;
+    EXPECT_EQ(update(), StaticShadowCacheState::NONE);
+    EXPECT_EQ(shadowMapManager->getStaticShadowCacheMissCount(), 0);
+    EXPECT_EQ(shadowMapManager->getStaticShadowCacheHitCount(), 0);
+}
+
+TEST_F(FilamentStaticShadowCacheTest, CastersHashInvalidates) {
+    EXPECT_EQ(update(), StaticShadowCacheState::MISS);
+
+    // a static caster leaves the shadow map
+    soa.elementAt<FScene::VISIBLE_MASK>(1) = 0;
+    EXPECT_EQ(update(), StaticShadowCacheState::MISS);
+    EXPECT_EQ(update(), StaticShadowCacheState::HIT);
+
+    // and comes back
+    soa.elementAt<FScene::VISIBLE_MASK>(1) = VISIBLE_MASK;
+    EXPECT_EQ(update(), StaticShadowCacheState::MISS);
+
+    // the order of the renderables doesn't matter
+    std::swap(soa.elementAt<FScene::RENDERABLE_INSTANCE>(0),
+            soa.elementAt<FScene::RENDERABLE_INSTANCE>(1));
+    std::swap(soa.elementAt<FScene::PRIMITIVES>(0), soa.elementAt<FScene::PRIMITIVES>(1));
+    EXPECT_EQ(update(), StaticShadowCacheState::HIT);
+
+    // a static caster moves
+    auto& tcm = engine->getTransformManager();
+    tcm.setTransform(tcm.getInstance(entities[0]), mat4f::translation(float3{ 1, 0, 0 }));
+    EXPECT_EQ(update(), StaticShadowCacheState::MISS);
+    EXPECT_EQ(update(), StaticShadowCacheState::HIT);
+
+    // a dynamic caster moves
+    tcm.setTransform(tcm.getInstance(entities[2]), mat4f::translation(float3{ 1, 0, 0 }));
+    EXPECT_EQ(update(), StaticShadowCacheState::HIT);
+}
+
+TEST_F(FilamentStaticShadowCacheTest, LightFromWorldInvalidates) {
+    const mat4f lightSpace = mat4f::scaling(float3{ 0.5f });
+    EXPECT_EQ(update(lightSpace), StaticShadowCacheState::MISS);
+    EXPECT_EQ(update(lightSpace), StaticShadowCacheState::HIT);
+
+    // rounding errors are tolerated
+    mat4f nearlyEqual = lightSpace;
+    nearlyEqual[0][0] = std::nextafter(nearlyEqual[0][0], 1.0f);
+    EXPECT_EQ(update(nearlyEqual), StaticShadowCacheState::HIT);
+
+    // the light or its frustum moves
+    EXPECT_EQ(update(mat4f::translation(float3{ 0, 0.01f, 0 }) * lightSpace),
+            StaticShadowCacheState::MISS);
+    EXPECT_EQ(update(lightSpace), StaticShadowCacheState::MISS);
+}
+
+TEST_F(FilamentStaticShadowCacheTest, PolygonOffsetInvalidates) {
+    EXPECT_EQ(update({}, { 1.0f, 1.0f }), StaticShadowCacheState::MISS);
+    EXPECT_EQ(update({}, { 1.0f, 1.0f }), StaticShadowCacheState::HIT);
+    EXPECT_EQ(update({}, { 2.0f, 1.0f }), StaticShadowCacheState::MISS);
+    EXPECT_EQ(update({}, { 2.0f, 2.0f }), StaticShadowCacheState::MISS);
+    EXPECT_EQ(update({}, { 2.0f, 2.0f }), StaticShadowCacheState::HIT);
+}
+
+TEST_F(FilamentStaticShadowCacheTest, RenderableChangesInvalidate) {
+    auto& rcm = engine->getRenderableManager();
+    auto const* mi = engine->getDefaultMaterial()->getDefaultInstance();
+    EXPECT_EQ(update(), StaticShadowCacheState::MISS);
+
+    // the material or the geometry of a static caster changes
+    rcm.setMaterialInstanceAt(rcm.getInstance(entities[0]), 0, mi);
+    EXPECT_EQ(update(), StaticShadowCacheState::MISS);
+    rcm.setGeometryAt(rcm.getInstance(entities[1]), 0,
+            RenderableManager::PrimitiveType::TRIANGLES, 0, 3);
+    EXPECT_EQ(update(), StaticShadowCacheState::MISS);
+    EXPECT_EQ(update(), StaticShadowCacheState::HIT);
+
+    // same for a dynamic caster, which doesn't matter
+    rcm.setMaterialInstanceAt(rcm.getInstance(entities[2]), 0, mi);
+    EXPECT_EQ(update(), StaticShadowCacheState::HIT);
+
+    // flagging a static caster again, e.g. after updating its vertex buffer
+    rcm.setStaticShadowCaster(rcm.getInstance(entities[0]), true);
+    EXPECT_EQ(update(), StaticShadowCacheState::MISS);
+    EXPECT_EQ(update(), StaticShadowCacheState::HIT);
+}
+
+TEST_F(FilamentStaticShadowCacheTest, DynamicRenderablesKeepCache) {
+    auto& rcm = engine->getRenderableManager();
+    EXPECT_EQ(update(), StaticShadowCacheState::MISS);
+
+    // creating and destroying a renderable that isn't a static caster
+    utils::Entity const entity = utils::EntityManager::get().create();
+    mesh->builder()
+            .boundingBox({ { 0, 0, 0 }, { 1, 1, 1 } })
+            .castShadows(true)
+            .build(*engine, entity);
+    EXPECT_EQ(update(), StaticShadowCacheState::HIT);
+
+    // clearing the flag of a renderable that doesn't have it
+    rcm.setStaticShadowCaster(rcm.getInstance(entity), false);
+    rcm.setStaticShadowCaster(rcm.getInstance(entities[2]), false);
+    EXPECT_EQ(update(), StaticShadowCacheState::HIT);
+
+    rcm.destroy(entity);
+    utils::EntityManager::get().destroy(entity);
+    EXPECT_EQ(update(), StaticShadowCacheState::HIT);
+
+    // a renderable that stops being a static caster
+    rcm.setStaticShadowCaster(rcm.getInstance(entities[1]), false);
+    EXPECT_EQ(update(), StaticShadowCacheState::MISS);
+}
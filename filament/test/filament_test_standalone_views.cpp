@@ -0,0 +1,252 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <filament/Camera.h>
+#include <filament/Engine.h>
+#include <filament/LightManager.h>
+#include <filament/RenderableManager.h>
+#include <filament/Renderer.h>
+#include <filament/RenderTarget.h>
+#include <filament/Scene.h>
+#include <filament/Texture.h>
+#include <filament/TransformManager.h>
+#include <filament/View.h>
+#include <filament/Viewport.h>
+
+#include "details/Scene.h"
+#include "details/View.h"
+
+#include "TriangleMesh.h"
+
+#include <utils/Entity.h>
+#include <utils/EntityManager.h>
+
+#include <math/vec3.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+using namespace filament;
+using namespace filament::math;
+using namespace utils;
+
+// Renders views looking down -Z and +Z at a scene with renderables and point lights on both
+// sides, with renderStandaloneView() and renderStandaloneViews(), and compares what each view
+// culled and prepared.
+class StandaloneViewsTest : public ::testing::Test {
+protected:
+    // What a view culled and prepared, kept by the view after rendering
+    struct ViewState {
+        uint32_t visibleRenderableCount;
+        uint32_t visibleDirectionalShadowCasterCount;
+        uint32_t visibleSpotShadowCasterCount;
+        bool hasDirectionalLight;
+        bool hasDynamicLighting;
+        bool hasShadowing;
+
+        bool operator==(ViewState const& rhs) const noexcept {
+            return visibleRenderableCount == rhs.visibleRenderableCount &&
+                    visibleDirectionalShadowCasterCount == rhs.visibleDirectionalShadowCasterCount &&
+                    visibleSpotShadowCasterCount == rhs.visibleSpotShadowCasterCount &&
+                    hasDirectionalLight == rhs.hasDirectionalLight &&
+                    hasDynamicLighting == rhs.hasDynamicLighting &&
+                    hasShadowing == rhs.hasShadowing;
+        }
+    };
+
+    void SetUp() override {
+        engine = Engine::create(Engine::Backend::NOOP);
+        renderer = engine->createRenderer();
+
+        mesh = std::make_unique<test::TriangleMesh>(*engine);
+
+        color = Texture::Builder()
+                .width(16).height(16)
+                .format(Texture::InternalFormat::RGBA8)
+                .usage(Texture::Usage::COLOR_ATTACHMENT | Texture::Usage::SAMPLEABLE)
+                .build(*engine);
+        target = RenderTarget::Builder()
+                .texture(RenderTarget::AttachmentPoint::COLOR, color)
+                .build(*engine);
+    }
+
+    void TearDown() override {
+        for (View* view : views) {
+            engine->destroy(view);
+        }
+        for (Entity e : cameras) {
+            engine->destroyCameraComponent(e);
+        }
+        for (Scene* scene : scenes) {
+            engine->destroy(scene);
+        }
+        for (Entity e : entities) {
+            engine->getRenderableManager().destroy(e);
+            engine->getLightManager().destroy(e);
+            engine->getTransformManager().destroy(e);
+        }
+        EntityManager::get().destroy(entities.size(), entities.data());
+        EntityManager::get().destroy(cameras.size(), cameras.data());
+        engine->destroy(target);
+        engine->destroy(color);
+        mesh.reset();
+        engine->destroy(renderer);
+        Engine::destroy(&engine);
+    }
+
+    Entity createEntity(float3 position) {
+        Entity e = EntityManager::get().create();
+        auto& tcm = engine->getTransformManager();
+        tcm.create(e);
+        tcm.setTransform(tcm.getInstance(e), mat4f::translation(position));
+        entities.push_back(e);
+        return e;
+    }
+
+    void addRenderable(Scene* scene, float3 position) {
+        Entity e = createEntity(position);
+        mesh->builder()
+                .boundingBox({ { -1, -1, -1 }, { 1, 1, 1 } })
+                .castShadows(true)
+                .receiveShadows(true)
+                .build(*engine, e);
+        scene->addEntity(e);
+    }
+
+    void addPointLight(Scene* scene, float3 position) {
+        Entity e = createEntity({});
+        LightManager::Builder(LightManager::Type::POINT)
+                .position(position)
+                .falloff(2.0f)
+                .build(*engine, e);
+        scene->addEntity(e);
+    }
+
+    // Renderables and point lights in front of and behind the origin, and a directional light
+    Scene* createScene(size_t behindCount) {
+        Scene* scene = engine->createScene();
+        scenes.push_back(scene);
+        addRenderable(scene, { 0, 0, -5 });
+        addPointLight(scene, { 0, 0, -5 });
+        for (size_t i = 0; i < behindCount; i++) {
+            addRenderable(scene, { float(i), 0, 5 });
+            addPointLight(scene, { float(i), 0, 5 });
+        }
+        Entity sun = createEntity({});
+        LightManager::Builder(LightManager::Type::DIRECTIONAL)
+                .direction({ 0, -1, 0 })
+                .castShadows(true)
+                .build(*engine, sun);
+        scene->addEntity(sun);
+        return scene;
+    }
+
+    View* createView(Scene* scene, float3 direction) {
+        Entity e = EntityManager::get().create();
+        cameras.push_back(e);
+        Camera* camera = engine->createCamera(e);
+        camera->setProjection(90.0, 1.0, 0.1, 100.0);
+        camera->lookAt({ 0, 0, 0 }, direction, { 0, 1, 0 });
+        View* view = engine->createView();
+        view->setScene(scene);
+        view->setCamera(camera);
+        view->setViewport({ 0, 0, 16, 16 });
+        view->setRenderTarget(target);
+        views.push_back(view);
+        return view;
+    }
+
+    ViewState getState(View const* view) const {
+        FView const& v = *upcast(view);
+        return { v.getVisibleRenderables().size(),
+                 v.getVisibleDirectionalShadowCasters().size(),
+                 v.getVisibleSpotShadowCasters().size(),
+                 v.hasDirectionalLight(), v.hasDynamicLighting(), v.hasShadowing() };
+    }
+
+    // number of lights the last view rendered with the scene kept after culling
+    static size_t getVisibleLightCount(Scene const* scene) {
+        return upcast(scene)->getLightData().size() - FScene::DIRECTIONAL_LIGHTS_COUNT;
+    }
+
+    void testViews(std::vector<View const*> const& batch) {
+        // each view rendered on its own
+        std::vector<ViewState> expected;
+        std::vector<size_t> expectedLightCounts;
+        for (View const* view : batch) {
+            renderer->renderStandaloneView(view);
+            expected.push_back(getState(view));
+            expectedLightCounts.push_back(getVisibleLightCount(view->getScene()));
+        }
+
+        // all the views rendered as a batch, in this order and in the reverse order, so that
+        // each view is the last one of a batch once
+        for (bool reversed : { false, true }) {
+            std::vector<View const*> views = batch;
+            if (reversed) {
+                std::reverse(views.begin(), views.end());
+            }
+            renderer->renderStandaloneViews(views.data(), views.size());
+            for (size_t i = 0; i < views.size(); i++) {
+                size_t const j = reversed ? views.size() - 1 - i : i;
+                EXPECT_TRUE(getState(views[i]) == expected[j]) << "view " << j;
+            }
+            // the scene's lights are the ones the last view of the batch culled
+            size_t const last = reversed ? 0 : views.size() - 1;
+            EXPECT_EQ(getVisibleLightCount(views.back()->getScene()), expectedLightCounts[last]);
+        }
+    }
+
+    Engine* engine = nullptr;
+    Renderer* renderer = nullptr;
+    std::unique_ptr<test::TriangleMesh> mesh;
+    Texture* color = nullptr;
+    RenderTarget* target = nullptr;
+    std::vector<Entity> entities;
+    std::vector<Entity> cameras;
+    std::vector<Scene*> scenes;
+    std::vector<View*> views;
+};
+
+TEST_F(StandaloneViewsTest, SharedScene) {
+    Scene* scene = createScene(2);
+    View const* front = createView(scene, { 0, 0, -1 });
+    View const* back = createView(scene, { 0, 0, 1 });
+
+    // the views don't see the same renderables and lights
+    renderer->renderStandaloneView(front);
+    EXPECT_EQ(getVisibleLightCount(scene), 1u);
+    renderer->renderStandaloneView(back);
+    EXPECT_EQ(getVisibleLightCount(scene), 2u);
+
+    testViews({ front, back });
+    testViews({ front, back, front });
+}
+
+TEST_F(StandaloneViewsTest, DifferentScenes) {
+    Scene* sceneA = createScene(1);
+    Scene* sceneB = createScene(3);
+    View const* frontA = createView(sceneA, { 0, 0, -1 });
+    View const* backA = createView(sceneA, { 0, 0, 1 });
+    View const* backB = createView(sceneB, { 0, 0, 1 });
+
+    testViews({ frontA, backB });
+    testViews({ frontA, backB, backA });
+    testViews({ backA, backB, frontA, backB });
+}
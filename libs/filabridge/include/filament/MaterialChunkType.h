@@ -44,6 +44,9 @@ enum UTILS_PUBLIC ChunkType : uint64_t {
     MaterialGlsl = charTo64bitNum("MAT_GLSL"),
     MaterialSpirv = charTo64bitNum("MAT_SPIR"),
     MaterialMetal = charTo64bitNum("MAT_METL"),
+    MaterialGlslCompressed = charTo64bitNum("MAT_GLSZ"),
+    MaterialSpirvCompressed = charTo64bitNum("MAT_SPIZ"),
+    MaterialMetalCompressed = charTo64bitNum("MAT_METZ"),
     MaterialShaderModels = charTo64bitNum("MAT_SMDL"),
     MaterialSamplerBindings = charTo64bitNum("MAT_SAMP"),   // no longer used
     MaterialProperties = charTo64bitNum("MAT_PROP"),
@@ -56,9 +56,9 @@ constexpr size_t CONFIG_MAX_LIGHT_COUNT = 256;
 constexpr size_t CONFIG_MAX_LIGHT_INDEX = CONFIG_MAX_LIGHT_COUNT - 1;
 
 // The maximum number of spot lights in a scene that can cast shadows.
-// There is currently a limit to 14 spot shadow due to how we store the culling result
-// (see View.h).
-constexpr size_t CONFIG_MAX_SHADOW_CASTING_SPOTS = 14;
+// This value is limited by UBO size, ES3.0 only guarantees 16 KiB.
+// We store 112 bytes per spot light shadow.
+constexpr size_t CONFIG_MAX_SHADOW_CASTING_SPOTS = 128;
 
 // The maximum number of shadow cascades that can be used for directional lights.
 constexpr size_t CONFIG_MAX_SHADOW_CASCADES = 4;
@@ -67,6 +67,12 @@ constexpr size_t CONFIG_MAX_SHADOW_CASCADES = 4;
 // We store 64 bytes per bone.
 constexpr size_t CONFIG_MAX_BONE_COUNT = 256;
 
+// The maximum number of renderables that can be drawn with a single instanced draw call when
+// automatic instancing is enabled.
+// This value is also limited by UBO size, ES3.0 only guarantees 16 KiB.
+// We store 256 bytes per renderable.
+constexpr size_t CONFIG_MAX_INSTANCES = 64;
+
 // The maximum number of morph target count.
 // This value is limited by ES3.0, ES3.0 only guarantees 256 layers in an array texture.
 constexpr size_t CONFIG_MAX_MORPH_TARGET_COUNT = 256;
@@ -171,9 +171,8 @@ struct PerViewUib { // NOLINT(cppcoreguidelines-pro-type-member-init)
 static_assert(sizeof(PerViewUib) == sizeof(math::float4) * 128,
         "PerViewUib should be exactly 2KiB");
 
-// PerRenderableUib must have an alignment of 256 to be compatible with all versions of GLES.
-struct alignas(256) PerRenderableUib { // NOLINT(cppcoreguidelines-pro-type-member-init)
-    static constexpr utils::StaticString _name{ "ObjectUniforms" };
+// PerRenderableData must have an alignment of 256 to be compatible with all versions of GLES.
+struct alignas(256) PerRenderableData { // NOLINT(cppcoreguidelines-pro-type-member-init)
     math::mat4f worldFromModelMatrix;
     math::mat3f worldFromModelNormalMatrix;   // this gets expanded to 48 bytes during the copy to the UBO
     alignas(16) uint32_t morphTargetCount;
@@ -183,13 +182,25 @@ struct alignas(256) PerRenderableUib { // NOLINT(cppcoreguidelines-pro-type-memb
     // TODO: We need a better solution, this currently holds the average local scale for the renderable
     float userData;
 
-    static uint32_t packFlags(bool skinning, bool morphing, bool contactShadows) noexcept {
+    static uint32_t packFlags(bool skinning, bool morphing, bool contactShadows,
+            bool instancing) noexcept {
         return (skinning ? 1 : 0) |
                (morphing ? 2 : 0) |
-               (contactShadows ? 4 : 0);
+               (contactShadows ? 4 : 0) |
+               (instancing ? 8 : 0);
     }
 };
-static_assert(sizeof(PerRenderableUib) % 256 == 0, "sizeof(Transform) should be a multiple of 256");
+static_assert(sizeof(PerRenderableData) % 256 == 0, "sizeof(Transform) should be a multiple of 256");
+
+// The per-renderable UBO is bound at the offset of a renderable's data. Renderables drawn with
+// a single instanced draw call (automatic instancing) have their data stored consecutively
+// and each instance reads its own element.
+struct PerRenderableUib { // NOLINT(cppcoreguidelines-pro-type-member-init)
+    static constexpr utils::StaticString _name{ "ObjectUniforms" };
+    PerRenderableData data[CONFIG_MAX_INSTANCES];
+};
+static_assert(sizeof(PerRenderableUib) <= 16384,
+        "PerRenderableUib exceed max UBO size");
 
 struct LightsUib { // NOLINT(cppcoreguidelines-pro-type-member-init)
     static constexpr utils::StaticString _name{ "LightsUniforms" };
@@ -26,6 +26,8 @@
 
 #include <tsl/robin_map.h>
 
+#include <vector>
+
 namespace filaflat {
 
 class BlobDictionary;
@@ -41,10 +43,24 @@ public:
     bool readIndex(filamat::ChunkType materialTag);
 
     // call this as many times as needed
+    // the dictionary is not used by the compressed chunks, it can be empty
     bool getShader(ShaderBuilder& shaderBuilder,
             BlobDictionary const& dictionary,
             uint8_t shaderModel, filament::Variant variant, uint8_t stage);
 
+    // returns the compressed chunk type corresponding to a material chunk type
+    static filamat::ChunkType getCompressedType(filamat::ChunkType materialTag) noexcept;
+
+    struct BlockInfo {
+        uint32_t compressedSize;
+        uint32_t size;
+        uint32_t shaderCount;   // distinct shaders stored in the block
+    };
+
+    // blocks of a compressed chunk, valid after readIndex()
+    size_t getBlockCount() const noexcept { return mBlocks.size(); }
+    BlockInfo getBlockInfo(size_t index) const noexcept;
+
 private:
     ChunkContainer const& mContainer;
     filamat::ChunkType mMaterialTag = filamat::ChunkType::Unknown;
@@ -52,6 +68,28 @@ private:
     const uint8_t* mBase = nullptr;
     tsl::robin_map<uint32_t, uint32_t> mOffsets;
 
+    // For compressed chunks, mOffsets indexes mShaders.
+    struct Shader {
+        uint32_t block;
+        uint32_t offset;
+        uint32_t size;
+    };
+    struct Block {
+        const uint8_t* data;
+        uint32_t compressedSize;
+        uint32_t size;
+    };
+    std::vector<Shader> mShaders;
+    std::vector<Block> mBlocks;
+    // the last decompressed block, consecutive requests are usually for the same variant
+    std::vector<uint8_t> mDecompressedBlock;
+    uint32_t mDecompressedBlockIndex = UINT32_MAX;
+
+    bool readCompressedIndex(Unflattener unflattener);
+
+    bool getCompressedShader(ShaderBuilder& shaderBuilder,
+            uint8_t shaderModel, filament::Variant variant, uint8_t stage);
+
     bool getTextShader(Unflattener unflattener,
             BlobDictionary const& dictionary, ShaderBuilder& shaderBuilder,
             uint8_t shaderModel, filament::Variant variant, uint8_t ps);
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Lz4.h"
+
+#include <string.h>
+
+namespace filaflat {
+
+static inline bool readLength(const uint8_t*& src, const uint8_t* end, size_t& length) noexcept {
+    uint8_t b;
+    do {
+        if (src == end) {
+            return false;
+        }
+        b = *src++;
+        length += b;
+    } while (b == 255);
+    return true;
+}
+
+bool decompressLz4(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize) noexcept {
+    const uint8_t* const srcEnd = src + srcSize;
+    uint8_t* const dstStart = dst;
+    uint8_t* const dstEnd = dst + dstSize;
+
+    while (src < srcEnd) {
+        const uint8_t token = *src++;
+
+        size_t literalCount = token >> 4u;
+        if (literalCount == 15 && !readLength(src, srcEnd, literalCount)) {
+            return false;
+        }
+        if (literalCount > size_t(srcEnd - src) || literalCount > size_t(dstEnd - dst)) {
+            return false;
+        }
+        memcpy(dst, src, literalCount);
+        src += literalCount;
+        dst += literalCount;
+
+        // the last sequence only has literals
+        if (src == srcEnd) {
+            break;
+        }
+
+        if (srcEnd - src < 2) {
+            return false;
+        }
+        const size_t offset = size_t(src[0]) | (size_t(src[1]) << 8u);
+        src += 2;
+        if (offset == 0 || offset > size_t(dst - dstStart)) {
+            return false;
+        }
+
+        size_t matchLength = token & 0xFu;
+        if (matchLength == 15 && !readLength(src, srcEnd, matchLength)) {
+            return false;
+        }
+        matchLength += 4;
+        if (matchLength > size_t(dstEnd - dst)) {
+            return false;
+        }
+
+        // matches can overlap the bytes they produce, which repeats them
+        const uint8_t* match = dst - offset;
+        if (offset >= matchLength) {
+            memcpy(dst, match, matchLength);
+            dst += matchLength;
+        } else {
+            for (uint8_t* const end = dst + matchLength; dst != end;) {
+                *dst++ = *match++;
+            }
+        }
+    }
+    return dst == dstEnd;
+}
+
+} // namespace filaflat
@@ -0,0 +1,31 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAFLAT_LZ4_H
+#define TNT_FILAFLAT_LZ4_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace filaflat {
+
+// Decompresses a single block of the LZ4 block format. Returns false if the block is malformed
+// or if it doesn't decompress to exactly dstSize bytes.
+bool decompressLz4(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize) noexcept;
+
+} // namespace filaflat
+
+#endif // TNT_FILAFLAT_LZ4_H
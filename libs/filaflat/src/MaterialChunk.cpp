@@ -19,8 +19,16 @@
 #include <filaflat/ChunkContainer.h>
 #include <filaflat/ShaderBuilder.h>
 
+#include "Lz4.h"
+
 #include <utils/Log.h>
 
+#if defined (FILAMENT_DRIVER_SUPPORTS_VULKAN)
+#include <smolv.h>
+#endif
+
+#include <algorithm>
+
 namespace filaflat {
 
 static inline uint32_t makeKey(uint8_t shaderModel, filament::Variant variant, uint8_t type) noexcept {
@@ -49,6 +57,15 @@ bool MaterialChunk::readIndex(filamat::ChunkType materialTag) {
     mMaterialTag = materialTag;
     mBase = unflattener.getCursor();
 
+    switch (materialTag) {
+        case filamat::ChunkType::MaterialGlslCompressed:
+        case filamat::ChunkType::MaterialSpirvCompressed:
+        case filamat::ChunkType::MaterialMetalCompressed:
+            return readCompressedIndex(unflattener);
+        default:
+            break;
+    }
+
     // Read how many shaders we have in the chunk.
     uint64_t numShaders;
     if (!unflattener.read(&numShaders) || numShaders == 0) {
@@ -84,6 +101,96 @@ bool MaterialChunk::readIndex(filamat::ChunkType materialTag) {
     return true;
 }
 
+bool MaterialChunk::readCompressedIndex(Unflattener unflattener) {
+    uint64_t numShaders;
+    if (!unflattener.read(&numShaders) || numShaders == 0) {
+        return false;
+    }
+
+    mShaders.reserve(numShaders);
+    for (uint64_t i = 0; i < numShaders; i++) {
+        uint8_t shaderModelValue;
+        filament::Variant variant;
+        uint8_t pipelineStageValue;
+        Shader shader{};
+        if (!unflattener.read(&shaderModelValue) ||
+                !unflattener.read(&variant) ||
+                !unflattener.read(&pipelineStageValue) ||
+                !unflattener.read(&shader.block) ||
+                !unflattener.read(&shader.offset) ||
+                !unflattener.read(&shader.size)) {
+            return false;
+        }
+        uint32_t key = makeKey(shaderModelValue, variant, pipelineStageValue);
+        mOffsets[key] = uint32_t(mShaders.size());
+        mShaders.push_back(shader);
+    }
+
+    // For now, 1 (LZ4) is the only compression scheme.
+    uint32_t compressionScheme;
+    if (!unflattener.read(&compressionScheme) || compressionScheme != 1) {
+        return false;
+    }
+
+    uint32_t blockCount;
+    if (!unflattener.read(&blockCount)) {
+        return false;
+    }
+
+    std::vector<uint32_t> blockOffsets(blockCount);
+    mBlocks.resize(blockCount);
+    for (uint32_t i = 0; i < blockCount; i++) {
+        if (!unflattener.read(&blockOffsets[i]) ||
+                !unflattener.read(&mBlocks[i].compressedSize) ||
+                !unflattener.read(&mBlocks[i].size)) {
+            return false;
+        }
+    }
+
+    // The blocks are only decompressed when one of their shaders is requested, but check now
+    // that they and the shaders they contain are within bounds.
+    const uint8_t* const data = unflattener.getCursor();
+    const size_t dataSize = mContainer.getChunkEnd(mMaterialTag) - data;
+    for (uint32_t i = 0; i < blockCount; i++) {
+        if (size_t(blockOffsets[i]) + mBlocks[i].compressedSize > dataSize) {
+            return false;
+        }
+        mBlocks[i].data = data + blockOffsets[i];
+    }
+    for (Shader const& shader : mShaders) {
+        if (shader.block >= blockCount ||
+                size_t(shader.offset) + shader.size > mBlocks[shader.block].size) {
+            return false;
+        }
+    }
+    return true;
+}
+
+MaterialChunk::BlockInfo MaterialChunk::getBlockInfo(size_t index) const noexcept {
+    std::vector<uint32_t> offsets;
+    for (Shader const& shader : mShaders) {
+        if (shader.block == index) {
+            offsets.push_back(shader.offset);
+        }
+    }
+    std::sort(offsets.begin(), offsets.end());
+    const size_t shaderCount = std::unique(offsets.begin(), offsets.end()) - offsets.begin();
+    return { mBlocks[index].compressedSize, mBlocks[index].size, uint32_t(shaderCount) };
+}
+
+filamat::ChunkType MaterialChunk::getCompressedType(filamat::ChunkType materialTag) noexcept {
+    switch (materialTag) {
+        case filamat::ChunkType::MaterialGlsl:
+            return filamat::ChunkType::MaterialGlslCompressed;
+        case filamat::ChunkType::MaterialSpirv:
+            return filamat::ChunkType::MaterialSpirvCompressed;
+        case filamat::ChunkType::MaterialMetal:
+            return filamat::ChunkType::MaterialMetalCompressed;
+        default:
+            return filamat::ChunkType::Unknown;
+    }
+}
+
 bool MaterialChunk::getTextShader(Unflattener unflattener, BlobDictionary const& dictionary,
         ShaderBuilder& shaderBuilder, uint8_t shaderModel, filament::Variant variant, uint8_t ps) {
     if (mBase == nullptr) {
@@ -162,6 +269,56 @@ bool MaterialChunk::getSpirvShader(BlobDictionary const& dictionary,
     return true;
 }
 
+bool MaterialChunk::getCompressedShader(ShaderBuilder& shaderBuilder,
+        uint8_t shaderModel, filament::Variant variant, uint8_t stage) {
+
+    if (mBase == nullptr) {
+        return false;
+    }
+
+    uint32_t key = makeKey(shaderModel, variant, stage);
+    auto pos = mOffsets.find(key);
+    if (pos == mOffsets.end()) {
+        return false;
+    }
+
+    Shader const& shader = mShaders[pos->second];
+    if (shader.block != mDecompressedBlockIndex) {
+        Block const& block = mBlocks[shader.block];
+        mDecompressedBlock.resize(block.size);
+        if (!decompressLz4(block.data, block.compressedSize,
+                mDecompressedBlock.data(), block.size)) {
+            mDecompressedBlockIndex = UINT32_MAX;
+            return false;
+        }
+        mDecompressedBlockIndex = shader.block;
+    }
+
+    const char* const data = (const char*)mDecompressedBlock.data() + shader.offset;
+    shaderBuilder.reset();
+    if (mMaterialTag == filamat::ChunkType::MaterialSpirvCompressed) {
+#if defined (FILAMENT_DRIVER_SUPPORTS_VULKAN)
+        const size_t spirvSize = smolv::GetDecodedBufferSize(data, shader.size);
+        if (spirvSize == 0) {
+            return false;
+        }
+        std::vector<char> spirv(spirvSize);
+        if (!smolv::Decode(data, shader.size, spirv.data(), spirvSize)) {
+            return false;
+        }
+        shaderBuilder.announce(spirvSize);
+        shaderBuilder.append(spirv.data(), spirvSize);
+#else
+        return false;
+#endif
+    } else {
+        // text shaders are stored with their null terminator
+        shaderBuilder.announce(shader.size);
+        shaderBuilder.append(data, shader.size);
+    }
+    return true;
+}
+
 bool MaterialChunk::getShader(ShaderBuilder& shaderBuilder,
         BlobDictionary const& dictionary, uint8_t shaderModel, filament::Variant variant, uint8_t stage) {
     switch (mMaterialTag) {
@@ -170,6 +327,10 @@ bool MaterialChunk::getShader(ShaderBuilder& shaderBuilder,
             return getTextShader(mUnflattener, dictionary, shaderBuilder, shaderModel, variant, stage);
         case filamat::ChunkType::MaterialSpirv:
             return getSpirvShader(dictionary, shaderBuilder, shaderModel, variant, stage);
+        case filamat::ChunkType::MaterialGlslCompressed:
+        case filamat::ChunkType::MaterialSpirvCompressed:
+        case filamat::ChunkType::MaterialMetalCompressed:
+            return getCompressedShader(shaderBuilder, shaderModel, variant, stage);
         default:
             return false;
     }
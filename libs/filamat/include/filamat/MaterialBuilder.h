@@ -516,6 +516,34 @@ public:
     //! If true, will include debugging information in generated SPIRV.
     MaterialBuilder& generateDebugInfo(bool generateDebugInfo) noexcept;
 
+    /**
+     * Specifies a directory used to cache the compiled shaders across builds. Shaders whose
+     * generated code, configuration and compiler versions are unchanged are read from the cache
+     * instead of being compiled again. The directory is created if needed and can be shared by
+     * concurrent builds. Ignored when linking against filamat_lite.
+     */
+    MaterialBuilder& shaderCache(const char* directory) noexcept;
+
+    /**
+     * If true, the shaders are stored in independently compressed blocks instead of shared
+     * dictionaries (default is false). This makes the package smaller and lets filament
+     * decompress only the variants it uses, but the package can't be read by older versions
+     * of filament.
+     */
+    MaterialBuilder& compressShaders(bool compressShaders) noexcept;
+
+    struct BuildStatistics {
+        size_t shaderCount = 0;         //!< shaders generated for all the variants
+        size_t uniqueShaderCount = 0;   //!< distinct shaders among them, which are compiled
+        size_t cacheHitCount = 0;       //!< compiled shaders read from the shader cache
+        size_t cacheMissCount = 0;      //!< compiled shaders added to the shader cache
+    };
+
+    //! Returns statistics about the last call to build().
+    BuildStatistics getBuildStatistics() const noexcept {
+        return mBuildStatistics;
+    }
+
     //! Specifies a list of variants that should be filtered out during code generation.
     MaterialBuilder& variantFilter(filament::UserVariantFilterMask variantFilter) noexcept;
 
@@ -659,7 +687,7 @@ private:
     bool generateShaders(
             utils::JobSystem& jobSystem,
             const std::vector<filamat::Variant>& variants, ChunkContainer& container,
-            const MaterialInfo& info) const noexcept;
+            const MaterialInfo& info, BuildStatistics& statistics) const noexcept;
 
     bool hasCustomVaryings() const noexcept;
     bool needsStandardDepthProgram() const noexcept;
@@ -754,6 +782,11 @@ private:
     PreprocessorDefineList mDefines;
 
     filament::UserVariantFilterMask mVariantFilter = {};
+
+    utils::CString mShaderCacheDirectory;
+    BuildStatistics mBuildStatistics;
+
+    bool mCompressShaders = false;
 };
 
 } // namespace filamat
@@ -424,6 +424,12 @@ void GLSLPostProcessor::fullOptimization(const TShader& tShader,
     }
 }
 
+// IMPORTANT: bump this whenever the output of this file changes for a given input, in particular
+// when the optimization passes below, in registerPerformancePasses() or in registerSizePasses()
+// are modified. Otherwise, stale shaders will be fetched from the matc shader cache. Compiler
+// upgrades are taken into account by the cache separately.
+const uint32_t GLSLPostProcessor::OUTPUT_VERSION = 1;
+
 std::shared_ptr<spvtools::Optimizer> GLSLPostProcessor::createOptimizer(
         MaterialBuilder::Optimization optimization, Config const& config) {
     auto optimizer = std::make_shared<spvtools::Optimizer>(SPV_ENV_UNIVERSAL_1_0);
@@ -45,6 +45,10 @@ public:
         GENERATE_DEBUG_INFO = 1 << 1,
     };
 
+    // Version of the output of process() for a given input and compilers, used to invalidate
+    // the shader cache (see ShaderCache). Defined next to the optimization passes.
+    static const uint32_t OUTPUT_VERSION;
+
     GLSLPostProcessor(MaterialBuilder::Optimization optimization, uint32_t flags);
 
     ~GLSLPostProcessor();
@@ -16,13 +16,17 @@
 
 #include "filamat/MaterialBuilder.h"
 
+#include <algorithm>
 #include <atomic>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include <utils/JobSystem.h>
 #include <utils/Log.h>
-#include <utils/Mutex.h>
 #include <utils/Panic.h>
 
 #include <private/filament/UniformInterfaceBlock.h>
@@ -36,6 +40,7 @@
 #include "shaders/ShaderGenerator.h"
 
 #include "eiff/BlobDictionary.h"
+#include "eiff/CompressedShaderChunk.h"
 #include "eiff/LineDictionary.h"
 #include "eiff/MaterialInterfaceBlockChunk.h"
 #include "eiff/MaterialTextChunk.h"
@@ -49,6 +54,7 @@
 
 #ifndef FILAMAT_LITE
 #include "GLSLPostProcessor.h"
+#include "ShaderCache.h"
 #include "sca/GLSLTools.h"
 #else
 #include "sca/GLSLToolsLite.h"
@@ -404,6 +410,16 @@ MaterialBuilder& MaterialBuilder::generateDebugInfo(bool generateDebugInfo) noex
     return *this;
 }
 
+MaterialBuilder& MaterialBuilder::shaderCache(const char* directory) noexcept {
+    mShaderCacheDirectory = CString(directory);
+    return *this;
+}
+
+MaterialBuilder& MaterialBuilder::compressShaders(bool compressShaders) noexcept {
+    mCompressShaders = compressShaders;
+    return *this;
+}
+
 MaterialBuilder& MaterialBuilder::variantFilter(filament::UserVariantFilterMask variantFilter) noexcept {
     mVariantFilter = variantFilter;
     return *this;
@@ -622,17 +638,22 @@ static void showErrorMessage(const char* materialName, filament::Variant variant
 }
 
 bool MaterialBuilder::generateShaders(JobSystem& jobSystem, const std::vector<Variant>& variants,
-        ChunkContainer& container, const MaterialInfo& info) const noexcept {
+        ChunkContainer& container, const MaterialInfo& info,
+        BuildStatistics& statistics) const noexcept {
     // Create a postprocessor to optimize / compile to Spir-V if necessary.
 #ifndef FILAMAT_LITE
     uint32_t flags = 0;
     flags |= mPrintShaders ? GLSLPostProcessor::PRINT_SHADERS : 0;
     flags |= mGenerateDebugInfo ? GLSLPostProcessor::GENERATE_DEBUG_INFO : 0;
     GLSLPostProcessor postProcessor(mOptimization, flags);
+
+    // The cache is bypassed when printing shaders, which happens during their compilation.
+    std::unique_ptr<ShaderCache> shaderCache;
+    if (!mShaderCacheDirectory.empty() && !mPrintShaders) {
+        shaderCache = std::make_unique<ShaderCache>(mShaderCacheDirectory.c_str());
+    }
 #endif
 
-    // Start: must be protected by lock
-    Mutex entriesLock;
     std::vector<TextEntry> glslEntries;
     std::vector<SpirvEntry> spirvEntries;
     std::vector<TextEntry> metalEntries;
@@ -640,7 +661,6 @@ bool MaterialBuilder::generateShaders(JobSystem& jobSystem, const std::vector<Va
 #ifndef FILAMAT_LITE
     BlobDictionary spirvDictionary;
 #endif
-    // End: must be protected by lock
 
     ShaderGenerator sg(
             mProperties, mVariables, mOutputs, mDefines, mMaterialFragmentCode.getResolved(),
@@ -650,7 +670,26 @@ bool MaterialBuilder::generateShaders(JobSystem& jobSystem, const std::vector<Va
     container.addSimpleChild<bool>(ChunkType::MaterialHasCustomDepthShader, needsStandardDepthProgram());
 
     std::atomic_bool cancelJobs(false);
-    bool firstJob = true;
+
+#ifndef FILAMAT_LITE
+    // glslang performs unguarded global operations on first use, so the first shader that is
+    // actually compiled must be compiled alone. With the shader cache, this is not necessarily
+    // the first job: the jobs that miss the cache wait until the first compile is complete.
+    std::atomic_bool firstCompileDone(false);
+    std::mutex firstCompileLock;
+    auto process = [&](const std::string& shader, GLSLPostProcessor::Config const& config,
+            std::string* pGlsl, std::vector<uint32_t>* pSpirv, std::string* pMsl) {
+        if (!firstCompileDone.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(firstCompileLock);
+            if (!firstCompileDone.load(std::memory_order_relaxed)) {
+                const bool ok = postProcessor.process(shader, config, pGlsl, pSpirv, pMsl);
+                firstCompileDone.store(true, std::memory_order_release);
+                return ok;
+            }
+        }
+        return postProcessor.process(shader, config, pGlsl, pSpirv, pMsl);
+    };
+#endif
 
     for (const auto& params : mCodeGenPermutations) {
         if (cancelJobs.load()) {
@@ -669,39 +708,16 @@ bool MaterialBuilder::generateShaders(JobSystem& jobSystem, const std::vector<Va
         const bool targetApiNeedsMsl = targetApi == TargetApi::METAL;
         const bool targetApiNeedsGlsl = targetApi == TargetApi::OPENGL;
 
-        // Set when a job fails
+        // Generate raw shader code.
+        std::vector<std::string> shaders(variants.size());
         JobSystem::Job* parent = jobSystem.createJob();
-
-        for (const auto& v : variants) {
-            JobSystem::Job* job = jobs::createJob(jobSystem, parent, [&]() {
-                if (cancelJobs.load()) {
-                    return;
-                }
-
-                // TODO: avoid allocations when not required
-                std::vector<uint32_t> spirv;
-                std::string msl;
-
-                std::vector<uint32_t>* pSpirv = targetApiNeedsSpirv ? &spirv : nullptr;
-                std::string* pMsl = targetApiNeedsMsl ? &msl : nullptr;
-
-                TextEntry glslEntry{0};
-                SpirvEntry spirvEntry{0};
-                TextEntry metalEntry{0};
-
-                glslEntry.shaderModel = static_cast<uint8_t>(params.shaderModel);
-                spirvEntry.shaderModel = static_cast<uint8_t>(params.shaderModel);
-                metalEntry.shaderModel = static_cast<uint8_t>(params.shaderModel);
-
-                glslEntry.variantKey  = v.variant.key;
-                spirvEntry.variantKey = v.variant.key;
-                metalEntry.variantKey = v.variant.key;
-
-                // Generate raw shader code.
-                // The quotes in Google-style line directives cause problems with certain drivers. These
-                // directives are optimized away when using the full filamat, so down below we
-                // explicitly remove them when using filamat lite.
-                std::string shader;
+        for (size_t i = 0; i < variants.size(); i++) {
+            jobSystem.run(jobs::createJob(jobSystem, parent, [&, i]() {
+                const auto& v = variants[i];
+                std::string& shader = shaders[i];
+                // The quotes in Google-style line directives cause problems with certain drivers.
+                // These directives are optimized away when using the full filamat, so down below
+                // we explicitly remove them when using filamat lite.
                 if (v.stage == filament::backend::ShaderType::VERTEX) {
                     shader = sg.createVertexProgram(
                             shaderModel, targetApi, targetLanguage, info, v.variant,
@@ -718,12 +734,63 @@ bool MaterialBuilder::generateShaders(JobSystem& jobSystem, const std::vector<Va
                     glslTools.removeGoogleLineDirectives(shader);
 #endif
                 }
+            }));
+        }
+        jobSystem.runAndWait(parent);
 
-                std::string* pGlsl = nullptr;
-                if (targetApiNeedsGlsl) {
-                    pGlsl = &shader;
+        // Many variants generate the exact same code, typically when the features they enable
+        // are not used by the material. Only the first of identical shaders is compiled, the
+        // others reuse its output.
+        auto isSameProgram = [&](size_t a, size_t b) {
+            if (variants[a].stage != variants[b].stage) {
+                return false;
+            }
+            // the MSL bindings also depend on the samplers of the variant
+            if (targetApiNeedsMsl && mMaterialDomain == MaterialDomain::SURFACE) {
+                for (uint8_t index = 0; index < filament::BindingPoints::COUNT; index++) {
+                    if (filament::SibGenerator::getSib(index, variants[a].variant) !=
+                            filament::SibGenerator::getSib(index, variants[b].variant)) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        };
+        std::vector<size_t> sources(variants.size());
+        std::vector<size_t> uniqueShaders;
+        std::unordered_map<std::string_view, std::vector<size_t>> identicalShaders;
+        for (size_t i = 0; i < variants.size(); i++) {
+            auto& candidates = identicalShaders[shaders[i]];
+            auto pos = std::find_if(candidates.begin(), candidates.end(),
+                    [&](size_t j) { return isSameProgram(i, j); });
+            if (pos == candidates.end()) {
+                candidates.push_back(i);
+                uniqueShaders.push_back(i);
+                sources[i] = i;
+            } else {
+                sources[i] = *pos;
+            }
+        }
+        statistics.shaderCount += variants.size();
+        statistics.uniqueShaderCount += uniqueShaders.size();
+
+        // Compile the unique shaders.
+        std::vector<std::vector<uint32_t>> spirvs(variants.size());
+        std::vector<std::string> msls(variants.size());
+        parent = jobSystem.createJob();
+        for (size_t i : uniqueShaders) {
+            jobSystem.run(jobs::createJob(jobSystem, parent, [&, i]() {
+                if (cancelJobs.load()) {
+                    return;
                 }
 
+                const auto& v = variants[i];
+                std::string& shader = shaders[i];
+
+                std::string* pGlsl = targetApiNeedsGlsl ? &shader : nullptr;
+                std::vector<uint32_t>* pSpirv = targetApiNeedsSpirv ? &spirvs[i] : nullptr;
+                std::string* pMsl = targetApiNeedsMsl ? &msls[i] : nullptr;
+
 #ifndef FILAMAT_LITE
                 GLSLPostProcessor::Config config{
                         .variant = v.variant,
@@ -741,7 +808,20 @@ bool MaterialBuilder::generateShaders(JobSystem& jobSystem, const std::vector<Va
                     config.glsl.subpassInputToColorLocation.emplace_back(0, 0);
                 }
 
-                bool ok = postProcessor.process(shader, config, pGlsl, pSpirv, pMsl);
+                bool ok;
+                if (shaderCache) {
+                    const ShaderCache::Key key =
+                            ShaderCache::computeKey(shader, config, mOptimization, flags);
+                    ok = shaderCache->get(key, pGlsl, pSpirv, pMsl);
+                    if (!ok) {
+                        ok = process(shader, config, pGlsl, pSpirv, pMsl);
+                        if (ok) {
+                            shaderCache->put(key, pGlsl, pSpirv, pMsl);
+                        }
+                    }
+                } else {
+                    ok = process(shader, config, pGlsl, pSpirv, pMsl);
+                }
 #else
                 bool ok = true;
 #endif
@@ -756,56 +836,65 @@ bool MaterialBuilder::generateShaders(JobSystem& jobSystem, const std::vector<Va
                         ShaderGenerator::fixupExternalSamplers(shaderModel, shader, info);
                     }
                 }
+            }));
+        }
 
-                // NOTE: Everything below touches shared structures protected by a lock
-                // NOTE: do not execute expensive work from here on!
-                std::unique_lock<utils::Mutex> lock(entriesLock);
-
-                if (targetApi == TargetApi::OPENGL) {
-                    glslEntry.stage = v.stage;
-                    glslEntry.shader = shader;
+        jobSystem.runAndWait(parent);
 
-                    glslEntries.push_back(glslEntry);
-                }
+        if (cancelJobs.load()) {
+            return false;
+        }
 
-#ifndef FILAMAT_LITE
-                if (targetApi == TargetApi::VULKAN) {
-                    assert(!spirv.empty());
-                    spirvEntry.stage = v.stage;
-                    spirvEntry.spirv = std::move(spirv);
+        // Emit an entry for every variant, duplicates are merged by the dictionaries below.
+        for (size_t i = 0; i < variants.size(); i++) {
+            const auto& v = variants[i];
+            const size_t source = sources[i];
 
-                    spirvEntries.push_back(spirvEntry);
-                }
+            if (targetApi == TargetApi::OPENGL) {
+                TextEntry glslEntry{0};
+                glslEntry.shaderModel = static_cast<uint8_t>(params.shaderModel);
+                glslEntry.variantKey = v.variant.key;
+                glslEntry.stage = v.stage;
+                glslEntry.shader = shaders[source];
+                glslEntries.push_back(std::move(glslEntry));
+            }
 
-                if (targetApi == TargetApi::METAL) {
-                    assert(!spirv.empty());
-                    assert(msl.length() > 0);
-                    metalEntry.stage = v.stage;
-                    metalEntry.shader = msl;
+#ifndef FILAMAT_LITE
+            if (targetApi == TargetApi::VULKAN) {
+                assert(!spirvs[source].empty());
+                SpirvEntry spirvEntry{0};
+                spirvEntry.shaderModel = static_cast<uint8_t>(params.shaderModel);
+                spirvEntry.variantKey = v.variant.key;
+                spirvEntry.stage = v.stage;
+                spirvEntry.spirv = spirvs[source];
+                spirvEntries.push_back(std::move(spirvEntry));
+            }
 
-                    metalEntries.push_back(metalEntry);
-                }
-#endif
-            });
-
-            // NOTE: We run the first job separately to work the lack of thread safety
-            //       guarantees in glslang. This library performs unguarded global
-            //       operations on first use.
-            if (firstJob) {
-                jobSystem.runAndWait(job);
-                firstJob = false;
-            } else {
-                jobSystem.run(job);
+            if (targetApi == TargetApi::METAL) {
+                assert(!spirvs[source].empty());
+                assert(msls[source].length() > 0);
+                TextEntry metalEntry{0};
+                metalEntry.shaderModel = static_cast<uint8_t>(params.shaderModel);
+                metalEntry.variantKey = v.variant.key;
+                metalEntry.stage = v.stage;
+                metalEntry.shader = msls[source];
+                metalEntries.push_back(std::move(metalEntry));
             }
+#endif
         }
-
-        jobSystem.runAndWait(parent);
     }
 
     if (cancelJobs.load()) {
         return false;
     }
 
+#ifndef FILAMAT_LITE
+    if (shaderCache) {
+        statistics.cacheHitCount = shaderCache->getHitCount();
+        statistics.cacheMissCount = shaderCache->getMissCount();
+    }
+#endif
+
     // Sort the variants.
     auto compare = [](const auto& a, const auto& b) {
         static_assert(sizeof(decltype(a.variantKey)) == 1);
@@ -818,6 +907,23 @@ bool MaterialBuilder::generateShaders(JobSystem& jobSystem, const std::vector<Va
     std::sort(spirvEntries.begin(), spirvEntries.end(), compare);
     std::sort(metalEntries.begin(), metalEntries.end(), compare);
 
+    if (mCompressShaders) {
+        if (!glslEntries.empty()) {
+            container.addChild<CompressedShaderChunk>(glslEntries,
+                    ChunkType::MaterialGlslCompressed);
+        }
+#ifndef FILAMAT_LITE
+        if (!spirvEntries.empty()) {
+            container.addChild<CompressedShaderChunk>(spirvEntries, !mGenerateDebugInfo);
+        }
+        if (!metalEntries.empty()) {
+            container.addChild<CompressedShaderChunk>(metalEntries,
+                    ChunkType::MaterialMetalCompressed);
+        }
+#endif
+        return true;
+    }
+
     // Generate the dictionaries.
     for (const auto& s : glslEntries) {
         textDictionary.addText(s.shader);
@@ -966,7 +1072,8 @@ Package MaterialBuilder::build(JobSystem& jobSystem) noexcept {
     const auto variants = mMaterialDomain == MaterialDomain::SURFACE ?
         determineSurfaceVariants(mVariantFilter, isLit(), mShadowMultiplier) :
         determinePostProcessVariants();
-    bool success = generateShaders(jobSystem, variants, container, info);
+    mBuildStatistics = {};
+    bool success = generateShaders(jobSystem, variants, container, info, mBuildStatistics);
 
     if (!success) {
         // Return an empty package to signal a failure to build the material.
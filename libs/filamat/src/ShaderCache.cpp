@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ShaderCache.h"
+
+#include "shaders/MaterialInfo.h"
+
+#include <filament/MaterialEnums.h>
+
+#include <spirv-tools/libspirv.h>
+#include <spirv_cross_c.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <thread>
+
+namespace filamat {
+
+// Must be bumped whenever the format of the cache entries changes. Changes to the output of
+// GLSLPostProcessor are tracked by GLSLPostProcessor::OUTPUT_VERSION.
+static constexpr uint32_t SHADER_CACHE_VERSION = 1;
+
+// "FSHC" in little-endian
+static constexpr uint32_t SHADER_CACHE_MAGIC = 0x43485346;
+
+namespace {
+
+// 64-bit FNV-1a, stable across platforms and runs
+class KeyHasher {
+public:
+    void add(void const* data, size_t size) noexcept {
+        uint8_t const* p = static_cast<uint8_t const*>(data);
+        for (size_t i = 0; i < size; i++) {
+            mHash = (mHash ^ p[i]) * 0x100000001b3ull;
+        }
+    }
+
+    void add(uint64_t v) noexcept {
+        add(&v, sizeof(v));
+    }
+
+    void add(char const* s) noexcept {
+        const size_t size = strlen(s);
+        add(uint64_t(size));
+        add(s, size);
+    }
+
+    void add(std::string const& s) noexcept {
+        add(uint64_t(s.size()));
+        add(s.data(), s.size());
+    }
+
+    uint64_t get() const noexcept { return mHash; }
+
+private:
+    uint64_t mHash = 0xcbf29ce484222325ull;
+};
+
+} // anonymous namespace
+
+ShaderCache::ShaderCache(const char* directory) noexcept
+        : mDirectory(directory) {
+    mIsValid = mDirectory.isDirectory() || mDirectory.mkdirRecursive();
+}
+
+ShaderCache::Key ShaderCache::computeKey(std::string const& shader,
+        GLSLPostProcessor::Config const& config,
+        MaterialBuilder::Optimization optimization, uint32_t flags) noexcept {
+    KeyHasher hasher;
+
+    // versions of the cache, the material format and the compilers
+    const glslang::Version glslangVersion = glslang::GetVersion();
+    hasher.add(uint64_t(SHADER_CACHE_VERSION));
+    hasher.add(uint64_t(GLSLPostProcessor::OUTPUT_VERSION));
+    hasher.add(uint64_t(filament::MATERIAL_VERSION));
+    hasher.add(uint64_t(glslangVersion.major));
+    hasher.add(uint64_t(glslangVersion.minor));
+    hasher.add(uint64_t(glslangVersion.patch));
+    hasher.add(spvSoftwareVersionString());
+    // SPIRV-Cross has no release versions, its C API version is bumped with implementation changes
+    hasher.add(uint64_t(SPVC_C_API_VERSION_MAJOR));
+    hasher.add(uint64_t(SPVC_C_API_VERSION_MINOR));
+    hasher.add(uint64_t(SPVC_C_API_VERSION_PATCH));
+
+    // options of the post-processor, printing the shaders doesn't affect the output
+    hasher.add(uint64_t(optimization));
+    hasher.add(uint64_t(flags & GLSLPostProcessor::GENERATE_DEBUG_INFO));
+
+    // configuration of this shader
+    hasher.add(uint64_t(config.variant.key));
+    hasher.add(uint64_t(config.targetApi));
+    hasher.add(uint64_t(config.shaderType));
+    hasher.add(uint64_t(config.shaderModel));
+    hasher.add(uint64_t(config.domain));
+    hasher.add(uint64_t(config.hasFramebufferFetch));
+    for (auto const& [input, location] : config.glsl.subpassInputToColorLocation) {
+        hasher.add(uint64_t(input));
+        hasher.add(uint64_t(location));
+    }
+
+    // the material's samplers determine the MSL bindings
+    if (config.materialInfo) {
+        auto const& sib = config.materialInfo->sib;
+        hasher.add(sib.getName().c_str_safe());
+        hasher.add(uint64_t(sib.getStageFlags().hasShaderType(config.shaderType)));
+        for (auto const& info : sib.getSamplerInfoList()) {
+            hasher.add(info.name.c_str_safe());
+        }
+    }
+
+    hasher.add(shader);
+    return hasher.get();
+}
+
+utils::Path ShaderCache::getEntryPath(Key key) const noexcept {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.shader", (unsigned long long)key);
+    return mDirectory.concat(name);
+}
+
+bool ShaderCache::get(Key key, std::string* glsl, SpirvBlob* spirv, std::string* msl) noexcept {
+    bool found = false;
+    if (mIsValid) {
+        std::ifstream in(getEntryPath(key).c_str(), std::ios::binary);
+        uint32_t magic = 0;
+        in.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+        found = in.good() && magic == SHADER_CACHE_MAGIC;
+
+        // each output is stored as its size in bytes, followed by its content
+        auto read = [&in, &found](auto* output) {
+            uint64_t size = 0;
+            in.read(reinterpret_cast<char*>(&size), sizeof(size));
+            if (!in.good() || size % sizeof((*output)[0])) {
+                found = false;
+                return;
+            }
+            if (output) {
+                output->resize(size / sizeof((*output)[0]));
+                in.read(reinterpret_cast<char*>(output->data()), std::streamsize(size));
+                found = found && !in.fail();
+            } else {
+                in.seekg(std::streamoff(size), std::ios::cur);
+            }
+        };
+        if (found) { read(glsl); }
+        if (found) { read(spirv); }
+        if (found) { read(msl); }
+    }
+    (found ? mHitCount : mMissCount).fetch_add(1, std::memory_order_relaxed);
+    return found;
+}
+
+void ShaderCache::put(Key key, std::string const* glsl, SpirvBlob const* spirv,
+        std::string const* msl) noexcept {
+    if (!mIsValid) {
+        return;
+    }
+
+    // Write to a temporary file and rename it, so that other processes never see a partially
+    // written entry.
+    const utils::Path path = getEntryPath(key);
+    const size_t unique = std::hash<std::thread::id>()(std::this_thread::get_id()) ^
+            size_t(std::chrono::steady_clock::now().time_since_epoch().count()) ^
+            size_t(std::random_device()());
+    const std::string temporary = path.getPath() + "." + std::to_string(unique) + ".tmp";
+
+    bool success;
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<char const*>(&SHADER_CACHE_MAGIC), sizeof(SHADER_CACHE_MAGIC));
+        auto write = [&out](auto const* output) {
+            const uint64_t size = output ? output->size() * sizeof((*output)[0]) : 0;
+            out.write(reinterpret_cast<char const*>(&size), sizeof(size));
+            if (size) {
+                out.write(reinterpret_cast<char const*>(output->data()), std::streamsize(size));
+            }
+        };
+        write(glsl);
+        write(spirv);
+        write(msl);
+        out.close();
+        success = !out.fail();
+    }
+
+    // if another process stored the same entry concurrently, either copy is fine
+    if (!success || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+    }
+}
+
+} // namespace filamat
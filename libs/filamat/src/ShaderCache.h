@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMAT_SHADERCACHE_H
+#define TNT_FILAMAT_SHADERCACHE_H
+
+#include "GLSLPostProcessor.h"
+
+#include <utils/Path.h>
+
+#include <atomic>
+#include <string>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace filamat {
+
+/*
+ * An on-disk, content-addressed cache of the GLSLPostProcessor outputs.
+ *
+ * Entries are keyed by a hash of everything the outputs depend on: the generated shader, the
+ * post-processor configuration, the optimization level and the versions of the material
+ * format and of the shader compilers. Entries are written atomically, so a cache directory can
+ * be shared by several matc processes.
+ */
+class ShaderCache {
+public:
+    using Key = uint64_t;
+
+    explicit ShaderCache(const char* directory) noexcept;
+
+    static Key computeKey(std::string const& shader, GLSLPostProcessor::Config const& config,
+            MaterialBuilder::Optimization optimization, uint32_t flags) noexcept;
+
+    // Fills the requested (non-null) outputs and returns true if the entry exists.
+    bool get(Key key, std::string* glsl, SpirvBlob* spirv, std::string* msl) noexcept;
+
+    // Stores the non-null outputs. Failures are ignored, the entry is simply not cached.
+    void put(Key key, std::string const* glsl, SpirvBlob const* spirv,
+            std::string const* msl) noexcept;
+
+    size_t getHitCount() const noexcept { return mHitCount.load(std::memory_order_relaxed); }
+    size_t getMissCount() const noexcept { return mMissCount.load(std::memory_order_relaxed); }
+
+private:
+    utils::Path getEntryPath(Key key) const noexcept;
+
+    utils::Path mDirectory;
+    bool mIsValid = false;
+    std::atomic<size_t> mHitCount = { 0 };
+    std::atomic<size_t> mMissCount = { 0 };
+};
+
+} // namespace filamat
+
+#endif // TNT_FILAMAT_SHADERCACHE_H
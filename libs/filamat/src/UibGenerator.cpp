@@ -149,13 +149,7 @@ UniformInterfaceBlock const& UibGenerator::getPerViewUib() noexcept  {
 UniformInterfaceBlock const& UibGenerator::getPerRenderableUib() noexcept {
     static UniformInterfaceBlock uib =  UniformInterfaceBlock::Builder()
             .name(PerRenderableUib::_name)
-            .add("worldFromModelMatrix",       1, UniformInterfaceBlock::Type::MAT4, Precision::HIGH)
-            .add("worldFromModelNormalMatrix", 1, UniformInterfaceBlock::Type::MAT3, Precision::HIGH)
-            .add("morphTargetCount", 1, UniformInterfaceBlock::Type::UINT)
-            .add("flags", 1, UniformInterfaceBlock::Type::UINT)
-            .add("channels", 1, UniformInterfaceBlock::Type::UINT)
-            .add("objectId", 1, UniformInterfaceBlock::Type::UINT)
-            .add("userData", 1, UniformInterfaceBlock::Type::FLOAT)
+            .add("data", CONFIG_MAX_INSTANCES, "PerRenderableData", sizeof(PerRenderableData))
             .build();
     return uib;
 }
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CompressedShaderChunk.h"
+
+#include "Lz4.h"
+
+#ifndef FILAMAT_LITE
+#include <smolv.h>
+#endif
+
+#include <utils/Log.h>
+
+#include <unordered_map>
+
+namespace filamat {
+
+// For now, LZ4 is the only compression scheme.
+static constexpr uint32_t COMPRESSION_SCHEME_LZ4 = 1;
+
+CompressedShaderChunk::CompressedShaderChunk(std::vector<TextEntry> const& entries,
+        ChunkType type) : Chunk(type) {
+    std::vector<Payload> payloads;
+    payloads.reserve(entries.size());
+    for (const TextEntry& entry : entries) {
+        payloads.push_back({ entry.shaderModel, entry.variantKey, entry.stage,
+                std::string(entry.shader.c_str(), entry.shader.size() + 1) });
+    }
+    compress(payloads);
+}
+
+#ifndef FILAMAT_LITE
+CompressedShaderChunk::CompressedShaderChunk(std::vector<SpirvEntry> const& entries,
+        bool stripDebugInfo) : Chunk(ChunkType::MaterialSpirvCompressed) {
+    const uint32_t flags = stripDebugInfo ? smolv::kEncodeFlagStripDebugInfo : 0;
+    std::vector<Payload> payloads;
+    payloads.reserve(entries.size());
+    for (const SpirvEntry& entry : entries) {
+        smolv::ByteArray encoded;
+        if (!smolv::Encode(entry.spirv.data(), entry.spirv.size() * 4, encoded, flags)) {
+            utils::slog.e << "Error with SPIRV compression" << utils::io::endl;
+        }
+        payloads.push_back({ entry.shaderModel, entry.variantKey, entry.stage,
+                std::string(encoded.begin(), encoded.end()) });
+    }
+    compress(payloads);
+}
+#endif
+
+void CompressedShaderChunk::compress(std::vector<Payload> const& payloads) {
+    std::string block;
+    auto flushBlock = [this, &block]() {
+        if (!block.empty()) {
+            mBlocks.push_back({ uint32_t(block.size()),
+                    compressLz4(reinterpret_cast<const uint8_t*>(block.data()), block.size()) });
+            block.clear();
+        }
+    };
+
+    // The entries are sorted by variant, so both stages of a variant usually share a block.
+    std::unordered_map<std::string, size_t> firstShaders;
+    mShaders.reserve(payloads.size());
+    for (const Payload& payload : payloads) {
+        Shader shader{ payload.shaderModel, payload.variantKey, payload.stage, 0, 0, 0 };
+        auto [pos, inserted] = firstShaders.try_emplace(payload.data, mShaders.size());
+        if (inserted) {
+            if (!block.empty() && block.size() + payload.data.size() > BLOCK_SIZE) {
+                flushBlock();
+            }
+            shader.block = uint32_t(mBlocks.size());
+            shader.offset = uint32_t(block.size());
+            shader.size = uint32_t(payload.data.size());
+            block += payload.data;
+        } else {
+            Shader const& first = mShaders[pos->second];
+            shader.block = first.block;
+            shader.offset = first.offset;
+            shader.size = first.size;
+        }
+        mShaders.push_back(shader);
+    }
+    flushBlock();
+}
+
+void CompressedShaderChunk::flatten(Flattener& f) {
+    f.writeUint64(mShaders.size());
+    for (const Shader& shader : mShaders) {
+        f.writeUint8(shader.shaderModel);
+        f.writeUint8(shader.variantKey);
+        f.writeUint8(shader.stage);
+        f.writeUint32(shader.block);
+        f.writeUint32(shader.offset);
+        f.writeUint32(shader.size);
+    }
+
+    f.writeUint32(COMPRESSION_SCHEME_LZ4);
+    f.writeUint32(uint32_t(mBlocks.size()));
+    size_t offset = 0;
+    for (const Block& block : mBlocks) {
+        f.writeUint32(uint32_t(offset));
+        f.writeUint32(uint32_t(block.compressed.size()));
+        f.writeUint32(block.size);
+        offset += block.compressed.size();
+    }
+    for (const Block& block : mBlocks) {
+        f.writeRaw(reinterpret_cast<const char*>(block.compressed.data()), block.compressed.size());
+    }
+}
+
+} // namespace filamat
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMAT_COMPRESSED_SHADER_CHUNK_H
+#define TNT_FILAMAT_COMPRESSED_SHADER_CHUNK_H
+
+#include "Chunk.h"
+#include "ShaderEntry.h"
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+namespace filamat {
+
+// Stores the shaders of one target API in independently compressed blocks, so that loading a
+// variant only decompresses the block that contains it. Identical shaders are stored once.
+//
+// Layout:
+//   uint64 shader count
+//   per shader: uint8 shader model, uint8 variant, uint8 stage,
+//               uint32 block index, uint32 offset and uint32 size within the decompressed block
+//   uint32 compression scheme (1: LZ4 block format)
+//   uint32 block count
+//   per block: uint32 offset, uint32 compressed size and uint32 decompressed size
+//   the compressed blocks, their offsets are relative to the first one
+class CompressedShaderChunk final : public Chunk {
+public:
+    // Target size of the decompressed blocks, larger shaders get a block of their own.
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    // GLSL or MSL shaders, stored with their null terminator.
+    CompressedShaderChunk(std::vector<TextEntry> const& entries, ChunkType type);
+
+#ifndef FILAMAT_LITE
+    // SPIR-V shaders, stored encoded with smol-v.
+    CompressedShaderChunk(std::vector<SpirvEntry> const& entries, bool stripDebugInfo);
+#endif
+
+    ~CompressedShaderChunk() override = default;
+
+private:
+    struct Payload {
+        uint8_t shaderModel;
+        filament::Variant::type_t variantKey;
+        uint8_t stage;
+        std::string data;
+    };
+
+    struct Shader {
+        uint8_t shaderModel;
+        filament::Variant::type_t variantKey;
+        uint8_t stage;
+        uint32_t block;
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    struct Block {
+        uint32_t size;
+        std::vector<uint8_t> compressed;
+    };
+
+    void compress(std::vector<Payload> const& payloads);
+
+    void flatten(Flattener& f) override;
+
+    std::vector<Shader> mShaders;
+    std::vector<Block> mBlocks;
+};
+
+} // namespace filamat
+
+#endif // TNT_FILAMAT_COMPRESSED_SHADER_CHUNK_H
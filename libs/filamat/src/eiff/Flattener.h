@@ -114,6 +114,14 @@ public:
         mCursor += nbytes;
     }
 
+    // Writes the bytes as-is, the reader must know their size.
+    void writeRaw(const char* data, size_t nbytes) {
+        if (mStart != nullptr) {
+            memcpy(reinterpret_cast<char*>(mCursor), data, nbytes);
+        }
+        mCursor += nbytes;
+    }
+
     void writeSizePlaceholder() {
         mSizePlaceholders.push_back(mCursor);
         if (mStart != nullptr) {
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Lz4.h"
+
+#include <string.h>
+
+namespace filamat {
+
+// constants of the LZ4 block format
+static constexpr size_t MIN_MATCH = 4;
+static constexpr size_t MAX_OFFSET = 65535;
+// the last 5 bytes are always literals, and the last match starts 12 bytes before the end
+static constexpr size_t LAST_LITERALS = 5;
+static constexpr size_t MATCH_FIND_LIMIT = 12;
+
+static constexpr uint32_t HASH_BITS = 16;
+static constexpr uint32_t NO_POSITION = UINT32_MAX;
+
+static inline uint32_t read32(const uint8_t* p) noexcept {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t hash(uint32_t sequence) noexcept {
+    return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static void writeLength(std::vector<uint8_t>& out, size_t length) {
+    for (length -= 15; length >= 255; length -= 255) {
+        out.push_back(255);
+    }
+    out.push_back(uint8_t(length));
+}
+
+// matchLength is 0 for the last sequence, which only has literals
+static void writeSequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t literalCount,
+        size_t offset, size_t matchLength) {
+    const size_t matchCode = matchLength ? matchLength - MIN_MATCH : 0;
+    out.push_back(uint8_t(((literalCount < 15 ? literalCount : 15) << 4) |
+            (matchCode < 15 ? matchCode : 15)));
+    if (literalCount >= 15) {
+        writeLength(out, literalCount);
+    }
+    out.insert(out.end(), literals, literals + literalCount);
+    if (matchLength) {
+        out.push_back(uint8_t(offset & 0xff));
+        out.push_back(uint8_t(offset >> 8));
+        if (matchCode >= 15) {
+            writeLength(out, matchCode);
+        }
+    }
+}
+
+std::vector<uint8_t> compressLz4(const uint8_t* data, size_t size) {
+    std::vector<uint8_t> out;
+    out.reserve(size / 2 + 16);
+
+    size_t anchor = 0;
+    if (size > MATCH_FIND_LIMIT) {
+        std::vector<uint32_t> positions(1u << HASH_BITS, NO_POSITION);
+        const size_t matchEndLimit = size - LAST_LITERALS;
+        size_t i = 0;
+        while (i + MATCH_FIND_LIMIT < size) {
+            const uint32_t sequence = read32(data + i);
+            uint32_t& entry = positions[hash(sequence)];
+            const size_t candidate = entry;
+            entry = uint32_t(i);
+            if (candidate == NO_POSITION || i - candidate > MAX_OFFSET ||
+                    read32(data + candidate) != sequence) {
+                i++;
+                continue;
+            }
+            size_t length = MIN_MATCH;
+            while (i + length < matchEndLimit && data[candidate + length] == data[i + length]) {
+                length++;
+            }
+            writeSequence(out, data + anchor, i - anchor, i - candidate, length);
+            i += length;
+            anchor = i;
+        }
+    }
+    writeSequence(out, data + anchor, size - anchor, 0, 0);
+    return out;
+}
+
+} // namespace filamat
@@ -0,0 +1,33 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMAT_LZ4_H
+#define TNT_FILAMAT_LZ4_H
+
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace filamat {
+
+// Compresses data into a single block of the LZ4 block format, which filaflat decompresses.
+// The compressor is a simple greedy one, it favors the decompression speed over the ratio.
+std::vector<uint8_t> compressLz4(const uint8_t* data, size_t size);
+
+} // namespace filamat
+
+#endif // TNT_FILAMAT_LZ4_H
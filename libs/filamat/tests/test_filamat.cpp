@@ -23,9 +23,17 @@
 
 #include <filamat/Enums.h>
 
+#include <filaflat/BlobDictionary.h>
+#include <filaflat/ChunkContainer.h>
+#include <filaflat/DictionaryReader.h>
+#include <filaflat/MaterialChunk.h>
+#include <filaflat/ShaderBuilder.h>
+
 #include <utils/JobSystem.h>
+#include <utils/Path.h>
 
 #include <memory>
+#include <vector>
 
 using namespace utils;
 using namespace ASTUtils;
@@ -768,6 +776,199 @@ TEST_F(MaterialCompiler, CustomSurfaceShadingHasFunction) {
     EXPECT_TRUE(result.isValid());
 }
 
+TEST_F(MaterialCompiler, ShaderCache) {
+    std::string shaderCode(R"(
+        void material(inout MaterialInputs material) {
+            prepareMaterial(material);
+            material.baseColor = vec4(1.0, 0.0, 0.0, 1.0);
+        }
+    )");
+
+    const utils::Path cacheDirectory =
+            utils::Path::getTemporaryDirectory().concat("filamat_test_shader_cache");
+    for (utils::Path entry : cacheDirectory.listContents()) {
+        entry.unlinkFile();
+    }
+
+    auto build = [&](filamat::MaterialBuilder::BuildStatistics& stats) {
+        filamat::MaterialBuilder builder;
+        builder.material(shaderCode.c_str());
+        builder.targetApi(filamat::MaterialBuilder::TargetApi::ALL);
+        builder.shaderCache(cacheDirectory.c_str());
+        filamat::Package package = builder.build(*jobSystem);
+        stats = builder.getBuildStatistics();
+        EXPECT_TRUE(package.isValid());
+        return std::vector<uint8_t>(package.getData(), package.getData() + package.getSize());
+    };
+
+    // the first build compiles all the shaders and populates the cache
+    filamat::MaterialBuilder::BuildStatistics first;
+    std::vector<uint8_t> const uncached = build(first);
+    EXPECT_EQ(first.cacheHitCount, 0);
+    EXPECT_EQ(first.cacheMissCount, first.uniqueShaderCount);
+
+    // the second build fetches them all and produces the same package
+    filamat::MaterialBuilder::BuildStatistics second;
+    std::vector<uint8_t> const cached = build(second);
+    EXPECT_EQ(second.cacheHitCount, first.cacheMissCount);
+    EXPECT_EQ(second.cacheMissCount, 0);
+    EXPECT_EQ(cached, uncached);
+
+    for (utils::Path entry : cacheDirectory.listContents()) {
+        entry.unlinkFile();
+    }
+    EXPECT_TRUE(cacheDirectory.rmdir());
+}
+
+TEST_F(MaterialCompiler, ShaderCachePartiallyPopulated) {
+    std::string shaderCode(R"(
+        void material(inout MaterialInputs material) {
+            prepareMaterial(material);
+            material.baseColor = vec4(0.0, 1.0, 0.0, 1.0);
+        }
+    )");
+
+    const utils::Path cacheDirectory =
+            utils::Path::getTemporaryDirectory().concat("filamat_test_shader_cache_partial");
+    for (utils::Path entry : cacheDirectory.listContents()) {
+        entry.unlinkFile();
+    }
+
+    auto build = [&](filamat::MaterialBuilder::BuildStatistics& stats) {
+        filamat::MaterialBuilder builder;
+        builder.material(shaderCode.c_str());
+        builder.targetApi(filamat::MaterialBuilder::TargetApi::ALL);
+        builder.shaderCache(cacheDirectory.c_str());
+        filamat::Package package = builder.build(*jobSystem);
+        stats = builder.getBuildStatistics();
+        EXPECT_TRUE(package.isValid());
+        return std::vector<uint8_t>(package.getData(), package.getData() + package.getSize());
+    };
+
+    filamat::MaterialBuilder::BuildStatistics first;
+    std::vector<uint8_t> const uncached = build(first);
+    ASSERT_GT(first.cacheMissCount, 1);
+
+    // remove every other entry, so that the jobs alternate between cache hits and the first
+    // compile of glslang, which must still happen alone
+    std::vector<utils::Path> entries = cacheDirectory.listContents();
+    size_t removed = 0;
+    for (size_t i = 0; i < entries.size(); i += 2) {
+        removed += entries[i].unlinkFile() ? 1 : 0;
+    }
+    ASSERT_GT(removed, 0);
+    ASSERT_LT(removed, entries.size());
+
+    filamat::MaterialBuilder::BuildStatistics second;
+    std::vector<uint8_t> const partial = build(second);
+    EXPECT_GE(second.cacheMissCount, removed);
+    EXPECT_GT(second.cacheHitCount, 0);
+    EXPECT_EQ(second.cacheHitCount + second.cacheMissCount, first.cacheMissCount);
+    EXPECT_EQ(partial, uncached);
+
+    for (utils::Path entry : cacheDirectory.listContents()) {
+        entry.unlinkFile();
+    }
+    EXPECT_TRUE(cacheDirectory.rmdir());
+}
+
+TEST_F(MaterialCompiler, DuplicateShaders) {
+    std::string shaderCode(R"(
+        void material(inout MaterialInputs material) {
+            prepareMaterial(material);
+            material.baseColor = vec4(1.0, 0.0, 0.0, 1.0);
+        }
+    )");
+
+    // unlit materials ignore the lighting variants, which then generate identical shaders
+    filamat::MaterialBuilder builder;
+    builder.material(shaderCode.c_str());
+    builder.shading(filamat::MaterialBuilder::Shading::UNLIT);
+    builder.targetApi(filamat::MaterialBuilder::TargetApi::ALL);
+    filamat::Package package = builder.build(*jobSystem);
+    EXPECT_TRUE(package.isValid());
+
+    const auto stats = builder.getBuildStatistics();
+    EXPECT_GT(stats.uniqueShaderCount, 0);
+    EXPECT_LT(stats.uniqueShaderCount, stats.shaderCount);
+}
+
+TEST_F(MaterialCompiler, CompressedShaders) {
+    std::string shaderCode(R"(
+        void material(inout MaterialInputs material) {
+            prepareMaterial(material);
+            material.baseColor = vec4(1.0, 0.0, 0.0, 1.0);
+        }
+    )");
+
+    auto build = [&](bool compressShaders) {
+        filamat::MaterialBuilder builder;
+        builder.material(shaderCode.c_str());
+        builder.targetApi(filamat::MaterialBuilder::TargetApi::ALL);
+        builder.compressShaders(compressShaders);
+        filamat::Package package = builder.build(*jobSystem);
+        EXPECT_TRUE(package.isValid());
+        return std::vector<uint8_t>(package.getData(), package.getData() + package.getSize());
+    };
+
+    std::vector<uint8_t> reference = build(false);
+    std::vector<uint8_t> compressed = build(true);
+    EXPECT_LT(compressed.size(), reference.size());
+
+    filaflat::ChunkContainer referenceContainer(reference.data(), reference.size());
+    filaflat::ChunkContainer compressedContainer(compressed.data(), compressed.size());
+    ASSERT_TRUE(referenceContainer.parse());
+    ASSERT_TRUE(compressedContainer.parse());
+
+    // every shader must be decompressed to the same code as the dictionary-based one
+    const std::pair<filamat::ChunkType, filamat::ChunkType> tags[] = {
+            { filamat::ChunkType::MaterialGlsl, filamat::ChunkType::DictionaryText },
+            { filamat::ChunkType::MaterialSpirv, filamat::ChunkType::DictionarySpirv },
+            { filamat::ChunkType::MaterialMetal, filamat::ChunkType::DictionaryText },
+    };
+    for (auto [materialTag, dictionaryTag] : tags) {
+        const filamat::ChunkType compressedTag =
+                filaflat::MaterialChunk::getCompressedType(materialTag);
+        EXPECT_FALSE(compressedContainer.hasChunk(materialTag));
+        ASSERT_TRUE(compressedContainer.hasChunk(compressedTag));
+
+        // SPIR-V is only decoded when filaflat supports Vulkan
+        filaflat::BlobDictionary dictionary;
+        if (!filaflat::DictionaryReader::unflatten(referenceContainer, dictionaryTag, dictionary)) {
+            EXPECT_EQ(materialTag, filamat::ChunkType::MaterialSpirv);
+            continue;
+        }
+        filaflat::MaterialChunk referenceChunk(referenceContainer);
+        ASSERT_TRUE(referenceChunk.readIndex(materialTag));
+
+        filaflat::BlobDictionary emptyDictionary;
+        filaflat::MaterialChunk compressedChunk(compressedContainer);
+        ASSERT_TRUE(compressedChunk.readIndex(compressedTag));
+        EXPECT_GT(compressedChunk.getBlockCount(), 0);
+
+        size_t shaderCount = 0;
+        filaflat::ShaderBuilder expected;
+        filaflat::ShaderBuilder actual;
+        for (uint8_t shaderModel = 1; shaderModel <= 2; shaderModel++) {
+            for (size_t key = 0; key < filament::VARIANT_COUNT; key++) {
+                for (ShaderType stage : { ShaderType::VERTEX, ShaderType::FRAGMENT }) {
+                    const filament::Variant variant{ filament::Variant::type_t(key) };
+                    const bool found = referenceChunk.getShader(expected, dictionary,
+                            shaderModel, variant, uint8_t(stage));
+                    EXPECT_EQ(found, compressedChunk.getShader(actual, emptyDictionary,
+                            shaderModel, variant, uint8_t(stage)));
+                    if (found) {
+                        ASSERT_EQ(expected.size(), actual.size());
+                        EXPECT_EQ(0, memcmp(expected.data(), actual.data(), actual.size()));
+                        shaderCount++;
+                    }
+                }
+            }
+        }
+        EXPECT_GT(shaderCount, 0);
+    }
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
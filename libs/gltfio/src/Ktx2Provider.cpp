@@ -221,7 +221,10 @@ void Ktx2Provider::transcodeSingleTexture() {
 }
 
 Ktx2Provider::Ktx2Provider(Engine* engine) : mEngine(engine) {
-    mDecoderRootJob = mEngine->getJobSystem().createJob();
+    JobSystem& js = mEngine->getJobSystem();
+    mDecoderRootJob = js.createJob();
+    // decoding is spread over several frames, it must not delay the frame-critical jobs
+    js.setLane(mDecoderRootJob, JobSystem::Lane::BACKGROUND);
 #ifdef NDEBUG
     const bool quiet = true;
 #else
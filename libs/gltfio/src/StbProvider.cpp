@@ -246,7 +246,10 @@ void StbProvider::decodeSingleTexture() {
 }
 
 StbProvider::StbProvider(Engine* engine) : mEngine(engine) {
-    mDecoderRootJob = mEngine->getJobSystem().createJob();
+    JobSystem& js = mEngine->getJobSystem();
+    mDecoderRootJob = js.createJob();
+    // decoding is spread over several frames, it must not delay the frame-critical jobs
+    js.setLane(mDecoderRootJob, JobSystem::Lane::BACKGROUND);
 }
 
 StbProvider::~StbProvider() {
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ibl/Cubemap.h>
+#include <ibl/CubemapIBL.h>
+#include <ibl/CubemapUtils.h>
+#include <ibl/Image.h>
+
+#include <utils/JobSystem.h>
+
+#include <math/vec3.h>
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+using namespace filament::ibl;
+using namespace filament::math;
+
+// A 256x256 source environment and all its miplevels, like cmgen uses.
+struct Environment {
+    std::vector<Image> images;
+    std::vector<Cubemap> levels;
+
+    explicit Environment(utils::JobSystem& js) {
+        Image image;
+        Cubemap cm = CubemapUtils::create(image, 256);
+        for (size_t f = 0; f < 6; f++) {
+            Image& face = cm.getImageForFace(Cubemap::Face(f));
+            for (size_t y = 0; y < 256; y++) {
+                for (size_t x = 0; x < 256; x++) {
+                    Cubemap::writeAt(face.getPixelRef(x, y), Cubemap::Texel(
+                            float((x * 7 + y * 13 + f * 31) % 97) / 96.0f,
+                            float((x ^ y) & 0xFF) / 255.0f,
+                            float(f) / 5.0f));
+                }
+            }
+        }
+        cm.makeSeamless();
+        images.push_back(std::move(image));
+        levels.push_back(std::move(cm));
+
+        size_t dim = 256;
+        while (dim > 1) {
+            dim >>= 1u;
+            Image temp;
+            Cubemap dst = CubemapUtils::create(temp, dim);
+            CubemapUtils::downsampleCubemapLevelBoxFilter(js, dst, levels.back());
+            dst.makeSeamless();
+            images.push_back(std::move(temp));
+            levels.push_back(std::move(dst));
+        }
+    }
+};
+
+// Prefilters a cubemap of the given size for the given roughness, with 256 samples per texel.
+static void BM_roughnessFilter(benchmark::State& state, float linearRoughness) {
+    utils::JobSystem js;
+    js.adopt();
+    const Environment environment(js);
+    const size_t dim = size_t(state.range(0));
+
+    Image image;
+    Cubemap dst = CubemapUtils::create(image, dim);
+    for (auto _ : state) {
+        CubemapIBL::roughnessFilter(js, dst, environment.levels, linearRoughness, 256,
+                float3{ 1 }, true);
+        benchmark::DoNotOptimize(image.getData());
+    }
+    js.emancipate();
+
+    state.SetItemsProcessed(state.iterations() * dim * dim * 6);
+}
+
+BENCHMARK_CAPTURE(BM_roughnessFilter, rough_0_25, 0.25f)
+        ->ArgName("dim")->Arg(32)->Arg(64)->Arg(128)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_roughnessFilter, rough_0_50, 0.50f)
+        ->ArgName("dim")->Arg(32)->Arg(64)->Arg(128)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_roughnessFilter, rough_1_00, 1.00f)
+        ->ArgName("dim")->Arg(32)->Arg(64)->Arg(128)->UseRealTime()->Unit(benchmark::kMillisecond);
@@ -23,12 +23,14 @@
 
 #include "CubemapUtilsImpl.h"
 
+#include <utils/Hash.h>
 #include <utils/JobSystem.h>
 
 #include <math/mat3.h>
 #include <math/scalar.h>
 
-#include <random>
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
 using namespace filament::math;
@@ -350,8 +352,8 @@ void CubemapIBL::roughnessFilter(
         uint8_t l1;
     };
 
-    std::vector<CacheEntry> cache;
-    cache.reserve(maxNumSamples);
+    std::vector<CacheEntry> entries;
+    entries.reserve(maxNumSamples);
 
     // precompute everything that only depends on the sample #
     float weight = 0;
@@ -402,65 +404,168 @@ void CubemapIBL::roughnessFilter(
             uint8_t l1 = uint8_t(std::min(maxLevel, size_t(l0 + 1)));
             float lerp = mipLevel - (float) l0;
 
-            cache.push_back({ L, brdf_NoL, lerp, l0, l1 });
+            entries.push_back({ L, brdf_NoL, lerp, l0, l1 });
         }
     }
 
-    for (auto& entry : cache) {
+    for (auto& entry : entries) {
         entry.brdf_NoL *= 1.0f / weight;
     }
 
     // we can sample the cubemap in any order, sort by the weight, it could improve fp precision
-    std::sort(cache.begin(), cache.end(), [](CacheEntry const& lhs, CacheEntry const& rhs) {
+    std::sort(entries.begin(), entries.end(), [](CacheEntry const& lhs, CacheEntry const& rhs) {
         return lhs.brdf_NoL < rhs.brdf_NoL;
     });
 
+    // The sample cache is shared by all texels, it's stored as a structure of arrays so that
+    // the per-sample loops below can be vectorized by the compiler.
+    struct SampleCache {
+        std::vector<float> Lx, Ly, Lz;
+        std::vector<float> brdf_NoL;
+        std::vector<float> lerp;
+        std::vector<uint8_t> l0, l1;
+        // level parameters, resolved once per sample
+        std::vector<float> dim0, dim1, upper0, upper1;
+        size_t size() const { return Lx.size(); }
+    } cache;
+
+    for (CacheEntry const& e : entries) {
+        const float d0 = float(levels[e.l0].getDimensions());
+        const float d1 = float(levels[e.l1].getDimensions());
+        cache.Lx.push_back(e.L.x);
+        cache.Ly.push_back(e.L.y);
+        cache.Lz.push_back(e.L.z);
+        cache.brdf_NoL.push_back(e.brdf_NoL);
+        cache.lerp.push_back(e.lerp);
+        cache.l0.push_back(e.l0);
+        cache.l1.push_back(e.l1);
+        cache.dim0.push_back(d0);
+        cache.dim1.push_back(d1);
+        cache.upper0.push_back(std::nextafter(d0, 0.0f));
+        cache.upper1.push_back(std::nextafter(d1, 0.0f));
+    }
 
-    struct State {
-        // maybe blue-noise instead would look even better
-        std::default_random_engine gen;
-        std::uniform_real_distribution<float> distribution{ -F_PI, F_PI };
-    };
-
-    auto scanline = [&](State& state, size_t y,
-            Cubemap::Face f, Cubemap::Texel* data, size_t dim) {
-        if (UTILS_UNLIKELY(updater)) {
-            size_t p = progress.fetch_add(1, std::memory_order_relaxed) + 1;
-            updater(0, (float) p / ((float) dim * 6.0f), userdata);
+    // the images of every face of every level, indexed by [level * 6 + face]
+    std::vector<const Image*> faceImages(levels.size() * 6);
+    for (size_t l = 0; l < levels.size(); l++) {
+        for (size_t f = 0; f < 6; f++) {
+            faceImages[l * 6 + f] = &levels[l].getImageForFace(Cubemap::Face(f));
         }
-        mat3 R;
-        const size_t numSamples = cache.size();
-        for (size_t x = 0; x < dim; ++x, ++data) {
-            const float2 p(Cubemap::center(x, y));
-            const float3 N(dst.getDirectionFor(f, p.x, p.y) * mirror);
+    }
 
-            // center the cone around the normal (handle case of normal close to up)
-            const float3 up = std::abs(N.z) < 0.999 ? float3(0, 0, 1) : float3(1, 0, 0);
-            R[0] = normalize(cross(up, N));
-            R[1] = cross(N, R[0]);
-            R[2] = N;
+    // Samples are processed in batches: the first pass rotates the samples and computes their
+    // cubemap addresses for a whole batch without branches, the second pass does the fetches.
+    constexpr size_t BATCH_SIZE = 64;
+
+    auto filterTexel = [&](const mat3& R) -> float3 {
+        const size_t count = cache.size();
+        float3 Li = 0;
+        for (size_t first = 0; first < count; first += BATCH_SIZE) {
+            const size_t n = std::min(BATCH_SIZE, count - first);
+            const float* UTILS_RESTRICT const Lx = cache.Lx.data() + first;
+            const float* UTILS_RESTRICT const Ly = cache.Ly.data() + first;
+            const float* UTILS_RESTRICT const Lz = cache.Lz.data() + first;
+            const float* UTILS_RESTRICT const dim0 = cache.dim0.data() + first;
+            const float* UTILS_RESTRICT const dim1 = cache.dim1.data() + first;
+            const float* UTILS_RESTRICT const upper0 = cache.upper0.data() + first;
+            const float* UTILS_RESTRICT const upper1 = cache.upper1.data() + first;
+
+            uint8_t face[BATCH_SIZE];
+            float x0[BATCH_SIZE], y0[BATCH_SIZE];
+            float x1[BATCH_SIZE], y1[BATCH_SIZE];
+
+            // this must match Cubemap::getAddressFor()
+            for (size_t i = 0; i < n; i++) {
+                const float rx = R[0].x * Lx[i] + R[1].x * Ly[i] + R[2].x * Lz[i];
+                const float ry = R[0].y * Lx[i] + R[1].y * Ly[i] + R[2].y * Lz[i];
+                const float rz = R[0].z * Lx[i] + R[1].z * Ly[i] + R[2].z * Lz[i];
+                const float ax = std::abs(rx);
+                const float ay = std::abs(ry);
+                const float az = std::abs(rz);
+                const bool isX = ax >= ay && ax >= az;
+                const bool isY = !isX && ay >= az;
+                const float ma = 1.0f / (isX ? ax : (isY ? ay : az));
+                const float major = isX ? rx : (isY ? ry : rz);
+                const uint8_t axis = isX ? 0 : (isY ? 2 : 4);
+                face[i] = axis + (major >= 0 ? 0 : 1);
+                const float sc = isX ? (rx >= 0 ? -rz : rz) : (isY ? rx : (rz >= 0 ? rx : -rx));
+                const float tc = isY ? (ry >= 0 ? rz : -rz) : -ry;
+                const float s = (sc * ma + 1.0f) * 0.5f;
+                const float t = (tc * ma + 1.0f) * 0.5f;
+                x0[i] = std::min(s * dim0[i], upper0[i]);
+                y0[i] = std::min(t * dim0[i], upper0[i]);
+                x1[i] = std::min(s * dim1[i], upper1[i]);
+                y1[i] = std::min(t * dim1[i], upper1[i]);
+            }
 
-            R *= mat3f::rotation(state.distribution(state.gen), float3{0,0,1});
+            for (size_t i = 0; i < n; i++) {
+                const size_t sample = first + i;
+                const Image& i0 = *faceImages[cache.l0[sample] * 6u + face[i]];
+                const Image& i1 = *faceImages[cache.l1[sample] * 6u + face[i]];
+                float3 c0 = Cubemap::filterAt(i0, x0[i], y0[i]);
+                c0 += cache.lerp[sample] * (Cubemap::filterAt(i1, x1[i], y1[i]) - c0);
+                Li += c0 * cache.brdf_NoL[sample];
+            }
+        }
+        return Li;
+    };
 
-            float3 Li = 0;
-            for (size_t sample = 0; sample < numSamples; sample++) {
-                const CacheEntry& e = cache[sample];
-                const float3 L(R * e.L);
-                const Cubemap& cmBase = levels[e.l0];
-                const Cubemap& next = levels[e.l1];
-                const float3 c0 = Cubemap::trilinearFilterAt(cmBase, next, e.lerp, L);
-                Li += c0 * e.brdf_NoL;
+    // The destination is processed in square tiles rather than scanlines, neighboring texels
+    // fetch from nearby locations of the source levels, so this is more cache friendly.
+    constexpr size_t TILE_SIZE = 16;
+    const size_t dim = dst.getDimensions();
+    const size_t tilesPerSide = (dim + TILE_SIZE - 1) / TILE_SIZE;
+    const size_t tileCount = 6 * tilesPerSide * tilesPerSide;
+
+    auto processTile = [&](size_t index) {
+        const Cubemap::Face f = Cubemap::Face(index / (tilesPerSide * tilesPerSide));
+        const size_t tile = index % (tilesPerSide * tilesPerSide);
+        const size_t tx = (tile % tilesPerSide) * TILE_SIZE;
+        const size_t ty = (tile / tilesPerSide) * TILE_SIZE;
+        Image& image(dst.getImageForFace(f));
+        mat3 R;
+        for (size_t y = ty, ye = std::min(dim, ty + TILE_SIZE); y < ye; y++) {
+            Cubemap::Texel* data = static_cast<Cubemap::Texel*>(image.getPixelRef(tx, y));
+            for (size_t x = tx, xe = std::min(dim, tx + TILE_SIZE); x < xe; ++x, ++data) {
+                const float2 p(Cubemap::center(x, y));
+                const float3 N(dst.getDirectionFor(f, p.x, p.y) * mirror);
+
+                // center the cone around the normal (handle case of normal close to up)
+                const float3 up = std::abs(N.z) < 0.999 ? float3(0, 0, 1) : float3(1, 0, 0);
+                R[0] = normalize(cross(up, N));
+                R[1] = cross(N, R[0]);
+                R[2] = N;
+
+                // random rotation of the samples around the normal, it only depends on the
+                // texel so that the result doesn't depend on the order tiles are processed in.
+                // maybe blue-noise instead would look even better
+                const uint32_t key[3] = { uint32_t(f), uint32_t(x), uint32_t(y) };
+                const float angle = float(hash::murmur3(key, 3, 0)) * (1.0f / 4294967296.0f);
+                R *= mat3f::rotation((angle * 2.0f - 1.0f) * (float) F_PI, float3{ 0, 0, 1 });
+
+                Cubemap::writeAt(data, Cubemap::Texel(filterTexel(R)));
             }
-            Cubemap::writeAt(data, Cubemap::Texel(Li));
+        }
+        if (UTILS_UNLIKELY(updater)) {
+            size_t p = progress.fetch_add(1, std::memory_order_relaxed) + 1;
+            updater(0, (float) p / (float) tileCount, userdata);
         }
     };
 
-    // don't use the jobsystem unless we have enough work per scanline -- or the overhead of
+    // don't use the jobsystem unless we have enough work -- or the overhead of
     // launching jobs will prevail.
-    if (dst.getDimensions() * maxNumSamples <= 256) {
-        CubemapUtils::processSingleThreaded<State>(dst, js, std::ref(scanline));
+    if (dim * maxNumSamples <= 256) {
+        for (size_t i = 0; i < tileCount; i++) {
+            processTile(i);
+        }
     } else {
-        CubemapUtils::process<State>(dst, js, std::ref(scanline));
+        auto job = jobs::parallel_for(js, nullptr, 0, uint32_t(tileCount),
+                [&processTile](uint32_t start, uint32_t count) {
+                    for (uint32_t i = start; i < start + count; i++) {
+                        processTile(i);
+                    }
+                }, jobs::CountSplitter<1, 8>());
+        js.runAndWait(job);
     }
 }
 
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <image/ImageSampler.h>
+#include <image/LinearImage.h>
+
+#include <utils/JobSystem.h>
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+using namespace image;
+
+static LinearImage createImage(uint32_t size) {
+    LinearImage image(size, size, 4);
+    float* pixels = image.getPixelRef();
+    for (uint32_t i = 0, n = size * size * 4; i < n; i++) {
+        pixels[i] = float(i % 251) / 250.0f;
+    }
+    return image;
+}
+
+// Generates all the miplevels of a 1024x1024 RGBA image, on a single thread or with a JobSystem.
+static void BM_generateMipmaps(benchmark::State& state, Filter filter) {
+    const LinearImage source = createImage(1024);
+    const uint32_t count = getMipmapCount(source);
+    std::vector<LinearImage> mips(count);
+
+    utils::JobSystem js;
+    js.adopt();
+    const bool useJobSystem = state.range(0) != 0;
+    for (auto _ : state) {
+        if (useJobSystem) {
+            generateMipmaps(js, source, filter, mips.data(), count);
+        } else {
+            generateMipmaps(source, filter, mips.data(), count);
+        }
+        benchmark::DoNotOptimize(mips[0].getPixelRef());
+    }
+    js.emancipate();
+
+    state.SetItemsProcessed(state.iterations() * source.getWidth() * source.getHeight());
+}
+
+BENCHMARK_CAPTURE(BM_generateMipmaps, box, Filter::BOX)
+        ->ArgName("jobs")->Arg(0)->Arg(1)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_generateMipmaps, gaussian, Filter::GAUSSIAN_SCALARS)
+        ->ArgName("jobs")->Arg(0)->Arg(1)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_generateMipmaps, lanczos, Filter::LANCZOS)
+        ->ArgName("jobs")->Arg(0)->Arg(1)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_generateMipmaps, mitchell, Filter::MITCHELL)
+        ->ArgName("jobs")->Arg(0)->Arg(1)->UseRealTime()->Unit(benchmark::kMillisecond);
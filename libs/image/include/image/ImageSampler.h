@@ -21,6 +21,10 @@
 
 #include <utils/compiler.h>
 
+namespace utils {
+class JobSystem;
+} // namespace utils
+
 namespace image {
 
 /**
@@ -107,6 +111,14 @@ UTILS_PUBLIC
 LinearImage resampleImage(const LinearImage& source, uint32_t width, uint32_t height,
         const ImageSampler& sampler);
 
+/**
+ * Same as above, but rows are resampled in parallel using the given JobSystem, which must have
+ * adopted the calling thread. The result is bit-for-bit identical to the single-threaded version.
+ */
+UTILS_PUBLIC
+LinearImage resampleImage(utils::JobSystem& js, const LinearImage& source, uint32_t width,
+        uint32_t height, const ImageSampler& sampler);
+
 /**
  * Resizes the given linear image using a simplified API that takes target dimensions and filter.
  */
@@ -145,6 +157,15 @@ void computeSingleSample(const LinearImage& source, float x, float y, SingleSamp
 UTILS_PUBLIC
 void generateMipmaps(const LinearImage& source, Filter, LinearImage* result, uint32_t mipCount);
 
+/**
+ * Same as above, but the rows of each miplevel are resampled in parallel using the given
+ * JobSystem, which must have adopted the calling thread. Miplevels are still generated one after
+ * the other. The result is bit-for-bit identical to the single-threaded version.
+ */
+UTILS_PUBLIC
+void generateMipmaps(utils::JobSystem& js, const LinearImage& source, Filter, LinearImage* result,
+        uint32_t mipCount);
+
 /**
  * Returns the number of miplevels it would take to downsample the given image down to 1x1. This
  * number does not include the original image (i.e. mip 0).
@@ -21,9 +21,12 @@
 #include <math/vec3.h>
 #include <math/vec4.h>
 
-#include <utils/Panic.h>
 #include <utils/CString.h>
+#include <utils/JobSystem.h>
+#include <utils/Panic.h>
 
+#include <algorithm>
+#include <limits>
 #include <memory>
 #include <vector>
 #include <unordered_map>
@@ -132,8 +135,18 @@ void generateMadProgram(uint32_t ntarget, uint32_t nsource, float left, float ri
     // the [0,1] domain. If this were a huge number, the filtered results would look the same, but
     // the filter would perform very poorly because it would be iterating over a lot more samples
     // than necessary.
+    // Note that this is much larger than the actual half-width, which is computed below as
+    // "support". Both are used so that the candidate samples, and therefore the results, are
+    // the same as they always were.
     const float filterBounds = domainScale * std::abs(filter.boundingRadius);
 
+    // The filter functions are zero beyond max(boundingRadius, 0.5), NEAREST has a zero radius.
+    const float support = std::max(std::abs(filter.boundingRadius), 0.5f) / domainScale;
+
+    // Converts a coordinate in [0..1] to a fractional source index.
+    auto toSourceIndex = [=](float x) {
+        return (left + x * (right - left)) * float(nsource) - 0.5f;
+    };
     // Iterate through target samples. "xtarget" points to the center of each target pixel.
     float xtarget = dtarget / 2.0f;
     for (uint32_t itarget = 0; itarget < ntarget; ++itarget, xtarget += dtarget) {
@@ -143,9 +156,14 @@ void generateMadProgram(uint32_t ntarget, uint32_t nsource, float left, float ri
         uint32_t count = 0;
         float sum = 0;
 
-        // Iterate through source samples that lie within the bounded region.
-        const auto isource_lower = int32_t((xtarget - filterBounds) * nsource);
-        const auto isource_upper = int32_t(std::ceil((xtarget + filterBounds) * nsource));
+        // Iterate through source samples that lie within the bounded region, clamped to the
+        // samples that can have a non-zero weight (with a margin for rounding errors).
+        const float ilower = toSourceIndex(xtarget - support);
+        const float iupper = toSourceIndex(xtarget + support);
+        const auto isource_lower = std::max(int32_t((xtarget - filterBounds) * nsource),
+                int32_t(std::floor(std::min(ilower, iupper))) - 1);
+        const auto isource_upper = std::min(int32_t(std::ceil((xtarget + filterBounds) * nsource)),
+                int32_t(std::ceil(std::max(ilower, iupper))) + 1);
         for (int32_t isource = isource_lower; isource <= isource_upper; ++isource) {
             const float xsource = (((isource + 0.5f) / nsource) - left) / (right - left);
             const bool outside_image = isource < 0 || isource >= int32_t(nsource);
@@ -172,22 +190,70 @@ void generateMadProgram(uint32_t ntarget, uint32_t nsource, float left, float ri
     }
 }
 
-// Transforms a MAD program intended for single-channel data into a program intended for
-// multi-channel data.
-void expandMadProgram(uint32_t nchannels, MadProgram* program) {
-    if (nchannels == 1) {
-        return;
+// Instructions are grouped by target sample, in increasing order. Returns the index of the first
+// instruction of each target sample, followed by the size of the program.
+std::vector<uint32_t> getTargetOffsets(const MadProgram& program, uint32_t ntarget) {
+    std::vector<uint32_t> offsets(ntarget + 1, uint32_t(program.size()));
+    for (uint32_t i = uint32_t(program.size()); i-- > 0;) {
+        offsets[program[i].targetIndex] = i;
+    }
+    // target samples without instructions get an empty range
+    for (uint32_t i = ntarget; i-- > 0;) {
+        offsets[i] = std::min(offsets[i], offsets[i + 1]);
+    }
+    return offsets;
+}
+
+struct MadOp {
+    static constexpr float initialValue = 0.0f;
+    float operator()(float target, float source, float weight) const noexcept {
+        return target + source * weight;
+    }
+};
+
+// The MIN filter is special because it starts with non-zero values and ignores filter weights.
+struct MinOp {
+    static constexpr float initialValue = std::numeric_limits<float>::max();
+    float operator()(float target, float source, float) const noexcept {
+        return std::min(source, target);
     }
-    MadProgram result;
-    result.reserve(program->size() * nchannels);
-    for (auto mad : *program) {
-        mad.sourceIndex *= nchannels;
-        mad.targetIndex *= nchannels;
-        for (uint32_t j = 0; j < nchannels; ++j, ++mad.sourceIndex, ++mad.targetIndex) {
-            result.push_back(mad);
+};
+
+// Executes the MAD instructions over each of the given rows, for all channels at once. NCHAN is
+// the number of channels when known at compile time (so the compiler can vectorize), or zero.
+// Each target value always accumulates its source samples in program order, so the results don't
+// depend on how the rows are split across threads.
+template<uint32_t NCHAN, typename Op>
+void resampleRows(float* UTILS_RESTRICT target, float const* UTILS_RESTRICT source,
+        uint32_t twidth, uint32_t swidth, uint32_t channels, const MadProgram& program,
+        uint32_t first, uint32_t count, Op op) {
+    const uint32_t nchan = NCHAN ? NCHAN : channels;
+    for (uint32_t row = first; row < first + count; ++row) {
+        float* const targetRow = target + size_t(row) * twidth * nchan;
+        float const* const sourceRow = source + size_t(row) * swidth * nchan;
+        for (auto mad : program) {
+            float* const t = targetRow + mad.targetIndex * nchan;
+            float const* const s = sourceRow + mad.sourceIndex * int32_t(nchan);
+            for (uint32_t c = 0; c < nchan; ++c) {
+                t[c] = op(t[c], s[c], mad.weight);
+            }
         }
     }
-    program->swap(result);
+}
+
+// Runs fn(first, count) over rows [0, rowCount), in parallel if a JobSystem is given.
+template<typename F>
+void forEachRows(utils::JobSystem* js, uint32_t rowCount, size_t rowSize, F fn) {
+    // don't bother with jobs for small images
+    constexpr size_t MIN_FLOATS_PER_JOB = 16384;
+    if (!js || size_t(rowCount) * rowSize <= MIN_FLOATS_PER_JOB) {
+        fn(0, rowCount);
+        return;
+    }
+    utils::JobSystem::Job* job = utils::jobs::parallel_for(*js, nullptr, 0, rowCount,
+            [&fn](uint32_t first, uint32_t count) { fn(first, count); },
+            utils::jobs::CountSplitter<16>());
+    js->runAndWait(job);
 }
 
 FilterFunction createFilterFunction(Filter ftype) {
@@ -226,50 +292,87 @@ void normalize(LinearImage& image) {
     }
 }
 
-LinearImage resampleImage1D(const LinearImage& source, MadProgram* program,
-        uint32_t twidth, Filter filter, float left, float right, float filterRadiusMultiplier) {
+// Resizes the image horizontally, rows are independent.
+template<typename Op>
+void resampleHorizontal(utils::JobSystem* js, const LinearImage& source, LinearImage& result,
+        const MadProgram& program, Op op) {
+    const uint32_t swidth = source.getWidth();
+    const uint32_t twidth = result.getWidth();
+    const uint32_t nchan = source.getChannels();
+    float const* const sourcePixels = source.getPixelRef();
+    float* const targetPixels = result.getPixelRef();
+    using RowsFn = decltype(&resampleRows<0, Op>);
+    constexpr RowsFn rowsFns[] = {
+            resampleRows<0, Op>, resampleRows<1, Op>, resampleRows<2, Op>,
+            resampleRows<3, Op>, resampleRows<4, Op> };
+    const RowsFn rowsFn = rowsFns[nchan < 5 ? nchan : 0];
+    forEachRows(js, source.getHeight(), size_t(swidth) * nchan,
+            [&, op](uint32_t first, uint32_t count) {
+        rowsFn(targetPixels, sourcePixels, twidth, swidth, nchan, program, first, count, op);
+    });
+}
+
+// Resizes the image vertically, each target row is a weighted sum of whole source rows so the
+// inner loop is contiguous across pixels and channels.
+template<typename Op>
+void resampleVertical(utils::JobSystem* js, const LinearImage& source, LinearImage& result,
+        const MadProgram& program, Op op) {
+    const size_t rowSize = size_t(source.getWidth()) * source.getChannels();
+    const std::vector<uint32_t> offsets = getTargetOffsets(program, result.getHeight());
+    float const* const sourcePixels = source.getPixelRef();
+    float* const targetPixels = result.getPixelRef();
+    forEachRows(js, result.getHeight(), rowSize, [&, op](uint32_t first, uint32_t count) {
+        for (uint32_t row = first; row < first + count; ++row) {
+            float* UTILS_RESTRICT const t = targetPixels + row * rowSize;
+            for (uint32_t i = offsets[row]; i < offsets[row + 1]; ++i) {
+                const MadInstruction mad = program[i];
+                float const* UTILS_RESTRICT const s = sourcePixels + mad.sourceIndex * int64_t(rowSize);
+                for (size_t x = 0; x < rowSize; ++x) {
+                    t[x] = op(t[x], s[x], mad.weight);
+                }
+            }
+        }
+    });
+}
+
+// Resamples the image along one axis, with an image of the same size along the other axis.
+LinearImage resampleImage1D(utils::JobSystem* js, const LinearImage& source, MadProgram* program,
+        bool vertical, uint32_t tsize, Filter filter, float left, float right,
+        float filterRadiusMultiplier) {
     const uint32_t swidth = source.getWidth();
     const uint32_t sheight = source.getHeight();
     const uint32_t nchan = source.getChannels();
-    const bool mag = twidth > swidth;
+    const uint32_t ssize = vertical ? sheight : swidth;
+    const bool mag = tsize > ssize;
     if (filter == Filter::DEFAULT) filter = mag ? Filter::MITCHELL : Filter::LANCZOS;
-    const FilterFunction hfn = createFilterFunction(filter);
+    const FilterFunction fn = createFilterFunction(filter);
 
     // Generate a flat list of multiply-add (MAD) instructions.
     program->clear();
-    generateMadProgram(twidth, swidth, left, right, hfn, filterRadiusMultiplier, program);
-    expandMadProgram(nchan, program);
+    generateMadProgram(tsize, ssize, left, right, fn, filterRadiusMultiplier, program);
 
     // Allocate the target image.
-    LinearImage result(twidth, sheight, nchan);
-    float const* sourceRow = source.getPixelRef();
-    float* targetRow = result.getPixelRef();
+    LinearImage result(vertical ? swidth : tsize, vertical ? tsize : sheight, nchan);
 
-    // The MIN filter is special because it starts with non-zero values and ignores filter weights.
-    if (filter == Filter::MINIMUM) {
-        for (uint32_t n = 0; n < twidth * sheight * nchan; ++n) {
-            targetRow[n] = std::numeric_limits<float>::max();
+    auto resample = [&](auto op) {
+        if (op.initialValue != 0.0f) {
+            float* const pixels = result.getPixelRef();
+            std::fill(pixels, pixels + size_t(result.getWidth()) * result.getHeight() * nchan,
+                    op.initialValue);
         }
-        for (uint32_t row = 0; row < sheight; ++row) {
-            for (auto mad : *program) {
-                const float a = sourceRow[mad.sourceIndex];
-                const float b = targetRow[mad.targetIndex];
-                targetRow[mad.targetIndex] = std::min(a, b);
-            }
-            targetRow += twidth * nchan;
-            sourceRow += swidth * nchan;
+        if (vertical) {
+            resampleVertical(js, source, result, *program, op);
+        } else {
+            resampleHorizontal(js, source, result, *program, op);
         }
+    };
+
+    if (filter == Filter::MINIMUM) {
+        resample(MinOp{});
         return result;
     }
 
-    // Resize the image horizontally by executing the MAD instructions over each row.
-    for (uint32_t row = 0; row < sheight; ++row) {
-        for (auto mad : *program) {
-            targetRow[mad.targetIndex] += sourceRow[mad.sourceIndex] * mad.weight;
-        }
-        targetRow += twidth * nchan;
-        sourceRow += swidth * nchan;
-    }
+    resample(MadOp{});
 
     // Perform post processing for the current pass.
     if (filter == Filter::GAUSSIAN_NORMALS) {
@@ -278,16 +381,8 @@ LinearImage resampleImage1D(const LinearImage& source, MadProgram* program,
     return result;
 }
 
-} // anonymous namespace
-
-namespace image {
-
-SingleSample::~SingleSample() {
-    delete[] data;
-}
-
-LinearImage resampleImage(const LinearImage& source, uint32_t width, uint32_t height,
-        const ImageSampler& sampler) {
+LinearImage resampleImageImpl(utils::JobSystem* js, const LinearImage& source, uint32_t width,
+        uint32_t height, const ImageSampler& sampler) {
     ASSERT_PRECONDITION(
         sampler.east.mode == Boundary::EXCLUDE &&
         sampler.north.mode == Boundary::EXCLUDE &&
@@ -302,11 +397,44 @@ LinearImage resampleImage(const LinearImage& source, uint32_t width, uint32_t he
     const float bottom = sampler.sourceRegion.bottom;
     MadProgram program;
     LinearImage result;
-    result = transpose(resampleImage1D(source, &program, width, hfilter, left, right, radius));
-    result = transpose(resampleImage1D(result, &program, height, vfilter, top, bottom, radius));
+    result = resampleImage1D(js, source, &program, false, width, hfilter, left, right, radius);
+    result = resampleImage1D(js, result, &program, true, height, vfilter, top, bottom, radius);
     return result;
 }
 
+void generateMipmapsImpl(utils::JobSystem* js, const LinearImage& source, Filter filter,
+        LinearImage* result, uint32_t mips) {
+    mips = std::min(mips, getMipmapCount(source));
+    uint32_t width = source.getWidth();
+    uint32_t height = source.getHeight();
+    for (uint32_t n = 0; n < mips; ++n) {
+        width = std::max(width >> 1u, 1u);
+        height = std::max(height >> 1u, 1u);
+        result[n] = resampleImageImpl(js, source, width, height, ImageSampler {
+            .horizontalFilter = filter,
+            .verticalFilter = filter
+        });
+    }
+}
+
+} // anonymous namespace
+
+namespace image {
+
+SingleSample::~SingleSample() {
+    delete[] data;
+}
+
+LinearImage resampleImage(const LinearImage& source, uint32_t width, uint32_t height,
+        const ImageSampler& sampler) {
+    return resampleImageImpl(nullptr, source, width, height, sampler);
+}
+
+LinearImage resampleImage(utils::JobSystem& js, const LinearImage& source, uint32_t width,
+        uint32_t height, const ImageSampler& sampler) {
+    return resampleImageImpl(&js, source, width, height, sampler);
+}
+
 LinearImage resampleImage(const LinearImage& source, uint32_t width, uint32_t height,
         Filter filter) {
     return resampleImage(source, width, height, ImageSampler {
@@ -323,8 +451,8 @@ void computeSingleSample(const LinearImage& source, float x, float y, SingleSamp
     const float right = x + radius / source.getWidth();
     const float bottom = y + radius / source.getHeight();
     MadProgram program;
-    LinearImage row = transpose(resampleImage1D(source, &program, 1, filter, left, right, radius));
-    row = resampleImage1D(row, &program, 1, filter, top, bottom, radius);
+    LinearImage row = resampleImage1D(nullptr, source, &program, false, 1, filter, left, right, radius);
+    row = resampleImage1D(nullptr, row, &program, true, 1, filter, top, bottom, radius);
     if (!result->data) {
         result->data = new float[source.getChannels()];
     }
@@ -339,14 +467,12 @@ void computeSingleSample(const LinearImage& source, float x, float y, SingleSamp
 // Unlike traditional mipmap generation, our implementation generates all levels from the original
 // image, under the premise that this produces a higher quality result.
 void generateMipmaps(const LinearImage& source, Filter filter, LinearImage* result, uint32_t mips) {
-    mips = std::min(mips, getMipmapCount(source));
-    uint32_t width = source.getWidth();
-    uint32_t height = source.getHeight();
-    for (uint32_t n = 0; n < mips; ++n) {
-        width = std::max(width >> 1u, 1u);
-        height = std::max(height >> 1u, 1u);
-        result[n] = resampleImage(source, width, height, filter);
-    }
+    generateMipmapsImpl(nullptr, source, filter, result, mips);
+}
+
+void generateMipmaps(utils::JobSystem& js, const LinearImage& source, Filter filter,
+        LinearImage* result, uint32_t mips) {
+    generateMipmapsImpl(&js, source, filter, result, mips);
 }
 
 uint32_t getMipmapCount(const LinearImage& source) {
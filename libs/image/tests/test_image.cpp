@@ -26,12 +26,14 @@
 
 #include <gtest/gtest.h>
 
+#include <utils/JobSystem.h>
 #include <utils/Panic.h>
 #include <utils/Path.h>
 
 #include <math/vec3.h>
 #include <math/vec4.h>
 
+#include <cstring>
 #include <fstream>
 #include <string>
 #include <sstream>
@@ -362,6 +364,41 @@ TEST_F(ImageTest, Mipmaps) { // NOLINT
     }
 }
 
+TEST_F(ImageTest, MipmapsJobSystem) { // NOLINT
+    utils::JobSystem js;
+    js.adopt();
+
+    // large enough to be split into several jobs, with odd dimensions
+    LinearImage src = createNormalMap(256);
+    src = resampleImage(src, 301, 257, Filter::BOX);
+    const uint32_t count = getMipmapCount(src);
+
+    // the multi-threaded results must be bit-for-bit identical to the single-threaded ones
+    for (Filter filter : { Filter::BOX, Filter::GAUSSIAN_SCALARS, Filter::GAUSSIAN_NORMALS,
+            Filter::MITCHELL, Filter::LANCZOS, Filter::MINIMUM }) {
+        vector<LinearImage> expected(count);
+        vector<LinearImage> mips(count);
+        generateMipmaps(src, filter, expected.data(), count);
+        generateMipmaps(js, src, filter, mips.data(), count);
+        for (uint32_t index = 0; index < count; ++index) {
+            ASSERT_EQ(expected[index].getWidth(), mips[index].getWidth());
+            ASSERT_EQ(expected[index].getHeight(), mips[index].getHeight());
+            const size_t size = expected[index].getWidth() * expected[index].getHeight() *
+                    expected[index].getChannels() * sizeof(float);
+            EXPECT_EQ(0, memcmp(expected[index].getPixelRef(), mips[index].getPixelRef(), size));
+        }
+
+        // magnification too
+        ImageSampler sampler { .horizontalFilter = filter, .verticalFilter = filter };
+        LinearImage big = resampleImage(src, 640, 480, sampler);
+        LinearImage bigMT = resampleImage(js, src, 640, 480, sampler);
+        EXPECT_EQ(0, memcmp(big.getPixelRef(), bigMT.getPixelRef(),
+                640 * 480 * big.getChannels() * sizeof(float)));
+    }
+
+    js.emancipate();
+}
+
 TEST_F(ImageTest, Ktx) { // NOLINT
     uint8_t foo[] = {1, 2, 3};
     uint8_t* data;
@@ -63,6 +63,10 @@ ShaderExtractor::ShaderExtractor(Backend backend, const void* data, size_t size)
 
 bool ShaderExtractor::parse() noexcept {
     if (mChunkContainer.parse()) {
+        const ChunkType compressedTag = MaterialChunk::getCompressedType(mMaterialTag);
+        if (mChunkContainer.hasChunk(compressedTag)) {
+            mMaterialTag = compressedTag;
+        }
         return mMaterialChunk.readIndex(mMaterialTag);
     }
     return false;
@@ -76,11 +80,17 @@ bool ShaderExtractor::getShader(ShaderModel shaderModel,
         Variant variant, ShaderType stage, ShaderBuilder& shader) noexcept {
 
     ChunkContainer const& cc = mChunkContainer;
+    BlobDictionary blobDictionary;
+    if (mMaterialChunk.getBlockCount() > 0) {
+        // compressed shaders don't use a dictionary
+        return mMaterialChunk.getShader(shader, blobDictionary,
+                (uint8_t)shaderModel, variant, stage);
+    }
+
     if (!cc.hasChunk(mMaterialTag) || !cc.hasChunk(mDictionaryTag)) {
         return false;
     }
 
-    BlobDictionary blobDictionary;
     if (!DictionaryReader::unflatten(cc, mDictionaryTag, blobDictionary)) {
         return false;
     }
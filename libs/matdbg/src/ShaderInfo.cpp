@@ -38,7 +38,24 @@ using namespace filamat;
 using namespace std;
 using namespace utils;
 
+// When present, the compressed chunks replace the dictionary-based ones.
+static filamat::ChunkType resolveChunkType(ChunkContainer const& container,
+        filamat::ChunkType type) {
+    const filamat::ChunkType compressedType = MaterialChunk::getCompressedType(type);
+    return container.hasChunk(compressedType) ? compressedType : type;
+}
+
+// In compressed chunks, each entry is followed by the shader's location in its block.
+static bool skipBlockLocation(Unflattener& unflattener, bool compressed) {
+    if (compressed) {
+        uint32_t offset, size;
+        return unflattener.read(&offset) && unflattener.read(&size);
+    }
+    return true;
+}
+
 size_t getShaderCount(ChunkContainer container, filamat::ChunkType type) {
+    type = resolveChunkType(container, type);
     if (!container.hasChunk(type)) {
         return 0;
     }
@@ -53,13 +70,16 @@ size_t getShaderCount(ChunkContainer container, filamat::ChunkType type) {
 }
 
 bool getMetalShaderInfo(ChunkContainer container, ShaderInfo* info) {
-    if (!container.hasChunk(filamat::ChunkType::MaterialMetal)) {
+    const filamat::ChunkType type =
+            resolveChunkType(container, filamat::ChunkType::MaterialMetal);
+    const bool compressed = type != filamat::ChunkType::MaterialMetal;
+    if (!container.hasChunk(type)) {
         return true;
     }
 
     Unflattener unflattener(
-            container.getChunkStart(filamat::ChunkType::MaterialMetal),
-            container.getChunkEnd(filamat::ChunkType::MaterialMetal));
+            container.getChunkStart(type),
+            container.getChunkEnd(type));
 
     uint64_t shaderCount = 0;
     if (!unflattener.read(&shaderCount) || shaderCount == 0) {
@@ -88,6 +108,10 @@ bool getMetalShaderInfo(ChunkContainer container, ShaderInfo* info) {
             return false;
         }
 
+        if (!skipBlockLocation(unflattener, compressed)) {
+            return false;
+        }
+
         *info++ = {
                 .shaderModel = ShaderModel(shaderModelValue),
                 .variant = variant,
@@ -100,13 +124,16 @@ bool getMetalShaderInfo(ChunkContainer container, ShaderInfo* info) {
 }
 
 bool getGlShaderInfo(ChunkContainer container, ShaderInfo* info) {
-    if (!container.hasChunk(filamat::ChunkType::MaterialGlsl)) {
+    const filamat::ChunkType type =
+            resolveChunkType(container, filamat::ChunkType::MaterialGlsl);
+    const bool compressed = type != filamat::ChunkType::MaterialGlsl;
+    if (!container.hasChunk(type)) {
         return true;
     }
 
     Unflattener unflattener(
-            container.getChunkStart(filamat::ChunkType::MaterialGlsl),
-            container.getChunkEnd(filamat::ChunkType::MaterialGlsl));
+            container.getChunkStart(type),
+            container.getChunkEnd(type));
 
     uint64_t shaderCount;
     if (!unflattener.read(&shaderCount) || shaderCount == 0) {
@@ -135,6 +162,10 @@ bool getGlShaderInfo(ChunkContainer container, ShaderInfo* info) {
             return false;
         }
 
+        if (!skipBlockLocation(unflattener, compressed)) {
+            return false;
+        }
+
         *info++ = {
             .shaderModel = ShaderModel(shaderModelValue),
             .variant = variant,
@@ -146,13 +177,16 @@ bool getGlShaderInfo(ChunkContainer container, ShaderInfo* info) {
 }
 
 bool getVkShaderInfo(ChunkContainer container, ShaderInfo* info) {
-    if (!container.hasChunk(filamat::ChunkType::MaterialSpirv)) {
+    const filamat::ChunkType type =
+            resolveChunkType(container, filamat::ChunkType::MaterialSpirv);
+    const bool compressed = type != filamat::ChunkType::MaterialSpirv;
+    if (!container.hasChunk(type)) {
         return true;
     }
 
     Unflattener unflattener(
-            container.getChunkStart(filamat::ChunkType::MaterialSpirv),
-            container.getChunkEnd(filamat::ChunkType::MaterialSpirv));
+            container.getChunkStart(type),
+            container.getChunkEnd(type));
 
     uint64_t shaderCount;
     if (!unflattener.read(&shaderCount) || shaderCount == 0) {
@@ -181,6 +215,10 @@ bool getVkShaderInfo(ChunkContainer container, ShaderInfo* info) {
             return false;
         }
 
+        if (!skipBlockLocation(unflattener, compressed)) {
+            return false;
+        }
+
         *info++ = {
             .shaderModel = ShaderModel(shaderModelValue),
             .variant = variant,
@@ -15,6 +15,7 @@
  */
 
 #include <filaflat/ChunkContainer.h>
+#include <filaflat/MaterialChunk.h>
 
 #include <filament/MaterialEnums.h>
 
@@ -23,6 +24,7 @@
 #include <matdbg/TextWriter.h>
 #include <matdbg/ShaderInfo.h>
 
+#include <algorithm>
 #include <sstream>
 #include <iomanip>
 
@@ -388,6 +390,45 @@ static bool printMetalInfo(ostream& text, const ChunkContainer& container) {
     return true;
 }
 
+static bool printBlockInfo(ostream& text, const ChunkContainer& container, ChunkType type,
+        const char* title) {
+    if (!container.hasChunk(type)) {
+        return true;
+    }
+    MaterialChunk chunk(container);
+    if (!chunk.readIndex(type)) {
+        return false;
+    }
+
+    text << title << endl;
+    text << "    " << setw(6) << left << "Block";
+    text << setw(12) << right << "Compressed";
+    text << setw(12) << right << "Size";
+    text << setw(8) << right << "Ratio";
+    text << setw(9) << right << "Shaders" << endl;
+
+    size_t totalCompressedSize = 0;
+    size_t totalSize = 0;
+    for (size_t i = 0; i < chunk.getBlockCount(); i++) {
+        const MaterialChunk::BlockInfo block = chunk.getBlockInfo(i);
+        text << "    #" << setw(5) << left << i;
+        text << setw(12) << right << block.compressedSize;
+        text << setw(12) << right << block.size;
+        text << setw(7) << right << fixed << setprecision(2)
+             << double(block.size) / max(block.compressedSize, 1u) << "x";
+        text << setw(9) << right << block.shaderCount << endl;
+        totalCompressedSize += block.compressedSize;
+        totalSize += block.size;
+    }
+    text << "    " << setw(6) << left << "Total";
+    text << setw(12) << right << totalCompressedSize;
+    text << setw(12) << right << totalSize;
+    text << setw(7) << right << fixed << setprecision(2)
+         << double(totalSize) / max(totalCompressedSize, size_t(1)) << "x" << endl;
+    text << endl;
+    return true;
+}
+
 bool TextWriter::writeMaterialInfo(const filaflat::ChunkContainer& container) {
     ostringstream text;
     if (!printMaterial(text, container)) {
@@ -405,6 +446,18 @@ bool TextWriter::writeMaterialInfo(const filaflat::ChunkContainer& container) {
     if (!printMetalInfo(text, container)) {
         return false;
     }
+    if (!printBlockInfo(text, container, ChunkType::MaterialGlslCompressed,
+            "GLSL compressed blocks:")) {
+        return false;
+    }
+    if (!printBlockInfo(text, container, ChunkType::MaterialSpirvCompressed,
+            "Vulkan compressed blocks:")) {
+        return false;
+    }
+    if (!printBlockInfo(text, container, ChunkType::MaterialMetalCompressed,
+            "Metal compressed blocks:")) {
+        return false;
+    }
 
     printChunks(text, container);
 
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "PerformanceCounters.h"
+
+#include <utils/Entity.h>
+#include <utils/EntityManager.h>
+#include <utils/SingleInstanceComponentManager.h>
+
+#include <tsl/robin_map.h>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace utils;
+
+namespace {
+
+using ComponentManager = SingleInstanceComponentManager<float>;
+
+class ComponentBenchmark : public benchmark::Fixture {
+public:
+    void SetUp(benchmark::State& state) override {
+        EntityManager& em = EntityManager::get();
+        entities.resize(state.range(0));
+        em.create(entities.size(), entities.data());
+        for (Entity e : entities) {
+            cm.addComponent(e);
+            map[e] = ComponentManager::Instance(map.size() + 1);
+        }
+        // entities are looked up either in the order they were created or in random order
+        if (state.range(1)) {
+            std::shuffle(entities.begin(), entities.end(), std::default_random_engine{});
+        }
+    }
+
+    void TearDown(benchmark::State& state) override {
+        for (Entity e : entities) {
+            cm.removeComponent(e);
+        }
+        map.clear();
+        EntityManager::get().destroy(entities.size(), entities.data());
+    }
+
+protected:
+    std::vector<Entity> entities;
+    ComponentManager cm;
+    // this is how SingleInstanceComponentManager used to map entities to instances
+    tsl::robin_map<Entity, ComponentManager::Instance> map;
+};
+
+} // anonymous namespace
+
+BENCHMARK_DEFINE_F(ComponentBenchmark, getInstance)(benchmark::State& state) {
+    PerformanceCounters pc(state);
+    for (auto _ : state) {
+        size_t sum = 0;
+        for (Entity e : entities) {
+            sum += cm.getInstance(e);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations() * entities.size()));
+}
+
+BENCHMARK_DEFINE_F(ComponentBenchmark, robin_map)(benchmark::State& state) {
+    PerformanceCounters pc(state);
+    for (auto _ : state) {
+        size_t sum = 0;
+        for (Entity e : entities) {
+            auto pos = map.find(e);
+            sum += pos != map.end() ? pos->second : 0;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations() * entities.size()));
+}
+
+// arguments are the number of entities and whether they are looked up in random order
+static void arguments(benchmark::internal::Benchmark* b) {
+    b->ArgNames({ "entities", "random" });
+    for (int64_t count : { 1024, 65536, 1 << 20 }) {
+        b->Args({ count, 0 });
+        b->Args({ count, 1 });
+    }
+}
+
+BENCHMARK_REGISTER_F(ComponentBenchmark, getInstance)->Apply(arguments);
+BENCHMARK_REGISTER_F(ComponentBenchmark, robin_map)->Apply(arguments);
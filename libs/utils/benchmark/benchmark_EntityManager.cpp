@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "PerformanceCounters.h"
+
+#include <utils/Entity.h>
+#include <utils/EntityManager.h>
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+using namespace utils;
+
+static void BM_entity_create_destroy(benchmark::State& state) {
+    EntityManager& em = EntityManager::get();
+    std::vector<Entity> entities(state.range(0));
+    PerformanceCounters pc(state);
+    for (auto _ : state) {
+        em.create(entities.size(), entities.data());
+        em.destroy(entities.size(), entities.data());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations() * entities.size()));
+}
+
+// Each thread creates and destroys its own batch of entities, this measures contention.
+static void BM_entity_create_destroy_threads(benchmark::State& state) {
+    EntityManager& em = EntityManager::get();
+    std::vector<Entity> entities(state.range(0));
+    for (auto _ : state) {
+        em.create(entities.size(), entities.data());
+        em.destroy(entities.size(), entities.data());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations() * entities.size()));
+}
+
+static void BM_entity_isAlive(benchmark::State& state) {
+    EntityManager& em = EntityManager::get();
+    std::vector<Entity> entities(state.range(0));
+    em.create(entities.size(), entities.data());
+    {
+        PerformanceCounters pc(state);
+        for (auto _ : state) {
+            size_t alive = 0;
+            for (Entity e : entities) {
+                alive += em.isAlive(e);
+            }
+            benchmark::DoNotOptimize(alive);
+        }
+    }
+    state.SetItemsProcessed(int64_t(state.iterations() * entities.size()));
+    em.destroy(entities.size(), entities.data());
+}
+
+BENCHMARK(BM_entity_create_destroy)->Arg(1)->Arg(1024)->Arg(1 << 20);
+BENCHMARK(BM_entity_create_destroy_threads)->Arg(1)->Arg(64)
+        ->Threads(1)->Threads(2)->Threads(4)->Threads(8)->UseRealTime();
+BENCHMARK(BM_entity_isAlive)->Arg(1024)->Arg(1 << 20)->Arg(2'000'000);
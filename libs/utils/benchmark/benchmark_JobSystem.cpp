@@ -21,6 +21,10 @@
 
 #include <benchmark/benchmark.h>
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+
 using namespace utils;
 
 
@@ -78,7 +82,98 @@ static void BM_JobSystemParallelFor(benchmark::State& state) {
     js.emancipate();
 }
 
+// Same as BM_JobSystemAsChildren4k, with range(0) threads in the pool (capped to 32)
+static void BM_JobSystemThreads(benchmark::State& state) {
+    JobSystem js(state.range(0));
+    js.adopt();
+
+    {
+        PerformanceCounters pc(state);
+        for (auto _ : state) {
+            auto root = js.create(nullptr, &emptyJob);
+            for (size_t i = 0; i < 4095; i++) {
+                js.run(js.create(root, &emptyJob));
+            }
+            js.runAndWait(root);
+        }
+    }
+    state.SetItemsProcessed((int64_t)state.iterations() * 4096);
+
+    js.emancipate();
+}
+
+// Measures the time to run frame jobs while the workers are saturated with long jobs, which
+// are either in the background lane (range(0) = 1) or in the frame lane (range(0) = 0).
+static void BM_JobSystemFrameLatency(benchmark::State& state) {
+    JobSystem js;
+    js.adopt();
+
+    struct Load {
+        std::atomic_bool done = { false };
+        // each load job spins for about 500us, then replaces itself
+        static void run(JobSystem& js, JobSystem::Job* parent, Load* load) {
+            js.run(jobs::createJob(js, parent, [&js, parent, load]() {
+                auto const start = std::chrono::steady_clock::now();
+                while (std::chrono::steady_clock::now() - start < std::chrono::microseconds(500)) {
+                }
+                if (!load->done.load(std::memory_order_relaxed)) {
+                    run(js, parent, load);
+                }
+            }));
+        }
+    } load;
+
+    JobSystem::Job* root = js.createJob();
+    if (state.range(0)) {
+        js.setLane(root, JobSystem::Lane::BACKGROUND);
+    }
+    for (size_t i = 0, c = std::thread::hardware_concurrency() * 2; i < c; i++) {
+        Load::run(js, root, &load);
+    }
+
+    {
+        PerformanceCounters pc(state);
+        for (auto _ : state) {
+            auto job = jobs::parallel_for(js, nullptr, 0, 4096,
+                    [](uint32_t start, uint32_t count) { }, jobs::CountSplitter<64>());
+            js.runAndWait(job);
+        }
+    }
+    state.SetItemsProcessed((int64_t)state.iterations() * 4096);
+
+    load.done = true;
+    js.runAndWait(root);
+    js.emancipate();
+}
+
+// Compares random stealing with topology-aware placement and stealing, which only makes a
+// difference on machines with several last-level caches or NUMA nodes.
+static void BM_JobSystemTopology(benchmark::State& state) {
+    JobSystem js(0, 1, state.range(0) ?
+            JobSystem::CpuTopology::fromSysfs() : JobSystem::CpuTopology{});
+    js.adopt();
+
+    std::vector<float> data(1u << 20);
+    {
+        PerformanceCounters pc(state);
+        for (auto _ : state) {
+            auto job = jobs::parallel_for(js, nullptr, data.data(), uint32_t(data.size()),
+                    [](float* data, uint32_t count) {
+                        for (uint32_t i = 0; i < count; i++) {
+                            data[i] = data[i] * 0.5f + 1.0f;
+                        }
+                    }, jobs::CountSplitter<1024>());
+            js.runAndWait(job);
+        }
+    }
+    state.SetItemsProcessed((int64_t)state.iterations() * int64_t(data.size()));
+
+    js.emancipate();
+}
 
 BENCHMARK(BM_JobSystem);
 BENCHMARK(BM_JobSystemAsChildren4k);
 BENCHMARK(BM_JobSystemParallelFor);
+BENCHMARK(BM_JobSystemThreads)->ArgName("threads")->RangeMultiplier(2)->Range(4, 64)->UseRealTime();
+BENCHMARK(BM_JobSystemFrameLatency)->ArgName("background")->Arg(0)->Arg(1)->UseRealTime();
+BENCHMARK(BM_JobSystemTopology)->ArgName("topology")->Arg(0)->Arg(1)->UseRealTime();
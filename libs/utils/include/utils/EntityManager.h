@@ -17,6 +17,8 @@
 #ifndef TNT_UTILS_ENTITYMANAGER_H
 #define TNT_UTILS_ENTITYMANAGER_H
 
+#include <atomic>
+
 #include <assert.h>
 #include <stdint.h>
 
@@ -77,7 +79,7 @@ public:
     // Thread safe.
     bool isAlive(Entity e) const noexcept {
         assert(getIndex(e) < RAW_INDEX_COUNT);
-        return (!e.isNull()) && (getGeneration(e) == mGens[getIndex(e)]);
+        return (!e.isNull()) && (getGeneration(e) == getGenerationForIndex(getIndex(e)));
     }
 
     // registers a listener to be called when an entity is destroyed. thread safe.
@@ -90,9 +92,19 @@ public:
 
     /* no user serviceable parts below */
 
+    // index of the given Entity, smaller than getMaxEntityCount() + 1. An index is only used
+    // by one living Entity at a time, it can be used to build direct-indexed tables.
+    static size_t getEntityIndex(Entity e) noexcept {
+        return getIndex(e);
+    }
+
     // current generation of the given index. Use for debugging and testing.
     uint8_t getGenerationForIndex(size_t index) const noexcept {
-        return mGens[index];
+        // indices of pages that are not allocated yet have never been used
+        // (relaxed is enough, an Entity is always handed over to other threads with a barrier)
+        uint8_t const* const page =
+                mGens[index >> GENERATION_PAGE_SHIFT].load(std::memory_order_relaxed);
+        return UTILS_LIKELY(page) ? page[index & GENERATION_PAGE_MASK] : uint8_t(0);
     }
     // singleton, can't be copied
     EntityManager(const EntityManager& rhs) = delete;
@@ -108,12 +120,18 @@ private:
     EntityManager();
     ~EntityManager();
 
-    // GENERATION_SHIFT determines how many simultaneous Entities are available, the
-    // minimum memory requirement is 2^GENERATION_SHIFT bytes.
-    static constexpr const int GENERATION_SHIFT = 17;
+    // GENERATION_SHIFT determines how many simultaneous Entities are available (about 4M).
+    // The generations are stored in pages of 2^GENERATION_PAGE_SHIFT bytes which are allocated
+    // as the indices get used, so the memory requirement grows with the number of entities.
+    static constexpr const int GENERATION_SHIFT = 22;
     static constexpr const size_t RAW_INDEX_COUNT = (1 << GENERATION_SHIFT);
     static constexpr const Entity::Type INDEX_MASK = (1 << GENERATION_SHIFT) - 1u;
 
+    static constexpr const int GENERATION_PAGE_SHIFT = 16;
+    static constexpr const size_t GENERATION_PAGE_SIZE = (1 << GENERATION_PAGE_SHIFT);
+    static constexpr const size_t GENERATION_PAGE_MASK = GENERATION_PAGE_SIZE - 1u;
+    static constexpr const size_t GENERATION_PAGE_COUNT = RAW_INDEX_COUNT / GENERATION_PAGE_SIZE;
+
     static inline Entity::Type getGeneration(Entity e) noexcept {
         return e.getId() >> GENERATION_SHIFT;
     }
@@ -124,8 +142,9 @@ private:
         return (g << GENERATION_SHIFT) | (i & INDEX_MASK);
     }
 
-    // stores the generation of each index.
-    uint8_t * const mGens;
+    // stores the generation of each index, by pages. Pages are published atomically so that
+    // entities can be created without holding a lock.
+    std::atomic<uint8_t*> mGens[GENERATION_PAGE_COUNT] = {};
 };
 
 } // namespace utils
@@ -39,15 +39,32 @@
 namespace utils {
 
 class JobSystem {
-    static constexpr size_t MAX_JOB_COUNT = 16384;
-    static_assert(MAX_JOB_COUNT <= 0x7FFE, "MAX_JOB_COUNT must be <= 0x7FFE");
-    using WorkQueue = WorkStealingDequeue<uint16_t, MAX_JOB_COUNT>;
+    // Jobs are allocated by chunks of 1 MiB, as needed. Chunks are never freed until the
+    // JobSystem is destroyed, so there are no allocations once the high-water mark is reached.
+    static constexpr size_t JOB_CHUNK_SIZE = 16384;
+    static constexpr size_t MAX_JOB_CHUNK_COUNT = 64;
+    static constexpr size_t MAX_JOB_COUNT = JOB_CHUNK_SIZE * MAX_JOB_CHUNK_COUNT;
+    static constexpr uint32_t NO_PARENT = 0xFFFFFF;
+    static_assert(MAX_JOB_COUNT < NO_PARENT, "MAX_JOB_COUNT must be < 0xFFFFFF");
+    static_assert(MAX_JOB_CHUNK_COUNT <= 64, "Job::chunk must hold all chunk indices");
+    // queues hold job indices + 1, they grow as needed
+    using WorkQueue = WorkStealingDequeue<uint32_t, 4096>;
 
 public:
     class Job;
 
     using JobFunc = void(*)(void*, JobSystem&, Job*);
 
+    /*
+     * Jobs are run in one of two lanes. Workers only pick up BACKGROUND jobs when no FRAME job
+     * is available anywhere, which keeps long-running work (e.g. texture decoding) from delaying
+     * frame-critical jobs. A job being executed is never interrupted though.
+     */
+    enum class Lane : uint8_t {
+        FRAME,          // default, frame-critical jobs
+        BACKGROUND      // jobs that can be delayed
+    };
+
     class alignas(CACHELINE_SIZE) Job {
     public:
         Job() noexcept {} /* = default; */ /* clang bug */ // NOLINT(modernize-use-equals-default,cppcoreguidelines-pro-type-member-init)
@@ -69,15 +86,40 @@ public:
                                                                 // v7 | v8
         void* storage[JOB_STORAGE_SIZE_WORDS];                  // 48 | 48
         JobFunc function;                                       //  4 |  8
-        uint16_t parent;                                        //  2 |  2
+        uint32_t parent : 24;                                   //  3 |  3
+        uint32_t lane : 2;                                      //  1 |  1
+        uint32_t chunk : 6;     // index of the job chunk holding this job
+        // a job can't have more than 65534 unfinished children
         std::atomic<uint16_t> runningJobCount = { 1 };          //  2 |  2
         mutable std::atomic<uint16_t> refCount = { 1 };         //  2 |  2
-                                                                //  6 |  2 (padding)
+                                                                //  4 |  0 (padding)
                                                                 // 64 | 64
     };
 
+    /*
+     * Which CPUs share a last-level cache and a NUMA node. When a JobSystem is given a
+     * topology, its workers are pinned so that consecutive workers share a cache, and they
+     * steal preferably from workers of their own cache domain, then of their own node.
+     */
+    struct CpuTopology {
+        struct Cpu {
+            uint16_t id;            // as used by the OS for affinity
+            uint16_t cacheDomain;   // id of the lowest CPU sharing our last-level cache
+            uint16_t numaNode;
+        };
+        std::vector<Cpu> cpus;      // online CPUs
+
+        // Reads the topology of this machine from sysfs, root is normally "/sys/devices/system".
+        // Returns an empty topology when not available (e.g. not on Linux).
+        static CpuTopology fromSysfs(const char* root = "/sys/devices/system") noexcept;
+    };
+
     explicit JobSystem(size_t threadCount = 0, size_t adoptableThreadsCount = 1) noexcept;
 
+    // Topology-aware mode, an empty topology is the same as not using one.
+    JobSystem(size_t threadCount, size_t adoptableThreadsCount,
+            CpuTopology const& topology) noexcept;
+
     ~JobSystem();
 
     // Make the current thread part of the thread pool.
@@ -99,8 +141,18 @@ public:
     Job* setMasterJob(Job* job) noexcept { return setRootJob(job); }
 
 
+    // Jobs are created in the lane of their parent, or in Lane::FRAME if they don't have one.
     Job* create(Job* parent, JobFunc func) noexcept;
 
+    /*
+     * Sets the lane a job will run in. Children created after this call inherit the lane.
+     *
+     * Never use this once a flavor of run() has been called.
+     */
+    void setLane(Job* job, Lane lane) noexcept {
+        job->lane = uint32_t(lane);
+    }
+
     // NOTE: All methods below must be called from the same thread and that thread must be
     // owned by JobSystem's thread pool.
 
@@ -303,6 +355,11 @@ public:
         return mParallelSplitCount;
     }
 
+    // number of jobs that can be alive at once before more storage gets allocated
+    size_t getJobCapacity() const noexcept {
+        return mJobChunkCount.load(std::memory_order_relaxed) * JOB_CHUNK_SIZE;
+    }
+
 private:
     // this is just to avoid using std::default_random_engine, since we're in a public header.
     class default_random_engine {
@@ -317,16 +374,37 @@ private:
         }
     };
 
+    static constexpr size_t LANE_COUNT = 2;
+
+    // a range of indices in mThreadStates
+    struct StealRange {
+        uint16_t first = 0;
+        uint16_t count = 0;
+    };
+
     struct alignas(CACHELINE_SIZE) ThreadState {    // this causes 40-bytes padding
         // make sure storage is cache-line aligned
         WorkQueue workQueue;
 
+        // background jobs, only executed when no frame jobs are available
+        alignas(CACHELINE_SIZE)     // this causes 48-bytes padding
+        WorkQueue backgroundWorkQueue;
+
+        WorkQueue& getWorkQueue(Lane lane) noexcept {
+            return lane == Lane::FRAME ? workQueue : backgroundWorkQueue;
+        }
+
         // these are not accessed by the worker threads
         alignas(CACHELINE_SIZE)     // this causes 56-bytes padding
         JobSystem* js;
         std::thread thread;
         default_random_engine rndGen;
         uint32_t id;
+        uint16_t cpu;               // CPU this thread is pinned to
+        uint8_t stealAttempt = 0;
+        // workers sharing our cache and NUMA node, count is 0 when unknown
+        StealRange cacheDomain;
+        StealRange numaNode;
     };
 
     static_assert(sizeof(ThreadState) % CACHELINE_SIZE == 0,
@@ -338,32 +416,46 @@ private:
     void decRef(Job const* job) noexcept;
 
     Job* allocateJob() noexcept;
+    Job* allocateJobChunk(size_t chunkCount) noexcept;
+    void freeJob(Job* job) noexcept;
+    uint32_t getJobIndex(Job const* job) const noexcept;
+    Job* getJob(uint32_t index) const noexcept;
     JobSystem::ThreadState* getStateToStealFrom(JobSystem::ThreadState& state) noexcept;
     bool hasJobCompleted(Job const* job) noexcept;
 
     void requestExit() noexcept;
     bool exitRequested() const noexcept;
     bool hasActiveJobs() const noexcept;
+    bool hasActiveJobs(Lane lane) const noexcept;
 
     void loop(ThreadState* state) noexcept;
-    bool execute(JobSystem::ThreadState& state) noexcept;
-    Job* steal(JobSystem::ThreadState& state) noexcept;
+    bool execute(JobSystem::ThreadState& state, bool background = true) noexcept;
+    Job* steal(JobSystem::ThreadState& state, Lane lane) noexcept;
     void finish(Job* job) noexcept;
 
-    void put(WorkQueue& workQueue, Job* job) noexcept;
-    Job* pop(WorkQueue& workQueue) noexcept;
-    Job* steal(WorkQueue& workQueue) noexcept;
+    void put(ThreadState& state, Job* job) noexcept;
+    Job* pop(WorkQueue& workQueue, Lane lane) noexcept;
+    Job* steal(WorkQueue& workQueue, Lane lane) noexcept;
 
-    void wait(std::unique_lock<Mutex>& lock, Job* job = nullptr) noexcept;
+    uint32_t prepareWait() noexcept;
+    void cancelWait() noexcept;
+    void wait(uint32_t epoch, Job* job = nullptr) noexcept;
+    void wake(int count) noexcept;
     void wakeAll() noexcept;
     void wakeOne() noexcept;
+    void wake(Lane lane) noexcept;
 
     // these have thread contention, keep them together
+    std::atomic<uint32_t> mWaiterEpoch = { 0 };     // incremented by wake-ups, threads park on it
+    std::atomic<uint32_t> mWaiterCount = { 0 };     // # of threads parked or about to park
+#if !defined(__linux__)
+    // on linux threads park directly on mWaiterEpoch with a futex
     utils::Mutex mWaiterLock;
     utils::Condition mWaiterCondition;
+#endif
 
-    std::atomic<uint32_t> mActiveJobs = { 0 };
-    utils::Arena<utils::ThreadSafeObjectPoolAllocator<Job>, LockingPolicy::NoLock> mJobPool;
+    // number of jobs waiting to be executed, for each lane
+    std::atomic<uint32_t> mActiveJobs[LANE_COUNT] = {};
 
     template <typename T>
     using aligned_vector = std::vector<T, utils::STLAlignedAllocator<T>>;
@@ -376,10 +468,19 @@ private:
 
     alignas(16) // at least we align to half (or quarter) cache-line
     aligned_vector<ThreadState> mThreadStates;          // actual data is stored offline
+
+    struct JobChunk {
+        explicit JobChunk(const char* name) noexcept;
+        utils::Arena<utils::ThreadSafeObjectPoolAllocator<Job>, LockingPolicy::NoLock> pool;
+        Job* const base;                                // Base for conversion to indices
+    };
+    std::atomic<JobChunk*> mJobChunks[MAX_JOB_CHUNK_COUNT] = {};
+    std::atomic<uint32_t> mJobChunkCount = { 0 };       // this one is almost never written
+    utils::Mutex mJobChunkLock;                         // only taken to add a chunk
     std::atomic<bool> mExitRequested = { false };       // this one is almost never written
     std::atomic<uint16_t> mAdoptedThreads = { 0 };      // this one is almost never written
-    Job* const mJobStorageBase;                         // Base for conversion to indices
     uint16_t mThreadCount = 0;                          // total # of threads in the pool
+    uint16_t mIdleSpinCount = 0;                        // # of checks for work before parking
     uint8_t mParallelSplitCount = 0;                    // # of split allowable in parallel_for
     Job* mRootJob = nullptr;
 
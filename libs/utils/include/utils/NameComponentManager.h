@@ -102,7 +102,7 @@ public:
     // for backward binary compatibility reasons.
     size_t getComponentCount() const noexcept;
     Entity const* getEntities() const noexcept;
-    void gc(const EntityManager& em, size_t ratio = 4) noexcept;
+    void gc(const EntityManager& em, size_t budget = DEFAULT_GC_BUDGET) noexcept;
     /*! \endcond */
 
     /**
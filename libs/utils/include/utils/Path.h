@@ -265,6 +265,14 @@ public:
      */
     bool mkdirRecursive() const;
 
+    /**
+     * Deletes the directory denoted by the given path, which must be empty.
+     *
+     * @return True if directory was successfully deleted.
+     *         When false, errno should have details on actual error.
+     */
+    bool rmdir() const;
+
     /**
      * Deletes this file.
      *
@@ -20,10 +20,16 @@
 #include <utils/compiler.h>
 #include <utils/Entity.h>
 #include <utils/EntityManager.h>
+#include <utils/Mutex.h>
 #include <utils/StructureOfArrays.h>
 
 #include <tsl/robin_map.h>
 
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 #include <assert.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -47,13 +53,50 @@ template <typename ... Elements>
 class UTILS_PUBLIC SingleInstanceComponentManager {
 private:
 
-    // this is just to avoid using std::default_random_engine, since we're in a public header.
-    class default_random_engine {
-        uint32_t mState = 1u; // must be 0 < seed < 0x7fffffff
+    // Records the destroyed entities that have a component in this manager. The lock is only
+    // taken when a destroyed entity has a component.
+    class DestroyedEntityQueue : public EntityManager::Listener {
     public:
-        inline uint32_t operator()() noexcept {
-            return mState = uint32_t((uint64_t(mState) * 48271u) % 0x7fffffffu);
+        DestroyedEntityQueue(EntityManager& em,
+                SingleInstanceComponentManager const& manager) noexcept
+                : mEntityManager(em), mManager(manager) {
+            em.registerListener(this);
+        }
+
+        ~DestroyedEntityQueue() noexcept {
+            mEntityManager.unregisterListener(this);
+        }
+
+        void onEntitiesDestroyed(size_t n, Entity const* entities) noexcept override {
+            std::unique_lock<Mutex> guard(mLock, std::defer_lock);
+            for (size_t i = 0; i < n; i++) {
+                if (mManager.hasComponent(entities[i])) {
+                    if (!guard.owns_lock()) {
+                        guard.lock();
+                    }
+                    mEntities.push_back(entities[i]);
+                }
+            }
         }
+
+        // appends the entities destroyed since the last call to `out`
+        void drain(std::vector<Entity>& out) noexcept {
+            std::lock_guard<Mutex> guard(mLock);
+            if (out.empty()) {
+                std::swap(out, mEntities);
+            } else {
+                out.insert(out.end(), mEntities.begin(), mEntities.end());
+                mEntities.clear();
+            }
+        }
+
+        EntityManager const& getEntityManager() const noexcept { return mEntityManager; }
+
+    private:
+        EntityManager& mEntityManager;
+        SingleInstanceComponentManager const& mManager;
+        Mutex mLock;
+        std::vector<Entity> mEntities;
     };
 
 protected:
@@ -86,12 +129,15 @@ public:
     }
 
     // Get instance of this Entity to be used to retrieve components
-    UTILS_NOINLINE
     Instance getInstance(Entity e) const noexcept {
-        auto const& map = mInstanceMap;
-        // find() generates quite a bit of code
-        auto pos = map.find(e);
-        return pos != map.end() ? pos->second : 0;
+        Instance const* const slot = getSlot(EntityManager::getEntityIndex(e));
+        Instance const ci = slot ? *slot : 0;
+        // the slot may belong to another generation of this entity index, the dummy component
+        // at index 0 holds a null entity, so this also works when the slot is empty.
+        if (UTILS_LIKELY(data<ENTITY_INDEX>()[ci] == e)) {
+            return ci;
+        }
+        return UTILS_UNLIKELY(!mDisplacedMap.empty()) ? getDisplacedInstance(e) : 0;
     }
 
     // returns the number of components (i.e. size of each arrays)
@@ -124,10 +170,19 @@ public:
     // This invalidates all pointers components.
     inline Instance removeComponent(Entity e);
 
+    // default maximum number of components removed by a call to gc()
+    static constexpr size_t DEFAULT_GC_BUDGET = 1024;
+
     // trigger one round of garbage collection. this is intended to be called on a regular
-    // basis. This gc gives up after it cannot randomly free 'ratio' component in a row.
-    void gc(const EntityManager& em, size_t ratio = 4) noexcept {
-        gc(em, ratio, [this](Entity e) {
+    // basis, always with the same EntityManager. The components of destroyed entities are
+    // removed in the order they were destroyed, gc() removes at most 'budget' components
+    // per call.
+    // After the first call, the destroyed entities that have a component are queued until the
+    // next call, so gc() must keep being called for as long as entities are destroyed. From
+    // then on, EntityManager::destroy() must not run concurrently with the functions adding
+    // or removing components, because it looks up the destroyed entities in this manager.
+    void gc(const EntityManager& em, size_t budget = DEFAULT_GC_BUDGET) noexcept {
+        gc(em, budget, [this](Entity e) {
                     removeComponent(e);
                 });
     }
@@ -216,48 +271,138 @@ protected:
         assert(i);
         assert(j);
         if (i && j) {
-            // update the index map
-            auto& map = mInstanceMap;
+            // update the index map, both locations must be found before either is updated
+            // because the two entities could share the same slot.
             Entity& ei = elementAt<ENTITY_INDEX>(i);
             Entity& ej = elementAt<ENTITY_INDEX>(j);
+            Instance* const li = ei ? locate(ei, i) : nullptr;
+            Instance* const lj = ej ? locate(ej, j) : nullptr;
             std::swap(ei, ej);
-            if (ei) {
-                map[ei] = i;
+            if (li) {
+                *li = j;
             }
-            if (ej) {
-                map[ej] = j;
+            if (lj) {
+                *lj = i;
             }
         }
     }
 
     template<typename REMOVE>
-    void gc(const EntityManager& em, size_t ratio,
+    void gc(const EntityManager& em, size_t budget,
             REMOVE removeComponent) noexcept {
-        Entity const* entities = getEntities();
-        size_t count = getComponentCount();
-        size_t aliveInARow = 0;
-        default_random_engine& rng = mRng;
-        UTILS_NOUNROLL
-        while (count && aliveInARow < ratio) {
-            // note: using the modulo favorizes lower number
-            size_t i = rng() % count;
-            if (UTILS_LIKELY(em.isAlive(entities[i]))) {
-                ++aliveInARow;
-                continue;
+        if (UTILS_UNLIKELY(!mDestroyedEntityQueue)) {
+            // The first time around, we start listening to destroyed entities and then remove
+            // the components of the entities destroyed until now, which the queue could have
+            // missed. Registering a listener doesn't modify the entities, hence the const_cast.
+            mDestroyedEntityQueue.reset(
+                    new DestroyedEntityQueue(const_cast<EntityManager&>(em), *this));
+            // removing a component moves the last one in its place, so we iterate backward
+            for (size_t i = getComponentCount(); i--;) {
+                Entity const e = getEntities()[i];
+                if (!em.isAlive(e)) {
+                    removeComponent(e);
+                }
             }
-            aliveInARow = 0;
-            count--;
-            removeComponent(entities[i]);
         }
+        assert(&mDestroyedEntityQueue->getEntityManager() == &em);
+
+        // The queued entities had a component when they were destroyed, but it may have been
+        // removed since, so only the removed components count against the budget.
+        std::vector<Entity>& pending = mPendingEntities;
+        mDestroyedEntityQueue->drain(pending);
+        size_t cursor = mPendingEntitiesCursor;
+        while (budget && cursor < pending.size()) {
+            Entity const e = pending[cursor++];
+            if (hasComponent(e)) {
+                removeComponent(e);
+                budget--;
+            }
+        }
+
+        // The processed entities are dropped only once they're at least half of the vector,
+        // so each entity is moved at most once on average.
+        if (cursor == pending.size()) {
+            pending.clear();
+            cursor = 0;
+        } else if (cursor >= pending.size() - cursor) {
+            pending.erase(pending.begin(), pending.begin() + cursor);
+            cursor = 0;
+        }
+        mPendingEntitiesCursor = cursor;
     }
 
 protected:
     SoA mData;
 
 private:
-    // maps an entity to an instance index
-    tsl::robin_map<Entity, Instance> mInstanceMap;
-    default_random_engine mRng;
+    // The entity to instance map is a table indexed by the entity index, allocated by pages
+    // of 1024 instances (4 KiB) as needed.
+    static constexpr size_t INSTANCE_PAGE_SHIFT = 10;
+    static constexpr size_t INSTANCE_PAGE_SIZE = 1u << INSTANCE_PAGE_SHIFT;
+    static constexpr size_t INSTANCE_PAGE_MASK = INSTANCE_PAGE_SIZE - 1u;
+
+    Instance const* getSlot(size_t index) const noexcept {
+        size_t const page = index >> INSTANCE_PAGE_SHIFT;
+        if (UTILS_LIKELY(page < mInstancePages.size())) {
+            Instance const* const p = mInstancePages[page].get();
+            if (UTILS_LIKELY(p)) {
+                return p + (index & INSTANCE_PAGE_MASK);
+            }
+        }
+        return nullptr;
+    }
+
+    Instance& getOrCreateSlot(size_t index) {
+        size_t const page = index >> INSTANCE_PAGE_SHIFT;
+        if (UTILS_UNLIKELY(page >= mInstancePages.size())) {
+            mInstancePages.resize(page + 1);
+        }
+        std::unique_ptr<Instance[]>& p = mInstancePages[page];
+        if (UTILS_UNLIKELY(!p)) {
+            p.reset(new Instance[INSTANCE_PAGE_SIZE]());
+        }
+        return p[index & INSTANCE_PAGE_MASK];
+    }
+
+    // returns where the given entity's instance ci is recorded
+    Instance* locate(Entity e, Instance ci) noexcept {
+        Instance* const slot = const_cast<Instance*>(getSlot(EntityManager::getEntityIndex(e)));
+        if (UTILS_LIKELY(slot && *slot == ci)) {
+            return slot;
+        }
+        auto pos = mDisplacedMap.find(e);
+        assert(pos != mDisplacedMap.end());
+        return &pos.value();
+    }
+
+    // forgets where the given entity's instance ci is recorded
+    void unmap(Entity e, Instance ci) noexcept {
+        Instance* const slot = const_cast<Instance*>(getSlot(EntityManager::getEntityIndex(e)));
+        if (UTILS_LIKELY(slot && *slot == ci)) {
+            *slot = 0;
+        } else {
+            mDisplacedMap.erase(e);
+        }
+    }
+
+    UTILS_NOINLINE
+    Instance getDisplacedInstance(Entity e) const noexcept {
+        auto const& map = mDisplacedMap;
+        // find() generates quite a bit of code
+        auto pos = map.find(e);
+        return pos != map.end() ? pos->second : 0;
+    }
+
+    // maps an entity index to an instance
+    std::vector<std::unique_ptr<Instance[]>> mInstancePages;
+    // Components of destroyed entities (not garbage collected yet) whose slot was reused by
+    // a newer entity with the same index. This is usually empty.
+    tsl::robin_map<Entity, Instance> mDisplacedMap;
+    // created by the first call to gc()
+    std::unique_ptr<DestroyedEntityQueue> mDestroyedEntityQueue;
+    // destroyed entities, gc() hasn't processed those past the cursor yet
+    std::vector<Entity> mPendingEntities;
+    size_t mPendingEntitiesCursor = 0;
 };
 
 // Keep these outside of the class because CLion has trouble parsing them
@@ -266,15 +411,19 @@ typename SingleInstanceComponentManager<Elements ...>::Instance
 SingleInstanceComponentManager<Elements ...>::addComponent(Entity e) {
     Instance ci = 0;
     if (!e.isNull()) {
-        if (!hasComponent(e)) {
+        ci = getInstance(e);
+        if (!ci) {
+            Instance& slot = getOrCreateSlot(EntityManager::getEntityIndex(e));
             // this is like a push_back(e);
             mData.push_back().template back<ENTITY_INDEX>() = e;
             // index 0 is used when the component doesn't exist
             ci = Instance(mData.size() - 1);
-            mInstanceMap[e] = ci;
-        } else {
-            // if the entity already has this component, just return its instance
-            ci = mInstanceMap[e];
+            if (UTILS_UNLIKELY(slot)) {
+                // the slot is used by a destroyed entity with the same index, which hasn't been
+                // garbage collected yet. Move it out of the way.
+                mDisplacedMap[elementAt<ENTITY_INDEX>(slot)] = slot;
+            }
+            slot = ci;
         }
     }
     assert(ci != 0);
@@ -285,11 +434,10 @@ SingleInstanceComponentManager<Elements ...>::addComponent(Entity e) {
 template <typename ... Elements>
 typename SingleInstanceComponentManager<Elements ...>::Instance
 SingleInstanceComponentManager<Elements ... >::removeComponent(Entity e) {
-    auto& map = mInstanceMap;
-    auto pos = map.find(e);
-    if (UTILS_LIKELY(pos != map.end())) {
-        size_t index = pos->second;
-        assert(index != 0);
+    Instance const index = getInstance(e);
+    if (UTILS_LIKELY(index)) {
+        // this must happen first, in case e and lastEntity share the same slot
+        unmap(e, index);
         size_t last = mData.size() - 1;
         if (last != index) {
             // move the last item to where we removed this component, as to keep
@@ -299,10 +447,9 @@ SingleInstanceComponentManager<Elements ... >::removeComponent(Entity e) {
             });
 
             Entity lastEntity = mData.template elementAt<ENTITY_INDEX>(index);
-            map[lastEntity] = index;
+            *locate(lastEntity, Instance(last)) = index;
         }
         mData.pop_back();
-        map.erase(pos);
         return last;
     }
     return 0;
@@ -24,7 +24,7 @@
 #define SYSTRACE_TAG_JOBSYSTEM      (1<<2)
 
 
-#if defined(__ANDROID__)
+#if defined(__ANDROID__) || (defined(__linux__) && defined(FILAMENT_ENABLE_SYSTRACE))
 
 #include <atomic>
 
@@ -107,6 +107,8 @@
 namespace utils {
 namespace details {
 
+#if defined(__ANDROID__)
+
 class Systrace {
 public:
 
@@ -228,6 +230,99 @@ private:
     static void int64_body(int fd, int pid, const char* name, int64_t value) noexcept;
 };
 
+#else // !ANDROID
+
+/*
+ * On Linux, the trace events are recorded into per-thread ring buffers which are written out as
+ * Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev) when the process exits, or when
+ * flush() is called. Recording is only enabled when the FILAMENT_SYSTRACE_FILE environment
+ * variable is set to the path of the file to write.
+ */
+class Systrace {
+public:
+
+    enum tags {
+        NEVER       = SYSTRACE_TAG_NEVER,
+        ALWAYS      = SYSTRACE_TAG_ALWAYS,
+        FILAMENT    = SYSTRACE_TAG_FILAMENT,
+        JOBSYSTEM   = SYSTRACE_TAG_JOBSYSTEM
+        // we could define more TAGS here, as we need them.
+    };
+
+    Systrace(uint32_t tag) noexcept {
+        if (tag) init(tag);
+    }
+
+    static void enable(uint32_t tags) noexcept;
+    static void disable(uint32_t tags) noexcept;
+
+    // Writes all the events recorded so far to the trace file. Returns false on error.
+    static bool flush() noexcept;
+
+    inline void traceBegin(uint32_t tag, const char* name) noexcept {
+        if (tag && UTILS_UNLIKELY(mIsTracingEnabled)) {
+            record(EventType::BEGIN, name, 0);
+        }
+    }
+
+    inline void traceEnd(uint32_t tag) noexcept {
+        if (tag && UTILS_UNLIKELY(mIsTracingEnabled)) {
+            record(EventType::END, nullptr, 0);
+        }
+    }
+
+    inline void asyncBegin(uint32_t tag, const char* name, int32_t cookie) noexcept {
+        if (tag && UTILS_UNLIKELY(mIsTracingEnabled)) {
+            record(EventType::ASYNC_BEGIN, name, cookie);
+        }
+    }
+
+    inline void asyncEnd(uint32_t tag, const char* name, int32_t cookie) noexcept {
+        if (tag && UTILS_UNLIKELY(mIsTracingEnabled)) {
+            record(EventType::ASYNC_END, name, cookie);
+        }
+    }
+
+    inline void value(uint32_t tag, const char* name, int32_t value) noexcept {
+        if (tag && UTILS_UNLIKELY(mIsTracingEnabled)) {
+            record(EventType::COUNTER, name, value);
+        }
+    }
+
+    inline void value(uint32_t tag, const char* name, int64_t value) noexcept {
+        if (tag && UTILS_UNLIKELY(mIsTracingEnabled)) {
+            record(EventType::COUNTER, name, value);
+        }
+    }
+
+private:
+    friend class ScopedTrace;
+
+    enum class EventType : uint8_t {
+        BEGIN, END, ASYNC_BEGIN, ASYNC_END, COUNTER
+    };
+
+    struct GlobalState {
+        bool isTracingAvailable;
+        std::atomic<uint32_t> isTracingEnabled;
+    };
+
+    static GlobalState sGlobalState;
+
+    void init(uint32_t tag) noexcept;
+
+    // cached values for faster access, no need to be initialized
+    bool mIsTracingEnabled;
+
+    static void setup() noexcept;
+    static void init_once() noexcept;
+    static bool isTracingEnabled(uint32_t tag) noexcept;
+
+    static void record(EventType type, const char* name, int64_t value) noexcept;
+};
+
+#endif // ANDROID
+
 // ------------------------------------------------------------------------------------------------
 
 class ScopedTrace {
@@ -258,7 +353,7 @@ private:
 } // namespace utils
 
 // ------------------------------------------------------------------------------------------------
-#else // !ANDROID
+#else // !ANDROID && !FILAMENT_ENABLE_SYSTRACE
 // ------------------------------------------------------------------------------------------------
 
 #define SYSTRACE_ENABLE()
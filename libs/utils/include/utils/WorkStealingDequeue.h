@@ -17,6 +17,8 @@
 #ifndef TNT_UTILS_WORKSTEALINGDEQUEUE_H
 #define TNT_UTILS_WORKSTEALINGDEQUEUE_H
 
+#include <utils/compiler.h>
+
 #include <atomic>
 
 #include <assert.h>
@@ -25,7 +27,7 @@
 namespace utils {
 
 /*
- * A templated, lockless, fixed-size work-stealing dequeue
+ * A templated, lockless, growable work-stealing dequeue
  *
  *
  *     top                          bottom
@@ -34,36 +36,65 @@ namespace utils {
  *    steal()                      push(), pop()
  *  any thread                     main thread
  *
+ * COUNT is the initial capacity, which is stored inline. When push() finds the dequeue full,
+ * the items are copied into a buffer twice as large. Retired buffers can still be read by a
+ * concurrent steal(), so they're only freed with the dequeue; the capacity never shrinks.
  *
  */
 template <typename TYPE, size_t COUNT>
 class WorkStealingDequeue {
-    static_assert(!(COUNT & (COUNT - 1)), "COUNT must be a power of two");
-    static constexpr size_t MASK = COUNT - 1;
+    static_assert(COUNT && !(COUNT & (COUNT - 1)), "COUNT must be a power of two");
 
     // mTop and mBottom must be signed integers. We use 64-bits atomics so we don't have
     // to worry about wrapping around.
     using index_t = int64_t;
 
+    struct Buffer {
+        size_t mask;
+        std::atomic<TYPE>* items;
+        Buffer* previous;   // the buffer this one replaced, freed with the dequeue
+    };
+
     std::atomic<index_t> mTop    = { 0 };   // written/read in pop()/steal()
     std::atomic<index_t> mBottom = { 0 };   // written only in pop(), read in push(), steal()
+    std::atomic<Buffer*> mBuffer;           // written only in push(), read in pop(), steal()
 
-    TYPE mItems[COUNT];
+    Buffer mInitialBuffer = { COUNT - 1, mItems, nullptr };
+    // Items are atomics because steal() can read an item that's being overwritten by push(),
+    // in which case steal() fails and the item is discarded. memory_order_relaxed is always
+    // enough, items are published by mBottom and mBuffer.
+    std::atomic<TYPE> mItems[COUNT];
 
     // NOTE: it's not safe to return a reference because getItemAt() can be called
     // concurrently and the caller could std::move() the item unsafely.
-    TYPE getItemAt(index_t index) noexcept { return mItems[index & MASK]; }
+    static TYPE getItemAt(Buffer const* buffer, index_t index) noexcept {
+        return buffer->items[index & buffer->mask].load(std::memory_order_relaxed);
+    }
 
-    void setItemAt(index_t index, TYPE item) noexcept { mItems[index & MASK] = item; }
+    static void setItemAt(Buffer* buffer, index_t index, TYPE item) noexcept {
+        buffer->items[index & buffer->mask].store(item, std::memory_order_relaxed);
+    }
+
+    UTILS_NOINLINE
+    Buffer* grow(Buffer* buffer, index_t top, index_t bottom) noexcept;
 
 public:
     using value_type = TYPE;
 
+    WorkStealingDequeue() noexcept : mBuffer(&mInitialBuffer) { }
+    ~WorkStealingDequeue() noexcept;
+
+    WorkStealingDequeue(WorkStealingDequeue const&) = delete;
+    WorkStealingDequeue& operator=(WorkStealingDequeue const&) = delete;
+
     inline void push(TYPE item) noexcept;
     inline TYPE pop() noexcept;
     inline TYPE steal() noexcept;
 
-    size_t getSize() const noexcept { return COUNT; }
+    // current capacity, grows as needed
+    size_t getSize() const noexcept {
+        return mBuffer.load(std::memory_order_relaxed)->mask + 1;
+    }
 
     // for debugging only...
     size_t getCount() const noexcept {
@@ -83,7 +114,14 @@ void WorkStealingDequeue<TYPE, COUNT>::push(TYPE item) noexcept {
     // std::memory_order_relaxed is sufficient because this load doesn't acquire anything from
     // another thread. mBottom is only written in pop() which cannot be concurrent with push()
     index_t bottom = mBottom.load(std::memory_order_relaxed);
-    setItemAt(bottom, item);
+    Buffer* buffer = mBuffer.load(std::memory_order_relaxed);
+
+    // A stale mTop can only make the dequeue look fuller than it is, relaxed is enough.
+    index_t top = mTop.load(std::memory_order_relaxed);
+    if (UTILS_UNLIKELY(bottom - top > index_t(buffer->mask))) {
+        buffer = grow(buffer, top, bottom);
+    }
+    setItemAt(buffer, bottom, item);
 
     // std::memory_order_release is used because we release the item we just pushed to other
     // threads which are calling steal().
@@ -115,15 +153,18 @@ TYPE WorkStealingDequeue<TYPE, COUNT>::pop() noexcept {
     //  (i.e. other thread's writes of mTop don't publish data)
     index_t top = mTop.load(std::memory_order_seq_cst);
 
+    // std::memory_order_relaxed is sufficient, mBuffer is only written in push()
+    Buffer const* const buffer = mBuffer.load(std::memory_order_relaxed);
+
     if (top < bottom) {
         // Queue isn't empty and it's not the last item, just return it, this is the common case.
-        return getItemAt(bottom);
+        return getItemAt(buffer, bottom);
     }
 
     TYPE item{};
     if (top == bottom) {
         // we just took the last item
-        item = getItemAt(bottom);
+        item = getItemAt(buffer, bottom);
 
         // Because we know we took the last item, we could be racing with steal() -- the last
         // item being both at the top and bottom of the queue.
@@ -183,8 +224,12 @@ TYPE WorkStealingDequeue<TYPE, COUNT>::steal() noexcept {
             return TYPE();
         }
 
-        // The queue isn't empty
-        TYPE item(getItemAt(top));
+        // The queue isn't empty.
+        // std::memory_order_acquire is needed because we're acquiring the items copied in grow().
+        // Any buffer we can observe here holds the item at top: retired buffers are never
+        // written again, and the item was copied before the new buffer was published.
+        Buffer const* const buffer = mBuffer.load(std::memory_order_acquire);
+        TYPE item(getItemAt(buffer, top));
         if (mTop.compare_exchange_strong(top, top + 1,
                 std::memory_order_seq_cst,
                 std::memory_order_relaxed)) {
@@ -196,6 +241,37 @@ TYPE WorkStealingDequeue<TYPE, COUNT>::steal() noexcept {
     }
 }
 
+template <typename TYPE, size_t COUNT>
+WorkStealingDequeue<TYPE, COUNT>::~WorkStealingDequeue() noexcept {
+    Buffer* buffer = mBuffer.load(std::memory_order_relaxed);
+    while (buffer != &mInitialBuffer) {
+        Buffer* const previous = buffer->previous;
+        delete [] buffer->items;
+        delete buffer;
+        buffer = previous;
+    }
+}
+
+/*
+ * Doubles the capacity of the queue. Called from push() when the queue is full.
+ *
+ * Must be called from the main thread.
+ */
+template <typename TYPE, size_t COUNT>
+typename WorkStealingDequeue<TYPE, COUNT>::Buffer* WorkStealingDequeue<TYPE, COUNT>::grow(
+        Buffer* buffer, index_t top, index_t bottom) noexcept {
+    size_t const capacity = (buffer->mask + 1) * 2;
+    Buffer* const next = new Buffer{ capacity - 1, new std::atomic<TYPE>[capacity], buffer };
+    // Items in [top, bottom) may be stolen while we copy them, in which case their copy is
+    // simply never read.
+    for (index_t i = top; i < bottom; i++) {
+        setItemAt(next, i, getItemAt(buffer, i));
+    }
+    // std::memory_order_release is used because we release the items we just copied to other
+    // threads which are calling steal().
+    mBuffer.store(next, std::memory_order_release);
+    return next;
+}
 
 } // namespace utils
 
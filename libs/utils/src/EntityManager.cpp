@@ -20,14 +20,12 @@
 
 namespace utils {
 
-EntityManager::EntityManager()
-        : mGens(new uint8_t[RAW_INDEX_COUNT]) {
-    // initialize all the generations to 0
-    std::fill_n(mGens, RAW_INDEX_COUNT, 0);
-}
+EntityManager::EntityManager() = default;
 
 EntityManager::~EntityManager() {
-    delete [] mGens;
+    for (auto& page : mGens) {
+        delete [] page.load(std::memory_order_relaxed);
+    }
 }
 
 EntityManager::Listener::~Listener() noexcept = default;
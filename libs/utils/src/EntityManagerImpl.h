@@ -24,6 +24,7 @@
 #include <utils/Mutex.h>
 #include <utils/CallStack.h>
 #include <utils/FixedCapacityVector.h>
+#include <utils/Slice.h>
 
 #include <tsl/robin_set.h>
 
@@ -31,6 +32,8 @@
 #include <tsl/robin_map.h>
 #endif
 
+#include <algorithm>
+#include <atomic>
 #include <deque>
 #include <mutex> // for std::lock_guard
 #include <vector>
@@ -50,47 +53,67 @@ public:
 
     UTILS_NOINLINE
     void create(size_t n, Entity* entities) {
-        Entity::Type index{};
-        auto& freeList = mFreeList;
-        uint8_t* const gens = mGens;
+        size_t i = 0;
+
+        // In the common case, we just grab a range of never used indices, this doesn't require a
+        // lock. This works only until all indices have been used once, at which point we're always
+        // in the slower case below. The idea is that we have enough indices that it doesn't
+        // happen in practice.
+        // If we have more than a certain number of freed indices, we get them from the list
+        // instead. This is a trade-off between how often we recycle indices and how large the
+        // free list can grow.
+        if (UTILS_LIKELY(mFreeListSize.load(std::memory_order_relaxed) < MIN_FREE_INDICES &&
+                mCurrentIndex.load(std::memory_order_relaxed) < RAW_INDEX_COUNT)) {
+            const size_t first = mCurrentIndex.fetch_add(n, std::memory_order_relaxed);
+            const size_t last = std::min(first + n, RAW_INDEX_COUNT);
+            for (size_t index = first; index < last; index++) {
+                entities[i++] = Entity{ makeIdentity(getNewGeneration(index), index) };
+            }
+#if FILAMENT_UTILS_TRACK_ENTITIES
+            std::lock_guard<Mutex> lock(mFreeListLock);
+            for (size_t j = 0; j < i; j++) {
+                mDebugActiveEntities.emplace(entities[j], CallStack::unwind(5));
+            }
+#endif
+            if (UTILS_LIKELY(i == n)) {
+                return;
+            }
+        }
 
         // this must be thread-safe, acquire the free-list mutex
+        auto& freeList = mFreeList;
         std::lock_guard<Mutex> lock(mFreeListLock);
-        Entity::Type currentIndex = mCurrentIndex;
-        for (size_t i = 0; i < n; i++) {
-            // If we have more than a certain number of freed indices, get one from the list.
-            // this is a trade-off between how often we recycle indices and how large the free list
-            // can grow.
-            if (UTILS_UNLIKELY(currentIndex >= RAW_INDEX_COUNT || freeList.size() >= MIN_FREE_INDICES)) {
-
-                // this could only happen if we had gone through all the indices at least once
+        for (; i < n; i++) {
+            // Same trade-off as above, decided for each index: the free list is only used while
+            // it holds at least MIN_FREE_INDICES, or once all indices have been used.
+            const size_t next = freeList.size() < MIN_FREE_INDICES &&
+                    mCurrentIndex.load(std::memory_order_relaxed) < RAW_INDEX_COUNT ?
+                    mCurrentIndex.fetch_add(1, std::memory_order_relaxed) : RAW_INDEX_COUNT;
+            Entity::Type index;
+            if (next < RAW_INDEX_COUNT) {
+                index = Entity::Type(next);
+                getNewGeneration(index);
+            } else {
                 if (UTILS_UNLIKELY(freeList.empty())) {
-                    // return the null entity
+                    // this could only happen if we had gone through all the indices at least
+                    // once, return the null entity
                     entities[i] = {};
                     continue;
                 }
-
                 index = freeList.front();
                 freeList.pop_front();
-            } else {
-                // In the common case, we just grab the next index.
-                // This works only until all indices have been used once, at which point
-                // we're always in the slower case above. The idea is that we have enough indices
-                // that it doesn't happen in practice.
-                index = currentIndex++;
             }
-            entities[i] = Entity{ makeIdentity(gens[index], index) };
+            entities[i] = Entity{ makeIdentity(getGenerationForIndex(index), index) };
 #if FILAMENT_UTILS_TRACK_ENTITIES
             mDebugActiveEntities.emplace(entities[i], CallStack::unwind(5));
 #endif
         }
-        mCurrentIndex = currentIndex;
+        mFreeListSize.store(uint32_t(freeList.size()), std::memory_order_relaxed);
     }
 
     UTILS_NOINLINE
     void destroy(size_t n, Entity* entities) noexcept {
         auto& freeList = mFreeList;
-        uint8_t* const gens = mGens;
 
         std::unique_lock<Mutex> lock(mFreeListLock);
         for (size_t i = 0; i < n; i++) {
@@ -113,30 +136,40 @@ public:
                 // and entities work as weak references -- it just means that isAlive() could return
                 // true a little longer than expected in some other threads.
                 // We do need a memory fence though, it is provided by the mFreeListLock.unlock() below.
-                gens[index]++;
+                uint8_t* const page = mGens[index >> GENERATION_PAGE_SHIFT].load(
+                        std::memory_order_relaxed);
+                page[index & GENERATION_PAGE_MASK]++;
 
 #if FILAMENT_UTILS_TRACK_ENTITIES
                 mDebugActiveEntities.erase(entities[i]);
 #endif
             }
         }
+        mFreeListSize.store(uint32_t(freeList.size()), std::memory_order_relaxed);
         lock.unlock();
 
-        // notify our listeners that some entities are being destroyed
-        auto listeners = getListeners();
-        for (auto const& l : listeners) {
-            l->onEntitiesDestroyed(n, entities);
+        // notify our listeners that some entities are being destroyed, the whole batch is
+        // reported with a single callback per listener.
+        if (UTILS_UNLIKELY(mListenerCount.load(std::memory_order_relaxed))) {
+            Listener* inlineListeners[INLINE_LISTENER_COUNT];
+            utils::FixedCapacityVector<Listener*> heapListeners;
+            Slice<Listener*> listeners = getListeners(inlineListeners, heapListeners);
+            for (auto const& l : listeners) {
+                l->onEntitiesDestroyed(n, entities);
+            }
         }
     }
 
     void registerListener(EntityManager::Listener* l) noexcept {
         std::lock_guard<Mutex> lock(mListenerLock);
         mListeners.insert(l);
+        mListenerCount.store(uint32_t(mListeners.size()), std::memory_order_relaxed);
     }
 
     void unregisterListener(EntityManager::Listener* l) noexcept {
         std::lock_guard<Mutex> lock(mListenerLock);
         mListeners.erase(l);
+        mListenerCount.store(uint32_t(mListeners.size()), std::memory_order_relaxed);
     }
 
 #if FILAMENT_UTILS_TRACK_ENTITIES
@@ -159,16 +192,45 @@ public:
 #endif
 
 private:
-    utils::FixedCapacityVector<EntityManager::Listener*> getListeners() const noexcept {
+    static constexpr size_t INLINE_LISTENER_COUNT = 8;
+
+    // Returns a copy of the listeners, in `storage` if they fit, in `heap` otherwise.
+    Slice<Listener*> getListeners(Listener* (&storage)[INLINE_LISTENER_COUNT],
+            utils::FixedCapacityVector<Listener*>& heap) const noexcept {
         std::lock_guard<Mutex> lock(mListenerLock);
         tsl::robin_set<Listener*> const& listeners = mListeners;
-        utils::FixedCapacityVector<EntityManager::Listener*> result(listeners.size());
-        result.resize(result.capacity()); // unfortunately this memset()
-        std::copy(listeners.begin(), listeners.end(), result.begin());
-        return result; // the c++ standard guarantees a move
+        Listener** result = storage;
+        if (UTILS_UNLIKELY(listeners.size() > INLINE_LISTENER_COUNT)) {
+            heap = utils::FixedCapacityVector<Listener*>(listeners.size());
+            heap.resize(heap.capacity()); // unfortunately this memset()
+            result = heap.data();
+        }
+        std::copy(listeners.begin(), listeners.end(), result);
+        return { result, Slice<Listener*>::size_type(listeners.size()) };
+    }
+
+    // returns the generation of an index used for the first time, allocating its page if needed
+    uint8_t getNewGeneration(size_t index) {
+        std::atomic<uint8_t*>& slot = mGens[index >> GENERATION_PAGE_SHIFT];
+        uint8_t* page = slot.load(std::memory_order_acquire);
+        if (UTILS_UNLIKELY(!page)) {
+            // first use of this page of indices, all generations start at 0. Several threads
+            // can race here, only one of them publishes its page.
+            uint8_t* const newPage = new uint8_t[GENERATION_PAGE_SIZE]();
+            if (slot.compare_exchange_strong(page, newPage,
+                    std::memory_order_acq_rel, std::memory_order_acquire)) {
+                page = newPage;
+            } else {
+                delete [] newPage;
+            }
+        }
+        return page[index & GENERATION_PAGE_MASK];
     }
 
-    uint32_t mCurrentIndex = 1;
+    // next never used index, only grows (can go past RAW_INDEX_COUNT)
+    std::atomic<size_t> mCurrentIndex = { 1 };
+    std::atomic<uint32_t> mFreeListSize = { 0 };
+    std::atomic<uint32_t> mListenerCount = { 0 };
 
     // stores indices that got freed
     mutable Mutex mFreeListLock;
@@ -33,9 +33,17 @@ static constexpr bool DEBUG_FINISH_HANGS = false;
 #include <utils/Panic.h>
 #include <utils/Systrace.h>
 
+#include <algorithm>
+#include <limits>
 #include <random>
+#include <tuple>
 
 #include <math.h>
+#include <stdio.h>
+
+#if defined(__linux__)
+#    include "linux/futex.h"
+#endif
 
 #if !defined(WIN32)
 #    include <pthread.h>
@@ -70,6 +78,9 @@ static constexpr bool DEBUG_FINISH_HANGS = false;
 #   define HEAVY_SYSTRACE_VALUE32(name, v)
 #endif
 
+// number of times idle threads check for work before parking
+static constexpr size_t IDLE_SPIN_COUNT = 512;
+
 namespace utils {
 
 void JobSystem::setThreadName(const char* name) noexcept {
@@ -109,12 +120,106 @@ void JobSystem::setThreadAffinityById(size_t id) noexcept {
 #endif
 }
 
+JobSystem::JobChunk::JobChunk(const char* name) noexcept
+    : pool(name, JOB_CHUNK_SIZE * sizeof(Job)),
+      base(static_cast<Job *>(pool.getAllocator().getCurrent())) {
+}
+
+// parses a sysfs list of CPUs or nodes, e.g. "0-3,8-11"
+static std::vector<uint16_t> readSysfsList(const char* path) noexcept {
+    std::vector<uint16_t> list;
+    FILE* const file = fopen(path, "r");
+    if (file) {
+        unsigned int first, last;
+        while (fscanf(file, "%u", &first) == 1) {
+            last = first;
+            int c = fgetc(file);
+            if (c == '-') {
+                if (fscanf(file, "%u", &last) != 1) {
+                    break;
+                }
+                c = fgetc(file);
+            }
+            for (unsigned int i = first; i <= last && i <= std::numeric_limits<uint16_t>::max(); i++) {
+                list.push_back(uint16_t(i));
+            }
+            if (c != ',') {
+                break;
+            }
+        }
+        fclose(file);
+    }
+    return list;
+}
+
+static int readSysfsInt(const char* path, int defaultValue) noexcept {
+    int value = defaultValue;
+    FILE* const file = fopen(path, "r");
+    if (file) {
+        if (fscanf(file, "%d", &value) != 1) {
+            value = defaultValue;
+        }
+        fclose(file);
+    }
+    return value;
+}
+
+JobSystem::CpuTopology JobSystem::CpuTopology::fromSysfs(const char* root) noexcept {
+    CpuTopology topology;
+    char path[512];
+
+    snprintf(path, sizeof(path), "%s/cpu/online", root);
+    for (uint16_t id : readSysfsList(path)) {
+        Cpu cpu{ id, id, 0 };
+        // the last-level cache is the one with the highest level, CPUs sharing it are listed
+        int lastLevel = 0;
+        for (int index = 0; ; index++) {
+            snprintf(path, sizeof(path), "%s/cpu/cpu%u/cache/index%d/level", root, id, index);
+            int const level = readSysfsInt(path, -1);
+            if (level < 0) {
+                break;
+            }
+            if (level > lastLevel) {
+                snprintf(path, sizeof(path), "%s/cpu/cpu%u/cache/index%d/shared_cpu_list",
+                        root, id, index);
+                std::vector<uint16_t> const shared = readSysfsList(path);
+                if (!shared.empty()) {
+                    lastLevel = level;
+                    cpu.cacheDomain = *std::min_element(shared.begin(), shared.end());
+                }
+            }
+        }
+        topology.cpus.push_back(cpu);
+    }
+
+    // without NUMA support, all CPUs stay on node 0
+    snprintf(path, sizeof(path), "%s/node/online", root);
+    for (uint16_t node : readSysfsList(path)) {
+        snprintf(path, sizeof(path), "%s/node/node%u/cpulist", root, node);
+        for (uint16_t id : readSysfsList(path)) {
+            for (Cpu& cpu : topology.cpus) {
+                if (cpu.id == id) {
+                    cpu.numaNode = node;
+                }
+            }
+        }
+    }
+    return topology;
+}
+
 JobSystem::JobSystem(const size_t userThreadCount, const size_t adoptableThreadsCount) noexcept
-    : mJobPool("JobSystem Job pool", MAX_JOB_COUNT * sizeof(Job)),
-      mJobStorageBase(static_cast<Job *>(mJobPool.getAllocator().getCurrent()))
+    : JobSystem(userThreadCount, adoptableThreadsCount, CpuTopology{}) {
+}
+
+JobSystem::JobSystem(const size_t userThreadCount, const size_t adoptableThreadsCount,
+        CpuTopology const& topology) noexcept
 {
     SYSTRACE_ENABLE();
 
+    // the first chunk of jobs is always there
+    mJobChunks[0].store(new JobChunk("JobSystem Job pool"), std::memory_order_relaxed);
+    mJobChunkCount.store(1, std::memory_order_relaxed);
+
     int threadPoolCount = userThreadCount;
     if (threadPoolCount == 0) {
         // default value, system dependant
@@ -135,6 +240,8 @@ JobSystem::JobSystem(const size_t userThreadCount, const size_t adoptableThreads
 
     mThreadStates = aligned_vector<ThreadState>(threadPoolCount + adoptableThreadsCount);
     mThreadCount = uint16_t(threadPoolCount);
+    // spinning only makes sense if another CPU can post jobs in the meantime
+    mIdleSpinCount = std::thread::hardware_concurrency() > 1 ? IDLE_SPIN_COUNT : 0;
     mParallelSplitCount = (uint8_t)std::ceil((std::log2f(threadPoolCount + adoptableThreadsCount)));
 
     static_assert(std::atomic<bool>::is_always_lock_free);
@@ -144,6 +251,44 @@ JobSystem::JobSystem(const size_t userThreadCount, const size_t adoptableThreads
     const size_t hardwareThreadCount = mThreadCount;
     auto& states = mThreadStates;
 
+    for (size_t i = 0, n = states.size(); i < n; i++) {
+        states[i].cpu = uint16_t(i);
+    }
+
+    if (!topology.cpus.empty()) {
+        // place the workers so that consecutive workers share a cache domain and a node, this
+        // way domains are contiguous ranges of workers.
+        std::vector<CpuTopology::Cpu> cpus(topology.cpus);
+        std::sort(cpus.begin(), cpus.end(), [](auto const& lhs, auto const& rhs) {
+            return std::tie(lhs.numaNode, lhs.cacheDomain, lhs.id) <
+                   std::tie(rhs.numaNode, rhs.cacheDomain, rhs.id);
+        });
+        auto cpuOf = [&cpus](size_t i) -> CpuTopology::Cpu const& {
+            return cpus[i % cpus.size()];
+        };
+        for (size_t i = 0; i < hardwareThreadCount; i++) {
+            states[i].cpu = cpuOf(i).id;
+        }
+        // adopted threads aren't placed, so they only have the default range
+        auto setRanges = [&](StealRange ThreadState::*range, auto const& sameDomain) {
+            for (size_t first = 0, last; first < hardwareThreadCount; first = last) {
+                for (last = first + 1;
+                        last < hardwareThreadCount && sameDomain(cpuOf(first), cpuOf(last));
+                        last++) {
+                }
+                for (size_t i = first; i < last; i++) {
+                    states[i].*range = { uint16_t(first), uint16_t(last - first) };
+                }
+            }
+        };
+        setRanges(&ThreadState::cacheDomain, [](auto const& lhs, auto const& rhs) {
+            return lhs.numaNode == rhs.numaNode && lhs.cacheDomain == rhs.cacheDomain;
+        });
+        setRanges(&ThreadState::numaNode, [](auto const& lhs, auto const& rhs) {
+            return lhs.numaNode == rhs.numaNode;
+        });
+    }
+
     #pragma nounroll
     for (size_t i = 0, n = states.size(); i < n; i++) {
         auto& state = states[i];
@@ -167,6 +312,10 @@ JobSystem::~JobSystem() {
             state.thread.join();
         }
     }
+
+    for (size_t i = 0, c = mJobChunkCount.load(std::memory_order_relaxed); i < c; i++) {
+        delete mJobChunks[i].load(std::memory_order_relaxed);
+    }
 }
 
 inline void JobSystem::incRef(Job const* job) noexcept {
@@ -190,14 +339,13 @@ void JobSystem::decRef(Job const* job) noexcept {
     assert(c > 0);
     if (c == 1) {
         // This was the last reference, it's safe to destroy the job.
-        mJobPool.destroy(job);
+        freeJob(const_cast<Job*>(job));
     }
 }
 
 void JobSystem::requestExit() noexcept {
     mExitRequested.store(true);
-    std::lock_guard<Mutex> lock(mWaiterLock);
-    mWaiterCondition.notify_all();
+    wakeAll();
 }
 
 inline bool JobSystem::exitRequested() const noexcept {
@@ -206,26 +354,66 @@ inline bool JobSystem::exitRequested() const noexcept {
 }
 
 inline bool JobSystem::hasActiveJobs() const noexcept {
-    return mActiveJobs.load(std::memory_order_relaxed) > 0;
+    return hasActiveJobs(Lane::FRAME) || hasActiveJobs(Lane::BACKGROUND);
+}
+
+inline bool JobSystem::hasActiveJobs(Lane lane) const noexcept {
+    return mActiveJobs[size_t(lane)].load(std::memory_order_relaxed) > 0;
 }
 
 inline bool JobSystem::hasJobCompleted(JobSystem::Job const* job) noexcept {
     return job->runningJobCount.load(std::memory_order_acquire) <= 0;
 }
 
-void JobSystem::wait(std::unique_lock<Mutex>& lock, Job* job) noexcept {
-    if constexpr (!DEBUG_FINISH_HANGS) {
-        mWaiterCondition.wait(lock);
-    } else {
-        do {
-            // we use a pretty long timeout (4s) so we're very confident that the system is hung
-            // and nothing else is happening.
-            std::cv_status status = mWaiterCondition.wait_for(lock,
-                    std::chrono::milliseconds(4000));
-            if (status == std::cv_status::no_timeout) {
-                break;
-            }
+/*
+ * Threads park on mWaiterEpoch, which is incremented by each wake-up. A thread must call
+ * prepareWait() *before* checking whether it needs to wait, then either wait() or cancelWait().
+ * This way, wake-ups are lock-free and don't make a system call when no thread is parked.
+ */
+
+uint32_t JobSystem::prepareWait() noexcept {
+    mWaiterCount.fetch_add(1, std::memory_order_relaxed);
+    // pairs with the fence in wake(): either the caller will see the state that motivated a
+    // wake-up, or the waker will see the caller's mWaiterCount increment.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return mWaiterEpoch.load(std::memory_order_acquire);
+}
 
+void JobSystem::cancelWait() noexcept {
+    mWaiterCount.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void JobSystem::wait(uint32_t epoch, Job* job) noexcept {
+    HEAVY_SYSTRACE_CALL();
+    // we use a pretty long timeout (4s) so we're very confident that the system is hung
+    // and nothing else is happening.
+    constexpr std::chrono::milliseconds timeout(4000);
+    while (mWaiterEpoch.load(std::memory_order_acquire) == epoch) {
+        bool timedOut = false;
+#if defined(__linux__)
+        if constexpr (!DEBUG_FINISH_HANGS) {
+            linuxutil::futex_wait_ex(&mWaiterEpoch, false, epoch, false, nullptr);
+        } else {
+            // FUTEX_WAIT_BITSET timeouts are absolute, based on CLOCK_MONOTONIC
+            using namespace std::chrono;
+            uint64_t const ns = duration_cast<nanoseconds>(
+                    (steady_clock::now() + timeout).time_since_epoch()).count();
+            timespec ts{ decltype(timespec::tv_sec)(ns / 1000000000),
+                         decltype(timespec::tv_nsec)(ns % 1000000000) };
+            timedOut = linuxutil::futex_wait_ex(&mWaiterEpoch, false, epoch, false, &ts)
+                    == -ETIMEDOUT;
+        }
+#else
+        std::unique_lock<Mutex> lock(mWaiterLock);
+        if (mWaiterEpoch.load(std::memory_order_acquire) == epoch) {
+            if constexpr (!DEBUG_FINISH_HANGS) {
+                mWaiterCondition.wait(lock);
+            } else {
+                timedOut = mWaiterCondition.wait_for(lock, timeout) == std::cv_status::timeout;
+            }
+        }
+#endif
+        if (DEBUG_FINISH_HANGS && timedOut) {
             // hang debugging...
 
             // we check of we had active jobs or if the job we're waiting on had completed already.
@@ -233,7 +421,7 @@ void JobSystem::wait(std::unique_lock<Mutex>& lock, Job* job) noexcept {
             // confidence that we're in an incorrect state.
 
             auto id = getState().id;
-            auto activeJobs = mActiveJobs.load();
+            auto activeJobs = mActiveJobs[0].load() + mActiveJobs[1].load();
 
             if (job) {
                 auto runningJobCount = job->runningJobCount.load();
@@ -245,25 +433,47 @@ void JobSystem::wait(std::unique_lock<Mutex>& lock, Job* job) noexcept {
             ASSERT_POSTCONDITION(activeJobs <= 0,
                     "JobSystem(%p, %d): waiting while %d jobs are active!",
                     this, id, activeJobs);
+        }
+    }
+    mWaiterCount.fetch_sub(1, std::memory_order_relaxed);
+}
 
-        } while (true);
+void JobSystem::wake(int count) noexcept {
+    // pairs with the fence in prepareWait()
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (mWaiterCount.load(std::memory_order_relaxed) == 0) {
+        // nobody is parked, or about to park and will see our state changes
+        return;
     }
+    mWaiterEpoch.fetch_add(1, std::memory_order_release);
+#if defined(__linux__)
+    linuxutil::futex_wake_ex(&mWaiterEpoch, false, count);
+#else
+    std::lock_guard<Mutex> lock(mWaiterLock);
+    // this critical section guarantees that a waiter can't miss the notification between
+    // checking mWaiterEpoch and waiting on the condition.
+    mWaiterCondition.notify_n(size_t(count));
+#endif
 }
 
 void JobSystem::wakeAll() noexcept {
     HEAVY_SYSTRACE_CALL();
-    std::lock_guard<Mutex> lock(mWaiterLock);
-    // this empty critical section is needed -- it guarantees that notify_all() happens
-    // after the condition's variables are set.
-    mWaiterCondition.notify_all();
+    wake(std::numeric_limits<int>::max());
 }
 
 void JobSystem::wakeOne() noexcept {
     HEAVY_SYSTRACE_CALL();
-    std::lock_guard<Mutex> lock(mWaiterLock);
-    // this empty critical section is needed -- it guarantees that notify_one() happens
-    // after the condition's variables are set.
-    mWaiterCondition.notify_one();
+    wake(1);
+}
+
+void JobSystem::wake(Lane lane) noexcept {
+    // A thread waiting on a frame job doesn't pick up background jobs, so the one thread we'd
+    // wake might just go back to sleep, instead we wake everybody for background jobs.
+    if (lane == Lane::FRAME) {
+        wakeOne();
+    } else {
+        wakeAll();
+    }
 }
 
 inline JobSystem::ThreadState& JobSystem::getState() noexcept {
@@ -274,63 +484,119 @@ inline JobSystem::ThreadState& JobSystem::getState() noexcept {
 }
 
 JobSystem::Job* JobSystem::allocateJob() noexcept {
-    return mJobPool.make<Job>();
+    // memory_order_acquire is needed to see the chunks published by allocateJobChunk()
+    size_t const chunkCount = mJobChunkCount.load(std::memory_order_acquire);
+    // in the steady state, the first chunk is almost never full
+    for (size_t i = 0; i < chunkCount; i++) {
+        Job* const job = mJobChunks[i].load(std::memory_order_relaxed)->pool.make<Job>();
+        if (UTILS_LIKELY(job)) {
+            job->chunk = uint32_t(i);
+            return job;
+        }
+    }
+    return allocateJobChunk(chunkCount);
+}
+
+UTILS_NOINLINE
+JobSystem::Job* JobSystem::allocateJobChunk(size_t chunkCount) noexcept {
+    std::lock_guard<utils::Mutex> lock(mJobChunkLock);
+    // another thread might have added chunks while we were waiting for the lock
+    size_t const currentChunkCount = mJobChunkCount.load(std::memory_order_relaxed);
+    for (size_t i = chunkCount; i < currentChunkCount; i++) {
+        Job* const job = mJobChunks[i].load(std::memory_order_relaxed)->pool.make<Job>();
+        if (job) {
+            job->chunk = uint32_t(i);
+            return job;
+        }
+    }
+    if (UTILS_UNLIKELY(currentChunkCount == MAX_JOB_CHUNK_COUNT)) {
+        return nullptr;
+    }
+    SYSTRACE_NAME("JobSystem::allocateJobChunk");
+    JobChunk* const chunk = new JobChunk("JobSystem Job pool");
+    // allocate our job before publishing the chunk, so we can't be starved by other threads
+    Job* const job = chunk->pool.make<Job>();
+    job->chunk = uint32_t(currentChunkCount);
+    mJobChunks[currentChunkCount].store(chunk, std::memory_order_relaxed);
+    // memory_order_release publishes the chunk to allocateJob() and getJob()
+    mJobChunkCount.store(currentChunkCount + 1, std::memory_order_release);
+    return job;
+}
+
+void JobSystem::freeJob(Job* job) noexcept {
+    mJobChunks[job->chunk].load(std::memory_order_relaxed)->pool.destroy(job);
+}
+
+inline uint32_t JobSystem::getJobIndex(Job const* job) const noexcept {
+    // memory_order_relaxed is enough, the job was allocated in this chunk
+    JobChunk const* const chunk = mJobChunks[job->chunk].load(std::memory_order_relaxed);
+    assert(job >= chunk->base && job < chunk->base + JOB_CHUNK_SIZE);
+    return uint32_t(job->chunk * JOB_CHUNK_SIZE + (job - chunk->base));
+}
+
+inline JobSystem::Job* JobSystem::getJob(uint32_t index) const noexcept {
+    assert(index < MAX_JOB_COUNT);
+    // memory_order_relaxed is enough, the index was obtained from a job allocated in this chunk
+    JobChunk const* const chunk = mJobChunks[index / JOB_CHUNK_SIZE].load(std::memory_order_relaxed);
+    return chunk->base + index % JOB_CHUNK_SIZE;
 }
 
-void JobSystem::put(WorkQueue& workQueue, Job* job) noexcept {
+void JobSystem::put(ThreadState& state, Job* job) noexcept {
     assert(job);
-    size_t index = job - mJobStorageBase;
-    assert(index >= 0 && index < MAX_JOB_COUNT);
+    uint32_t const index = getJobIndex(job);
 
-    // put the job into the queue first
-    workQueue.push(uint16_t(index + 1));
+    // put the job into the queue of its lane first
+    Lane const lane = Lane(job->lane);
+    state.getWorkQueue(lane).push(index + 1);
     // then increase our active job count
-    uint32_t oldActiveJobs = mActiveJobs.fetch_add(1, std::memory_order_relaxed);
+    uint32_t oldActiveJobs = mActiveJobs[size_t(lane)].fetch_add(1, std::memory_order_relaxed);
     // but it's possible that the job has already been picked-up, so oldActiveJobs could be
     // negative for instance. We signal only if that's not the case.
     if (oldActiveJobs >= 0) {
-        wakeOne(); // wake-up a thread if needed...
+        wake(lane); // wake-up a thread if needed...
     }
 }
 
-JobSystem::Job* JobSystem::pop(WorkQueue& workQueue) noexcept {
+JobSystem::Job* JobSystem::pop(WorkQueue& workQueue, Lane lane) noexcept {
+    std::atomic<uint32_t>& activeJobs = mActiveJobs[size_t(lane)];
+
     // decrement mActiveJobs first, this is to ensure that if there is only a single job left
     // (and we're about to pick it up), other threads don't loop trying to do the same.
-    mActiveJobs.fetch_sub(1, std::memory_order_relaxed);
+    activeJobs.fetch_sub(1, std::memory_order_relaxed);
 
-    size_t index = workQueue.pop();
-    assert(index <= MAX_JOB_COUNT);
-    Job* job = !index ? nullptr : &mJobStorageBase[index - 1];
+    uint32_t const index = workQueue.pop();
+    Job* job = !index ? nullptr : getJob(index - 1);
 
     // if our guess was wrong, i.e. we couldn't pick-up a job (b/c our queue was empty), we
     // need to correct mActiveJobs.
     if (!job) {
-        if (mActiveJobs.fetch_add(1, std::memory_order_relaxed) >= 0) {
+        if (activeJobs.fetch_add(1, std::memory_order_relaxed) >= 0) {
             // and if there are some active jobs, then we need to wake someone up. We know it
             // can't be us, because we failed taking a job and we know another thread can't
             // have added one in our queue.
-            wakeOne();
+            wake(lane);
         }
     }
     return job;
 }
 
-JobSystem::Job* JobSystem::steal(WorkQueue& workQueue) noexcept {
+JobSystem::Job* JobSystem::steal(WorkQueue& workQueue, Lane lane) noexcept {
+    std::atomic<uint32_t>& activeJobs = mActiveJobs[size_t(lane)];
+
     // decrement mActiveJobs first, this is to ensure that if there is only a single job left
     // (and we're about to pick it up), other threads don't loop trying to do the same.
-    mActiveJobs.fetch_sub(1, std::memory_order_relaxed);
+    activeJobs.fetch_sub(1, std::memory_order_relaxed);
 
-    size_t index = workQueue.steal();
-    assert(index <= MAX_JOB_COUNT);
-    Job* job = !index ? nullptr : &mJobStorageBase[index - 1];
+    uint32_t const index = workQueue.steal();
+    Job* job = !index ? nullptr : getJob(index - 1);
 
     // if we failed taking a job, we need to correct mActiveJobs
     if (!job) {
-        if (mActiveJobs.fetch_add(1, std::memory_order_relaxed) >= 0) {
+        if (activeJobs.fetch_add(1, std::memory_order_relaxed) >= 0) {
             // and if there are some active jobs, then we need to wake someone up. We know it
             // can't be us, because we failed taking a job and we know another thread can't
             // have added one in our queue.
-            wakeOne();
+            wake(lane);
         }
     }
     return job;
@@ -347,9 +613,18 @@ inline JobSystem::ThreadState* JobSystem::getStateToStealFrom(JobSystem::ThreadS
 
     // don't try to steal from someone else if we're the only thread (infinite loop)
     if (threadCount >= 2) {
+        // with a topology, half of the attempts are within our cache domain and a quarter
+        // within our node. Ranges with fewer than two workers only contain us.
+        StealRange range{ 0, threadCount };
+        uint8_t const attempt = state.stealAttempt++ & 3u;
+        if (attempt < 2 && state.cacheDomain.count >= 2) {
+            range = state.cacheDomain;
+        } else if (attempt < 3 && state.numaNode.count >= 2) {
+            range = state.numaNode;
+        }
         do {
             // this is biased, but frankly, we don't care. it's fast.
-            uint16_t index = uint16_t(state.rndGen() % threadCount);
+            uint16_t index = range.first + uint16_t(state.rndGen() % range.count);
             assert(index < threadStates.size());
             stateToStealFrom = &threadStates[index];
             // don't steal from our own queue
@@ -358,27 +633,37 @@ inline JobSystem::ThreadState* JobSystem::getStateToStealFrom(JobSystem::ThreadS
     return stateToStealFrom;
 }
 
-JobSystem::Job* JobSystem::steal(JobSystem::ThreadState& state) noexcept {
+JobSystem::Job* JobSystem::steal(JobSystem::ThreadState& state, Lane lane) noexcept {
     HEAVY_SYSTRACE_CALL();
     Job* job = nullptr;
     do {
         ThreadState* const stateToStealFrom = getStateToStealFrom(state);
         if (UTILS_LIKELY(stateToStealFrom)) {
-            job = steal(stateToStealFrom->workQueue);
+            job = steal(stateToStealFrom->getWorkQueue(lane), lane);
         }
         // nullptr -> nothing to steal in that queue either, if there are active jobs,
-        // continue to try stealing one.
-    } while (!job && hasActiveJobs());
+        // continue to try stealing one. We give up on background jobs as soon as frame jobs
+        // become available.
+    } while (!job && hasActiveJobs(lane) &&
+            (lane == Lane::FRAME || !hasActiveJobs(Lane::FRAME)));
     return job;
 }
 
-bool JobSystem::execute(JobSystem::ThreadState& state) noexcept {
+bool JobSystem::execute(JobSystem::ThreadState& state, bool background) noexcept {
     HEAVY_SYSTRACE_CALL();
 
-    Job* job = pop(state.workQueue);
+    Job* job = pop(state.workQueue, Lane::FRAME);
     if (UTILS_UNLIKELY(job == nullptr)) {
         // our queue is empty, try to steal a job
-        job = steal(state);
+        job = steal(state, Lane::FRAME);
+    }
+
+    // background jobs are only considered when there are no frame jobs left
+    if (job == nullptr && background && hasActiveJobs(Lane::BACKGROUND)) {
+        job = pop(state.backgroundWorkQueue, Lane::BACKGROUND);
+        if (job == nullptr) {
+            job = steal(state, Lane::BACKGROUND);
+        }
     }
 
     if (job) {
@@ -399,7 +684,7 @@ void JobSystem::loop(ThreadState* state) noexcept {
 
     // set a CPU affinity on each of our JobSystem thread to prevent them from jumping from core
     // to core. On Android, it looks like the affinity needs to be reset from time to time.
-    setThreadAffinityById(state->id);
+    setThreadAffinityById(state->cpu);
 
     // record our work queue
     mThreadMapLock.lock();
@@ -410,10 +695,19 @@ void JobSystem::loop(ThreadState* state) noexcept {
     // run our main loop...
     do {
         if (!execute(*state)) {
-            std::unique_lock<Mutex> lock(mWaiterLock);
+            // spin for a little while first, new jobs often come right after
+            for (size_t i = 0, c = mIdleSpinCount;
+                    i < c && !exitRequested() && !hasActiveJobs(); i++) {
+                UTILS_PAUSE();
+            }
             while (!exitRequested() && !hasActiveJobs()) {
-                wait(lock);
-                setThreadAffinityById(state->id);
+                uint32_t const epoch = prepareWait();
+                if (exitRequested() || hasActiveJobs()) {
+                    cancelWait();
+                    break;
+                }
+                wait(epoch);
+                setThreadAffinityById(state->cpu);
             }
         }
     } while (!exitRequested());
@@ -426,7 +720,6 @@ void JobSystem::finish(Job* job) noexcept {
     bool notify = false;
 
     // terminate this job and notify its parent
-    Job* const storage = mJobStorageBase;
     do {
         // std::memory_order_release here is needed to synchronize with JobSystem::wait()
         // which needs to "see" all changes that happened before the job terminated.
@@ -435,7 +728,7 @@ void JobSystem::finish(Job* job) noexcept {
         if (runningJobCount == 1) {
             // no more work, destroy this job and notify its parent
             notify = true;
-            Job* const parent = job->parent == 0x7FFF ? nullptr : &storage[job->parent];
+            Job* const parent = job->parent == NO_PARENT ? nullptr : getJob(job->parent);
             decRef(job);
             job = parent;
         } else {
@@ -458,7 +751,7 @@ JobSystem::Job* JobSystem::create(JobSystem::Job* parent, JobFunc func) noexcept
     parent = (parent == nullptr) ? mRootJob : parent;
     Job* const job = allocateJob();
     if (UTILS_LIKELY(job)) {
-        size_t index = 0x7FFF;
+        uint32_t index = NO_PARENT;
         if (parent) {
             // add a reference to the parent to make sure it can't be terminated.
             // memory_order_relaxed is safe because no action is taken at this point
@@ -467,12 +760,14 @@ JobSystem::Job* JobSystem::create(JobSystem::Job* parent, JobFunc func) noexcept
 
             // can't create a child job of a terminated parent
             assert(parentJobCount > 0);
+            // runningJobCount would overflow
+            assert(parentJobCount < std::numeric_limits<uint16_t>::max());
 
-            index = parent - mJobStorageBase;
-            assert(index < MAX_JOB_COUNT);
+            index = getJobIndex(parent);
         }
         job->function = func;
-        job->parent = uint16_t(index);
+        job->parent = index;
+        job->lane = parent ? parent->lane : uint32_t(Lane::FRAME);
     }
     return job;
 }
@@ -502,7 +797,7 @@ void JobSystem::run(Job*& job) noexcept {
 
     ThreadState& state(getState());
 
-    put(state.workQueue, job);
+    put(state, job);
 
     // after run() returns, the job is virtually invalid (it'll die on its own)
     job = nullptr;
@@ -520,9 +815,12 @@ void JobSystem::waitAndRelease(Job*& job) noexcept {
     assert(job);
     assert(job->refCount.load(std::memory_order_relaxed) >= 1);
 
+    // while waiting on a frame job, we don't pick up background jobs which could delay us.
+    bool const background = Lane(job->lane) == Lane::BACKGROUND;
+
     ThreadState& state(getState());
     do {
-        if (!execute(state)) {
+        if (!execute(state, background)) {
             // test if job has completed first, to possibly avoid taking the lock
             if (hasJobCompleted(job)) {
                 break;
@@ -534,12 +832,21 @@ void JobSystem::waitAndRelease(Job*& job) noexcept {
             //    - yet our job hasn't completed yet
             //    ergo, it's being run in another thread
             //
-            // this could take time however, so we will wait with a condition, and
+            // this could take time however, so we will spin a little, then park, and
             // continue to handle more jobs, as they get added.
 
-            std::unique_lock<Mutex> lock(mWaiterLock);
-            if (!hasJobCompleted(job) && !hasActiveJobs() && !exitRequested()) {
-                wait(lock, job);
+            auto mustWait = [this, job, background]() {
+                bool const hasWork = background ? hasActiveJobs() : hasActiveJobs(Lane::FRAME);
+                return !hasJobCompleted(job) && !hasWork && !exitRequested();
+            };
+            for (size_t i = 0, c = mIdleSpinCount; i < c && mustWait(); i++) {
+                UTILS_PAUSE();
+            }
+            uint32_t const epoch = prepareWait();
+            if (mustWait()) {
+                wait(epoch, job);
+            } else {
+                cancelWait();
             }
         }
     } while (!hasJobCompleted(job) && !exitRequested());
@@ -602,7 +909,8 @@ void JobSystem::emancipate() {
 
 io::ostream& operator<<(io::ostream& out, JobSystem const& js) {
     for (auto const& item : js.mThreadStates) {
-        out << size_t(item.id) << ": " << item.workQueue.getCount() << io::endl;
+        out << size_t(item.id) << ": " << item.workQueue.getCount()
+            << " (" << item.backgroundWorkQueue.getCount() << " background)" << io::endl;
     }
     return out;
 }
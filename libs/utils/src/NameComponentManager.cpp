@@ -52,8 +52,8 @@ void NameComponentManager::removeComponent(Entity e) {
     SingleInstanceComponentManager::removeComponent(e);
 }
 
-void NameComponentManager::gc(const EntityManager& em, size_t ratio) noexcept {
-    SingleInstanceComponentManager::gc(em, ratio);
+void NameComponentManager::gc(const EntityManager& em, size_t budget) noexcept {
+    SingleInstanceComponentManager::gc(em, budget);
 }
 
 } // namespace utils
@@ -19,6 +19,7 @@
 #include <vector>
 
 #include <dirent.h>
+#include <unistd.h>
 #include <sys/stat.h>
 
 #include <mach-o/dyld.h>
@@ -31,6 +32,10 @@ bool Path::mkdir() const {
     return ::mkdir(m_path.c_str(), S_IRUSR | S_IWUSR | S_IXUSR) == 0;
 }
 
+bool Path::rmdir() const {
+    return ::rmdir(m_path.c_str()) == 0;
+}
+
 Path Path::getCurrentExecutable() {
     // First, need to establish resource path.
     char exec_buf[2048];
@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <utils/Systrace.h>
+
+#if defined(FILAMENT_ENABLE_SYSTRACE)
+
+#include <utils/Log.h>
+
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <new>
+
+#include <string.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace utils {
+namespace details {
+
+namespace {
+
+// Events are 64 bytes, so each thread uses 1 MiB of trace buffer.
+constexpr uint32_t EVENT_COUNT = 16384;
+static_assert(!(EVENT_COUNT & (EVENT_COUNT - 1)), "EVENT_COUNT must be a power of two");
+
+struct Event {
+    uint64_t timestamp;     // in nanoseconds
+    int64_t value;          // counter value or async cookie
+    uint8_t type;
+    // names are copied because they're not always literals
+    char name[64 - sizeof(uint64_t) - sizeof(int64_t) - sizeof(uint8_t)];
+};
+static_assert(sizeof(Event) == 64);
+
+// A ring buffer written only by its owner thread. Buffers are never freed so that the events
+// of threads that have exited can still be written out.
+struct ThreadBuffer {
+    ThreadBuffer* next = nullptr;
+    pid_t tid = 0;
+    char threadName[16] = {};
+    // total number of events ever recorded, the oldest ones are overwritten
+    std::atomic<uint32_t> head = { 0 };
+    Event events[EVENT_COUNT];
+};
+
+std::atomic<ThreadBuffer*> sThreadBuffers = { nullptr };
+const char* sTraceFile = nullptr;
+pthread_once_t sSystraceOnceControl = PTHREAD_ONCE_INIT;
+thread_local ThreadBuffer* tThreadBuffer = nullptr;
+
+ThreadBuffer* createThreadBuffer() noexcept {
+    ThreadBuffer* const buffer = new(std::nothrow) ThreadBuffer;
+    if (UTILS_UNLIKELY(!buffer)) {
+        return nullptr;
+    }
+    buffer->tid = pid_t(syscall(SYS_gettid));
+    pthread_getname_np(pthread_self(), buffer->threadName, sizeof(buffer->threadName));
+    // lock-free push at the front of the list of buffers
+    ThreadBuffer* head = sThreadBuffers.load(std::memory_order_relaxed);
+    do {
+        buffer->next = head;
+    } while (!sThreadBuffers.compare_exchange_weak(head, buffer,
+            std::memory_order_release, std::memory_order_relaxed));
+    return buffer;
+}
+
+void writeEscaped(FILE* file, const char* s) noexcept {
+    for (char c = *s; c; c = *++s) {
+        if (c == '"' || c == '\\') {
+            fputc('\\', file);
+            fputc(c, file);
+        } else if ((unsigned char)c >= 0x20) {
+            fputc(c, file);
+        }
+    }
+}
+
+} // anonymous namespace
+
+Systrace::GlobalState Systrace::sGlobalState = {};
+
+void Systrace::init_once() noexcept {
+    GlobalState& s = sGlobalState;
+    sTraceFile = getenv("FILAMENT_SYSTRACE_FILE");
+    s.isTracingAvailable = sTraceFile && *sTraceFile;
+    if (s.isTracingAvailable) {
+        atexit([]() { flush(); });
+    }
+}
+
+void Systrace::setup() noexcept {
+    pthread_once(&sSystraceOnceControl, init_once);
+}
+
+void Systrace::enable(uint32_t tags) noexcept {
+    setup();
+    if (UTILS_LIKELY(sGlobalState.isTracingAvailable)) {
+        sGlobalState.isTracingEnabled.fetch_or(tags, std::memory_order_relaxed);
+    }
+}
+
+void Systrace::disable(uint32_t tags) noexcept {
+    sGlobalState.isTracingEnabled.fetch_and(~tags, std::memory_order_relaxed);
+}
+
+bool Systrace::isTracingEnabled(uint32_t tag) noexcept {
+    if (tag) {
+        setup();
+        return bool((sGlobalState.isTracingEnabled.load(std::memory_order_relaxed) | SYSTRACE_TAG_ALWAYS) & tag);
+    }
+    return false;
+}
+
+void Systrace::init(uint32_t tag) noexcept {
+    mIsTracingEnabled = isTracingEnabled(tag) && sGlobalState.isTracingAvailable;
+}
+
+void Systrace::record(EventType type, const char* name, int64_t value) noexcept {
+    ThreadBuffer* buffer = tThreadBuffer;
+    if (UTILS_UNLIKELY(!buffer)) {
+        buffer = tThreadBuffer = createThreadBuffer();
+        if (UTILS_UNLIKELY(!buffer)) {
+            return;
+        }
+    }
+
+    using namespace std::chrono;
+    const uint32_t head = buffer->head.load(std::memory_order_relaxed);
+    Event& event = buffer->events[head & (EVENT_COUNT - 1)];
+    event.timestamp = uint64_t(duration_cast<nanoseconds>(
+            steady_clock::now().time_since_epoch()).count());
+    event.value = value;
+    event.type = uint8_t(type);
+    if (name) {
+        strncpy(event.name, name, sizeof(event.name) - 1);
+        event.name[sizeof(event.name) - 1] = 0;
+    } else {
+        event.name[0] = 0;
+    }
+    // publish the event to flush()
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+bool Systrace::flush() noexcept {
+    setup();
+    if (!sGlobalState.isTracingAvailable) {
+        return false;
+    }
+
+    FILE* const file = fopen(sTraceFile, "w");
+    if (!file) {
+        slog.e << "Systrace: couldn't open " << sTraceFile << io::endl;
+        return false;
+    }
+
+    const pid_t pid = getpid();
+    const char* separator = "\n";
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+
+    size_t eventCount = 0;
+    for (ThreadBuffer const* buffer = sThreadBuffers.load(std::memory_order_acquire);
+            buffer; buffer = buffer->next) {
+        if (buffer->threadName[0]) {
+            fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+                    "\"args\":{\"name\":\"", separator, pid, buffer->tid);
+            writeEscaped(file, buffer->threadName);
+            fprintf(file, "\"}}");
+            separator = ",\n";
+        }
+
+        // Events recorded while we're flushing may be missed or, if the ring buffer wraps
+        // around, be partially overwritten. This is acceptable for a tracing tool.
+        const uint32_t head = buffer->head.load(std::memory_order_acquire);
+        const uint32_t first = head > EVENT_COUNT ? head - EVENT_COUNT : 0;
+        for (uint32_t i = first; i != head; i++) {
+            Event const& event = buffer->events[i & (EVENT_COUNT - 1)];
+            static constexpr const char* phases[] = { "B", "E", "b", "e", "C" };
+            fprintf(file, "%s{\"ph\":\"%s\",\"pid\":%d,\"tid\":%d,\"ts\":%" PRIu64 ".%03u",
+                    separator, phases[event.type], pid, buffer->tid,
+                    event.timestamp / 1000u, unsigned(event.timestamp % 1000u));
+            if (event.name[0]) {
+                fprintf(file, ",\"name\":\"");
+                writeEscaped(file, event.name);
+                fprintf(file, "\"");
+            }
+            switch (EventType(event.type)) {
+                case EventType::BEGIN:
+                case EventType::END:
+                    break;
+                case EventType::ASYNC_BEGIN:
+                case EventType::ASYNC_END:
+                    fprintf(file, ",\"cat\":\"filament\",\"id\":%" PRId64, event.value);
+                    break;
+                case EventType::COUNTER:
+                    fprintf(file, ",\"args\":{\"value\":%" PRId64 "}", event.value);
+                    break;
+            }
+            fprintf(file, "}");
+            separator = ",\n";
+            eventCount++;
+        }
+    }
+
+    fprintf(file, "\n]}\n");
+    const bool success = !ferror(file);
+    fclose(file);
+
+    slog.i << "Systrace: wrote " << eventCount << " events to " << sTraceFile << io::endl;
+    return success;
+}
+
+} // namespace details
+} // namespace utils
+
+#endif // FILAMENT_ENABLE_SYSTRACE
@@ -29,6 +29,10 @@ bool Path::mkdir() const {
     return _mkdir(m_path.c_str()) == 0;
 }
 
+bool Path::rmdir() const {
+    return _rmdir(m_path.c_str()) == 0;
+}
+
 Path Path::getCurrentExecutable() {
     // First, need to establish resource path.
     TCHAR path[MAX_PATH + 1];
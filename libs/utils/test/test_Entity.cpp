@@ -17,9 +17,13 @@
 #include <gtest/gtest.h>
 
 #include <memory>
+#include <thread>
+#include <unordered_set>
+#include <vector>
 
 #include "../src/EntityManagerImpl.h"
 #include <utils/NameComponentManager.h>
+#include <utils/SingleInstanceComponentManager.h>
 
 using namespace utils;
 
@@ -97,6 +101,26 @@ TEST(EntityTest, Free) {
     EXPECT_EQ(EntityManagerImpl::makeIdentity(1, 1), e.getId());
 }
 
+TEST(EntityTest, FreeListThreshold) {
+    EntityManagerImpl em;
+    std::vector<Entity> entities(1100);
+    em.create(entities.size(), entities.data());
+    em.destroy(entities.size(), entities.data());
+
+    // indices are recycled one at a time, only while at least 1024 of them are free, after that
+    // never used indices are handed out again
+    std::vector<Entity> recycled(100);
+    em.create(recycled.size(), recycled.data());
+    for (size_t i = 0; i < recycled.size(); i++) {
+        if (i < 77) {
+            EXPECT_EQ(EntityManagerImpl::makeIdentity(1, i + 1), recycled[i].getId());
+        } else {
+            EXPECT_EQ(EntityManagerImpl::makeIdentity(0, i - 77 + 1101), recycled[i].getId());
+        }
+    }
+    em.destroy(recycled.size(), recycled.data());
+}
+
 TEST(EntityTest, Lots) {
     EntityManagerImpl em;
     std::unique_ptr<Entity[]> entities(new Entity[EntityManager::getMaxEntityCount()]);
@@ -128,6 +152,65 @@ TEST(EntityTest, Lots) {
     // at this point, we should be getting indices from the free-list exclusively
 }
 
+TEST(EntityTest, Millions) {
+    EntityManagerImpl em;
+    constexpr size_t n = 2'000'000;
+    ASSERT_GE(EntityManager::getMaxEntityCount(), n);
+
+    std::unique_ptr<Entity[]> entities(new Entity[n]);
+    em.create(n, entities.get());
+    for (size_t i = 0; i < n; i++) {
+        ASSERT_FALSE(entities[i].isNull());
+        ASSERT_TRUE(em.isAlive(entities[i]));
+    }
+    EXPECT_EQ(EntityManagerImpl::makeIdentity(0, n), entities[n - 1].getId());
+
+    em.destroy(n, entities.get());
+    for (size_t i = 0; i < n; i++) {
+        ASSERT_FALSE(em.isAlive(entities[i]));
+    }
+
+    // indices are now recycled with a new generation
+    Entity e = em.create();
+    EXPECT_EQ(EntityManagerImpl::makeIdentity(1, 1), e.getId());
+    EXPECT_TRUE(em.isAlive(e));
+    em.destroy(e);
+}
+
+TEST(EntityTest, Threads) {
+    EntityManagerImpl em;
+    constexpr size_t THREAD_COUNT = 8;
+    constexpr size_t BATCH_COUNT = 64;
+    constexpr size_t BATCH_SIZE = 256;
+    std::unique_ptr<Entity[]> entities(new Entity[THREAD_COUNT * BATCH_COUNT * BATCH_SIZE]);
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < THREAD_COUNT; t++) {
+        threads.emplace_back([&em, t, p = entities.get()]() {
+            Entity* const base = p + t * BATCH_COUNT * BATCH_SIZE;
+            for (size_t b = 0; b < BATCH_COUNT; b++) {
+                em.create(BATCH_SIZE, base + b * BATCH_SIZE);
+                // destroy half of them, so that indices get recycled
+                if (b & 1) {
+                    em.destroy(BATCH_SIZE, base + b * BATCH_SIZE);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // all the entities that are still alive must be unique
+    std::unordered_set<uint32_t> alive;
+    for (size_t i = 0; i < THREAD_COUNT * BATCH_COUNT * BATCH_SIZE; i++) {
+        if (em.isAlive(entities[i])) {
+            EXPECT_TRUE(alive.insert(EntityManagerImpl::getIndex(entities[i])).second);
+        }
+    }
+    EXPECT_EQ(THREAD_COUNT * BATCH_COUNT * BATCH_SIZE / 2, alive.size());
+}
+
 
 TEST(EntityTest, NameComponent) {
 
@@ -176,3 +259,107 @@ TEST(EntityTest, NameComponent) {
 
     cm.gc(em);
 }
+
+TEST(EntityTest, ComponentIndexReuse) {
+
+    EntityManagerImpl em;
+    SingleInstanceComponentManager<int> cm;
+
+    // enough entities for their indices to be recycled
+    std::vector<Entity> dead(4096);
+    em.create(dead.size(), dead.data());
+    for (Entity e : dead) {
+        cm.addComponent(e);
+    }
+    em.destroy(dead.size(), dead.data());
+
+    // the components of the dead entities are not garbage collected yet when new entities
+    // reuse their indices
+    std::vector<Entity> alive(4096);
+    em.create(alive.size(), alive.data());
+    for (Entity e : alive) {
+        cm.addComponent(e);
+    }
+    EXPECT_EQ(dead.size() + alive.size(), cm.getComponentCount());
+    EXPECT_EQ(EntityManager::getEntityIndex(dead[0]), EntityManager::getEntityIndex(alive[0]));
+
+    auto check = [&cm](std::vector<Entity> const& entities) {
+        for (Entity e : entities) {
+            auto i = cm.getInstance(e);
+            EXPECT_NE(0, i);
+            EXPECT_EQ(e, cm.getEntity(i));
+        }
+    };
+    check(dead);
+    check(alive);
+
+    // every other component moves around when removing these
+    for (size_t i = 0; i < dead.size(); i += 2) {
+        cm.removeComponent(dead[i]);
+        EXPECT_FALSE(cm.hasComponent(dead[i]));
+    }
+    check(alive);
+
+    for (size_t i = 1; i < dead.size(); i += 2) {
+        cm.removeComponent(dead[i]);
+    }
+    EXPECT_EQ(alive.size(), cm.getComponentCount());
+    for (Entity e : dead) {
+        EXPECT_FALSE(cm.hasComponent(e));
+    }
+    check(alive);
+
+    for (Entity e : alive) {
+        cm.removeComponent(e);
+    }
+    EXPECT_TRUE(cm.empty());
+    em.destroy(alive.size(), alive.data());
+}
+
+TEST(EntityTest, ComponentGc) {
+
+    EntityManagerImpl em;
+    SingleInstanceComponentManager<int> cm;
+
+    std::vector<Entity> entities(1000);
+    em.create(entities.size(), entities.data());
+    for (Entity e : entities) {
+        cm.addComponent(e);
+    }
+
+    // entities destroyed before the first gc() are found by scanning the components
+    em.destroy(100, entities.data());
+    cm.gc(em);
+    EXPECT_EQ(900, cm.getComponentCount());
+
+    // after that, the destroyed entities are queued, and processed within the budget
+    em.destroy(300, entities.data() + 100);
+    Entity other = em.create();
+    em.destroy(other);
+    cm.gc(em, 100);
+    EXPECT_EQ(800, cm.getComponentCount());
+    cm.gc(em, 1000);
+    EXPECT_EQ(600, cm.getComponentCount());
+    for (size_t i = 0; i < entities.size(); i++) {
+        EXPECT_EQ(i >= 400, cm.hasComponent(entities[i]));
+    }
+
+    // only the removed components count against the budget
+    std::vector<Entity> others(500);
+    em.create(others.size(), others.data());
+    em.destroy(others.size(), others.data());
+    em.destroy(100, entities.data() + 400);
+    cm.gc(em, 60);
+    EXPECT_EQ(540, cm.getComponentCount());
+    cm.gc(em, 60);
+    EXPECT_EQ(500, cm.getComponentCount());
+    for (size_t i = 0; i < entities.size(); i++) {
+        EXPECT_EQ(i >= 500, cm.hasComponent(entities[i]));
+    }
+
+    // components removed explicitly are skipped
+    cm.removeComponent(entities[500]);
+    em.destroy(500, entities.data() + 500);
+    cm.gc(em);
+    EXPECT_TRUE(cm.empty());
+}
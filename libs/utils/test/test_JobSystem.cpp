@@ -17,12 +17,14 @@
 #include <gtest/gtest.h>
 
 #include <utils/JobSystem.h>
+#include <utils/Path.h>
 #include <utils/WorkStealingDequeue.h>
 
 #include <math/vec3.h>
 #include <math/mat3.h>
 
 #include <array>
+#include <string>
 #include <thread>
 #include <utils/Allocator.h>
 
@@ -191,6 +193,79 @@ TEST(JobSystem, WorkStealingDequeue_PushPopSteal) {
 
 
 static std::atomic_int v = {0};
+TEST(JobSystem, WorkStealingDequeue_Grow) {
+    struct MyJob {
+    };
+    WorkStealingDequeue<MyJob*, 16> queue;
+    EXPECT_EQ(16, queue.getSize());
+
+    std::vector<MyJob> jobs;
+    jobs.resize(4096);
+
+    // pushing more items than the initial capacity grows the queue and preserves the order
+    for (size_t i=0 ; i<4096 ; i++) {
+        queue.push(&jobs[i]);
+    }
+    EXPECT_EQ(4096, queue.getSize());
+    EXPECT_EQ(4096, queue.getCount());
+    for (size_t i=0 ; i<2048 ; i++) {
+        EXPECT_EQ(&jobs[i], queue.steal());
+    }
+    for (size_t i=0 ; i<2048 ; i++) {
+        EXPECT_EQ(&jobs[4095-i], queue.pop());
+    }
+    EXPECT_EQ(nullptr, queue.pop());
+
+    // the queue doesn't grow further once it's large enough
+    for (size_t i=0 ; i<4096 ; i++) {
+        queue.push(&jobs[i]);
+    }
+    for (size_t i=0 ; i<4096 ; i++) {
+        queue.pop();
+    }
+    EXPECT_EQ(4096, queue.getSize());
+}
+
+TEST(JobSystem, WorkStealingDequeue_PushStealGrow) {
+    struct MyJob {
+    };
+    WorkStealingDequeue<MyJob*, 16> queue;
+    constexpr size_t size = 65536;
+
+    MyJob pJob;
+
+    // the queue grows while other threads are stealing from it
+    int pop = 0;
+    std::atomic_int steal = { 0 };
+    std::atomic_bool done = { false };
+    std::thread push_pop_thread([&]() {
+        for (int i=0 ; i<size ; i++) {
+            queue.push(&pJob);
+        }
+        while (queue.pop()) {
+            pop++;
+        }
+        done = true;
+    });
+
+    auto stealer = [&]() {
+        while (!done.load()) {
+            if (queue.steal()) {
+                steal++;
+            }
+        }
+    };
+    std::thread steal_thread0(stealer);
+    std::thread steal_thread1(stealer);
+
+    steal_thread0.join();
+    steal_thread1.join();
+    push_pop_thread.join();
+
+    EXPECT_EQ(pop + steal, size);
+    EXPECT_TRUE(queue.getCount() == 0);
+}
+
 TEST(JobSystem, JobSystemParallelChildren) {
     v = 0;
 
@@ -344,3 +419,171 @@ TEST(JobSystem, JobSystemDelegates) {
 
     js.emancipate();
 }
+
+TEST(JobSystem, JobSystemLanes) {
+    JobSystem js;
+    js.adopt();
+
+    // background jobs that don't finish until we tell them, they may occupy all workers
+    std::atomic_bool done = { false };
+    std::atomic_int backgroundCalls = { 0 };
+    JobSystem::Job* background = js.createJob();
+    js.setLane(background, JobSystem::Lane::BACKGROUND);
+    for (int i = 0; i < 64; i++) {
+        js.run(jobs::createJob(js, background, [&done, &backgroundCalls]() {
+            while (!done.load()) {
+                std::this_thread::yield();
+            }
+            backgroundCalls++;
+        }));
+    }
+
+    // frame jobs must complete regardless, if needed this thread runs them while waiting
+    std::atomic_int frameCalls = { 0 };
+    JobSystem::Job* frame = js.createJob();
+    for (int i = 0; i < 64; i++) {
+        js.run(jobs::createJob(js, frame, [&frameCalls]() {
+            frameCalls++;
+        }));
+    }
+    js.runAndWait(frame);
+    EXPECT_EQ(64, frameCalls.load());
+
+    done = true;
+    js.runAndWait(background);
+    EXPECT_EQ(64, backgroundCalls.load());
+
+    js.emancipate();
+}
+
+TEST(JobSystem, JobSystemManyJobs) {
+    JobSystem js;
+    js.adopt();
+
+    // more jobs than fit in a single chunk are alive at the same time, a single parent can't
+    // have more than 65534 children, so we use two levels.
+    constexpr size_t PARENT_COUNT = 128;
+    constexpr size_t CHILD_COUNT = 1024;
+    std::atomic_int calls = { 0 };
+    std::vector<JobSystem::Job*> jobs;
+    jobs.reserve(PARENT_COUNT * (CHILD_COUNT + 1));
+
+    size_t capacity = 0;
+    for (int round = 0; round < 2; round++) {
+        calls = 0;
+        JobSystem::Job* root = js.createJob();
+        for (size_t i = 0; i < PARENT_COUNT; i++) {
+            JobSystem::Job* parent = js.createJob(root);
+            for (size_t j = 0; j < CHILD_COUNT; j++) {
+                jobs.push_back(jobs::createJob(js, parent, [&calls]() { calls++; }));
+                ASSERT_NE(nullptr, jobs.back());
+            }
+            jobs.push_back(parent);
+        }
+        EXPECT_GE(js.getJobCapacity(), PARENT_COUNT * (CHILD_COUNT + 1));
+
+        for (JobSystem::Job*& job : jobs) {
+            js.run(job);
+        }
+        jobs.clear();
+        js.runAndWait(root);
+        EXPECT_EQ(PARENT_COUNT * CHILD_COUNT, calls.load());
+
+        // the job storage is reused, it doesn't grow in the steady state
+        if (round == 0) {
+            capacity = js.getJobCapacity();
+        } else {
+            EXPECT_EQ(capacity, js.getJobCapacity());
+        }
+    }
+
+    js.emancipate();
+}
+
+// 2 NUMA nodes, each with 2 last-level caches shared by 2 CPUs
+static JobSystem::CpuTopology getSimulatedTopology() {
+    JobSystem::CpuTopology topology;
+    for (uint16_t id = 0; id < 8; id++) {
+        topology.cpus.push_back({ id, uint16_t(id & ~1u), uint16_t(id / 4) });
+    }
+    return topology;
+}
+
+// Deletes a file, or a directory and everything it contains
+static bool removeRecursive(Path path) {
+    if (path.isDirectory()) {
+        for (Path const& child : path.listContents()) {
+            removeRecursive(child);
+        }
+        return path.rmdir();
+    }
+    return path.unlinkFile();
+}
+
+TEST(JobSystem, JobSystemCpuTopologyFromSysfs) {
+    Path root = Path::getTemporaryDirectory() + "filament_test_sysfs";
+    // in case a previous run failed before cleaning up
+    removeRecursive(root);
+
+    auto write = [&root](std::string const& name, std::string const& content) {
+        Path const path = root + name;
+        path.getParent().mkdirRecursive();
+        FILE* file = fopen(path.c_str(), "w");
+        ASSERT_NE(nullptr, file);
+        fputs(content.c_str(), file);
+        fclose(file);
+    };
+
+    // simulate the sysfs of the topology above
+    write("cpu/online", "0-7\n");
+    for (int id = 0; id < 8; id++) {
+        std::string const cpu = "cpu/cpu" + std::to_string(id) + "/cache/";
+        write(cpu + "index0/level", "1\n");
+        write(cpu + "index0/shared_cpu_list", std::to_string(id) + "\n");
+        write(cpu + "index1/level", "3\n");
+        write(cpu + "index1/shared_cpu_list",
+                std::to_string(id & ~1) + "-" + std::to_string(id | 1) + "\n");
+        write(cpu + "index2/level", "2\n");
+        write(cpu + "index2/shared_cpu_list", std::to_string(id) + "\n");
+    }
+    write("node/online", "0-1\n");
+    write("node/node0/cpulist", "0-3\n");
+    write("node/node1/cpulist", "4,5,6-7\n");
+
+    JobSystem::CpuTopology const expected = getSimulatedTopology();
+    JobSystem::CpuTopology const topology = JobSystem::CpuTopology::fromSysfs(root.c_str());
+    ASSERT_EQ(expected.cpus.size(), topology.cpus.size());
+    for (size_t i = 0; i < expected.cpus.size(); i++) {
+        EXPECT_EQ(expected.cpus[i].id, topology.cpus[i].id);
+        EXPECT_EQ(expected.cpus[i].cacheDomain, topology.cpus[i].cacheDomain);
+        EXPECT_EQ(expected.cpus[i].numaNode, topology.cpus[i].numaNode);
+    }
+
+    // a missing sysfs gives an empty topology
+    EXPECT_TRUE(JobSystem::CpuTopology::fromSysfs((root + "missing").c_str()).cpus.empty());
+
+    EXPECT_TRUE(removeRecursive(root));
+    EXPECT_FALSE(root.exists());
+}
+
+TEST(JobSystem, JobSystemTopology) {
+    // more workers than CPUs, the topology doesn't need to match this machine
+    for (size_t threadCount : { 4, 8, 12 }) {
+        JobSystem js(threadCount, 1, getSimulatedTopology());
+        js.adopt();
+
+        std::vector<uint32_t> result(65536);
+        auto job = jobs::parallel_for(js, nullptr, 0, uint32_t(result.size()),
+                [&result](uint32_t start, uint32_t count) {
+                    for (uint32_t i = start; i < start + count; i++) {
+                        result[i] = i * 2;
+                    }
+                }, jobs::CountSplitter<64>());
+        js.runAndWait(job);
+        for (uint32_t i = 0; i < result.size(); i++) {
+            ASSERT_EQ(i * 2, result[i]);
+        }
+
+        js.emancipate();
+    }
+}
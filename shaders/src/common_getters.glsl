@@ -72,6 +72,11 @@ highp vec2 uvToRenderTargetUV(highp vec2 uv) {
 #define FILAMENT_OBJECT_SKINNING_ENABLED_BIT   0x1u
 #define FILAMENT_OBJECT_MORPHING_ENABLED_BIT   0x2u
 #define FILAMENT_OBJECT_CONTACT_SHADOWS_BIT    0x4u
+#define FILAMENT_OBJECT_INSTANCING_ENABLED_BIT 0x8u
+
+// Data of the renderable being drawn. With automatic instancing, the renderables of an
+// instanced draw call have their data stored consecutively in the per-renderable UBO.
+#define object_uniforms objectUniforms.data[instance_index]
 
 /** @public-api */
 highp vec4 getResolution() {
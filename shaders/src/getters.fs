@@ -19,6 +19,11 @@ highp vec2 getUV1() {
 }
 #endif
 
+/** @public-api */
+highp float getObjectUserData() {
+    return object_uniforms.userData;
+}
+
 #if defined(BLEND_MODE_MASKED)
 /** @public-api */
 float getMaskThreshold() {
@@ -8,12 +8,12 @@ mat4 getLightFromWorldMatrix() {
 
 /** @public-api */
 mat4 getWorldFromModelMatrix() {
-    return objectUniforms.worldFromModelMatrix;
+    return object_uniforms.worldFromModelMatrix;
 }
 
 /** @public-api */
 mat3 getWorldFromModelNormalMatrix() {
-    return objectUniforms.worldFromModelNormalMatrix;
+    return object_uniforms.worldFromModelNormalMatrix;
 }
 
 //------------------------------------------------------------------------------
@@ -29,8 +29,7 @@ int getVertexIndex() {
 #endif
 }
 
-/** @public-api */
-int getInstanceIndex() {
+int getDrawInstanceIndex() {
 #if defined(TARGET_METAL_ENVIRONMENT) || defined(TARGET_VULKAN_ENVIRONMENT)
     return gl_InstanceIndex;
 #else
@@ -38,6 +37,24 @@ int getInstanceIndex() {
 #endif
 }
 
+/**
+ * Returns the index of the current instance, as specified with RenderableManager's
+ * Builder::instances(). This is always 0 for renderables that don't set it.
+ *
+ * @public-api
+ */
+int getInstanceIndex() {
+    // the renderable manages its own instances, they all share the first element of the UBO
+    bool instancing = (objectUniforms.data[0].flags & FILAMENT_OBJECT_INSTANCING_ENABLED_BIT) != 0u;
+    return instancing ? getDrawInstanceIndex() : 0;
+}
+
+// Must be called first in main(), sets the index used to access the renderable's data
+void initInstanceIndex() {
+    bool instancing = (objectUniforms.data[0].flags & FILAMENT_OBJECT_INSTANCING_ENABLED_BIT) != 0u;
+    instance_index = instancing ? 0 : getDrawInstanceIndex();
+}
+
 #if defined(VARIANT_HAS_SKINNING_OR_MORPHING)
 vec3 mulBoneNormal(vec3 n, uint i) {
 
@@ -86,7 +103,7 @@ void skinPosition(inout vec3 p, const uvec4 ids, const vec4 weights) {
 
 void morphPosition(inout vec4 p) {
     ivec3 texcoord = ivec3(getVertexIndex() % MAX_MORPH_TARGET_BUFFER_WIDTH, getVertexIndex() / MAX_MORPH_TARGET_BUFFER_WIDTH, 0);
-    for (uint i = 0u; i < objectUniforms.morphTargetCount; ++i) {
+    for (uint i = 0u; i < object_uniforms.morphTargetCount; ++i) {
         float w = morphingUniforms.weights[i][0];
         if (w != 0.0) {
             texcoord.z = int(i);
@@ -97,7 +114,7 @@ void morphPosition(inout vec4 p) {
 
 void morphNormal(inout vec3 n) {
     ivec3 texcoord = ivec3(getVertexIndex() % MAX_MORPH_TARGET_BUFFER_WIDTH, getVertexIndex() / MAX_MORPH_TARGET_BUFFER_WIDTH, 0);
-    for (uint i = 0u; i < objectUniforms.morphTargetCount; ++i) {
+    for (uint i = 0u; i < object_uniforms.morphTargetCount; ++i) {
         float w = morphingUniforms.weights[i][0];
         if (w != 0.0) {
             texcoord.z = int(i);
@@ -116,7 +133,7 @@ vec4 getPosition() {
 
 #if defined(VARIANT_HAS_SKINNING_OR_MORPHING)
 
-    if ((objectUniforms.flags & FILAMENT_OBJECT_MORPHING_ENABLED_BIT) != 0u) {
+    if ((object_uniforms.flags & FILAMENT_OBJECT_MORPHING_ENABLED_BIT) != 0u) {
         #if defined(LEGACY_MORPHING)
         pos += morphingUniforms.weights[0] * mesh_custom0;
         pos += morphingUniforms.weights[1] * mesh_custom1;
@@ -127,7 +144,7 @@ vec4 getPosition() {
         #endif
     }
 
-    if ((objectUniforms.flags & FILAMENT_OBJECT_SKINNING_ENABLED_BIT) != 0u) {
+    if ((object_uniforms.flags & FILAMENT_OBJECT_SKINNING_ENABLED_BIT) != 0u) {
         skinPosition(pos.xyz, mesh_bone_indices, mesh_bone_weights);
     }
 
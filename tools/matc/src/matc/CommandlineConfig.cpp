@@ -66,6 +66,15 @@ static void usage(char* name) {
             "           directionalLighting, dynamicLighting, shadowReceiver, skinning, vsm, fog,"
             "           ssr (screen-space reflections)\n"
             "       This variant filter is merged with the filter from the material, if any\n\n"
+            "   --cache-dir=<dir>, -c <dir>\n"
+            "       Cache the compiled shaders in <dir> and reuse them when their code, options\n"
+            "       and compiler versions are unchanged. <dir> can be shared by concurrent builds\n\n"
+            "   --compress, -z\n"
+            "       Store the shaders in independently compressed blocks, so that only the variants\n"
+            "       in use are decompressed. Requires a version of filament that supports it\n\n"
+            "   --verbose\n"
+            "       Print build statistics: the ratio of duplicate variant shaders, which are\n"
+            "       compiled only once, and the shader cache hit rate\n\n"
             "   --version, -v\n"
             "       Print the material version number\n\n"
             "Internal use and debugging only:\n"
@@ -156,7 +165,7 @@ static void parseDefine(std::string defineString,
 }
 
 bool CommandlineConfig::parse() {
-    static constexpr const char* OPTSTR = "hlxo:f:dm:a:p:D:OSEr:vV:gtw";
+    static constexpr const char* OPTSTR = "hlxo:f:dm:a:p:D:OSEr:vV:gtwc:z";
     static const struct option OPTIONS[] = {
             { "help",                    no_argument, nullptr, 'h' },
             { "license",                 no_argument, nullptr, 'l' },
@@ -176,6 +185,9 @@ bool CommandlineConfig::parse() {
             { "print",                   no_argument, nullptr, 't' },
             { "version",                 no_argument, nullptr, 'v' },
             { "raw",                     no_argument, nullptr, 'w' },
+            { "cache-dir",         required_argument, nullptr, 'c' },
+            { "compress",                no_argument, nullptr, 'z' },
+            { "verbose",                 no_argument, nullptr, 's' },
             { nullptr, 0, nullptr, 0 }  // termination of the option list
     };
 
@@ -274,6 +286,15 @@ bool CommandlineConfig::parse() {
             case 'w':
                 mRawShaderMode = true;
                 break;
+            case 'c':
+                mShaderCacheDirectory = arg;
+                break;
+            case 's':
+                mPrintBuildStatistics = true;
+                break;
+            case 'z':
+                mCompressShaders = true;
+                break;
         }
     }
 
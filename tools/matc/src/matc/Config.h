@@ -23,6 +23,7 @@
 #include <filamat/MaterialBuilder.h>
 
 #include <memory>
+#include <string>
 #include <unordered_map>
 #include <ostream>
 
@@ -118,6 +119,18 @@ public:
         return mDefines;
     }
 
+    const std::string& getShaderCacheDirectory() const noexcept {
+        return mShaderCacheDirectory;
+    }
+
+    bool printBuildStatistics() const noexcept {
+        return mPrintBuildStatistics;
+    }
+
+    bool compressShaders() const noexcept {
+        return mCompressShaders;
+    }
+
 protected:
     bool mDebug = false;
     bool mIsValid = true;
@@ -130,6 +143,9 @@ protected:
     TargetApi mTargetApi = (TargetApi) 0;
     std::unordered_map<std::string, std::string> mDefines;
     filament::UserVariantFilterMask mVariantFilter = 0;
+    std::string mShaderCacheDirectory;
+    bool mPrintBuildStatistics = false;
+    bool mCompressShaders = false;
 };
 
 }
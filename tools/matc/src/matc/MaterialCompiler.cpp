@@ -311,12 +311,17 @@ bool MaterialCompiler::run(const Config& config) {
         .optimization(config.getOptimizationLevel())
         .printShaders(config.printShaders())
         .generateDebugInfo(config.isDebug())
+        .compressShaders(config.compressShaders())
         .variantFilter(config.getVariantFilter() | builder.getVariantFilter());
 
     for (const auto& define : config.getDefines()) {
         builder.shaderDefine(define.first.c_str(), define.second.c_str());
     }
 
+    if (!config.getShaderCacheDirectory().empty()) {
+        builder.shaderCache(config.getShaderCacheDirectory().c_str());
+    }
+
     JobSystem js;
     js.adopt();
 
@@ -330,6 +335,23 @@ bool MaterialCompiler::run(const Config& config) {
         std::cerr << "Could not compile material " << input->getName() << std::endl;
         return false;
     }
+
+    if (config.printBuildStatistics()) {
+        const auto stats = builder.getBuildStatistics();
+        const size_t duplicateCount = stats.shaderCount - stats.uniqueShaderCount;
+        std::cout << "Shaders: " << stats.shaderCount << " generated, "
+                << stats.uniqueShaderCount << " compiled ("
+                << (stats.shaderCount ? 100 * duplicateCount / stats.shaderCount : 0)
+                << "% duplicates)" << std::endl;
+        if (!config.getShaderCacheDirectory().empty()) {
+            const size_t total = stats.cacheHitCount + stats.cacheMissCount;
+            std::cout << "Shader cache: " << stats.cacheHitCount << " hits, "
+                    << stats.cacheMissCount << " misses ("
+                    << (total ? 100 * stats.cacheHitCount / total : 0) << "% hit rate)"
+                    << std::endl;
+        }
+    }
+
     return writePackage(package, config);
 }
 